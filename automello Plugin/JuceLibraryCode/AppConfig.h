@@ -39,3 +39,4 @@
 //#define  JUCE_SUPPORT_CARBON
 //#define  JUCE_CHECK_MEMORY_LEAKS
 //#define  JUCE_CATCH_UNHANDLED_EXCEPTIONS
+//#define  JUCE_CHECK_AUDIO_THREAD_ALLOCATIONS
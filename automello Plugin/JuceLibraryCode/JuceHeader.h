@@ -26,6 +26,8 @@
  #include "../juce/juce_amalgamated.h"
 #elif defined (JUCER_XCODE_MAC_F6D2F4CF)
  #include "../juce/juce_amalgamated.h"
+#elif defined (JUCER_LINUX_MAKE_7346DA2A)
+ #include "../juce/juce_amalgamated.h"
 #endif
 
 namespace ProjectInfo
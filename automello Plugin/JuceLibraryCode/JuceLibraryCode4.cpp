@@ -24,4 +24,6 @@
  #include "../juce/amalgamation/juce_amalgamated4.cpp"
 #elif defined (JUCER_XCODE_MAC_F6D2F4CF)
  #include "../juce/amalgamation/juce_amalgamated4.cpp"
+#elif defined (JUCER_LINUX_MAKE_7346DA2A)
+ #include "../juce/amalgamation/juce_amalgamated4.cpp"
 #endif
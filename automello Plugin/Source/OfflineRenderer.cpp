@@ -0,0 +1,212 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.cpp
+
+  ==============================================================================
+*/
+
+#include "OfflineRenderer.h"
+
+
+//==============================================================================
+AutomelloOfflineRenderer::Settings::Settings()
+  : sampleRate( 44100.0 ),
+    blockSize( 8192 ),
+    tailSeconds( 3.0 ),
+    bitsPerSample( 24 ),
+    reverbSend( 0.0f ),
+    reverbSize( 0.5f )
+{
+}
+
+//==============================================================================
+AutomelloOfflineRenderer::AutomelloOfflineRenderer( const Settings& settings_ )
+  : settings( settings_ ),
+    buffer( JucePlugin_MaxNumOutputChannels, settings_.blockSize ),
+    secondsRendered( 0.0 )
+{
+  formatManager.registerBasicFormats();
+
+  processor.setDirectory( settings.datasetDirectory );
+  processor.setParameter( AutomelloPluginAudioProcessor::reverbSendParam, settings.reverbSend );
+  processor.setParameter( AutomelloPluginAudioProcessor::reverbSizeParam, settings.reverbSize );
+
+  processor.setNonRealtime( true );
+  processor.setPlayConfigDetails( JucePlugin_MaxNumInputChannels, JucePlugin_MaxNumOutputChannels,
+                                  settings.sampleRate, settings.blockSize );
+  processor.prepareToPlay( settings.sampleRate, settings.blockSize );
+
+  // Enough room for a busy block, so that adding events doesn't keep reallocating
+  midiBlock.ensureSize( 8192 );
+}
+
+AutomelloOfflineRenderer::~AutomelloOfflineRenderer()
+{
+  processor.releaseResources();
+}
+
+const String AutomelloOfflineRenderer::render( const File& midiFile, const File& outputFile )
+{
+  MidiFileReader reader( midiFile );
+
+  if (! reader.isValid())
+    return "Couldn't read the midi file " + midiFile.getFullPathName();
+
+  AudioFormat* const format = formatManager.findFormatForFileExtension( outputFile.getFileExtension() );
+
+  if (format == nullptr)
+    return "Unknown audio file type: " + outputFile.getFullPathName();
+
+  outputFile.deleteFile();
+  ScopedPointer<FileOutputStream> outputStream( outputFile.createOutputStream() );
+
+  if (outputStream == nullptr)
+    return "Couldn't write to " + outputFile.getFullPathName();
+
+  ScopedPointer<AudioFormatWriter> writer( format->createWriterFor( outputStream, settings.sampleRate,
+                                                                    (unsigned int) buffer.getNumChannels(),
+                                                                    settings.bitsPerSample, StringPairArray(), 0 ) );
+  if (writer == nullptr)
+    return "Can't write " + String( settings.bitsPerSample ) + "-bit " + format->getFormatName();
+
+  outputStream.release(); // (the writer owns it now)
+
+  // Start from silence, whatever the previous file left ringing
+  processor.reset();
+
+  MidiFileReader::Iterator events( reader );
+  bool moreEvents = events.next();
+  int64 blockStart = 0, lastEventPosition = 0, endPosition = -1;
+
+  for (;;)
+  {
+    const int64 blockEnd = blockStart + settings.blockSize;
+    midiBlock.clear();
+
+    while (moreEvents)
+    {
+      const int64 eventPosition = (int64) (events.getTimeInSeconds() * settings.sampleRate + 0.5);
+
+      if (eventPosition >= blockEnd)
+        break;
+
+      // Meta-events are only there to describe the file
+      if (events.getData()[0] != 0xff)
+        midiBlock.addEvent( events.getData(), events.getDataSize(), (int) (eventPosition - blockStart) );
+
+      lastEventPosition = eventPosition;
+      moreEvents = events.next();
+    }
+
+    if (! moreEvents && endPosition < 0)
+      endPosition = lastEventPosition + (int64) (settings.tailSeconds * settings.sampleRate);
+
+    const int numSamples = moreEvents ? settings.blockSize
+                                      : (int) jmin( (int64) settings.blockSize, endPosition - blockStart );
+    if (numSamples <= 0)
+      break;
+
+    buffer.clear();
+    processor.processBlock( buffer, midiBlock );
+
+    if (! writer->writeFromAudioSampleBuffer( buffer, 0, numSamples ))
+      return "Couldn't write to " + outputFile.getFullPathName();
+
+    blockStart = blockEnd;
+    secondsRendered += numSamples / settings.sampleRate;
+  }
+
+  return String::empty;
+}
+
+//==============================================================================
+namespace
+{
+  class RenderThread  : public Thread
+  {
+  public:
+    RenderThread( const AutomelloOfflineRenderer::Settings& settings,
+                  const Array<File>& midiFiles_, const Array<File>& outputFiles_,
+                  Atomic<int>& nextJob_, StringArray& errors_, CriticalSection& errorLock_ )
+      : Thread( "Automello renderer" ),
+        renderer( settings ),
+        midiFiles( midiFiles_ ),
+        outputFiles( outputFiles_ ),
+        nextJob( nextJob_ ),
+        errors( errors_ ),
+        errorLock( errorLock_ )
+    {
+    }
+
+    ~RenderThread()
+    {
+      stopThread( -1 );
+    }
+
+    void run()
+    {
+      while (! threadShouldExit())
+      {
+        const int job = (++nextJob) - 1;
+
+        if (job >= midiFiles.size())
+          break;
+
+        const String error( renderer.render( midiFiles.getReference( job ), outputFiles.getReference( job ) ) );
+
+        if (error.isNotEmpty())
+        {
+          const ScopedLock sl( errorLock );
+          errors.add( error );
+        }
+      }
+    }
+
+    AutomelloOfflineRenderer renderer;
+
+  private:
+    const Array<File>& midiFiles;
+    const Array<File>& outputFiles;
+    Atomic<int>& nextJob;
+    StringArray& errors;
+    CriticalSection& errorLock;
+
+    JUCE_DECLARE_NON_COPYABLE (RenderThread);
+  };
+}
+
+const StringArray AutomelloOfflineRenderer::renderAll( const Settings& settings,
+                                                       const Array<File>& midiFiles,
+                                                       const Array<File>& outputFiles,
+                                                       int numThreads,
+                                                       double& totalSecondsRendered )
+{
+  jassert( midiFiles.size() == outputFiles.size() );
+
+  StringArray errors;
+  CriticalSection errorLock;
+  Atomic<int> nextJob;
+  OwnedArray<RenderThread> threads;
+
+  numThreads = jlimit( 1, jmax( 1, midiFiles.size() ), numThreads );
+
+  // The renderers are created one at a time, so that the first one fills in the
+  // shared header cache and the others can load the dataset straight from it
+  for (int i = 0; i < numThreads; ++i)
+    threads.add( new RenderThread( settings, midiFiles, outputFiles, nextJob, errors, errorLock ) );
+
+  for (int i = 0; i < numThreads; ++i)
+    threads.getUnchecked( i )->startThread();
+
+  totalSecondsRendered = 0.0;
+
+  for (int i = 0; i < numThreads; ++i)
+  {
+    RenderThread* const t = threads.getUnchecked( i );
+    t->waitForThreadToExit( -1 );
+    totalSecondsRendered += t->renderer.getSecondsRendered();
+  }
+
+  return errors;
+}
@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.h
+
+    Renders midi files through the plugin's processor as fast as the machine
+    will go, without needing a host or an audio device.
+
+  ==============================================================================
+*/
+
+#ifndef __OFFLINERENDERER_H_7D3A19C2__
+#define __OFFLINERENDERER_H_7D3A19C2__
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "PluginProcessor.h"
+
+
+//==============================================================================
+/**
+    Drives an AutomelloPluginAudioProcessor from a midi file and writes what it
+    plays to an audio file.
+
+    The midi file is memory-mapped and streamed straight into processBlock(), one
+    large block at a time, so nothing waits on a real-time clock. Each renderer
+    owns its own processor with the dataset loaded, so it can be reused for any
+    number of files, and renderAll() runs one per core.
+*/
+class AutomelloOfflineRenderer
+{
+public:
+  //==============================================================================
+  struct Settings
+  {
+    Settings();
+
+    File datasetDirectory;
+    double sampleRate;
+    int blockSize;
+    double tailSeconds;     // how long to keep going after the last midi event
+    int bitsPerSample;
+    float reverbSend, reverbSize;
+  };
+
+  //==============================================================================
+  /** Creates a processor and loads the dataset into it. */
+  AutomelloOfflineRenderer( const Settings& settings );
+  ~AutomelloOfflineRenderer();
+
+  /** Renders a midi file into an audio file, whose format is chosen from its
+      file extension.
+
+      Returns an error message, or an empty string if it worked.
+  */
+  const String render( const File& midiFile, const File& outputFile );
+
+  /** Returns the total length of audio that this renderer has written. */
+  double getSecondsRendered() const noexcept      { return secondsRendered; }
+
+  //==============================================================================
+  /** Renders a list of midi files on several threads at once.
+
+      Each thread gets its own renderer, and they take the next file from the list
+      as they finish the previous one. outputFiles must be the same size as midiFiles.
+
+      Returns any error messages, and sets totalSecondsRendered to the length of all
+      the audio that got written.
+  */
+  static const StringArray renderAll( const Settings& settings,
+                                      const Array<File>& midiFiles,
+                                      const Array<File>& outputFiles,
+                                      int numThreads,
+                                      double& totalSecondsRendered );
+
+private:
+  //==============================================================================
+  Settings settings;
+  AutomelloPluginAudioProcessor processor;
+  AudioFormatManager formatManager;
+  AudioSampleBuffer buffer;
+  MidiBuffer midiBlock;
+  double secondsRendered;
+
+  JUCE_DECLARE_NON_COPYABLE (AutomelloOfflineRenderer);
+};
+
+
+#endif  // __OFFLINERENDERER_H_7D3A19C2__
@@ -14,21 +14,50 @@
 
 //==============================================================================
 AutomelloPluginAudioProcessor::AutomelloPluginAudioProcessor()
+  : reverbBus( 2, 1 ),
+    reverbSend( 0.0f ),
+    lastReverbSend( 0.0f ),
+    reverbSize( 0.5f ),
+    reverbIsRinging( false )
 {
   nVoices = 10;
   // Initialise the synth...
   for (int i = nVoices; --i >= 0;)
     synth.addVoice( new SamplerVoice() );
+
+  // WAV, AIFF, and (if they're enabled) FLAC and Ogg-Vorbis
+  formatManager.registerBasicFormats();
+
+  // Remember which format each sample file uses, so that reloading a
+  // directory doesn't have to probe every file again
+  formatManager.setHeaderCache( &headerCache );
+  ScopedPointer<XmlElement> cacheXml( XmlDocument::parse( getHeaderCacheFile() ) );
+  if (cacheXml != nullptr)
+    headerCache.restoreFromXml( *cacheXml );
+
+  // The reverb is used as a send effect, so it only needs to produce the wet signal
+  Reverb::Parameters reverbParameters;
+  reverbParameters.roomSize = reverbSize;
+  reverbParameters.dryLevel = 0.0f;
+  reverb.setParameters( reverbParameters );
 }
 
 AutomelloPluginAudioProcessor::~AutomelloPluginAudioProcessor()
 {
+  formatManager.setHeaderCache( nullptr );
+}
+
+File AutomelloPluginAudioProcessor::getHeaderCacheFile()
+{
+  return File::getSpecialLocation( File::userApplicationDataDirectory )
+           .getChildFile( "Automello" )
+           .getChildFile( "AudioFileHeaders.xml" );
 }
 
 void AutomelloPluginAudioProcessor::setDirectory( File directory )
 {
   synth.clearSounds();
-  DirectoryIterator directoryIterator( directory, false, "*.wav", File::findFiles );
+  DirectoryIterator directoryIterator( directory, false, "*", File::findFiles );
   while (directoryIterator.next())
   {
     File theFileItFound( directoryIterator.getFile() );
@@ -36,10 +65,11 @@ void AutomelloPluginAudioProcessor::setDirectory( File directory )
     int MIDINote = MIDINoteText.getIntValue();
     if (MIDINote >= 0 && MIDINote < 128)
     {
-      WavAudioFormat wavFormat;
-        
-      ScopedPointer<AudioFormatReader> audioReader( wavFormat.createReaderFor( new FileInputStream( theFileItFound ), true ) );
-      
+      ScopedPointer<AudioFormatReader> audioReader( formatManager.createReaderFor( theFileItFound ) );
+
+      if (audioReader == nullptr)
+        continue;
+
       BigInteger whichNote;
       whichNote.setRange( MIDINote, 1, true );
       
@@ -49,11 +79,27 @@ void AutomelloPluginAudioProcessor::setDirectory( File directory )
                                         MIDINote,   // root midi note
                                         0.01,  // attack time
                                         0.1,  // release time
-                                        10.0  // maximum sample length
+                                        10.0,  // maximum sample length
+                                        true   // keep the audio compressed in memory
                                         ));
 
     }
   }
+
+  // The cache file is shared by every instance of the plugin, so it's only rewritten
+  // when this dataset added something new, and is swapped in whole so that nobody
+  // else can read a half-written file
+  if (headerCache.hasChanged())
+  {
+    const File cacheFile( getHeaderCacheFile() );
+    ScopedPointer<XmlElement> cacheXml( headerCache.createXml() );
+    TemporaryFile tempFile( cacheFile );
+
+    if (cacheFile.getParentDirectory().createDirectory()
+         && cacheXml->writeToFile( tempFile.getFile(), String::empty )
+         && tempFile.overwriteTargetFileWithTemporary())
+      headerCache.clearChangedFlag();
+  }
 }
 
 //==============================================================================
@@ -64,26 +110,45 @@ const String AutomelloPluginAudioProcessor::getName() const
 
 int AutomelloPluginAudioProcessor::getNumParameters()
 {
-    return 0;
+    return totalNumParams;
 }
 
 float AutomelloPluginAudioProcessor::getParameter (int index)
 {
-    return 0.0f;
+  switch (index)
+  {
+    case reverbSendParam:   return reverbSend;
+    case reverbSizeParam:   return reverbSize;
+    default:                return 0.0f;
+  }
 }
 
 void AutomelloPluginAudioProcessor::setParameter (int index, float newValue)
 {
+  switch (index)
+  {
+    case reverbSendParam:   reverbSend = newValue; break;
+    case reverbSizeParam:   reverbSize = newValue; break;
+    default:                break;
+  }
 }
 
 const String AutomelloPluginAudioProcessor::getParameterName (int index)
 {
-    return String::empty;
+  switch (index)
+  {
+    case reverbSendParam:   return "Reverb Send";
+    case reverbSizeParam:   return "Reverb Size";
+    default:                return String::empty;
+  }
 }
 
 const String AutomelloPluginAudioProcessor::getParameterText (int index)
 {
-    return String::empty;
+  if (index >= 0 && index < totalNumParams)
+    return String( getParameter( index ), 2 );
+
+  return String::empty;
 }
 
 const String AutomelloPluginAudioProcessor::getInputChannelName (int channelIndex) const
@@ -153,6 +218,10 @@ void AutomelloPluginAudioProcessor::prepareToPlay (double sampleRate, int sample
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
   synth.setCurrentPlaybackSampleRate (sampleRate);
+
+  reverb.setSampleRate( sampleRate );
+  reverbBus.setSize( 2, samplesPerBlock );
+  reverbIsRinging = false;
 }
 
 void AutomelloPluginAudioProcessor::releaseResources()
@@ -161,6 +230,16 @@ void AutomelloPluginAudioProcessor::releaseResources()
     // spare memory, etc.
 }
 
+void AutomelloPluginAudioProcessor::reset()
+{
+  // Cut off any notes that are still sounding, and the reverb tail along with them.
+  // There's nothing left to ramp the send level from, so it can jump straight to its value.
+  synth.allNotesOff( 0, false );
+  reverb.reset();
+  reverbIsRinging = false;
+  lastReverbSend = reverbSend;
+}
+
 void AutomelloPluginAudioProcessor::processBlock (AudioSampleBuffer& buffer, MidiBuffer& midiMessages)
 {
     const int numSamples = buffer.getNumSamples();
@@ -176,6 +255,9 @@ void AutomelloPluginAudioProcessor::processBlock (AudioSampleBuffer& buffer, Mid
     }
 
     synth.renderNextBlock (buffer, midiMessages, 0, numSamples);
+
+  if (reverbSend > 0.0f || lastReverbSend > 0.0f || reverbIsRinging)
+    processReverbSend( buffer, numSamples );
   
     // In case we have more outputs than inputs, we'll clear any output
     // channels that didn't contain input data, (because these aren't
@@ -186,6 +268,45 @@ void AutomelloPluginAudioProcessor::processBlock (AudioSampleBuffer& buffer, Mid
     }
 }
 
+void AutomelloPluginAudioProcessor::processReverbSend( AudioSampleBuffer& buffer, int numSamples )
+{
+  const int numChannels = jmin( buffer.getNumChannels(), reverbBus.getNumChannels() );
+
+  if (numChannels <= 0)
+    return;
+
+  // (only happens if the host gives us a bigger block than it promised)
+  if (numSamples > reverbBus.getNumSamples())
+    reverbBus.setSize( reverbBus.getNumChannels(), numSamples, false, false, true );
+
+  // Parameter changes are applied here, so that the reverb can ramp them in over this block
+  const float newReverbSize = reverbSize;
+  if (reverb.getParameters().roomSize != newReverbSize)
+  {
+    Reverb::Parameters reverbParameters( reverb.getParameters() );
+    reverbParameters.roomSize = newReverbSize;
+    reverb.setParameters( reverbParameters );
+  }
+
+  const float newReverbSend = reverbSend;
+  float* channels[2];
+
+  for (int i = 0; i < numChannels; ++i)
+  {
+    reverbBus.copyFromWithRamp( i, 0, buffer.getSampleData( i ), numSamples, lastReverbSend, newReverbSend );
+    channels[i] = reverbBus.getSampleData( i );
+  }
+
+  lastReverbSend = newReverbSend;
+  reverb.processChannels( channels, numChannels, numSamples );
+
+  for (int i = 0; i < numChannels; ++i)
+    buffer.addFrom( i, 0, reverbBus, i, 0, numSamples );
+
+  // Keep running after the send has been turned down, until the tail has died away
+  reverbIsRinging = reverbBus.getMagnitude( 0, numSamples ) > 1.0e-5f;
+}
+
 //==============================================================================
 bool AutomelloPluginAudioProcessor::hasEditor() const
 {
@@ -203,12 +324,23 @@ void AutomelloPluginAudioProcessor::getStateInformation (MemoryBlock& destData)
     // You should use this method to store your parameters in the memory block.
     // You could do that either as raw data, or use the XML or ValueTree classes
     // as intermediaries to make it easy to save and load complex data.
+  XmlElement xml( "AUTOMELLOSETTINGS" );
+  xml.setAttribute( "reverbSend", reverbSend );
+  xml.setAttribute( "reverbSize", reverbSize );
+  copyXmlToBinary( xml, destData );
 }
 
 void AutomelloPluginAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
+  ScopedPointer<XmlElement> xmlState( getXmlFromBinary( data, sizeInBytes ) );
+
+  if (xmlState != nullptr && xmlState->hasTagName( "AUTOMELLOSETTINGS" ))
+  {
+    reverbSend = (float) xmlState->getDoubleAttribute( "reverbSend", reverbSend );
+    reverbSize = (float) xmlState->getDoubleAttribute( "reverbSize", reverbSize );
+  }
 }
 
 //==============================================================================
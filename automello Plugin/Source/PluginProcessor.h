@@ -28,6 +28,7 @@ public:
   //==============================================================================
   void prepareToPlay (double sampleRate, int samplesPerBlock);
   void releaseResources();
+  void reset();
 
   void processBlock (AudioSampleBuffer& buffer, MidiBuffer& midiMessages);
 
@@ -66,11 +67,31 @@ public:
   void setStateInformation (const void* data, int sizeInBytes);
   void setDirectory( File directory );
 
+  //==============================================================================
+  enum Parameters
+  {
+    reverbSendParam = 0,
+    reverbSizeParam,
+
+    totalNumParams
+  };
+
 private:
   //==============================================================================
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AutomelloPluginAudioProcessor);
   Synthesiser synth;
   unsigned int nVoices;
+  AudioFormatManager formatManager;
+  AudioFileHeaderCache headerCache;
+
+  // A single reverb on a send/return bus, shared by all the voices
+  Reverb reverb;
+  AudioSampleBuffer reverbBus;
+  float reverbSend, lastReverbSend, reverbSize;
+  bool reverbIsRinging;
+
+  static File getHeaderCacheFile();
+  void processReverbSend( AudioSampleBuffer& buffer, int numSamples );
 };
 
 
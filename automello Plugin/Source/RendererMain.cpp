@@ -0,0 +1,137 @@
+/*
+  ==============================================================================
+
+    RendererMain.cpp
+
+    automello-render: a command-line tool that renders midi files through the
+    plugin's sampler faster than real time, for previews and QA.
+
+  ==============================================================================
+*/
+
+#include "OfflineRenderer.h"
+#include <iostream>
+
+
+//==============================================================================
+static File findDataset( const String& nameOrPath )
+{
+  const File asPath( File::getCurrentWorkingDirectory().getChildFile( nameOrPath.unquoted() ) );
+
+  if (asPath.isDirectory())
+    return asPath;
+
+  // Otherwise look for it in the same place that the plugin's editor does
+  return File::getSpecialLocation( File::userApplicationDataDirectory )
+           .getChildFile( JucePlugin_Name )
+           .getChildFile( "Datasets" )
+           .getChildFile( nameOrPath );
+}
+
+static void addMidiFiles( const File& fileOrFolder, Array<File>& midiFiles )
+{
+  if (fileOrFolder.isDirectory())
+  {
+    DirectoryIterator directoryIterator( fileOrFolder, true, "*", File::findFiles );
+
+    while (directoryIterator.next())
+      if (directoryIterator.getFile().hasFileExtension( "mid;midi;smf" ))
+        midiFiles.add( directoryIterator.getFile() );
+  }
+  else
+  {
+    midiFiles.add( fileOrFolder );
+  }
+}
+
+static int printUsage()
+{
+  std::cout << " Usage: automello-render -dataset NameOrFolder [options] MidiFilesOrFolders...\n\n"
+               " Options:\n"
+               "   -out Folder     where to write the audio files (default: next to each midi file)\n"
+               "   -format ext     wav or aiff (default: wav)\n"
+               "   -rate Hz        sample rate (default: 44100)\n"
+               "   -bits n         bits per sample (default: 24)\n"
+               "   -block n        samples per processBlock call (default: 8192)\n"
+               "   -tail seconds   how long to keep rendering after the last event (default: 3)\n"
+               "   -send 0..1      reverb send level (default: 0)\n"
+               "   -size 0..1      reverb size (default: 0.5)\n"
+               "   -jobs n         how many files to render at once (default: one per core)\n\n";
+  return 1;
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+  ScopedJuceInitialiser_NonGUI juceInitialiser;
+
+  std::cout << "\n*** automello-render\n";
+
+  AutomelloOfflineRenderer::Settings settings;
+  Array<File> midiFiles;
+  File outputFolder;
+  String extension( ".wav" );
+  int numJobs = SystemStats::getNumCpus();
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const String arg( argv[i] );
+    const bool hasValue = (i + 1 < argc);
+    const String value( hasValue ? String( argv[i + 1] ) : String::empty );
+
+    if      (arg == "-dataset" && hasValue)   { settings.datasetDirectory = findDataset( value ); ++i; }
+    else if (arg == "-out" && hasValue)       { outputFolder = File::getCurrentWorkingDirectory().getChildFile( value.unquoted() ); ++i; }
+    else if (arg == "-format" && hasValue)    { extension = "." + value.trimCharactersAtStart( "." ); ++i; }
+    else if (arg == "-rate" && hasValue)      { settings.sampleRate = value.getDoubleValue(); ++i; }
+    else if (arg == "-bits" && hasValue)      { settings.bitsPerSample = value.getIntValue(); ++i; }
+    else if (arg == "-block" && hasValue)     { settings.blockSize = value.getIntValue(); ++i; }
+    else if (arg == "-tail" && hasValue)      { settings.tailSeconds = value.getDoubleValue(); ++i; }
+    else if (arg == "-send" && hasValue)      { settings.reverbSend = (float) value.getDoubleValue(); ++i; }
+    else if (arg == "-size" && hasValue)      { settings.reverbSize = (float) value.getDoubleValue(); ++i; }
+    else if (arg == "-jobs" && hasValue)      { numJobs = value.getIntValue(); ++i; }
+    else if (arg.startsWithChar( '-' ))       return printUsage();
+    else                                      addMidiFiles( File::getCurrentWorkingDirectory().getChildFile( arg.unquoted() ), midiFiles );
+  }
+
+  if (midiFiles.size() == 0 || settings.sampleRate <= 0 || settings.blockSize <= 0)
+    return printUsage();
+
+  if (! settings.datasetDirectory.isDirectory())
+  {
+    std::cout << " !! The dataset folder doesn't exist: " << settings.datasetDirectory.getFullPathName() << "\n\n";
+    return 1;
+  }
+
+  if (outputFolder != File::nonexistent && ! outputFolder.createDirectory())
+  {
+    std::cout << " !! Couldn't create the output folder: " << outputFolder.getFullPathName() << "\n\n";
+    return 1;
+  }
+
+  Array<File> outputFiles;
+
+  for (int i = 0; i < midiFiles.size(); ++i)
+  {
+    const File& midiFile = midiFiles.getReference( i );
+    const File folder( outputFolder != File::nonexistent ? outputFolder : midiFile.getParentDirectory() );
+    outputFiles.add( folder.getChildFile( midiFile.getFileNameWithoutExtension() + extension ) );
+  }
+
+  numJobs = jlimit( 1, midiFiles.size(), numJobs );
+  std::cout << " Rendering " << midiFiles.size() << " file(s) with " << settings.datasetDirectory.getFileName()
+            << ", " << numJobs << " at a time...\n";
+
+  const double startTime = Time::getMillisecondCounterHiRes();
+  double secondsRendered = 0.0;
+  const StringArray errors( AutomelloOfflineRenderer::renderAll( settings, midiFiles, outputFiles,
+                                                                 numJobs, secondsRendered ) );
+  const double secondsTaken = (Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+  for (int i = 0; i < errors.size(); ++i)
+    std::cout << " !! " << errors[i] << "\n";
+
+  std::cout << " Rendered " << String( secondsRendered, 1 ) << "s of audio in " << String( secondsTaken, 2 ) << "s ("
+            << String( secondsRendered / jmax( 0.001, secondsTaken ), 1 ) << "x real time)\n\n";
+
+  return errors.size() == 0 ? 0 : 1;
+}
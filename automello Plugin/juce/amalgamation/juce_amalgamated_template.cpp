@@ -109,6 +109,7 @@
  #include "../src/containers/juce_AbstractFifo.cpp"
  #include "../src/maths/juce_BigInteger.cpp"
  #include "../src/memory/juce_MemoryBlock.cpp"
+ #include "../src/memory/juce_ScopedAudioThreadAllocationCheck.cpp"
  #include "../src/containers/juce_PropertySet.cpp"
  #include "../src/text/juce_Identifier.cpp"
  #include "../src/containers/juce_Variant.cpp"
@@ -135,6 +136,7 @@
  #include "../src/io/streams/juce_FileInputSource.cpp"
  #include "../src/io/streams/juce_MemoryInputStream.cpp"
  #include "../src/io/streams/juce_MemoryOutputStream.cpp"
+ #include "../src/io/streams/juce_PrefetchingInputStream.cpp"
  #include "../src/io/streams/juce_SubregionStream.cpp"
  #include "../src/core/juce_PerformanceCounter.cpp"
  #include "../src/core/juce_Uuid.cpp"
@@ -169,6 +171,7 @@
  #include "../src/utilities/juce_UnitTest.cpp"
  #include "../src/utilities/juce_DeletedAtShutdown.cpp"
  #include "../src/audio/audio_file_formats/juce_AiffAudioFormat.cpp"
+ #include "../src/audio/audio_file_formats/juce_AudioFileHeaderCache.cpp"
  #include "../src/audio/audio_file_formats/juce_AudioFormat.cpp"
  #include "../src/audio/audio_file_formats/juce_AudioFormatReader.cpp"
  #include "../src/audio/audio_file_formats/juce_AudioFormatWriter.cpp"
@@ -192,12 +195,18 @@
  #include "../src/audio/devices/juce_AudioDeviceManager.cpp"
  #include "../src/audio/devices/juce_AudioIODevice.cpp"
  #include "../src/audio/devices/juce_AudioIODeviceType.cpp"
+ #include "../src/audio/devices/juce_FileAudioIODeviceType.cpp"
+ #include "../src/audio/dsp/juce_AudioBufferPool.cpp"
  #include "../src/audio/dsp/juce_AudioDataConverters.cpp"
  #include "../src/audio/dsp/juce_AudioSampleBuffer.cpp"
+ #include "../src/audio/dsp/juce_BiquadCascade.cpp"
+ #include "../src/audio/dsp/juce_CompressedAudioBuffer.cpp"
+ #include "../src/audio/dsp/juce_FloatVectorOperations.cpp"
  #include "../src/audio/dsp/juce_IIRFilter.cpp"
  #include "../src/audio/midi/juce_MidiOutput.cpp"
  #include "../src/audio/midi/juce_MidiBuffer.cpp"
  #include "../src/audio/midi/juce_MidiFile.cpp"
+ #include "../src/audio/midi/juce_MidiFileReader.cpp"
  #include "../src/audio/midi/juce_MidiKeyboardState.cpp"
  #include "../src/audio/midi/juce_MidiMessage.cpp"
  #include "../src/audio/midi/juce_MidiMessageCollector.cpp"
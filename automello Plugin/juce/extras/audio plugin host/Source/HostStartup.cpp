@@ -64,6 +64,13 @@ public:
         AudioPluginFormatManager::getInstance()->addDefaultFormats();
         AudioPluginFormatManager::getInstance()->addFormat (new InternalPluginFormat());
 
+        // if this process has been launched to scan some plugins, that's all it needs to do
+        if (PluginDirectoryScanner::handleScannerProcessCommandLine (commandLine))
+        {
+            JUCEApplication::quit();
+            return;
+        }
+
         mainWindow = new MainHostWindow();
         //mainWindow->setUsingNativeTitleBar (true);
 
@@ -41,9 +41,15 @@ public:
         const File deadMansPedalFile (ApplicationProperties::getInstance()->getUserSettings()
                                         ->getFile().getSiblingFile ("RecentlyCrashedPluginsList"));
 
-        setContentOwned (new PluginListComponent (knownPluginList,
-                                                  deadMansPedalFile,
-                                                  ApplicationProperties::getInstance()->getUserSettings()), true);
+        PluginListComponent* const pluginList
+            = new PluginListComponent (knownPluginList, deadMansPedalFile,
+                                       ApplicationProperties::getInstance()->getUserSettings());
+
+        // (scanning in other processes means that a bad plugin can't crash the host)
+        pluginList->setScanInChildProcesses (File::getSpecialLocation (File::currentExecutableFile),
+                                             SystemStats::getNumCpus(), 30000);
+
+        setContentOwned (pluginList, true);
 
         setResizable (true, false);
         setResizeLimits (300, 400, 800, 1500);
@@ -109,6 +115,10 @@ MainHostWindow::MainHostWindow()
         delete savedPluginList;
     }
 
+    // (this lets a rescan skip loading any plugin files that haven't changed)
+    knownPluginList.setScanCacheFile (ApplicationProperties::getInstance()->getUserSettings()
+                                        ->getFile().getSiblingFile ("PluginScanCache"));
+
     pluginSortMethod = (KnownPluginList::SortMethod) ApplicationProperties::getInstance()->getUserSettings()
                             ->getIntValue ("pluginSortMethod", KnownPluginList::sortByManufacturer);
 
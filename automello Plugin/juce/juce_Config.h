@@ -307,6 +307,16 @@
   #define JUCE_CATCH_UNHANDLED_EXCEPTIONS 1
 #endif
 
+/** JUCE_CHECK_AUDIO_THREAD_ALLOCATIONS: Makes any heap allocation that happens inside a
+    ScopedAudioThreadAllocationCheck trigger an assertion. The audio device callbacks and the
+    plugin wrappers are marked with these, so turning this on in a debug build is a good way
+    of proving that nothing in your rendering code allocates memory. This replaces the global
+    operator new and delete, so it's turned off by default.
+*/
+#ifndef JUCE_CHECK_AUDIO_THREAD_ALLOCATIONS
+  #define JUCE_CHECK_AUDIO_THREAD_ALLOCATIONS 0
+#endif
+
 //=============================================================================
 // If only building the core classes, we can explicitly turn off some features to avoid including them:
 #if JUCE_ONLY_BUILD_CORE_LIBRARY
@@ -239,6 +239,12 @@ namespace JuceDummyNamespace {}
   #error unknown compiler
 #endif
 
+#if JUCE_INTEL && ! defined (JUCE_USE_SSE_INTRINSICS) \
+	 && (defined (__SSE2__) || defined (__amd64__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2))
+  /** If defined, this indicates that SSE2 intrinsics can be used by the DSP code. */
+  #define JUCE_USE_SSE_INTRINSICS 1
+#endif
+
 #endif   // __JUCE_TARGETPLATFORM_JUCEHEADER__
 
 /*** End of inlined file: juce_TargetPlatform.h ***/
@@ -513,6 +519,16 @@ namespace JuceDummyNamespace {}
   #define JUCE_CATCH_UNHANDLED_EXCEPTIONS 1
 #endif
 
+/** JUCE_CHECK_AUDIO_THREAD_ALLOCATIONS: Makes any heap allocation that happens inside a
+	ScopedAudioThreadAllocationCheck trigger an assertion. The audio device callbacks and the
+	plugin wrappers are marked with these, so turning this on in a debug build is a good way
+	of proving that nothing in your rendering code allocates memory. This replaces the global
+	operator new and delete, so it's turned off by default.
+*/
+#ifndef JUCE_CHECK_AUDIO_THREAD_ALLOCATIONS
+  #define JUCE_CHECK_AUDIO_THREAD_ALLOCATIONS 0
+#endif
+
 // If only building the core classes, we can explicitly turn off some features to avoid including them:
 #if JUCE_ONLY_BUILD_CORE_LIBRARY
   #undef  JUCE_QUICKTIME
@@ -833,6 +849,10 @@ namespace JuceDummyNamespace {}
   #include <intrin.h>
 #endif
 
+#if JUCE_USE_SSE_INTRINSICS
+  #include <emmintrin.h>
+#endif
+
 #if JUCE_MAC || JUCE_IOS
   #include <libkern/OSAtomic.h>
 #endif
@@ -1379,6 +1399,33 @@ inline int roundFloatToInt (const float value) noexcept
  #define JUCE_UNDENORMALISE(x)
 #endif
 
+/**
+	Turns on the CPU's flush-to-zero and denormals-are-zero modes for as long as this
+	object exists, and restores the previous settings when it's deleted.
+
+	Create one of these on the stack around a section of DSP code that uses SSE
+	arithmetic, and denormalised values will be treated as zero by the hardware,
+	rather than having to be checked for with JUCE_UNDENORMALISE. On CPUs where SSE
+	isn't being used, it has no effect.
+*/
+class ScopedNoDenormals
+{
+public:
+   #if JUCE_USE_SSE_INTRINSICS
+	inline ScopedNoDenormals() noexcept   : oldMXCSR (_mm_getcsr())   { _mm_setcsr (oldMXCSR | 0x8040); }
+	inline ~ScopedNoDenormals() noexcept				   { _mm_setcsr (oldMXCSR); }
+   #else
+	inline ScopedNoDenormals() noexcept {}
+   #endif
+
+private:
+   #if JUCE_USE_SSE_INTRINSICS
+	const unsigned int oldMXCSR;
+   #endif
+
+	JUCE_DECLARE_NON_COPYABLE (ScopedNoDenormals);
+};
+
 /** This namespace contains a few template classes for helping work out class type variations.
 */
 namespace TypeHelpers
@@ -5897,6 +5944,58 @@ private:
 #ifndef __JUCE_HEAPBLOCK_JUCEHEADER__
 #define __JUCE_HEAPBLOCK_JUCEHEADER__
 
+
+/*** Start of inlined file: juce_ScopedAudioThreadAllocationCheck.h ***/
+#ifndef __JUCE_SCOPEDAUDIOTHREADALLOCATIONCHECK_JUCEHEADER__
+#define __JUCE_SCOPEDAUDIOTHREADALLOCATIONCHECK_JUCEHEADER__
+
+/**
+	Marks a section of code which mustn't allocate any memory.
+
+	If JUCE_CHECK_AUDIO_THREAD_ALLOCATIONS is enabled, then any heap allocation that's
+	made by a thread while one of these objects exists on its stack will trigger an
+	assertion. That covers everything that goes through a HeapBlock (which includes the
+	juce containers, Strings and AudioSampleBuffers), and anything created with operator new.
+
+	The AudioDeviceManager and the plugin wrappers create one of these around their
+	rendering callbacks, so turning on the flag in a debug build will show up any
+	allocations that your audio code makes. When the flag is off, this class does nothing.
+
+	@see AudioBufferPool
+*/
+class JUCE_API  ScopedAudioThreadAllocationCheck
+{
+public:
+   #if JUCE_CHECK_AUDIO_THREAD_ALLOCATIONS
+	/** Starts disallowing allocations on the calling thread. */
+	ScopedAudioThreadAllocationCheck() noexcept;
+
+	/** Destructor. */
+	~ScopedAudioThreadAllocationCheck() noexcept;
+
+	/** Returns true if the calling thread is currently inside one of these objects. */
+	static bool isActive() noexcept;
+
+	/** This is called by the allocators, and asserts if the calling thread isn't allowed
+		to allocate memory at the moment.
+	*/
+	static void checkAllocation() noexcept;
+   #else
+	ScopedAudioThreadAllocationCheck() noexcept	 {}
+	~ScopedAudioThreadAllocationCheck() noexcept	{}
+
+	static bool isActive() noexcept		 { return false; }
+	static void checkAllocation() noexcept	  {}
+   #endif
+
+private:
+	JUCE_DECLARE_NON_COPYABLE (ScopedAudioThreadAllocationCheck);
+};
+
+#endif   // __JUCE_SCOPEDAUDIOTHREADALLOCATIONCHECK_JUCEHEADER__
+
+/*** End of inlined file: juce_ScopedAudioThreadAllocationCheck.h ***/
+
 /**
 	Very simple container class to hold a pointer to some data on the heap.
 
@@ -5961,6 +6060,7 @@ public:
 	explicit HeapBlock (const size_t numElements)
 		: data (static_cast <ElementType*> (::malloc (numElements * sizeof (ElementType))))
 	{
+		ScopedAudioThreadAllocationCheck::checkAllocation();
 	}
 
 	/** Destructor.
@@ -6039,6 +6139,7 @@ public:
 	*/
 	void malloc (const size_t newNumElements, const size_t elementSize = sizeof (ElementType))
 	{
+		ScopedAudioThreadAllocationCheck::checkAllocation();
 		::free (data);
 		data = static_cast <ElementType*> (::malloc (newNumElements * elementSize));
 	}
@@ -6048,6 +6149,7 @@ public:
 	*/
 	void calloc (const size_t newNumElements, const size_t elementSize = sizeof (ElementType))
 	{
+		ScopedAudioThreadAllocationCheck::checkAllocation();
 		::free (data);
 		data = static_cast <ElementType*> (::calloc (newNumElements, elementSize));
 	}
@@ -6058,6 +6160,7 @@ public:
 	*/
 	void allocate (const size_t newNumElements, const bool initialiseToZero)
 	{
+		ScopedAudioThreadAllocationCheck::checkAllocation();
 		::free (data);
 
 		if (initialiseToZero)
@@ -6073,6 +6176,7 @@ public:
 	*/
 	void realloc (const size_t newNumElements, const size_t elementSize = sizeof (ElementType))
 	{
+		ScopedAudioThreadAllocationCheck::checkAllocation();
 		if (data == nullptr)
 			data = static_cast <ElementType*> (::malloc (newNumElements * elementSize));
 		else
@@ -17557,6 +17661,24 @@ JUCE_API void JUCE_CALLTYPE  initialiseJuce_GUI();
 */
 JUCE_API void JUCE_CALLTYPE  shutdownJuce_GUI();
 
+/** Initialises Juce's non-GUI classes.
+
+	If you're writing a command-line app that doesn't use the START_JUCE_APPLICATION
+	macro or any GUI classes, call this function before making any Juce calls.
+
+	@see shutdownJuce_NonGUI()
+*/
+JUCE_API void JUCE_CALLTYPE  initialiseJuce_NonGUI();
+
+/** Clears up any static data being used by Juce's non-GUI classes.
+
+	Call this at the end of a command-line app, so that any singletons and other
+	DeletedAtShutdown objects get deleted before the leak-detectors check for leaks.
+
+	@see initialiseJuce_NonGUI()
+*/
+JUCE_API void JUCE_CALLTYPE  shutdownJuce_NonGUI();
+
 /** A utility object that helps you initialise and shutdown Juce correctly
 	using an RAII pattern.
 
@@ -17580,6 +17702,29 @@ public:
 	~ScopedJuceInitialiser_GUI()	{ shutdownJuce_GUI(); }
 };
 
+/** A utility object that helps you initialise and shutdown Juce correctly
+	using an RAII pattern.
+
+	When an instance of this class is created, it calls initialiseJuce_NonGUI(),
+	and when it's deleted, it calls shutdownJuce_NonGUI(), which lets you easily
+	make sure that these functions are matched correctly.
+
+	This class is particularly handy to use at the beginning of a console app's
+	main() function, because it'll take care of shutting down whenever you return
+	from the main() call.
+
+	@see ScopedJuceInitialiser_GUI
+*/
+class ScopedJuceInitialiser_NonGUI
+{
+public:
+	/** The constructor simply calls initialiseJuce_NonGUI(). */
+	ScopedJuceInitialiser_NonGUI()	  { initialiseJuce_NonGUI(); }
+
+	/** The destructor simply calls shutdownJuce_NonGUI(). */
+	~ScopedJuceInitialiser_NonGUI()	 { shutdownJuce_NonGUI(); }
+};
+
 /*
 	To start a JUCE app, use this macro: START_JUCE_APPLICATION (AppSubClass) where
 	AppSubClass is the name of a class derived from JUCEApplication.
@@ -21257,6 +21402,566 @@ OutputStream& JUCE_CALLTYPE operator<< (OutputStream& stream, const MemoryOutput
 #endif
 #ifndef __JUCE_OUTPUTSTREAM_JUCEHEADER__
 
+#endif
+#ifndef __JUCE_PREFETCHINGINPUTSTREAM_JUCEHEADER__
+
+/*** Start of inlined file: juce_PrefetchingInputStream.h ***/
+#ifndef __JUCE_PREFETCHINGINPUTSTREAM_JUCEHEADER__
+#define __JUCE_PREFETCHINGINPUTSTREAM_JUCEHEADER__
+
+
+/*** Start of inlined file: juce_TimeSliceThread.h ***/
+#ifndef __JUCE_TIMESLICETHREAD_JUCEHEADER__
+#define __JUCE_TIMESLICETHREAD_JUCEHEADER__
+
+
+/*** Start of inlined file: juce_Thread.h ***/
+#ifndef __JUCE_THREAD_JUCEHEADER__
+#define __JUCE_THREAD_JUCEHEADER__
+
+
+/*** Start of inlined file: juce_WaitableEvent.h ***/
+#ifndef __JUCE_WAITABLEEVENT_JUCEHEADER__
+#define __JUCE_WAITABLEEVENT_JUCEHEADER__
+
+/**
+	Allows threads to wait for events triggered by other threads.
+
+	A thread can call wait() on a WaitableObject, and this will suspend the
+	calling thread until another thread wakes it up by calling the signal()
+	method.
+*/
+class JUCE_API  WaitableEvent
+{
+public:
+
+	/** Creates a WaitableEvent object.
+
+		@param manualReset  If this is false, the event will be reset automatically when the wait()
+							method is called. If manualReset is true, then once the event is signalled,
+							the only way to reset it will be by calling the reset() method.
+	*/
+	WaitableEvent (bool manualReset = false) noexcept;
+
+	/** Destructor.
+
+		If other threads are waiting on this object when it gets deleted, this
+		can cause nasty errors, so be careful!
+	*/
+	~WaitableEvent() noexcept;
+
+	/** Suspends the calling thread until the event has been signalled.
+
+		This will wait until the object's signal() method is called by another thread,
+		or until the timeout expires.
+
+		After the event has been signalled, this method will return true and if manualReset
+		was set to false in the WaitableEvent's constructor, then the event will be reset.
+
+		@param timeOutMilliseconds  the maximum time to wait, in milliseconds. A negative
+									value will cause it to wait forever.
+
+		@returns	true if the object has been signalled, false if the timeout expires first.
+		@see signal, reset
+	*/
+	bool wait (int timeOutMilliseconds = -1) const noexcept;
+
+	/** Wakes up any threads that are currently waiting on this object.
+
+		If signal() is called when nothing is waiting, the next thread to call wait()
+		will return immediately and reset the signal.
+
+		If the WaitableEvent is manual reset, all current and future threads that wait upon this
+		object will be woken, until reset() is explicitly called.
+
+		If the WaitableEvent is automatic reset, and one or more threads is waiting upon the object,
+		then one of them will be woken up. If no threads are currently waiting, then the next thread
+		to call wait() will be woken up. As soon as a thread is woken, the signal is automatically
+		reset.
+
+		@see wait, reset
+	*/
+	void signal() const noexcept;
+
+	/** Resets the event to an unsignalled state.
+
+		If it's not already signalled, this does nothing.
+	*/
+	void reset() const noexcept;
+
+private:
+
+	void* internal;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaitableEvent);
+};
+
+#endif   // __JUCE_WAITABLEEVENT_JUCEHEADER__
+
+/*** End of inlined file: juce_WaitableEvent.h ***/
+
+/**
+	Encapsulates a thread.
+
+	Subclasses derive from Thread and implement the run() method, in which they
+	do their business. The thread can then be started with the startThread() method
+	and controlled with various other methods.
+
+	This class also contains some thread-related static methods, such
+	as sleep(), yield(), getCurrentThreadId() etc.
+
+	@see CriticalSection, WaitableEvent, Process, ThreadWithProgressWindow,
+		 MessageManagerLock
+*/
+class JUCE_API  Thread
+{
+public:
+
+	/**
+		Creates a thread.
+
+		When first created, the thread is not running. Use the startThread()
+		method to start it.
+	*/
+	explicit Thread (const String& threadName);
+
+	/** Destructor.
+
+		Deleting a Thread object that is running will only give the thread a
+		brief opportunity to stop itself cleanly, so it's recommended that you
+		should always call stopThread() with a decent timeout before deleting,
+		to avoid the thread being forcibly killed (which is a Bad Thing).
+	*/
+	virtual ~Thread();
+
+	/** Must be implemented to perform the thread's actual code.
+
+		Remember that the thread must regularly check the threadShouldExit()
+		method whilst running, and if this returns true it should return from
+		the run() method as soon as possible to avoid being forcibly killed.
+
+		@see threadShouldExit, startThread
+	*/
+	virtual void run() = 0;
+
+	// Thread control functions..
+
+	/** Starts the thread running.
+
+		This will start the thread's run() method.
+		(if it's already started, startThread() won't do anything).
+
+		@see stopThread
+	*/
+	void startThread();
+
+	/** Starts the thread with a given priority.
+
+		Launches the thread with a given priority, where 0 = lowest, 10 = highest.
+		If the thread is already running, its priority will be changed.
+
+		@see startThread, setPriority
+	*/
+	void startThread (int priority);
+
+	/** Attempts to stop the thread running.
+
+		This method will cause the threadShouldExit() method to return true
+		and call notify() in case the thread is currently waiting.
+
+		Hopefully the thread will then respond to this by exiting cleanly, and
+		the stopThread method will wait for a given time-period for this to
+		happen.
+
+		If the thread is stuck and fails to respond after the time-out, it gets
+		forcibly killed, which is a very bad thing to happen, as it could still
+		be holding locks, etc. which are needed by other parts of your program.
+
+		@param timeOutMilliseconds  The number of milliseconds to wait for the
+									thread to finish before killing it by force. A negative
+									value in here will wait forever.
+		@see signalThreadShouldExit, threadShouldExit, waitForThreadToExit, isThreadRunning
+	*/
+	void stopThread (int timeOutMilliseconds);
+
+	/** Returns true if the thread is currently active */
+	bool isThreadRunning() const;
+
+	/** Sets a flag to tell the thread it should stop.
+
+		Calling this means that the threadShouldExit() method will then return true.
+		The thread should be regularly checking this to see whether it should exit.
+
+		If your thread makes use of wait(), you might want to call notify() after calling
+		this method, to interrupt any waits that might be in progress, and allow it
+		to reach a point where it can exit.
+
+		@see threadShouldExit
+		@see waitForThreadToExit
+	*/
+	void signalThreadShouldExit();
+
+	/** Checks whether the thread has been told to stop running.
+
+		Threads need to check this regularly, and if it returns true, they should
+		return from their run() method at the first possible opportunity.
+
+		@see signalThreadShouldExit
+	*/
+	inline bool threadShouldExit() const		{ return threadShouldExit_; }
+
+	/** Waits for the thread to stop.
+
+		This will waits until isThreadRunning() is false or until a timeout expires.
+
+		@param timeOutMilliseconds  the time to wait, in milliseconds. If this value
+									is less than zero, it will wait forever.
+		@returns	true if the thread exits, or false if the timeout expires first.
+	*/
+	bool waitForThreadToExit (int timeOutMilliseconds) const;
+
+	/** Changes the thread's priority.
+		May return false if for some reason the priority can't be changed.
+
+		@param priority	 the new priority, in the range 0 (lowest) to 10 (highest). A priority
+							of 5 is normal.
+	*/
+	bool setPriority (int priority);
+
+	/** Changes the priority of the caller thread.
+
+		Similar to setPriority(), but this static method acts on the caller thread.
+		May return false if for some reason the priority can't be changed.
+
+		@see setPriority
+	*/
+	static bool setCurrentThreadPriority (int priority);
+
+	/** Sets the affinity mask for the thread.
+
+		This will only have an effect next time the thread is started - i.e. if the
+		thread is already running when called, it'll have no effect.
+
+		@see setCurrentThreadAffinityMask
+	*/
+	void setAffinityMask (uint32 affinityMask);
+
+	/** Changes the affinity mask for the caller thread.
+
+		This will change the affinity mask for the thread that calls this static method.
+
+		@see setAffinityMask
+	*/
+	static void setCurrentThreadAffinityMask (uint32 affinityMask);
+
+	// this can be called from any thread that needs to pause..
+	static void JUCE_CALLTYPE sleep (int milliseconds);
+
+	/** Yields the calling thread's current time-slot. */
+	static void JUCE_CALLTYPE yield();
+
+	/** Makes the thread wait for a notification.
+
+		This puts the thread to sleep until either the timeout period expires, or
+		another thread calls the notify() method to wake it up.
+
+		A negative time-out value means that the method will wait indefinitely.
+
+		@returns	true if the event has been signalled, false if the timeout expires.
+	*/
+	bool wait (int timeOutMilliseconds) const;
+
+	/** Wakes up the thread.
+
+		If the thread has called the wait() method, this will wake it up.
+
+		@see wait
+	*/
+	void notify() const;
+
+	/** A value type used for thread IDs.
+		@see getCurrentThreadId(), getThreadId()
+	*/
+	typedef void* ThreadID;
+
+	/** Returns an id that identifies the caller thread.
+
+		To find the ID of a particular thread object, use getThreadId().
+
+		@returns	a unique identifier that identifies the calling thread.
+		@see getThreadId
+	*/
+	static ThreadID getCurrentThreadId();
+
+	/** Finds the thread object that is currently running.
+
+		Note that the main UI thread (or other non-Juce threads) don't have a Thread
+		object associated with them, so this will return 0.
+	*/
+	static Thread* getCurrentThread();
+
+	/** Returns the ID of this thread.
+
+		That means the ID of this thread object - not of the thread that's calling the method.
+
+		This can change when the thread is started and stopped, and will be invalid if the
+		thread's not actually running.
+
+		@see getCurrentThreadId
+	*/
+	ThreadID getThreadId() const noexcept			   { return threadId_; }
+
+	/** Returns the name of the thread.
+
+		This is the name that gets set in the constructor.
+	*/
+	const String& getThreadName() const				 { return threadName_; }
+
+	/** Changes the name of the caller thread.
+		Different OSes may place different length or content limits on this name.
+	*/
+	static void setCurrentThreadName (const String& newThreadName);
+
+	/** Returns the number of currently-running threads.
+
+		@returns  the number of Thread objects known to be currently running.
+		@see stopAllThreads
+	*/
+	static int getNumRunningThreads();
+
+	/** Tries to stop all currently-running threads.
+
+		This will attempt to stop all the threads known to be running at the moment.
+	*/
+	static void stopAllThreads (int timeoutInMillisecs);
+
+private:
+
+	const String threadName_;
+	void* volatile threadHandle_;
+	ThreadID threadId_;
+	CriticalSection startStopLock;
+	WaitableEvent startSuspensionEvent_, defaultEvent_;
+	int threadPriority_;
+	uint32 affinityMask_;
+	bool volatile threadShouldExit_;
+
+   #ifndef DOXYGEN
+	friend class MessageManager;
+	friend void JUCE_API juce_threadEntryPoint (void*);
+   #endif
+
+	void launchThread();
+	void closeThreadHandle();
+	void killThread();
+	void threadEntryPoint();
+	static bool setThreadPriority (void* handle, int priority);
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Thread);
+};
+
+#endif   // __JUCE_THREAD_JUCEHEADER__
+
+/*** End of inlined file: juce_Thread.h ***/
+
+class TimeSliceThread;
+
+/**
+	Used by the TimeSliceThread class.
+
+	To register your class with a TimeSliceThread, derive from this class and
+	use the TimeSliceThread::addTimeSliceClient() method to add it to the list.
+
+	Make sure you always call TimeSliceThread::removeTimeSliceClient() before
+	deleting your client!
+
+	@see TimeSliceThread
+*/
+class JUCE_API  TimeSliceClient
+{
+public:
+	/** Destructor. */
+	virtual ~TimeSliceClient()   {}
+
+	/** Called back by a TimeSliceThread.
+
+		When you register this class with it, a TimeSliceThread will repeatedly call
+		this method.
+
+		The implementation of this method should use its time-slice to do something that's
+		quick - never block for longer than absolutely necessary.
+
+		@returns	Your method should return the number of milliseconds which it would like to wait before being called
+					again. Returning 0 will make the thread call again as soon as possible (after possibly servicing
+					other busy clients). If you return a value below zero, your client will be removed from the list of clients,
+					and won't be called again. The value you specify isn't a guaranteee, and is only used as a hint by the
+					thread - the actual time before the next callback may be more or less than specified.
+					You can force the TimeSliceThread to wake up and poll again immediately by calling its notify() method.
+	*/
+	virtual int useTimeSlice() = 0;
+
+private:
+	friend class TimeSliceThread;
+	Time nextCallTime;
+};
+
+/**
+	A thread that keeps a list of clients, and calls each one in turn, giving them
+	all a chance to run some sort of short task.
+
+	@see TimeSliceClient, Thread
+*/
+class JUCE_API  TimeSliceThread   : public Thread
+{
+public:
+
+	/**
+		Creates a TimeSliceThread.
+
+		When first created, the thread is not running. Use the startThread()
+		method to start it.
+	*/
+	explicit TimeSliceThread (const String& threadName);
+
+	/** Destructor.
+
+		Deleting a Thread object that is running will only give the thread a
+		brief opportunity to stop itself cleanly, so it's recommended that you
+		should always call stopThread() with a decent timeout before deleting,
+		to avoid the thread being forcibly killed (which is a Bad Thing).
+	*/
+	~TimeSliceThread();
+
+	/** Adds a client to the list.
+
+		The client's callbacks will start after the number of milliseconds specified
+		by millisecondsBeforeStarting (and this may happen before this method has returned).
+	*/
+	void addTimeSliceClient (TimeSliceClient* client, int millisecondsBeforeStarting = 0);
+
+	/** Removes a client from the list.
+
+		This method will make sure that all callbacks to the client have completely
+		finished before the method returns.
+	*/
+	void removeTimeSliceClient (TimeSliceClient* client);
+
+	/** If the given client is waiting in the queue, it will be moved to the front
+		and given a time-slice as soon as possible.
+
+		Returns false if the client isn't registered with this thread.
+	*/
+	bool moveToFrontOfQueue (TimeSliceClient* client);
+
+	/** Returns the number of registered clients. */
+	int getNumClients() const;
+
+	/** Returns one of the registered clients. */
+	TimeSliceClient* getClient (int index) const;
+
+   #ifndef DOXYGEN
+	void run();
+   #endif
+
+private:
+	CriticalSection callbackLock, listLock;
+	Array <TimeSliceClient*> clients;
+	TimeSliceClient* clientBeingCalled;
+
+	TimeSliceClient* getNextClient (int index) const;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TimeSliceThread);
+};
+
+#endif   // __JUCE_TIMESLICETHREAD_JUCEHEADER__
+
+/*** End of inlined file: juce_TimeSliceThread.h ***/
+
+/** Wraps another input stream, and uses a background thread to read ahead of
+	the current position.
+
+	A BufferedInputStream only goes back to its source when its buffer runs dry,
+	so anything that reads a file sequentially (e.g. an audio decoder) has to sit
+	and wait for each refill. This class keeps a set of buffers covering the region
+	just beyond the current read position, and uses a TimeSliceThread to fill them
+	in while the caller is busy with the data it has already got.
+
+	Reads that land in a block which hasn't been fetched yet (e.g. after a seek)
+	are serviced immediately on the caller's thread, and the background thread then
+	carries on prefetching from the new position.
+
+	@see BufferedInputStream, TimeSliceThread
+*/
+class JUCE_API  PrefetchingInputStream  : public InputStream,
+										  private TimeSliceClient
+{
+public:
+
+	/** Creates a PrefetchingInputStream.
+
+		@param sourceStream		 the source stream to read from
+		@param deleteSourceWhenDestroyed	whether the sourceStream that is passed in should be
+											deleted by this object when it is itself deleted.
+		@param backgroundThread		 the thread that should be used to read ahead. This
+											must be started by the caller, and must not be deleted
+											until this object has been destroyed. It can be shared
+											between any number of streams.
+		@param bufferSize		   the size of each of the blocks that are read from the
+											source
+		@param numBuffersToPrefetch	 how many blocks beyond the current position should be
+											kept filled (the minimum is 2)
+	*/
+	PrefetchingInputStream (InputStream* sourceStream,
+							bool deleteSourceWhenDestroyed,
+							TimeSliceThread& backgroundThread,
+							int bufferSize = 65536,
+							int numBuffersToPrefetch = 4);
+
+	/** Destructor.
+
+		This may also delete the source stream, if that option was chosen when the
+		stream was created.
+	*/
+	~PrefetchingInputStream();
+
+	int64 getTotalLength();
+	int64 getPosition();
+	bool setPosition (int64 newPosition);
+	int read (void* destBuffer, int maxBytesToRead);
+	bool isExhausted();
+
+private:
+
+	struct Block
+	{
+		HeapBlock <char> data;
+		int64 start;
+		int numBytes;
+	};
+
+	OptionalScopedPointer<InputStream> source;
+	TimeSliceThread& thread;
+	const int bufferSize;
+	const int64 totalLength;
+	int64 position, lastBlockRequested;
+	OwnedArray <Block> blocks;
+	CriticalSection sourceLock, blockLock;
+
+	int64 getBlockStart (int64 pos) const noexcept	  { return pos - (pos % bufferSize); }
+	Block* findBlock (int64 start) const noexcept;
+	Block* findBlockToReuse() const noexcept;
+	int64 findNextBlockToPrefetch() const noexcept;
+	void fillBlock (int64 start);
+	int useTimeSlice();
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PrefetchingInputStream);
+};
+
+#endif   // __JUCE_PREFETCHINGINPUTSTREAM_JUCEHEADER__
+
+/*** End of inlined file: juce_PrefetchingInputStream.h ***/
+
+
 #endif
 #ifndef __JUCE_SUBREGIONSTREAM_JUCEHEADER__
 
@@ -21710,6 +22415,9 @@ private:
 #endif
 #ifndef __JUCE_REFERENCECOUNTEDOBJECT_JUCEHEADER__
 
+#endif
+#ifndef __JUCE_SCOPEDAUDIOTHREADALLOCATIONCHECK_JUCEHEADER__
+
 #endif
 #ifndef __JUCE_SCOPEDPOINTER_JUCEHEADER__
 
@@ -22666,356 +23374,6 @@ private:
 
 /*** End of inlined file: juce_SpinLock.h ***/
 
-
-/*** Start of inlined file: juce_WaitableEvent.h ***/
-#ifndef __JUCE_WAITABLEEVENT_JUCEHEADER__
-#define __JUCE_WAITABLEEVENT_JUCEHEADER__
-
-/**
-	Allows threads to wait for events triggered by other threads.
-
-	A thread can call wait() on a WaitableObject, and this will suspend the
-	calling thread until another thread wakes it up by calling the signal()
-	method.
-*/
-class JUCE_API  WaitableEvent
-{
-public:
-
-	/** Creates a WaitableEvent object.
-
-		@param manualReset  If this is false, the event will be reset automatically when the wait()
-							method is called. If manualReset is true, then once the event is signalled,
-							the only way to reset it will be by calling the reset() method.
-	*/
-	WaitableEvent (bool manualReset = false) noexcept;
-
-	/** Destructor.
-
-		If other threads are waiting on this object when it gets deleted, this
-		can cause nasty errors, so be careful!
-	*/
-	~WaitableEvent() noexcept;
-
-	/** Suspends the calling thread until the event has been signalled.
-
-		This will wait until the object's signal() method is called by another thread,
-		or until the timeout expires.
-
-		After the event has been signalled, this method will return true and if manualReset
-		was set to false in the WaitableEvent's constructor, then the event will be reset.
-
-		@param timeOutMilliseconds  the maximum time to wait, in milliseconds. A negative
-									value will cause it to wait forever.
-
-		@returns	true if the object has been signalled, false if the timeout expires first.
-		@see signal, reset
-	*/
-	bool wait (int timeOutMilliseconds = -1) const noexcept;
-
-	/** Wakes up any threads that are currently waiting on this object.
-
-		If signal() is called when nothing is waiting, the next thread to call wait()
-		will return immediately and reset the signal.
-
-		If the WaitableEvent is manual reset, all current and future threads that wait upon this
-		object will be woken, until reset() is explicitly called.
-
-		If the WaitableEvent is automatic reset, and one or more threads is waiting upon the object,
-		then one of them will be woken up. If no threads are currently waiting, then the next thread
-		to call wait() will be woken up. As soon as a thread is woken, the signal is automatically
-		reset.
-
-		@see wait, reset
-	*/
-	void signal() const noexcept;
-
-	/** Resets the event to an unsignalled state.
-
-		If it's not already signalled, this does nothing.
-	*/
-	void reset() const noexcept;
-
-private:
-
-	void* internal;
-
-	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WaitableEvent);
-};
-
-#endif   // __JUCE_WAITABLEEVENT_JUCEHEADER__
-
-/*** End of inlined file: juce_WaitableEvent.h ***/
-
-
-/*** Start of inlined file: juce_Thread.h ***/
-#ifndef __JUCE_THREAD_JUCEHEADER__
-#define __JUCE_THREAD_JUCEHEADER__
-
-/**
-	Encapsulates a thread.
-
-	Subclasses derive from Thread and implement the run() method, in which they
-	do their business. The thread can then be started with the startThread() method
-	and controlled with various other methods.
-
-	This class also contains some thread-related static methods, such
-	as sleep(), yield(), getCurrentThreadId() etc.
-
-	@see CriticalSection, WaitableEvent, Process, ThreadWithProgressWindow,
-		 MessageManagerLock
-*/
-class JUCE_API  Thread
-{
-public:
-
-	/**
-		Creates a thread.
-
-		When first created, the thread is not running. Use the startThread()
-		method to start it.
-	*/
-	explicit Thread (const String& threadName);
-
-	/** Destructor.
-
-		Deleting a Thread object that is running will only give the thread a
-		brief opportunity to stop itself cleanly, so it's recommended that you
-		should always call stopThread() with a decent timeout before deleting,
-		to avoid the thread being forcibly killed (which is a Bad Thing).
-	*/
-	virtual ~Thread();
-
-	/** Must be implemented to perform the thread's actual code.
-
-		Remember that the thread must regularly check the threadShouldExit()
-		method whilst running, and if this returns true it should return from
-		the run() method as soon as possible to avoid being forcibly killed.
-
-		@see threadShouldExit, startThread
-	*/
-	virtual void run() = 0;
-
-	// Thread control functions..
-
-	/** Starts the thread running.
-
-		This will start the thread's run() method.
-		(if it's already started, startThread() won't do anything).
-
-		@see stopThread
-	*/
-	void startThread();
-
-	/** Starts the thread with a given priority.
-
-		Launches the thread with a given priority, where 0 = lowest, 10 = highest.
-		If the thread is already running, its priority will be changed.
-
-		@see startThread, setPriority
-	*/
-	void startThread (int priority);
-
-	/** Attempts to stop the thread running.
-
-		This method will cause the threadShouldExit() method to return true
-		and call notify() in case the thread is currently waiting.
-
-		Hopefully the thread will then respond to this by exiting cleanly, and
-		the stopThread method will wait for a given time-period for this to
-		happen.
-
-		If the thread is stuck and fails to respond after the time-out, it gets
-		forcibly killed, which is a very bad thing to happen, as it could still
-		be holding locks, etc. which are needed by other parts of your program.
-
-		@param timeOutMilliseconds  The number of milliseconds to wait for the
-									thread to finish before killing it by force. A negative
-									value in here will wait forever.
-		@see signalThreadShouldExit, threadShouldExit, waitForThreadToExit, isThreadRunning
-	*/
-	void stopThread (int timeOutMilliseconds);
-
-	/** Returns true if the thread is currently active */
-	bool isThreadRunning() const;
-
-	/** Sets a flag to tell the thread it should stop.
-
-		Calling this means that the threadShouldExit() method will then return true.
-		The thread should be regularly checking this to see whether it should exit.
-
-		If your thread makes use of wait(), you might want to call notify() after calling
-		this method, to interrupt any waits that might be in progress, and allow it
-		to reach a point where it can exit.
-
-		@see threadShouldExit
-		@see waitForThreadToExit
-	*/
-	void signalThreadShouldExit();
-
-	/** Checks whether the thread has been told to stop running.
-
-		Threads need to check this regularly, and if it returns true, they should
-		return from their run() method at the first possible opportunity.
-
-		@see signalThreadShouldExit
-	*/
-	inline bool threadShouldExit() const		{ return threadShouldExit_; }
-
-	/** Waits for the thread to stop.
-
-		This will waits until isThreadRunning() is false or until a timeout expires.
-
-		@param timeOutMilliseconds  the time to wait, in milliseconds. If this value
-									is less than zero, it will wait forever.
-		@returns	true if the thread exits, or false if the timeout expires first.
-	*/
-	bool waitForThreadToExit (int timeOutMilliseconds) const;
-
-	/** Changes the thread's priority.
-		May return false if for some reason the priority can't be changed.
-
-		@param priority	 the new priority, in the range 0 (lowest) to 10 (highest). A priority
-							of 5 is normal.
-	*/
-	bool setPriority (int priority);
-
-	/** Changes the priority of the caller thread.
-
-		Similar to setPriority(), but this static method acts on the caller thread.
-		May return false if for some reason the priority can't be changed.
-
-		@see setPriority
-	*/
-	static bool setCurrentThreadPriority (int priority);
-
-	/** Sets the affinity mask for the thread.
-
-		This will only have an effect next time the thread is started - i.e. if the
-		thread is already running when called, it'll have no effect.
-
-		@see setCurrentThreadAffinityMask
-	*/
-	void setAffinityMask (uint32 affinityMask);
-
-	/** Changes the affinity mask for the caller thread.
-
-		This will change the affinity mask for the thread that calls this static method.
-
-		@see setAffinityMask
-	*/
-	static void setCurrentThreadAffinityMask (uint32 affinityMask);
-
-	// this can be called from any thread that needs to pause..
-	static void JUCE_CALLTYPE sleep (int milliseconds);
-
-	/** Yields the calling thread's current time-slot. */
-	static void JUCE_CALLTYPE yield();
-
-	/** Makes the thread wait for a notification.
-
-		This puts the thread to sleep until either the timeout period expires, or
-		another thread calls the notify() method to wake it up.
-
-		A negative time-out value means that the method will wait indefinitely.
-
-		@returns	true if the event has been signalled, false if the timeout expires.
-	*/
-	bool wait (int timeOutMilliseconds) const;
-
-	/** Wakes up the thread.
-
-		If the thread has called the wait() method, this will wake it up.
-
-		@see wait
-	*/
-	void notify() const;
-
-	/** A value type used for thread IDs.
-		@see getCurrentThreadId(), getThreadId()
-	*/
-	typedef void* ThreadID;
-
-	/** Returns an id that identifies the caller thread.
-
-		To find the ID of a particular thread object, use getThreadId().
-
-		@returns	a unique identifier that identifies the calling thread.
-		@see getThreadId
-	*/
-	static ThreadID getCurrentThreadId();
-
-	/** Finds the thread object that is currently running.
-
-		Note that the main UI thread (or other non-Juce threads) don't have a Thread
-		object associated with them, so this will return 0.
-	*/
-	static Thread* getCurrentThread();
-
-	/** Returns the ID of this thread.
-
-		That means the ID of this thread object - not of the thread that's calling the method.
-
-		This can change when the thread is started and stopped, and will be invalid if the
-		thread's not actually running.
-
-		@see getCurrentThreadId
-	*/
-	ThreadID getThreadId() const noexcept			   { return threadId_; }
-
-	/** Returns the name of the thread.
-
-		This is the name that gets set in the constructor.
-	*/
-	const String& getThreadName() const				 { return threadName_; }
-
-	/** Changes the name of the caller thread.
-		Different OSes may place different length or content limits on this name.
-	*/
-	static void setCurrentThreadName (const String& newThreadName);
-
-	/** Returns the number of currently-running threads.
-
-		@returns  the number of Thread objects known to be currently running.
-		@see stopAllThreads
-	*/
-	static int getNumRunningThreads();
-
-	/** Tries to stop all currently-running threads.
-
-		This will attempt to stop all the threads known to be running at the moment.
-	*/
-	static void stopAllThreads (int timeoutInMillisecs);
-
-private:
-
-	const String threadName_;
-	void* volatile threadHandle_;
-	ThreadID threadId_;
-	CriticalSection startStopLock;
-	WaitableEvent startSuspensionEvent_, defaultEvent_;
-	int threadPriority_;
-	uint32 affinityMask_;
-	bool volatile threadShouldExit_;
-
-   #ifndef DOXYGEN
-	friend class MessageManager;
-	friend void JUCE_API juce_threadEntryPoint (void*);
-   #endif
-
-	void launchThread();
-	void closeThreadHandle();
-	void killThread();
-	void threadEntryPoint();
-	static bool setThreadPriority (void* handle, int priority);
-
-	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Thread);
-};
-
-#endif   // __JUCE_THREAD_JUCEHEADER__
-
-/*** End of inlined file: juce_Thread.h ***/
-
 /**
 	A critical section that allows multiple simultaneous readers.
 
@@ -23541,117 +23899,6 @@ private:
 #endif
 #ifndef __JUCE_TIMESLICETHREAD_JUCEHEADER__
 
-/*** Start of inlined file: juce_TimeSliceThread.h ***/
-#ifndef __JUCE_TIMESLICETHREAD_JUCEHEADER__
-#define __JUCE_TIMESLICETHREAD_JUCEHEADER__
-
-class TimeSliceThread;
-
-/**
-	Used by the TimeSliceThread class.
-
-	To register your class with a TimeSliceThread, derive from this class and
-	use the TimeSliceThread::addTimeSliceClient() method to add it to the list.
-
-	Make sure you always call TimeSliceThread::removeTimeSliceClient() before
-	deleting your client!
-
-	@see TimeSliceThread
-*/
-class JUCE_API  TimeSliceClient
-{
-public:
-	/** Destructor. */
-	virtual ~TimeSliceClient()   {}
-
-	/** Called back by a TimeSliceThread.
-
-		When you register this class with it, a TimeSliceThread will repeatedly call
-		this method.
-
-		The implementation of this method should use its time-slice to do something that's
-		quick - never block for longer than absolutely necessary.
-
-		@returns	Your method should return the number of milliseconds which it would like to wait before being called
-					again. Returning 0 will make the thread call again as soon as possible (after possibly servicing
-					other busy clients). If you return a value below zero, your client will be removed from the list of clients,
-					and won't be called again. The value you specify isn't a guaranteee, and is only used as a hint by the
-					thread - the actual time before the next callback may be more or less than specified.
-					You can force the TimeSliceThread to wake up and poll again immediately by calling its notify() method.
-	*/
-	virtual int useTimeSlice() = 0;
-
-private:
-	friend class TimeSliceThread;
-	Time nextCallTime;
-};
-
-/**
-	A thread that keeps a list of clients, and calls each one in turn, giving them
-	all a chance to run some sort of short task.
-
-	@see TimeSliceClient, Thread
-*/
-class JUCE_API  TimeSliceThread   : public Thread
-{
-public:
-
-	/**
-		Creates a TimeSliceThread.
-
-		When first created, the thread is not running. Use the startThread()
-		method to start it.
-	*/
-	explicit TimeSliceThread (const String& threadName);
-
-	/** Destructor.
-
-		Deleting a Thread object that is running will only give the thread a
-		brief opportunity to stop itself cleanly, so it's recommended that you
-		should always call stopThread() with a decent timeout before deleting,
-		to avoid the thread being forcibly killed (which is a Bad Thing).
-	*/
-	~TimeSliceThread();
-
-	/** Adds a client to the list.
-
-		The client's callbacks will start after the number of milliseconds specified
-		by millisecondsBeforeStarting (and this may happen before this method has returned).
-	*/
-	void addTimeSliceClient (TimeSliceClient* client, int millisecondsBeforeStarting = 0);
-
-	/** Removes a client from the list.
-
-		This method will make sure that all callbacks to the client have completely
-		finished before the method returns.
-	*/
-	void removeTimeSliceClient (TimeSliceClient* client);
-
-	/** Returns the number of registered clients. */
-	int getNumClients() const;
-
-	/** Returns one of the registered clients. */
-	TimeSliceClient* getClient (int index) const;
-
-   #ifndef DOXYGEN
-	void run();
-   #endif
-
-private:
-	CriticalSection callbackLock, listLock;
-	Array <TimeSliceClient*> clients;
-	TimeSliceClient* clientBeingCalled;
-
-	TimeSliceClient* getNextClient (int index) const;
-
-	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TimeSliceThread);
-};
-
-#endif   // __JUCE_TIMESLICETHREAD_JUCEHEADER__
-
-/*** End of inlined file: juce_TimeSliceThread.h ***/
-
-
 #endif
 #ifndef __JUCE_WAITABLEEVENT_JUCEHEADER__
 
@@ -36112,8 +36359,39 @@ protected:
 		}
 	};
 
+	/** Used by AudioFormatReader subclasses to implement readMaxLevels() for uncompressed formats.
+
+		Rather than converting the samples to 32-bit integers and then scanning them, as the
+		default readMaxLevels() does, this finds the extremes of each channel by scanning the
+		raw interleaved data in its native format, using SSE where it's available. If the source
+		stream is a FileInputStream, the file is memory-mapped so that the data can be scanned
+		in-place; otherwise it's read from the input stream in large blocks.
+
+		16, 24 and 32-bit integer data and little-endian 32-bit float data are supported. For
+		anything else, this returns false, and the caller should fall back to the default
+		AudioFormatReader::readMaxLevels() method.
+
+		@param dataStartPosition	the byte position in the stream of the first sample frame
+		@param bytesPerFrame	the number of bytes occupied by one frame of interleaved samples
+		@param isLittleEndian	   the byte-order of the sample data
+		@see readMaxLevels
+	*/
+	bool readMaxLevelsFromRawData (int64 dataStartPosition,
+								   int bytesPerFrame,
+								   bool isLittleEndian,
+								   int64 startSample,
+								   int64 numSamples,
+								   float& lowestLeft,
+								   float& highestLeft,
+								   float& lowestRight,
+								   float& highestRight);
+
 private:
 	String formatName;
+	ScopedPointer<MemoryMappedFile> mappedFile;
+	bool hasTriedToMapFile;
+
+	const void* getMappedSection (int64 startByte, int64 numBytes);
 
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioFormatReader);
 };
@@ -36143,6 +36421,11 @@ class AudioFormatWriter;
 /**
 	A multi-channel buffer of 32-bit floating point audio samples.
 
+	When the buffer allocates its own memory, the data for each channel starts on a
+	16-byte boundary, so that the FloatVectorOperations that it uses can work on it
+	efficiently.
+
+	@see FloatVectorOperations
 */
 class JUCE_API  AudioSampleBuffer
 {
@@ -36941,6 +37224,22 @@ public:
 	*/
 	virtual bool canHandleFile (const File& fileToTest);
 
+	/** Returns true if the given bytes, taken from the start of a stream, look like
+		the header of a file in this format.
+
+		This is used by the AudioFormatManager to decide which format is most likely
+		to be able to open a stream, so that it doesn't need to make every format try
+		to parse it. It's only a hint: a format that returns true will still have to
+		successfully open the stream, and if none of the formats that match can do that,
+		the manager will fall back to trying the others. The base class implementation
+		returns false.
+
+		@param headerData   the first bytes of the stream
+		@param numBytes	 the number of bytes available in headerData. This will be at
+							least 16 unless the stream is shorter than that.
+	*/
+	virtual bool matchesStreamHeader (const void* headerData, int numBytes) const;
+
 	/** Returns a set of sample rates that the format can read and write. */
 	virtual const Array <int> getPossibleSampleRates() = 0;
 
@@ -37062,6 +37361,7 @@ public:
 	const Array <int> getPossibleBitDepths();
 	bool canDoStereo();
 	bool canDoMono();
+	bool matchesStreamHeader (const void* headerData, int numBytes) const;
 
    #if JUCE_MAC
 	bool canHandleFile (const File& fileToTest);
@@ -37397,6 +37697,141 @@ private:
 /*** End of inlined file: juce_AudioCDReader.h ***/
 
 
+#endif
+#ifndef __JUCE_AUDIOFILEHEADERCACHE_JUCEHEADER__
+
+/*** Start of inlined file: juce_AudioFileHeaderCache.h ***/
+#ifndef __JUCE_AUDIOFILEHEADERCACHE_JUCEHEADER__
+#define __JUCE_AUDIOFILEHEADERCACHE_JUCEHEADER__
+
+struct HeaderCacheEntry;
+
+/**
+	Keeps a record of the properties of a set of audio files, so that they don't
+	need to be re-parsed each time they're needed.
+
+	Each entry stores the details that an AudioFormatReader pulled out of a file's
+	header (sample rate, channels, length, loop points and other metadata, etc.)
+	along with the file's size and modification time, so that if the file is changed,
+	its entry will be ignored.
+
+	If you give one of these to an AudioFormatManager, it'll add an entry for each
+	file that it opens, and will use the cached format name to go straight to the
+	right AudioFormat the next time a file is opened. The contents can be saved and
+	restored as XML, so that the cache can persist between sessions, and hasChanged()
+	tells you whether there's anything new that's worth saving.
+
+	@see AudioFormatManager::setHeaderCache
+*/
+class JUCE_API  AudioFileHeaderCache
+{
+public:
+
+	/** Creates an empty cache. */
+	AudioFileHeaderCache();
+
+	/** Destructor. */
+	~AudioFileHeaderCache();
+
+	/** Holds the properties of an audio file that were read from its header. */
+	class JUCE_API  HeaderInfo
+	{
+	public:
+		/** Creates an empty HeaderInfo. */
+		HeaderInfo();
+
+		/** Creates a HeaderInfo that holds the properties of the given reader. */
+		explicit HeaderInfo (const AudioFormatReader& reader);
+
+		/** The name of the AudioFormat that was used to read the file. */
+		String formatName;
+
+		/** The sample-rate of the file. */
+		double sampleRate;
+
+		/** The number of bits per sample, e.g. 16, 24, 32. */
+		unsigned int bitsPerSample;
+
+		/** The number of channels in the file. */
+		unsigned int numChannels;
+
+		/** The total number of samples in the file. */
+		int64 lengthInSamples;
+
+		/** Indicates whether the data is floating-point or fixed. */
+		bool usesFloatingPointData;
+
+		/** The reader's metadata values, which includes any loop points that
+			the format understands.
+		*/
+		StringPairArray metadataValues;
+	};
+
+	/** Looks for a cached entry for the given file.
+
+		If there's an entry for this file, and the file hasn't been modified since the
+		entry was added, this returns true and fills in the result object; otherwise it
+		returns false.
+	*/
+	bool getHeader (const File& file, HeaderInfo& result) const;
+
+	/** Adds or replaces the entry for a file, using the properties of a reader that
+		has been opened on it.
+
+		If the cache already holds exactly the same details for this file, nothing
+		is changed.
+	*/
+	void addHeader (const File& file, const AudioFormatReader& reader);
+
+	/** Removes any entry for the given file. */
+	void removeHeader (const File& file);
+
+	/** Removes all the entries. */
+	void clear();
+
+	/** Returns the number of files that have entries in the cache. */
+	int getNumHeaders() const;
+
+	/** Returns true if any entries have been added, replaced or removed since the
+		cache was created, restored with restoreFromXml(), or since clearChangedFlag()
+		was last called.
+
+		You can use this to avoid re-saving a cache that hasn't changed.
+	*/
+	bool hasChanged() const noexcept			{ return changed; }
+
+	/** Resets the flag that hasChanged() returns, e.g. after the cache has been saved. */
+	void clearChangedFlag() noexcept			{ changed = false; }
+
+	/** Creates some XML that can be used to store the state of this cache.
+
+		The caller must delete the object that is returned.
+		@see restoreFromXml
+	*/
+	XmlElement* createXml() const;
+
+	/** Replaces the contents of the cache with some XML that was created by
+		createXml().
+	*/
+	void restoreFromXml (const XmlElement& xml);
+
+private:
+
+	OwnedArray <HeaderCacheEntry> entries;
+	HashMap <String, HeaderCacheEntry*> entriesByPath;
+	CriticalSection lock;
+	bool changed;
+
+	void addEntry (HeaderCacheEntry* entry);
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioFileHeaderCache);
+};
+
+#endif   // __JUCE_AUDIOFILEHEADERCACHE_JUCEHEADER__
+
+/*** End of inlined file: juce_AudioFileHeaderCache.h ***/
+
+
 #endif
 #ifndef __JUCE_AUDIOFORMAT_JUCEHEADER__
 
@@ -37485,6 +37920,11 @@ public:
 	/** Searches through the known formats to try to create a suitable reader for
 		this file.
 
+		The formats whose signatures match the first few bytes of the file are tried
+		first (see AudioFormat::matchesStreamHeader()), followed by any others that
+		recognise the file's extension. If a header cache has been set, the format
+		that opened the file last time will be tried before any of these.
+
 		If none of the registered formats can open the file, it'll return 0. If it
 		returns a reader, it's the caller's responsibility to delete the reader.
 	*/
@@ -37497,17 +37937,69 @@ public:
 		reader that is returned, so the caller should not keep any references to it.
 
 		The stream that is passed-in must be capable of being repositioned so
-		that all the formats can have a go at opening it.
+		that all the formats can have a go at opening it. Any formats whose
+		signatures match the start of the stream will be given the first try.
 
 		If none of the registered formats can open the stream, it'll return 0. If it
 		returns a reader, it's the caller's responsibility to delete the reader.
 	*/
 	AudioFormatReader* createReaderFor (InputStream* audioFileStream);
 
+	/** Gives the manager a cache in which to keep the header details of the files
+		that it opens.
+
+		Each time createReaderFor() opens a file, the file's details are stored in
+		the cache, and the next time it's opened, the format that worked before will
+		be tried first. The manager doesn't take ownership of the cache, so it must
+		not be deleted until it has been removed by calling this method with a null
+		pointer, or until the manager has been deleted.
+	*/
+	void setHeaderCache (AudioFileHeaderCache* newCache) noexcept;
+
+	/** Returns the cache that was set with setHeaderCache(), or nullptr if there isn't one. */
+	AudioFileHeaderCache* getHeaderCache() const noexcept	   { return headerCache; }
+
+	/** Makes the readers that createReaderFor() opens from files read ahead of
+		themselves, using a background thread.
+
+		Each file's stream gets wrapped in a PrefetchingInputStream, so a reader that's
+		going through a file from start to finish doesn't have to wait for the disk.
+		The manager doesn't take ownership of the thread, which must already be
+		running, and it must not be stopped or deleted until all the readers that were
+		created while it was set have been deleted. Pass nullptr to stop using it.
+
+		@param thread		   the thread to do the reading, which can be shared
+										with other streams
+		@param numBuffersToPrefetch	 how many blocks beyond each reader's position
+										should be kept filled
+		@param bufferSize		   the size of each block
+		@see PrefetchingInputStream
+	*/
+	void setReadAheadThread (TimeSliceThread* thread,
+							 int numBuffersToPrefetch = 4,
+							 int bufferSize = 65536) noexcept;
+
+	/** Finds the sample rate, length, metadata, etc. of a file.
+
+		If a header cache has been set and it contains an up-to-date entry for this
+		file, that entry is returned without touching the file; otherwise, this will
+		open the file with createReaderFor(), which will also add it to the cache.
+
+		@returns true if the details were found, or false if the file couldn't be opened
+	*/
+	bool getHeaderInfo (const File& audioFile, AudioFileHeaderCache::HeaderInfo& result);
+
 private:
 
 	OwnedArray<AudioFormat> knownFormats;
 	int defaultFormatIndex;
+	AudioFileHeaderCache* headerCache;
+	TimeSliceThread* readAheadThread;
+	int numReadAheadBuffers, readAheadBufferSize;
+
+	AudioFormat* findFormatWithName (const String& formatName) const;
+	void addFormatsMatchingHeader (InputStream& stream, Array<AudioFormat*>& formats) const;
+	AudioFormatReader* createReaderUsingFormats (InputStream* stream, const Array<AudioFormat*>& formatsToTry);
 
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioFormatManager);
 };
@@ -37892,6 +38384,7 @@ public:
 	bool canDoStereo();
 	bool canDoMono();
 	bool isCompressed();
+	bool matchesStreamHeader (const void* headerData, int numBytes) const;
 	StringArray getQualityOptions();
 
 	AudioFormatReader* createReaderFor (InputStream* sourceStream,
@@ -37943,6 +38436,7 @@ public:
 	bool canDoStereo();
 	bool canDoMono();
 	bool isCompressed();
+	bool matchesStreamHeader (const void* headerData, int numBytes) const;
 	StringArray getQualityOptions();
 
 	/** Tries to estimate the quality level of an ogg file based on its size.
@@ -38125,6 +38619,7 @@ public:
 	const Array <int> getPossibleBitDepths();
 	bool canDoStereo();
 	bool canDoMono();
+	bool matchesStreamHeader (const void* headerData, int numBytes) const;
 
 	AudioFormatReader* createReaderFor (InputStream* sourceStream,
 										bool deleteStreamIfOpeningFails);
@@ -38570,6 +39065,27 @@ public:
 	*/
 	virtual int getInputLatencyInSamples() = 0;
 
+	/** Returns true if the device is currently calling its callback as fast as it can,
+		rather than in real time.
+
+		JACK does this while its session is in "freewheel" mode, e.g. when something's
+		being bounced. Callbacks may want to switch their processing to an offline
+		mode while it's happening.
+
+		@see setFreewheeling, AudioProcessor::setNonRealtime
+	*/
+	virtual bool isFreewheeling()				   { return false; }
+
+	/** Asks the device to start or stop calling its callback as fast as it can, so that
+		the audio can be rendered faster than real time.
+
+		Returns false if the device can't do this. For JACK, this puts the whole session
+		into freewheel mode.
+
+		@see isFreewheeling
+	*/
+	virtual bool setFreewheeling (bool /*shouldFreewheel*/)	 { return false; }
+
 	/** True if this device can show a pop-up control panel for editing its settings.
 
 		This is generally just true of ASIO devices. If true, you can call showControlPanel()
@@ -38700,6 +39216,12 @@ private:
 	a background thread to smooth out playback. You can either create one of these
 	directly, or use it indirectly using an AudioTransportSource.
 
+	The buffer is a single-reader, single-writer FIFO, so the audio thread never has
+	to wait for the background thread. The amount of data that's kept buffered is
+	adjusted according to how long the source's reads are taking, and if the audio
+	thread ever catches up with the background thread, this is counted, so that you
+	can check for dropouts with getNumUnderruns().
+
 	@see PositionableAudioSource, AudioTransportSource
 */
 class JUCE_API  BufferingAudioSource  : public PositionableAudioSource
@@ -38747,19 +39269,49 @@ public:
 	/** Implements the PositionableAudioSource method. */
 	bool isLooping() const			  { return source->isLooping(); }
 
+	/** Returns the number of times that the audio thread has run out of buffered data
+		since prepareToPlay() was called.
+
+		Each time this happens, some or all of a block will have been replaced by silence.
+	*/
+	int getNumUnderruns() const noexcept	{ return numUnderruns.get(); }
+
+	/** Returns the number of samples that the background thread is currently trying to
+		keep buffered ahead of the playback position.
+
+		This starts at a quarter of a second (or half the buffer if that's smaller), and
+		is increased if the source's reads start taking longer, or if there's an underrun.
+	*/
+	int getReadAheadTarget() const noexcept	 { return readAheadTarget; }
+
 private:
 
 	OptionalScopedPointer<PositionableAudioSource> source;
 	int numberOfSamplesToBuffer, numberOfChannels;
 	AudioSampleBuffer buffer;
-	CriticalSection bufferStartPosLock;
-	int64 volatile bufferValidStart, bufferValidEnd, nextPlayPos;
+	AbstractFifo fifo;
+	int64 volatile nextPlayPos, pendingSeekPos, flushUpTo, flushPosition;
+	int volatile flushSeekCount, readAheadTarget, minimumReadAhead;
+	Atomic<int> seekCount, flushSequence, numUnderruns, readerClaim;
 	double volatile sampleRate;
+
+	// only used by whichever thread has set readerClaim..
+	int64 samplesRead, samplesToSkip;
+	int lastFlushSequence, lastFlushSeekCount;
+
+	// only used by the background thread..
+	int64 samplesWritten, nextReadPos;
+	int lastSeekCount, lastNumUnderruns;
+	double worstReadTimeMs;
 	bool wasSourceLooping;
 
 	friend class SharedBufferingAudioSourceThread;
 	bool readNextBufferChunk();
 	void readBufferSection (int64 start, int length, int bufferOffset);
+	bool catchUpWithBackgroundThread();
+	void readFromFifo (const AudioSourceChannelInfo& info);
+	void updateReadAheadTarget (double millisecondsTaken);
+	void resetFifo();
 
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BufferingAudioSource);
 };
@@ -38776,6 +39328,12 @@ private:
 /**
 	A type of AudioSource that takes an input source and changes its sample rate.
 
+	The resampling is done with a polyphase windowed-sinc filter, which is band-limited
+	to avoid aliasing when either up- or down-sampling, and works for any ratio. The
+	filter tables are built when the ratio or quality is changed rather than on the
+	audio thread, and all the memory that the audio thread needs is allocated in
+	prepareToPlay().
+
 	@see AudioSource
 */
 class JUCE_API  ResamplingAudioSource  : public AudioSource
@@ -38796,9 +39354,34 @@ public:
 	/** Destructor. */
 	~ResamplingAudioSource();
 
+	/** The different filter lengths that the resampler can use.
+
+		Longer filters have a sharper cutoff and reject more of the aliased signal,
+		but take more CPU to run.
+	*/
+	enum Quality
+	{
+		lowQuality = 0,	 /**< 8-tap filters, suitable for previewing or for heavily-loaded systems. */
+		mediumQuality,	  /**< 24-tap filters, with around 70dB of alias rejection. */
+		highQuality	 /**< 48-tap filters, with around 90dB of alias rejection. */
+	};
+
+	/** Changes the length of filter that is used.
+
+		This must be called before prepareToPlay(), and mustn't be called while the
+		source is running. The default is mediumQuality.
+	*/
+	void setQuality (Quality newQuality);
+
+	/** Returns the quality setting that's in use. */
+	Quality getQuality() const noexcept			 { return quality; }
+
 	/** Changes the resampling ratio.
 
-		(This value can be changed at any time, even while the source is running).
+		(This value can be changed at any time, even while the source is running, and
+		the new ratio is picked up at the start of the next block. When down-sampling,
+		a new set of filters may need to be built, so avoid calling this from the audio
+		thread if you're changing the ratio continuously).
 
 		@param samplesInPerOutputSample	 if set to 1.0, the input is passed through; higher
 											values will speed it up; lower values will slow it
@@ -38818,28 +39401,35 @@ public:
 
 private:
 
-	OptionalScopedPointer<AudioSource> input;
-	double ratio, lastRatio;
-	AudioSampleBuffer buffer;
-	int bufferPos, sampsInBuffer;
-	double subSampleOffset;
-	double coefficients[6];
-	SpinLock ratioLock;
-	const int numChannels;
-	HeapBlock<float*> destBuffers, srcBuffers;
+	struct FilterBank
+	{
+		FilterBank();
 
-	void setFilterCoefficients (double c1, double c2, double c3, double c4, double c5, double c6);
-	void createLowPass (double proportionalRate);
+		void design (Quality quality, double stretch);
+		void swapWith (FilterBank& other) noexcept;
 
-	struct FilterState
-	{
-		double x1, x2, y1, y2;
+		HeapBlock<float> coefficients;
+		int numTaps, numPhases;
+		double stretch;
 	};
 
-	HeapBlock<FilterState> filterStates;
-	void resetFilters();
+	OptionalScopedPointer<AudioSource> input;
+	double ratio, activeRatio;
+	Quality quality;
+	FilterBank activeFilters, pendingFilters;
+	SpinLock pendingLock;
+	Atomic<int> newSettingsAvailable;
+	bool pendingFiltersChanged;
 
-	void applyFilter (float* samples, int num, FilterState& fs);
+	AudioSampleBuffer buffer;
+	int readPos, numBuffered;
+	double subSampleOffset;
+	const int numChannels;
+
+	void updatePendingFilters();
+	void applyPendingSettings() noexcept;
+	double getMaxRatio() const noexcept;
+	int processChunk (const AudioSourceChannelInfo& info, int startSample, int numSamples) noexcept;
 
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResamplingAudioSource);
 };
@@ -39128,6 +39718,11 @@ private:
 #define __JUCE_IIRFILTERAUDIOSOURCE_JUCEHEADER__
 
 
+/*** Start of inlined file: juce_BiquadCascade.h ***/
+#ifndef __JUCE_BIQUADCASCADE_JUCEHEADER__
+#define __JUCE_BIQUADCASCADE_JUCEHEADER__
+
+
 /*** Start of inlined file: juce_IIRFilter.h ***/
 #ifndef __JUCE_IIRFILTER_JUCEHEADER__
 #define __JUCE_IIRFILTER_JUCEHEADER__
@@ -39239,6 +39834,8 @@ protected:
 	float coefficients[6];
 	float x1, x2, y1, y2;
 
+	friend class BiquadCascade;
+
 	// (use the copyCoefficientsFrom() method instead of this operator)
 	IIRFilter& operator= (const IIRFilter&);
 	JUCE_LEAK_DETECTOR (IIRFilter);
@@ -39248,8 +39845,113 @@ protected:
 
 /*** End of inlined file: juce_IIRFilter.h ***/
 
+/**
+	A chain of biquad filters that can process several channels of audio at once.
+
+	Each stage of the cascade is a second-order section, and every channel is run through
+	all the stages in turn, with each channel keeping its own filter state. The filters use
+	the transposed direct form II structure, and on Intel machines groups of four channels
+	are processed together in SSE registers, with denormals flushed to zero by the CPU
+	rather than being checked for on each sample.
+
+	The coefficients can be changed from any thread while audio is being processed: new
+	settings are picked up at the start of the next call to processSamples(), and the audio
+	thread never waits for a lock to get them.
+
+	@see IIRFilter, IIRFilterAudioSource
+*/
+class JUCE_API  BiquadCascade
+{
+public:
+
+	/** Creates a cascade.
+
+		Initially all the stages are inactive, so the cascade has no effect on the
+		samples that it processes.
+
+		@param maxNumChannels   the number of channels of state that should be kept
+		@param numStages	the number of biquad sections that each channel is passed through
+	*/
+	BiquadCascade (int maxNumChannels, int numStages);
+
+	/** Destructor. */
+	~BiquadCascade();
+
+	/** Returns the number of channels that this cascade was created for. */
+	int getNumChannels() const noexcept		 { return numChannels; }
+
+	/** Returns the number of stages in the cascade. */
+	int getNumStages() const noexcept		   { return numStages; }
+
+	/** Makes one of the stages use the same settings as an IIRFilter.
+
+		If the filter is inactive, the stage will pass its input straight through.
+	*/
+	void setStage (int stageIndex, const IIRFilter& filterToCopy) noexcept;
+
+	/** Sets the coefficients of one of the stages.
+
+		The stage's transfer function is (b0 + b1 z^-1 + b2 z^-2) / (a0 + a1 z^-1 + a2 z^-2).
+	*/
+	void setStage (int stageIndex,
+				   double b0, double b1, double b2,
+				   double a0, double a1, double a2) noexcept;
+
+	/** Makes a stage pass its input straight through. */
+	void makeStageInactive (int stageIndex) noexcept;
+
+	/** Clears the filter state of all the channels, ready to start a new stream of data.
+
+		This is safe to call from any thread - the state is actually cleared at the start
+		of the next call to processSamples().
+	*/
+	void reset() noexcept;
+
+	/** Filters some channels of audio in-place.
+
+		@param channels	 an array of pointers to the sample data for each channel. Any
+								of these may be null, in which case that channel is skipped
+		@param numChannels	  the number of channels in the array, which mustn't be more than
+								the number that the cascade was created for
+		@param numSamples	   the number of samples to process in each channel
+	*/
+	void processSamples (float* const* channels, int numChannels, int numSamples) noexcept;
+
+	/** Filters a section of an AudioSampleBuffer in-place.
+
+		The buffer mustn't have more channels than the cascade was created for.
+	*/
+	void processSamples (AudioSampleBuffer& buffer, int startSample, int numSamples) noexcept;
+
+private:
+
+	enum { numCoefficients = 5, channelsPerGroup = 4 };
+
+	const int numChannels, numStages, numGroups;
+	HeapBlock <float> pendingCoefficients, workspace;
+	float* activeCoefficients;
+	float* state;
+	SpinLock pendingCoefficientsLock;
+	Atomic<int> newCoefficientsAvailable, resetNeeded;
+
+	void setCoefficients (int stageIndex, double b0, double b1, double b2, double a1, double a2) noexcept;
+	void updateCoefficients() noexcept;
+	void processGroup (float* const* groupChannels, int group, int numSamples) noexcept;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BiquadCascade);
+};
+
+#endif   // __JUCE_BIQUADCASCADE_JUCEHEADER__
+
+/*** End of inlined file: juce_BiquadCascade.h ***/
+
 /**
 	An AudioSource that performs an IIR filter on another source.
+
+	All the channels are filtered together by a BiquadCascade, so the filter settings
+	can be changed while the source is playing without blocking the audio thread, and
+	the filter state for every channel is allocated up-front, so nothing needs to be
+	allocated while it's playing.
 */
 class JUCE_API  IIRFilterAudioSource  : public AudioSource
 {
@@ -39260,9 +39962,13 @@ public:
 		@param inputSource		  the input source to read from - this must not be null
 		@param deleteInputWhenDeleted   if true, the input source will be deleted when
 										this object is deleted
+		@param maxNumChannels	   the largest number of channels that the source will be
+										asked to fill. Any channels beyond this will be passed
+										through without being filtered
 	*/
 	IIRFilterAudioSource (AudioSource* inputSource,
-						  bool deleteInputWhenDeleted);
+						  bool deleteInputWhenDeleted,
+						  int maxNumChannels = 2);
 
 	/** Destructor. */
 	~IIRFilterAudioSource();
@@ -39277,7 +39983,7 @@ public:
 private:
 
 	OptionalScopedPointer<AudioSource> input;
-	OwnedArray <IIRFilter> iirFilters;
+	BiquadCascade filter;
 
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (IIRFilterAudioSource);
 };
@@ -39400,9 +40106,17 @@ private:
 /**
 	Performs a simple reverb effect on a stream of audio data.
 
-	This is a simple stereo reverb, based on the technique and tunings used in FreeVerb.
-	Use setSampleRate() to prepare it, and then call processStereo() or processMono() to
-	apply the reverb to your audio data.
+	This is a simple reverb, based on the technique and tunings used in FreeVerb.
+	Use setSampleRate() to prepare it, and then call processStereo(), processMono() or
+	processChannels() to apply the reverb to your audio data.
+
+	Each channel has a bank of eight comb filters, which are run side-by-side in SSE
+	registers where possible, followed by four all-pass filters. Up to four channels
+	can be processed, each with slightly different delay times, so mono, stereo and
+	quad buses all get a decorrelated tail.
+
+	Parameter changes are faded in over the next block that gets processed, so the
+	settings can be moved while audio is playing without causing clicks.
 
 	@see ReverbAudioSource
 */
@@ -39416,6 +40130,9 @@ public:
 		setSampleRate (44100.0);
 	}
 
+	/** The maximum number of channels that processChannels() can handle. */
+	enum { maxNumChannels = 4 };
+
 	/** Holds the parameters being used by a Reverb object. */
 	struct Parameters
 	{
@@ -39441,6 +40158,7 @@ public:
 	const Parameters& getParameters() const noexcept	{ return parameters; }
 
 	/** Applies a new set of parameters to the reverb.
+		The new settings are ramped in over the course of the next block that's processed.
 		Note that this doesn't attempt to lock the reverb, so if you call this in parallel with
 		the process method, you may get artifacts.
 	*/
@@ -39450,10 +40168,10 @@ public:
 		const float dryScaleFactor = 2.0f;
 
 		const float wet = newParams.wetLevel * wetScaleFactor;
-		wet1 = wet * (newParams.width * 0.5f + 0.5f);
-		wet2 = wet * (1.0f - newParams.width) * 0.5f;
-		dry = newParams.dryLevel * dryScaleFactor;
-		gain = isFrozen (newParams.freezeMode) ? 0.0f : 0.015f;
+		wet1.setTarget (wet * (newParams.width * 0.5f + 0.5f));
+		wet2.setTarget (wet * (1.0f - newParams.width) * 0.5f);
+		dry.setTarget (newParams.dryLevel * dryScaleFactor);
+		gain.setTarget (isFrozen (newParams.freezeMode) ? 0.0f : 0.015f);
 		parameters = newParams;
 		shouldUpdateDamping = true;
 	}
@@ -39470,34 +40188,35 @@ public:
 		const int stereoSpread = 23;
 		const int intSampleRate = (int) sampleRate;
 
-		int i;
-		for (i = 0; i < numCombs; ++i)
+		for (int j = 0; j < maxNumChannels; ++j)
 		{
-			comb[0][i].setSize ((intSampleRate * combTunings[i]) / 44100);
-			comb[1][i].setSize ((intSampleRate * (combTunings[i] + stereoSpread)) / 44100);
-		}
+			int combSizes [numCombs];
 
-		for (i = 0; i < numAllPasses; ++i)
-		{
-			allPass[0][i].setSize ((intSampleRate * allPassTunings[i]) / 44100);
-			allPass[1][i].setSize ((intSampleRate * (allPassTunings[i] + stereoSpread)) / 44100);
+			int i;
+			for (i = 0; i < numCombs; ++i)
+				combSizes[i] = (intSampleRate * (combTunings[i] + j * stereoSpread)) / 44100;
+
+			comb[j].setSizes (combSizes);
+
+			for (i = 0; i < numAllPasses; ++i)
+				allPass[j][i].setSize ((intSampleRate * (allPassTunings[i] + j * stereoSpread)) / 44100);
 		}
 
-		shouldUpdateDamping = true;
+		snapParametersToTargets();
 	}
 
 	/** Clears the reverb's buffers. */
 	void reset()
 	{
-		for (int j = 0; j < numChannels; ++j)
+		for (int j = 0; j < maxNumChannels; ++j)
 		{
-			int i;
-			for (i = 0; i < numCombs; ++i)
-				comb[j][i].clear();
+			comb[j].clear();
 
-			for (i = 0; i < numAllPasses; ++i)
+			for (int i = 0; i < numAllPasses; ++i)
 				allPass[j][i].clear();
 		}
+
+		snapParametersToTargets();
 	}
 
 	/** Applies the reverb to two stereo channels of audio data. */
@@ -39505,30 +40224,8 @@ public:
 	{
 		jassert (left != nullptr && right != nullptr);
 
-		if (shouldUpdateDamping)
-			updateDamping();
-
-		for (int i = 0; i < numSamples; ++i)
-		{
-			const float input = (left[i] + right[i]) * gain;
-			float outL = 0, outR = 0;
-
-			int j;
-			for (j = 0; j < numCombs; ++j)  // accumulate the comb filters in parallel
-			{
-				outL += comb[0][j].process (input);
-				outR += comb[1][j].process (input);
-			}
-
-			for (j = 0; j < numAllPasses; ++j)  // run the allpass filters in series
-			{
-				outL = allPass[0][j].process (outL);
-				outR = allPass[1][j].process (outR);
-			}
-
-			left[i]  = outL * wet1 + outR * wet2 + left[i]  * dry;
-			right[i] = outR * wet1 + outL * wet2 + right[i] * dry;
-		}
+		float* const channels[] = { left, right };
+		processChannels (channels, 2, numSamples);
 	}
 
 	/** Applies the reverb to a single mono channel of audio data. */
@@ -39536,31 +40233,104 @@ public:
 	{
 		jassert (samples != nullptr);
 
+		processChannels (&samples, 1, numSamples);
+	}
+
+	/** Applies the reverb to between one and four channels of audio data.
+
+		The channels are mixed together to feed the reverb, and each one gets its own
+		tail. The width parameter controls how much of each channel's tail is mixed into
+		its neighbour's, where channels are paired as 0 & 1 and 2 & 3.
+	*/
+	void processChannels (float* const* const channels, const int numChannels, const int numSamples) noexcept
+	{
+		jassert (numChannels > 0 && numChannels <= maxNumChannels);
+		const int numToProcess = jmin (numChannels, (int) maxNumChannels);
+
+		if (numToProcess <= 0 || numSamples <= 0)
+			return;
+
 		if (shouldUpdateDamping)
 			updateDamping();
 
+		gain.startRamp (numSamples);
+		wet1.startRamp (numSamples);
+		wet2.startRamp (numSamples);
+		dry.startRamp (numSamples);
+		feedback.startRamp (numSamples);
+		damping.startRamp (numSamples);
+
+		const ScopedNoDenormals noDenormals;
+
+		// (this keeps a quad bus at the same input level as a stereo one)
+		const float inputScale = numToProcess > 2 ? 2.0f / numToProcess : 1.0f;
+
 		for (int i = 0; i < numSamples; ++i)
 		{
-			const float input = samples[i] * gain;
-			float output = 0;
+			float input = 0;
 
 			int j;
-			for (j = 0; j < numCombs; ++j)  // accumulate the comb filters in parallel
-				output += comb[0][j].process (input);
+			for (j = 0; j < numToProcess; ++j)
+				input += channels[j][i];
+
+			input *= gain.getNextValue() * inputScale;
+
+			const float feedbackNow = feedback.getNextValue();
+			const float dampingNow = damping.getNextValue();
+			float outputs [maxNumChannels];
 
-			for (j = 0; j < numAllPasses; ++j)  // run the allpass filters in series
-				output = allPass[0][j].process (output);
+			for (j = 0; j < numToProcess; ++j)
+			{
+				float output = comb[j].process (input, feedbackNow, dampingNow);
+
+				for (int k = 0; k < numAllPasses; ++k)  // run the allpass filters in series
+					output = allPass[j][k].process (output);
+
+				outputs[j] = output;
+			}
+
+			const float wet1Now = wet1.getNextValue();
+			const float wet2Now = wet2.getNextValue();
+			const float dryNow = dry.getNextValue();
 
-			samples[i] = output * wet1 + input * dry;
+			for (j = 0; j < numToProcess; ++j)
+			{
+				const int partner = j ^ 1;
+				float output = outputs[j] * wet1Now + channels[j][i] * dryNow;
+
+				if (partner < numToProcess)
+					output += outputs [partner] * wet2Now;
+
+				channels[j][i] = output;
+			}
 		}
+
+		// (avoids any rounding errors that the ramps may have accumulated)
+		snapParametersToTargets();
 	}
 
 private:
 
+	enum { numCombs = 8, numAllPasses = 4 };
+
+	class LinearSmoothedValue
+	{
+	public:
+		LinearSmoothedValue() noexcept  : current (0), target (0), step (0) {}
+
+		void setTarget (const float newTarget) noexcept	 { target = newTarget; }
+		void snapToTarget() noexcept			{ current = target; step = 0; }
+		void startRamp (const int numSamples) noexcept	  { step = (target - current) / numSamples; }
+		inline float getNextValue() noexcept		{ return current += step; }
+
+	private:
+		float current, target, step;
+	};
+
 	Parameters parameters;
 
 	volatile bool shouldUpdateDamping;
-	float gain, wet1, wet2, dry;
+	LinearSmoothedValue gain, wet1, wet2, dry, feedback, damping;
 
 	inline static bool isFrozen (const float freezeMode) noexcept  { return freezeMode >= 0.5f; }
 
@@ -39573,31 +40343,61 @@ private:
 		shouldUpdateDamping = false;
 
 		if (isFrozen (parameters.freezeMode))
-			setDamping (1.0f, 0.0f);
+		{
+			damping.setTarget (0.0f);
+			feedback.setTarget (1.0f);
+		}
 		else
-			setDamping (parameters.damping * dampScaleFactor,
-						parameters.roomSize * roomScaleFactor + roomOffset);
+		{
+			damping.setTarget (parameters.damping * dampScaleFactor);
+			feedback.setTarget (parameters.roomSize * roomScaleFactor + roomOffset);
+		}
 	}
 
-	void setDamping (const float dampingToUse, const float roomSizeToUse) noexcept
+	void snapParametersToTargets() noexcept
 	{
-		for (int j = 0; j < numChannels; ++j)
-			for (int i = numCombs; --i >= 0;)
-				comb[j][i].setFeedbackAndDamp (roomSizeToUse, dampingToUse);
+		if (shouldUpdateDamping)
+			updateDamping();
+
+		gain.snapToTarget();
+		wet1.snapToTarget();
+		wet2.snapToTarget();
+		dry.snapToTarget();
+		feedback.snapToTarget();
+		damping.snapToTarget();
 	}
 
-	class CombFilter
+	/*  The eight comb filters for one channel. Their delay lines are interleaved in a
+		single circular buffer with a row of eight values per sample, so that all the
+		combs can write their new values with a couple of vector stores.
+	*/
+	class CombFilterBank
 	{
 	public:
-		CombFilter() noexcept  : bufferSize (0), bufferIndex (0) {}
+		CombFilterBank() noexcept  : buffer (nullptr), last (nullptr), mask (0), writeIndex (0) {}
 
-		void setSize (const int size)
+		void setSizes (const int* const newSizes)
 		{
-			if (size != bufferSize)
+			int maxSize = 1;
+
+			for (int i = 0; i < numCombs; ++i)
 			{
-				bufferIndex = 0;
-				buffer.malloc (size);
-				bufferSize = size;
+				sizes[i] = jmax (1, newSizes[i]);
+				maxSize = jmax (maxSize, sizes[i]);
+			}
+
+			int numRows = 1;
+
+			while (numRows <= maxSize)
+				numRows <<= 1;
+
+			if (buffer == nullptr || numRows != mask + 1)
+			{
+				// (with space for the filter states, and some extra to align it all for SSE)
+				storage.malloc ((size_t) ((numRows + 1) * numCombs + 4));
+				buffer = reinterpret_cast <float*> ((reinterpret_cast <pointer_sized_int> (storage.getData()) + 15) & ~(pointer_sized_int) 15);
+				last = buffer + numRows * numCombs;
+				mask = numRows - 1;
 			}
 
 			clear();
@@ -39605,36 +40405,73 @@ private:
 
 		void clear() noexcept
 		{
-			last = 0;
-			buffer.clear (bufferSize);
-		}
+			writeIndex = 0;
 
-		void setFeedbackAndDamp (const float f, const float d) noexcept
-		{
-			damp1 = d;
-			damp2 = 1.0f - d;
-			feedback = f;
+			if (buffer != nullptr)
+				zeromem (buffer, sizeof (float) * (size_t) ((mask + 2) * numCombs));
 		}
 
-		inline float process (const float input) noexcept
+		/** Runs a sample through all the combs, and returns the sum of their outputs. */
+		inline float process (const float input, const float feedback, const float damp) noexcept
 		{
-			const float output = buffer [bufferIndex];
-			last = (output * damp2) + (last * damp1);
-			JUCE_UNDENORMALISE (last);
+			float* const row = buffer + writeIndex * numCombs;
 
-			float temp = input + (last * feedback);
-			JUCE_UNDENORMALISE (temp);
-			buffer [bufferIndex] = temp;
-			bufferIndex = (bufferIndex + 1) % bufferSize;
-			return output;
+		   #if JUCE_USE_SSE_INTRINSICS
+			const __m128 in = _mm_set1_ps (input);
+			const __m128 fb = _mm_set1_ps (feedback);
+			const __m128 damp1 = _mm_set1_ps (damp);
+			const __m128 damp2 = _mm_set1_ps (1.0f - damp);
+			__m128 sum = _mm_setzero_ps();
+
+			for (int i = 0; i < numCombs; i += 4)
+			{
+				const __m128 output = _mm_setr_ps (getDelayedSample (i),	 getDelayedSample (i + 1),
+												   getDelayedSample (i + 2), getDelayedSample (i + 3));
+
+				const __m128 l = _mm_add_ps (_mm_mul_ps (output, damp2), _mm_mul_ps (_mm_load_ps (last + i), damp1));
+				_mm_store_ps (last + i, l);
+				_mm_store_ps (row + i, _mm_add_ps (in, _mm_mul_ps (l, fb)));
+				sum = _mm_add_ps (sum, output);
+			}
+
+			sum = _mm_add_ps (sum, _mm_movehl_ps (sum, sum));
+			sum = _mm_add_ss (sum, _mm_shuffle_ps (sum, sum, 1));
+
+			writeIndex = (writeIndex + 1) & mask;
+			return _mm_cvtss_f32 (sum);
+		   #else
+			float sum = 0;
+
+			for (int i = 0; i < numCombs; ++i)
+			{
+				const float output = getDelayedSample (i);
+				last[i] = (output * (1.0f - damp)) + (last[i] * damp);
+				JUCE_UNDENORMALISE (last[i]);
+
+				float temp = input + (last[i] * feedback);
+				JUCE_UNDENORMALISE (temp);
+				row[i] = temp;
+				sum += output;
+			}
+
+			writeIndex = (writeIndex + 1) & mask;
+			return sum;
+		   #endif
 		}
 
 	private:
-		HeapBlock<float> buffer;
-		int bufferSize, bufferIndex;
-		float feedback, last, damp1, damp2;
+		HeapBlock<float> storage;
+		float* buffer;
+		float* last;
+		int sizes [numCombs];
+		int mask, writeIndex;
 
-		JUCE_DECLARE_NON_COPYABLE (CombFilter);
+		inline float getDelayedSample (const int combIndex) const noexcept
+		{
+			return buffer [((writeIndex - sizes [combIndex]) & mask) * numCombs + combIndex];
+		}
+
+		JUCE_DECLARE_NON_COPYABLE (CombFilterBank);
 	};
 
 	class AllPassFilter
@@ -39665,7 +40502,10 @@ private:
 			float temp = input + (bufferedValue * 0.5f);
 			JUCE_UNDENORMALISE (temp);
 			buffer [bufferIndex] = temp;
-			bufferIndex = (bufferIndex + 1) % bufferSize;
+
+			if (++bufferIndex >= bufferSize)
+				bufferIndex = 0;
+
 			return bufferedValue - input;
 		}
 
@@ -39676,10 +40516,8 @@ private:
 		JUCE_DECLARE_NON_COPYABLE (AllPassFilter);
 	};
 
-	enum { numCombs = 8, numAllPasses = 4, numChannels = 2 };
-
-	CombFilter comb [numChannels][numCombs];
-	AllPassFilter allPass [numChannels][numAllPasses];
+	CombFilterBank comb [maxNumChannels];
+	AllPassFilter allPass [maxNumChannels][numAllPasses];
 
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Reverb);
 };
@@ -41004,6 +41842,11 @@ private:
 	Analogous to the AudioSampleBuffer, this holds a set of midi events with
 	integer time-stamps. The buffer is kept sorted in order of the time-stamps.
 
+	The events are packed together in a single block of memory, alongside an index
+	of where each one starts. Adding an event whose time is at or after the last one
+	in the buffer is a quick append, and finding the events at a particular time is
+	done with a binary search, so large or dense buffers can be handled efficiently.
+
 	@see MidiMessage
 */
 class JUCE_API  MidiBuffer
@@ -41041,12 +41884,7 @@ public:
 	*/
 	bool isEmpty() const noexcept;
 
-	/** Counts the number of events in the buffer.
-
-		This is actually quite a slow operation, as it has to iterate through all
-		the events, so you might prefer to call isEmpty() if that's all you need
-		to know.
-	*/
+	/** Returns the number of events in the buffer. */
 	int getNumEvents() const noexcept;
 
 	/** Adds an event to the buffer.
@@ -41058,6 +41896,9 @@ public:
 		If an event is added whose sample position is the same as one or more events
 		already in the buffer, the new event will be placed after the existing ones.
 
+		Adding events in time order is the fastest way to fill a buffer, as each one
+		can just be appended to the end.
+
 		To retrieve events, use a MidiBuffer::Iterator object
 	*/
 	void addEvent (const MidiMessage& midiMessage, int sampleNumber);
@@ -41122,7 +41963,8 @@ public:
 
 	/** Preallocates some memory for the buffer to use.
 		This helps to avoid needing to reallocate space when the buffer has messages
-		added to it.
+		added to it. The index is given enough space for as many of the shortest
+		possible events as would fit into this number of bytes.
 	*/
 	void ensureSize (size_t minimumNumBytes);
 
@@ -41146,6 +41988,8 @@ public:
 
 		/** Repositions the iterator so that the next event retrieved will be the first
 			one whose sample position is at greater than or equal to the given position.
+
+			This does a binary search of the buffer's events.
 		*/
 		void setNextSamplePosition (int samplePosition) noexcept;
 
@@ -41189,9 +42033,13 @@ private:
 	friend class MidiBuffer::Iterator;
 	MemoryBlock data;
 	int bytesUsed;
+	HeapBlock <int> eventOffsets;
+	int numEvents, numEventOffsetsAllocated;
 
 	uint8* getData() const noexcept;
-	uint8* findEventAfter (uint8* d, int samplePosition) const noexcept;
+	void ensureIndexSize (int minNumEvents);
+	int findIndexOfEventAfter (int samplePosition) const noexcept;
+	uint8* getEventAtIndex (int index) const noexcept;
 	static int getEventTime (const void* d) noexcept;
 	static uint16 getEventDataSize (const void* d) noexcept;
 	static uint16 getEventTotalSize (const void* d) noexcept;
@@ -41798,12 +42646,407 @@ private:
 #endif
 #ifndef __JUCE_AUDIOIODEVICETYPE_JUCEHEADER__
 
+#endif
+#ifndef __JUCE_FILEAUDIOIODEVICETYPE_JUCEHEADER__
+
+/*** Start of inlined file: juce_FileAudioIODeviceType.h ***/
+#ifndef __JUCE_FILEAUDIOIODEVICETYPE_JUCEHEADER__
+#define __JUCE_FILEAUDIOIODEVICETYPE_JUCEHEADER__
+
+/**
+	A type of audio device that doesn't need any hardware: its callbacks are driven
+	by a thread, reading their input from an audio file and writing their output
+	to another one.
+
+	This is handy for testing and benchmarking audio code on machines that don't have
+	a sound card, because it behaves the same way every time it's run.
+
+	It provides two devices:
+	- "Real time", which makes its callbacks at the rate that a sound card would, so
+	  you can see whether your code keeps up with the deadlines.
+	- "As fast as possible", which makes the next callback as soon as the previous one
+	  has returned, so you can measure throughput. This one returns true from
+	  AudioIODevice::isFreewheeling().
+
+	The sample rate and block size are whatever you open the device with, like any
+	other device. The files and the number of channels are set on this object, and
+	are used by the devices that it creates afterwards.
+
+	This type isn't one of the ones that an AudioDeviceManager creates by default, so
+	to use it with one, override AudioDeviceManager::createAudioDeviceTypes(), e.g.
+	@code
+	class BenchmarkDeviceManager  : public AudioDeviceManager
+	{
+	public:
+		void createAudioDeviceTypes (OwnedArray <AudioIODeviceType>& types)
+		{
+			FileAudioIODeviceType* type = new FileAudioIODeviceType();
+			type->setInputFile (File ("~/test.wav"));
+			type->setOutputFile (File ("~/result.wav"));
+			type->setLengthToRender (44100 * 60);
+			types.add (type);
+		}
+	};
+	@endcode
+
+	@see AudioIODeviceType, AudioDeviceManager
+*/
+class JUCE_API  FileAudioIODeviceType  : public AudioIODeviceType
+{
+public:
+
+	/** Creates the device type.
+
+		Until they're changed, its devices will have two silent inputs and two outputs,
+		won't write their output anywhere, and will keep going until they're stopped.
+	*/
+	FileAudioIODeviceType();
+
+	/** Destructor. */
+	~FileAudioIODeviceType();
+
+	/** Sets the audio file that the devices will use as their input.
+
+		The whole file is loaded into memory when a device is opened, so that reading it
+		doesn't affect the timing, and it's played in a loop. Its sample rate is ignored,
+		and if it has fewer channels than the device, they get re-used in turn.
+
+		Pass File::nonexistent for the inputs to be silent.
+	*/
+	void setInputFile (const File& audioFile);
+
+	/** Sets the file that the devices will write their output into.
+
+		The format is chosen from the file's extension, and any existing file is replaced
+		when a device is opened. The file is finished when the device is closed, or when
+		it has rendered the length set by setLengthToRender().
+
+		Pass File::nonexistent for the output to be thrown away.
+	*/
+	void setOutputFile (const File& audioFile, int bitsPerSample = 24);
+
+	/** Sets how many input and output channels the devices will have. */
+	void setNumChannels (int numInputChannels, int numOutputChannels);
+
+	/** Makes the devices stop after they've rendered this many samples.
+
+		Once it's finished, the device's isPlaying() method will return false. If the
+		length is 0, the devices keep going until they're stopped.
+	*/
+	void setLengthToRender (int64 numSamples);
+
+	/** @internal */
+	void scanForDevices();
+	/** @internal */
+	StringArray getDeviceNames (bool wantInputNames) const;
+	/** @internal */
+	int getDefaultDeviceIndex (bool forInput) const;
+	/** @internal */
+	int getIndexOfDevice (AudioIODevice* device, bool asInput) const;
+	/** @internal */
+	bool hasSeparateInputsAndOutputs() const;
+	/** @internal */
+	AudioIODevice* createDevice (const String& outputDeviceName, const String& inputDeviceName);
+
+private:
+
+	friend class FileAudioIODevice;
+
+	struct Settings
+	{
+		File inputFile, outputFile;
+		int bitsPerSample, numInputChannels, numOutputChannels;
+		int64 lengthToRender;
+	};
+
+	Settings settings;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FileAudioIODeviceType);
+};
+
+#endif   // __JUCE_FILEAUDIOIODEVICETYPE_JUCEHEADER__
+
+/*** End of inlined file: juce_FileAudioIODeviceType.h ***/
+
+
+#endif
+#ifndef __JUCE_AUDIOBUFFERPOOL_JUCEHEADER__
+
+/*** Start of inlined file: juce_AudioBufferPool.h ***/
+#ifndef __JUCE_AUDIOBUFFERPOOL_JUCEHEADER__
+#define __JUCE_AUDIOBUFFERPOOL_JUCEHEADER__
+
+/**
+	A set of preallocated AudioSampleBuffers that can be borrowed by the audio thread.
+
+	When prepare() is called, the pool allocates a few buffers in each of a range of
+	size classes, from 64 samples up to the largest block size that you expect to process.
+	Each channel's data starts on a 64-byte boundary and is padded to a whole number of
+	cache lines, and all the channels of a buffer sit in a single contiguous block, so the
+	memory can also be used to hold interleaved data.
+
+	Buffers are borrowed using an AudioBufferPool::Buffer object, which picks the smallest
+	free buffer that's big enough, without locking or allocating, and hands it back when it's
+	deleted. E.g.
+	@code
+	void processBlock (AudioSampleBuffer& output)
+	{
+		AudioBufferPool::Buffer temp (pool, 2, output.getNumSamples());
+		temp.getBuffer().clear();
+		...
+	}
+	@endcode
+
+	@see AudioSampleBuffer, ScopedAudioThreadAllocationCheck
+*/
+class JUCE_API  AudioBufferPool
+{
+public:
+
+	/** Creates an empty pool.
+		You'll need to call prepare() before any buffers can be borrowed from it.
+	*/
+	AudioBufferPool();
+
+	/** Destructor.
+		None of the buffers may still be in use when the pool is deleted.
+	*/
+	~AudioBufferPool();
+
+	/** Allocates the buffers.
+
+		This frees any buffers that were previously allocated, so it mustn't be called
+		while any of them are being used - the best place to call it is from a
+		prepareToPlay() method.
+
+		@param maxNumChannels	   the largest number of channels that will be asked for
+		@param maxNumSamples		the largest number of samples that will be asked for
+		@param numBuffersPerSizeClass   how many buffers to create in each size class - this is
+										the number of buffers that can be borrowed at the same
+										time
+	*/
+	void prepare (int maxNumChannels, int maxNumSamples, int numBuffersPerSizeClass = 4);
+
+	/** Frees all the buffers.
+		As with prepare(), none of the buffers can be in use when this is called.
+	*/
+	void release();
+
+	/** Returns the number of channels that each of the buffers has space for. */
+	int getMaxNumChannels() const noexcept	  { return maxChannels; }
+
+	/** Returns the largest number of samples that a buffer can be borrowed for. */
+	int getMaxNumSamples() const noexcept	   { return maxSamples; }
+
+private:
+	class Block;
+
+public:
+
+	/**
+		Borrows a buffer from an AudioBufferPool for as long as this object exists.
+
+		If the pool doesn't have a free buffer that's large enough, this will assert and
+		allocate a buffer instead, so that your code still works - but you should make
+		the pool bigger to avoid allocating on the audio thread.
+	*/
+	class JUCE_API  Buffer
+	{
+	public:
+		/** Borrows a buffer from the pool.
+			The contents of the buffer are undefined, so you may want to clear it.
+		*/
+		Buffer (AudioBufferPool& pool, int numChannels, int numSamples);
+
+		/** Returns the buffer to the pool. */
+		~Buffer();
+
+		/** Returns the buffer, which has exactly the number of channels and samples
+			that were asked for.
+		*/
+		AudioSampleBuffer& getBuffer() noexcept	 { return buffer; }
+
+		/** Returns the buffer's memory as a single block of (numChannels * numSamples)
+			floats, which can be used to hold interleaved data.
+
+			This is the same memory that the AudioSampleBuffer's channels use, so you can't
+			use both at the same time.
+		*/
+		float* getInterleavedData() noexcept		{ return buffer.getSampleData (0); }
+
+	private:
+		Block* const block;
+		AudioSampleBuffer buffer;
+
+		JUCE_DECLARE_NON_COPYABLE (Buffer);
+	};
+
+private:
+
+	OwnedArray <Block> blocks;
+	int maxChannels, maxSamples;
+
+	Block* acquire (int numChannels, int numSamples) noexcept;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioBufferPool);
+};
+
+#endif   // __JUCE_AUDIOBUFFERPOOL_JUCEHEADER__
+
+/*** End of inlined file: juce_AudioBufferPool.h ***/
+
+
 #endif
 #ifndef __JUCE_AUDIODATACONVERTERS_JUCEHEADER__
 
 #endif
 #ifndef __JUCE_AUDIOSAMPLEBUFFER_JUCEHEADER__
 
+#endif
+#ifndef __JUCE_BIQUADCASCADE_JUCEHEADER__
+
+#endif
+#ifndef __JUCE_COMPRESSEDAUDIOBUFFER_JUCEHEADER__
+
+/*** Start of inlined file: juce_CompressedAudioBuffer.h ***/
+#ifndef __JUCE_COMPRESSEDAUDIOBUFFER_JUCEHEADER__
+#define __JUCE_COMPRESSEDAUDIOBUFFER_JUCEHEADER__
+
+/**
+	Holds a block of audio in memory in a losslessly-compressed form, from which any
+	section can be decoded on demand.
+
+	The audio is divided into fixed-size blocks of samplesPerBlock frames, each of which
+	is compressed independently (using a second-order fixed predictor with Rice-coded
+	residuals, similar to FLAC's "fixed" subframes), so any block can be decoded without
+	touching the rest of the data. Typical 16 or 24-bit material takes up around a third
+	of the space that it'd need as an AudioSampleBuffer.
+
+	The decoded samples are exactly the same values that AudioSampleBuffer::readFromAudioReader()
+	would have produced from the same reader. Floating-point sources (and anything else that
+	can't be represented as integers of the reader's bit depth) are stored verbatim.
+
+	To play the audio back, use a BlockCache, which keeps a couple of decoded blocks around
+	the current playback position.
+
+	@see SamplerSound
+*/
+class JUCE_API  CompressedAudioBuffer
+{
+public:
+
+	/** Reads and compresses a section of audio from a reader.
+
+		@param source	   the reader to read from. This isn't retained after the
+								constructor returns
+		@param startSample	  the first sample in the reader to read
+		@param numSamples	   the number of samples to read. Any part of this range that lies
+								beyond the end of the reader will be filled with silence
+		@param maxNumChannels   the maximum number of channels to keep; if the source has more
+								than this, the extra ones are ignored
+	*/
+	CompressedAudioBuffer (AudioFormatReader& source,
+						   int64 startSample,
+						   int numSamples,
+						   int maxNumChannels);
+
+	/** Destructor. */
+	~CompressedAudioBuffer();
+
+	/** The number of sample frames in each independently-decodable block. */
+	enum { samplesPerBlock = 2048 };
+
+	/** Returns the number of channels of audio held. */
+	int getNumChannels() const noexcept		 { return numChannels; }
+
+	/** Returns the number of samples held in each channel. */
+	int getNumSamples() const noexcept		  { return numSamples; }
+
+	/** Returns the number of blocks that the audio has been divided into. */
+	int getNumBlocks() const noexcept		   { return blockOffsets.size() - 1; }
+
+	/** Returns the number of bytes used to hold the compressed data. */
+	size_t getCompressedSize() const noexcept	   { return data.getSize(); }
+
+	/** Decodes one of the blocks.
+
+		@param blockIndex	   the block to decode, from 0 to getNumBlocks() - 1
+		@param destChannels	 an array of getNumChannels() pointers, each of which must have space
+								for samplesPerBlock floats. If the block is the last one and is shorter
+								than samplesPerBlock, the remainder is filled with zeros.
+	*/
+	void decodeBlock (int blockIndex, float* const* destChannels) const noexcept;
+
+	/**
+		Keeps a window of decoded samples from a CompressedAudioBuffer.
+
+		The window covers two adjacent blocks, so that an interpolating player can always
+		read a sample and its successor from it. As playback moves on, the later block is
+		shifted down and the next one is decoded, so each block of source material is only
+		decoded once for forward playback.
+
+		The memory is allocated when the object is created, so a cache can be used on the
+		audio thread without allocating.
+	*/
+	class JUCE_API  BlockCache
+	{
+	public:
+		/** Creates a cache with space for the given number of channels. */
+		explicit BlockCache (int maxNumChannels);
+
+		/** Destructor. */
+		~BlockCache();
+
+		/** Discards any decoded data and sets the buffer that should be read from.
+			The buffer mustn't have more channels than this cache was created for.
+		*/
+		void setSource (const CompressedAudioBuffer* source) noexcept;
+
+		/** Makes sure that the samples at samplePos and samplePos + 1 are decoded. */
+		inline void prepareToRead (const int samplePos) noexcept
+		{
+			if (samplePos < windowStart || samplePos + 1 >= windowEnd)
+				moveWindow (samplePos);
+		}
+
+		/** Returns a pointer to the decoded sample data for a channel.
+
+			The data starts at the sample index returned by getStartSample(), and is only valid
+			until the next call to prepareToRead().
+		*/
+		const float* getSampleData (const int channel) const noexcept   { return channels [channel]; }
+
+		/** Returns the index in the source buffer of the first sample in the decoded window. */
+		int getStartSample() const noexcept				 { return windowStart; }
+
+	private:
+		const CompressedAudioBuffer* source;
+		HeapBlock <float> storage;
+		HeapBlock <float*> channels;
+		int maxChannels, windowStart, windowEnd;
+
+		void moveWindow (int samplePos) noexcept;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BlockCache);
+	};
+
+private:
+
+	MemoryBlock data;
+	Array <int> blockOffsets;
+	int numChannels, numSamples, bitsPerSample;
+	bool usesFloatingPointData;
+
+	void encodeBlock (int* const* samples, int numSamplesInBlock, MemoryOutputStream& out) const;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CompressedAudioBuffer);
+};
+
+#endif   // __JUCE_COMPRESSEDAUDIOBUFFER_JUCEHEADER__
+
+/*** End of inlined file: juce_CompressedAudioBuffer.h ***/
+
+
 #endif
 #ifndef __JUCE_DECIBELS_JUCEHEADER__
 
@@ -41887,6 +43130,82 @@ private:
 /*** End of inlined file: juce_Decibels.h ***/
 
 
+#endif
+#ifndef __JUCE_FLOATVECTOROPERATIONS_JUCEHEADER__
+
+/*** Start of inlined file: juce_FloatVectorOperations.h ***/
+#ifndef __JUCE_FLOATVECTOROPERATIONS_JUCEHEADER__
+#define __JUCE_FLOATVECTOROPERATIONS_JUCEHEADER__
+
+/**
+	A collection of simple vector operations on arrays of floats, accelerated with
+	SSE instructions where they're available.
+
+	These are the loops that sit underneath AudioSampleBuffer's gain, mixing and
+	metering methods. The arrays don't need to be aligned, but they'll run fastest if
+	they start on a 16-byte boundary, which is always the case for the channels of an
+	AudioSampleBuffer that has allocated its own memory.
+
+	In all of these methods, the source and destination arrays must either be the
+	same array, or not overlap at all.
+
+	@see AudioSampleBuffer
+*/
+class JUCE_API  FloatVectorOperations
+{
+public:
+
+	/** Clears a vector of floats. */
+	static void clear (float* dest, int numValues) noexcept;
+
+	/** Copies a vector of floats, multiplying each value by a given multiplier. */
+	static void copyWithMultiply (float* dest, const float* src, float multiplier, int numValues) noexcept;
+
+	/** Copies a vector of floats, multiplying them by a gain which changes by a fixed
+		increment on each sample.
+	*/
+	static void copyWithRamp (float* dest, const float* src, float startGain, float increment, int numValues) noexcept;
+
+	/** Adds the source values to the destination values. */
+	static void add (float* dest, const float* src, int numValues) noexcept;
+
+	/** Multiplies each source value by the given multiplier, then adds it to the destination value. */
+	static void addWithMultiply (float* dest, const float* src, float multiplier, int numValues) noexcept;
+
+	/** Multiplies each source value by a gain which changes by a fixed increment on each
+		sample, and adds it to the destination value.
+	*/
+	static void addWithRamp (float* dest, const float* src, float startGain, float increment, int numValues) noexcept;
+
+	/** Multiplies each of the destination values by a fixed multiplier. */
+	static void multiply (float* dest, float multiplier, int numValues) noexcept;
+
+	/** Multiplies each of the destination values by a gain which changes by a fixed
+		increment on each sample.
+	*/
+	static void multiplyWithRamp (float* dest, float startGain, float increment, int numValues) noexcept;
+
+	/** Finds the lowest and highest values in a vector.
+		If the vector is empty, both results are set to zero.
+	*/
+	static void findMinAndMax (const float* src, int numValues, float& minResult, float& maxResult) noexcept;
+
+	/** Returns the sum of the squares of all the values in a vector.
+		The total is accumulated in double precision, so that long vectors don't lose accuracy.
+	*/
+	static double sumOfSquares (const float* src, int numValues) noexcept;
+
+private:
+	FloatVectorOperations();
+
+	JUCE_DECLARE_NON_COPYABLE (FloatVectorOperations);
+};
+
+#endif   // __JUCE_FLOATVECTOROPERATIONS_JUCEHEADER__
+
+/*** End of inlined file: juce_FloatVectorOperations.h ***/
+
+
 #endif
 #ifndef __JUCE_IIRFILTER_JUCEHEADER__
 
@@ -41937,6 +43256,10 @@ public:
 		These structures act as 'handles' on the events as they are moved about in
 		the list, and make it quick to find the matching note-offs for note-on events.
 
+		The sequence allocates its holders in large blocks rather than individually,
+		so a pointer to one stays valid until that event is deleted or the sequence
+		is cleared.
+
 		@see MidiMessageSequence::getEventPointer
 	*/
 	class MidiEventHolder
@@ -41998,7 +43321,8 @@ public:
 	/** Returns the index of the first event on or after the given timestamp.
 
 		If the time is beyond the end of the sequence, this will return the
-		number of events.
+		number of events. This does a binary search, so it relies on the sequence
+		being sorted.
 	*/
 	int getNextIndexAtTime (double timeStamp) const;
 
@@ -42069,6 +43393,9 @@ public:
 		Call this after moving messages about or deleting/adding messages, and it
 		will scan the list and make sure all the note-offs in the MidiEventHolder
 		structures are pointing at the correct ones.
+
+		If a note-on is followed by another note-on for the same note and channel
+		before any note-off, a note-off is inserted just before the second one.
 	*/
 	void updateMatchedPairs();
 
@@ -42140,8 +43467,14 @@ public:
 private:
 
 	friend class MidiFile;
-	OwnedArray <MidiEventHolder> list;
-
+	Array <MidiEventHolder*> list;
+	OwnedArray <HeapBlock <MidiEventHolder> > eventBlocks;
+	Array <MidiEventHolder*> freeEvents;
+	int numUsedInLastBlock, lastBlockSize;
+
+	MidiEventHolder* createEvent (const MidiMessage& message);
+	void deleteEventObject (MidiEventHolder* event);
+	void deleteAllEvents();
 	void sort();
 
 	JUCE_LEAK_DETECTOR (MidiMessageSequence);
@@ -42305,6 +43638,203 @@ private:
 /*** End of inlined file: juce_MidiFile.h ***/
 
 
+#endif
+#ifndef __JUCE_MIDIFILEREADER_JUCEHEADER__
+
+/*** Start of inlined file: juce_MidiFileReader.h ***/
+#ifndef __JUCE_MIDIFILEREADER_JUCEHEADER__
+#define __JUCE_MIDIFILEREADER_JUCEHEADER__
+
+/**
+	Reads the events from a standard midi file without loading it into MidiMessageSequences.
+
+	Unlike MidiFile, which parses everything into MidiMessage objects when it's loaded, this
+	just finds where the tracks begin. The events are decoded one at a time by a TrackCursor,
+	directly from the file's data, which is usually memory-mapped. To play back all the tracks
+	together, use an Iterator, which merges them into a single stream in time order, and keeps
+	track of the tempo so that it can tell you the time of each event in seconds.
+
+	Apart from the occasional sysex message, no memory is allocated while reading events, and
+	nothing is ever copied except for messages that use running status, so this is a good
+	way to feed large numbers of files to something like an offline renderer.
+	@code
+	MidiFileReader reader (File ("~/song.mid"));
+	MidiFileReader::Iterator i (reader);
+
+	while (i.next())
+		doSomething (i.getData(), i.getDataSize(), i.getTimeInSeconds());
+	@endcode
+
+	@see MidiFile
+*/
+class JUCE_API  MidiFileReader
+{
+public:
+
+	/** Memory-maps a file and reads its header.
+		Use isValid() to find out whether this succeeded.
+	*/
+	explicit MidiFileReader (const File& file);
+
+	/** Reads a midi file that's already in memory.
+
+		The data isn't copied, so it must not be changed or deleted while this object or
+		any of its cursors or iterators still exist.
+	*/
+	MidiFileReader (const void* midiFileData, size_t dataSize);
+
+	/** Destructor. */
+	~MidiFileReader();
+
+	/** Returns true if the data was a valid midi file. */
+	bool isValid() const noexcept			   { return valid; }
+
+	/** Returns the number of tracks in the file. */
+	int getNumTracks() const noexcept		   { return tracks.size(); }
+
+	/** Returns the file's time format, in the same form as MidiFile::getTimeFormat(). */
+	short getTimeFormat() const noexcept		{ return timeFormat; }
+
+	/**
+		Steps through the events in one of the tracks of a MidiFileReader.
+
+		The timestamps are the number of ticks since the start of the track.
+	*/
+	class JUCE_API  TrackCursor
+	{
+	public:
+		/** Creates a cursor which is positioned before the first event of a track.
+			You'll need to call next() to read the first event.
+		*/
+		TrackCursor (const MidiFileReader& reader, int trackIndex);
+
+		/** Destructor. */
+		~TrackCursor();
+
+		/** Moves on to the next event.
+			@returns false if there are no more events in the track, or if the data is corrupt
+		*/
+		bool next() noexcept;
+
+		/** Goes back to the start of the track. */
+		void rewind() noexcept;
+
+		/** Returns the current event's position, in ticks from the start of the track. */
+		int64 getTick() const noexcept			  { return tick; }
+
+		/** Returns the current event's raw midi data.
+
+			This usually points straight into the file, and is only valid until the cursor
+			is moved. The data is in the same form that a MidiMessage would hold it.
+		*/
+		const uint8* getData() const noexcept		   { return eventData; }
+
+		/** Returns the number of bytes in the current event. */
+		int getDataSize() const noexcept			{ return eventSize; }
+
+		/** Creates a MidiMessage for the current event, with its timestamp set to the tick. */
+		MidiMessage getMessage() const;
+
+		/** Returns the index of the track that this cursor is reading. */
+		int getTrackIndex() const noexcept		  { return trackIndex; }
+
+	private:
+		const uint8* trackStart;
+		const uint8* trackEnd;
+		const uint8* position;
+		const uint8* eventData;
+		int eventSize, trackIndex;
+		int64 tick;
+		uint8 runningStatus;
+		uint8 shortMessage [4];
+		MemoryBlock sysexData;
+
+		JUCE_DECLARE_NON_COPYABLE (TrackCursor);
+	};
+
+	/**
+		Merges all the tracks of a MidiFileReader into a single stream of events,
+		sorted by time.
+
+		Events that happen at the same time are returned with any note-offs first, then in
+		order of their track numbers.
+	*/
+	class JUCE_API  Iterator
+	{
+	public:
+		/** Creates an iterator which is positioned before the first event in the file.
+			You'll need to call next() to read the first event.
+		*/
+		explicit Iterator (const MidiFileReader& reader);
+
+		/** Destructor. */
+		~Iterator();
+
+		/** Moves on to the next event.
+			@returns false if all the tracks have finished
+		*/
+		bool next() noexcept;
+
+		/** Returns the current event's position in ticks. */
+		int64 getTick() const noexcept			  { return current->getTick(); }
+
+		/** Returns the current event's position in seconds, taking into account all the
+			tempo changes that have happened before it.
+		*/
+		double getTimeInSeconds() const noexcept		{ return timeInSeconds; }
+
+		/** Returns the current event's raw midi data - see TrackCursor::getData(). */
+		const uint8* getData() const noexcept		   { return current->getData(); }
+
+		/** Returns the number of bytes in the current event. */
+		int getDataSize() const noexcept			{ return current->getDataSize(); }
+
+		/** Returns the index of the track that the current event came from. */
+		int getTrackIndex() const noexcept		  { return current->getTrackIndex(); }
+
+		/** Creates a MidiMessage for the current event, with its timestamp set to the time in seconds. */
+		MidiMessage getMessage() const;
+
+	private:
+		OwnedArray <TrackCursor> cursors;
+		HeapBlock <TrackCursor*> queue;
+		TrackCursor* current;
+		int queueSize;
+		const short timeFormat;
+		int64 lastTick;
+		double timeInSeconds, secondsPerTick;
+		bool needsToAdvance;
+
+		static bool comesBefore (const TrackCursor* a, const TrackCursor* b) noexcept;
+		void removeFromQueue() noexcept;
+		void sortDown (int index) noexcept;
+
+		JUCE_DECLARE_NON_COPYABLE (Iterator);
+	};
+
+private:
+
+	struct TrackInfo
+	{
+		const uint8* data;
+		int size;
+	};
+
+	ScopedPointer <MemoryMappedFile> mappedFile;
+	Array <TrackInfo> tracks;
+	short timeFormat;
+	bool valid;
+
+	void parse (const uint8* data, size_t dataSize);
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiFileReader);
+};
+
+#endif   // __JUCE_MIDIFILEREADER_JUCEHEADER__
+
+/*** End of inlined file: juce_MidiFileReader.h ***/
+
+
 #endif
 #ifndef __JUCE_MIDIINPUT_JUCEHEADER__
 
@@ -42507,6 +44037,11 @@ private:
 	The class can also be used as either a MidiKeyboardStateListener or a MidiInputCallback
 	so it can easily use a midi input or keyboard component as its source.
 
+	Incoming messages are stored in a lock-free FIFO along with their timestamps, and are
+	only converted into sample positions when the audio thread collects them, so the audio
+	thread never has to wait for a midi input thread. Messages that arrive while the FIFO
+	is full are dropped - getNumDroppedMessages() tells you whether this has happened.
+
 	@see MidiMessage, MidiInput
 */
 class JUCE_API  MidiMessageCollector	: public MidiKeyboardStateListener,
@@ -42523,7 +44058,8 @@ public:
 	/** Clears any messages from the queue.
 
 		You need to call this method before starting to use the collector, so that
-		it knows the correct sample rate to use.
+		it knows the correct sample rate to use. It mustn't be called while another
+		thread is inside removeNextBlockOfMessages().
 	*/
 	void reset (double sampleRate);
 
@@ -42533,7 +44069,8 @@ public:
 		of the block returned by the next call to removeNextBlockOfMessages().
 
 		This method is fully thread-safe when overlapping calls are made with
-		removeNextBlockOfMessages().
+		removeNextBlockOfMessages(), and never blocks the thread that's calling that.
+		If several threads call it at once, they'll briefly wait for each other.
 	*/
 	void addMessageToQueue (const MidiMessage& message);
 
@@ -42547,10 +44084,19 @@ public:
 		midi event positions.
 
 		This method is fully thread-safe when overlapping calls are made with
-		addMessageToQueue().
+		addMessageToQueue(). It doesn't lock or allocate, although the destination
+		buffer may need to grow if it hasn't had enough space reserved with
+		MidiBuffer::ensureSize().
 	*/
 	void removeNextBlockOfMessages (MidiBuffer& destBuffer, int numSamples);
 
+	/** Returns the number of messages that have been thrown away because they arrived
+		when the queue was full.
+
+		This is reset to zero by reset().
+	*/
+	int getNumDroppedMessages() const noexcept	  { return numDroppedMessages.get(); }
+
 	/** @internal */
 	void handleNoteOn (MidiKeyboardState* source, int midiChannel, int midiNoteNumber, float velocity);
 	/** @internal */
@@ -42560,11 +44106,30 @@ public:
 
 private:
 
+	enum
+	{
+		maxQueuedMessages = 2048,
+		sysexBufferSize = 65536,
+		maxInlineBytes = 20
+	};
+
+	struct QueuedMessage
+	{
+		double timeStamp;
+		int numBytes;
+		uint8 data [maxInlineBytes];	// longer messages go into sysexData instead
+	};
+
 	double lastCallbackTime;
-	CriticalSection midiCallbackLock;
-	MidiBuffer incomingMessages;
+	SpinLock writerLock;
+	AbstractFifo messageFifo, sysexFifo;
+	HeapBlock <QueuedMessage> messages;
+	HeapBlock <uint8> sysexData, sysexScratch;
+	Atomic<int> numDroppedMessages;
 	double sampleRate;
 
+	const uint8* readMessageData (const QueuedMessage& message) noexcept;
+
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiMessageCollector);
 };
 
@@ -44553,6 +46118,39 @@ public:
 	void scanAndAddDragAndDroppedFiles (const StringArray& filenames,
 										OwnedArray <PluginDescription>& typesFound);
 
+	/** Gives the list a file in which to remember what it found in each plugin file
+		that it has scanned.
+
+		Each file's entry is keyed by its path, size and modification time, and includes
+		the files that turned out not to contain any plugins. When scanAndAddFile() is
+		asked not to rescan, it'll take the types from the cache instead of loading a
+		file whose entry still matches, so even after the list has been cleared, a
+		rescan of a folder full of unchanged plugins only needs to look at the files'
+		sizes and dates.
+
+		The cache is kept in a compact binary format, separately from the XML that
+		createXml() makes, and any existing contents of the file are loaded by this
+		method. Only plugins that are identified by a file path can be cached.
+		To make a scan load every file again, pass false for its dontRescanIfAlreadyInList
+		parameter.
+
+		Pass File::nonexistent to stop using a cache.
+
+		@see saveScanCacheIfNeeded
+	*/
+	void setScanCacheFile (const File& cacheFile);
+
+	/** Writes the scan cache to its file, if anything has been added to it since it
+		was loaded.
+
+		This is called automatically when the list is deleted, and when a
+		PluginDirectoryScanner finishes with it. Returns false if the file couldn't
+		be written.
+
+		@see setScanCacheFile
+	*/
+	bool saveScanCacheIfNeeded();
+
 	/** Sort methods used to change the order of the plugins in the list.
 	*/
 	enum SortMethod
@@ -44597,6 +46195,17 @@ private:
 
 	OwnedArray <PluginDescription> types;
 
+	class ScanCache;
+	friend class ScanCache;
+	friend class PluginDirectoryScanner;
+	ScopedPointer <ScanCache> scanCache;
+
+	bool addTypesFromScanCache (const String& fileOrIdentifier, AudioPluginFormat& format,
+								OwnedArray <PluginDescription>& typesFound);
+	bool addScannedTypes (const String& fileOrIdentifier, AudioPluginFormat& format,
+						  const OwnedArray <PluginDescription>& found,
+						  OwnedArray <PluginDescription>& typesFound);
+
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (KnownPluginList);
 };
 
@@ -44688,6 +46297,56 @@ public:
 	*/
 	const StringArray& getFailedFiles() const noexcept		  { return failedFiles; }
 
+	/** Makes the scanner load the plugins in some separate processes, rather than in
+		this one.
+
+		This means that a plugin which crashes or hangs while it's being loaded can't take
+		your app down with it, and several plugins can be scanned at once. After calling
+		this, each call to scanNextFile() collects any results that have come back, hands
+		out more files to the processes that are idle, and then waits briefly for them.
+
+		The scanner processes are launched by running scannerExecutable - normally
+		this will be your own app, e.g. File::getSpecialLocation (File::currentExecutableFile),
+		which must call handleScannerProcessCommandLine() when it starts up.
+
+		@param scannerExecutable	the program to run for each scanner process
+		@param numProcesses	 how many processes to run at once
+		@param timeoutMs		how long a plugin may take to load before it's treated
+									as having failed, and its process gets killed
+
+		If the processes can't be launched, the scanner goes back to loading the
+		plugins itself.
+	*/
+	void scanInChildProcesses (const File& scannerExecutable, int numProcesses, int timeoutMs);
+
+	/** Runs a plugin scanner process, if this is the command line that a
+		PluginDirectoryScanner used to launch it.
+
+		If your app is used for scanInChildProcesses(), call this at the start of your
+		JUCEApplication::initialise() method, after adding your plugin formats to the
+		AudioPluginFormatManager. If it returns true, the scanning has been done, and
+		your app should quit without doing anything else. If it returns false, the app
+		wasn't launched as a scanner, and should carry on as usual.
+	*/
+	static bool handleScannerProcessCommandLine (const String& commandLine);
+
+	/** Makes the scanner load several plugins at once, using a pool of threads in
+		this process.
+
+		After calling this, each call to scanNextFile() collects the types found by
+		any threads that have finished, gives the idle threads some more files, and
+		then waits briefly for them.
+
+		This is quicker than scanInChildProcesses() because nothing has to be launched,
+		but a plugin that crashes while it's being loaded will take your app down with
+		it. Only use it for formats whose plugins can safely be opened away from the
+		message thread, and by several threads at the same time.
+
+		Plugins that the KnownPluginList can find in its scan cache are added straight
+		away without being given to a thread - see KnownPluginList::setScanCacheFile().
+	*/
+	void scanInThreads (int numThreads);
+
 private:
 
 	KnownPluginList& list;
@@ -44698,8 +46357,21 @@ private:
 	int nextIndex;
 	float progress;
 
+	class ChildProcessPool;
+	friend class ChildProcessPool;
+	ScopedPointer<ChildProcessPool> childProcesses;
+	int numFilesFinished;
+
+	class ScanThreadPool;
+	friend class ScanThreadPool;
+	ScopedPointer<ScanThreadPool> scanThreads;
+
 	StringArray getDeadMansPedalFile();
 	void setDeadMansPedalFile (const StringArray& newContents);
+	const String getNextFileThatNeedsScanning (bool dontRescanIfAlreadyInList);
+	bool scanNextFilesInChildProcesses (bool dontRescanIfAlreadyInList);
+	bool scanNextFilesInThreads (bool dontRescanIfAlreadyInList);
+	void fileFinished (const String& file, int numTypesFound, bool crashed);
 
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginDirectoryScanner);
 };
@@ -46536,6 +48208,19 @@ public:
 	/** Destructor. */
 	~PluginListComponent();
 
+	/** Makes the component's scans load the plugins in separate processes.
+
+		See PluginDirectoryScanner::scanInChildProcesses() for details.
+	*/
+	void setScanInChildProcesses (const File& scannerExecutable, int numProcesses, int timeoutMs);
+
+	/** Makes the component's scans load several plugins at once in this process.
+
+		This is ignored if setScanInChildProcesses() has been used. See
+		PluginDirectoryScanner::scanInThreads() for details.
+	*/
+	void setScanInThreads (int numThreads);
+
 	/** @internal */
 	void resized();
 	/** @internal */
@@ -46563,6 +48248,8 @@ private:
 	TextButton optionsButton;
 	PropertiesFile* propertiesToUse;
 	int typeToScan;
+	File scannerExecutable;
+	int numScannerProcesses, scannerTimeoutMs, numScanThreads;
 
 	void scanFor (AudioPluginFormat* format);
 	static void optionsMenuStaticCallback (int result, PluginListComponent*);
@@ -46605,6 +48292,11 @@ private:
 
 	To play back a graph through an audio device, you might want to use an
 	AudioProcessorPlayer object.
+
+	Changes to the nodes and connections are picked up asynchronously: the new
+	rendering sequence is worked out on the message thread (or whichever thread
+	calls prepareToPlay()), and handed over to the audio thread without it ever
+	having to wait for a lock.
 */
 class JUCE_API  AudioProcessorGraph   : public AudioProcessor,
 										public AsyncUpdater
@@ -46654,8 +48346,13 @@ public:
 
 		const ScopedPointer<AudioProcessor> processor;
 		bool isPrepared;
+		int renderIndex;
+
+		class LatencyWatcher;
+		ScopedPointer<LatencyWatcher> latencyWatcher;
 
 		Node (uint32 nodeId, AudioProcessor* processor) noexcept;
+		~Node();
 
 		void prepare (double sampleRate, int blockSize, AudioProcessorGraph* graph);
 		void unprepare();
@@ -46807,6 +48504,40 @@ public:
 	*/
 	bool removeIllegalConnections();
 
+	/** Sets how many threads the graph uses to render each block.
+
+		With the default of 1, the nodes are processed one after another on the thread
+		that calls processBlock(). With more than that, the graph starts (numThreads - 1)
+		helper threads, and nodes that don't depend on each other's output get processed
+		at the same time, with the calling thread joining in.
+
+		The result is bit-identical to rendering serially, because each of the shared
+		buffers still has exactly the same operations done to it in the same order. But
+		it does mean that different processors will be running at the same time, so
+		only turn this on if they're all happy with that. A processor is never run on
+		two threads at once.
+	*/
+	void setNumRenderThreads (int numThreads);
+
+	/** Returns the number of threads set with setNumRenderThreads(). */
+	int getNumRenderThreads() const noexcept			{ return numRenderThreads; }
+
+	/** Sets the longest delay, in samples, that the graph's latency compensation should
+		be ready for.
+
+		When processors with different latencies feed into the same node, the graph
+		delays the quicker paths to keep everything lined up. Its delay lines are made
+		long enough for this much latency up-front, so that when a processor's latency
+		changes (up to this limit) the graph can adjust without reallocating anything or
+		losing the audio that's in them. Longer delays still work, but need new delay lines.
+
+		The default is 8192 samples.
+	*/
+	void setMaxLatencyCompensation (int numSamples);
+
+	/** Returns the value set by setMaxLatencyCompensation(). */
+	int getMaxLatencyCompensation() const noexcept		  { return maxLatencyCompensation; }
+
 	/** A special number that represents the midi channel of a node.
 
 		This is used as a channel index value if you want to refer to the midi input
@@ -46946,21 +48677,35 @@ private:
 
 	ReferenceCountedArray <Node> nodes;
 	OwnedArray <Connection> connections;
+	Array <Node*> renderOrder;
 	uint32 lastNodeId;
-	AudioSampleBuffer renderingBuffers;
-	OwnedArray <MidiBuffer> midiBuffers;
+	CriticalSection graphLock, renderLock;
+
+	class RenderingTaskList;
+	class RenderThreadPool;
+	class RenderSequence;
+	class RetiredSequenceDeleter;
+	RenderSequence* activeSequence;
+	Atomic <RenderSequence*> pendingSequence, retiredSequences;
+	ScopedPointer<RetiredSequenceDeleter> retiredSequenceDeleter;
+	ScopedPointer<RenderThreadPool> renderThreads;
+	int numRenderThreads;
 
-	CriticalSection renderLock;
-	Array<void*> renderingOps;
+	ReferenceCountedArray <ReferenceCountedObject> delayLines;
+	int maxLatencyCompensation;
 
 	friend class AudioGraphIOProcessor;
+	friend class AudioProcessorGraphTests;
 	AudioSampleBuffer* currentAudioInputBuffer;
-	AudioSampleBuffer currentAudioOutputBuffer;
+	AudioSampleBuffer* currentAudioOutputBuffer;
+	AudioBufferPool outputBufferPool;
 	MidiBuffer* currentMidiInputBuffer;
 	MidiBuffer currentMidiOutputBuffer;
 
 	void clearRenderingSequence();
 	void buildRenderingSequence();
+	void deleteRetiredSequences();
+	void addToRenderOrder (const Node* source, const Node* dest);
 
 	bool isAnInputTo (uint32 possibleInputId, uint32 possibleDestinationId, int recursionCheck) const;
 
@@ -46991,6 +48736,12 @@ private:
 	It's also a MidiInputCallback, so you can connect it to both an audio and midi
 	input to send both streams through the processor.
 
+	The audio callback never waits for a lock: the processor gets handed over to it
+	through an atomic pointer, and setProcessor() waits on the message thread until
+	the audio thread has finished with the old one. It also keeps track of how long
+	each block takes to render, compared with the time the device allows for it - see
+	getCpuStats().
+
 	@see AudioProcessor, AudioProcessorGraph
 */
 class JUCE_API  AudioProcessorPlayer	: public AudioIODeviceCallback,
@@ -47009,6 +48760,10 @@ public:
 
 		The processor that is passed in will not be deleted or owned by this object.
 		To stop anything playing, pass in 0 to this method.
+
+		If the device is running, this waits until any audio callback that might still
+		be using the old processor has finished, so once it returns, the old one can
+		safely be deleted. Don't call it from the audio thread!
 	*/
 	void setProcessor (AudioProcessor* processorToPlay);
 
@@ -47022,6 +48777,47 @@ public:
 	*/
 	MidiMessageCollector& getMidiMessageCollector()		 { return messageCollector; }
 
+	/** A snapshot of how long the processor has been taking to render its blocks.
+
+		The "load" of a block is the time it took to process, divided by the length
+		of audio it contained, so anything above 1.0 means that the block missed its
+		deadline.
+
+		@see getCpuStats
+	*/
+	struct JUCE_API  CpuStats
+	{
+		/** The histogram has one bin for each 5% of load, up to 100%, and the last
+			bin counts the blocks that went over.
+		*/
+		enum { numHistogramBins = 21 };
+
+		int64 numBlocks;		/**< The number of blocks that have been rendered. */
+		int64 numOverruns;	  /**< The number of blocks that took longer to render than they lasted. */
+		int64 numDropouts;	  /**< The number of callbacks that came more than two blocks late,
+										 which usually means that the device glitched. */
+		double averageLoad;	 /**< The total processing time, divided by the total length of the blocks. */
+		double peakLoad;		/**< The highest load that any block has had. */
+		double latestLoad;	  /**< The load of the most recent block, e.g. for a CPU meter. */
+		int64 histogram [numHistogramBins];
+
+		/** Returns a one-line description of these stats, for logging. */
+		const String getSummary() const;
+	};
+
+	/** Returns the stats for the blocks that have been rendered since the device
+		was started, or since the last call to resetCpuStats().
+
+		This can be called from any thread, and doesn't interfere with the audio
+		thread, although the values may be a block or so out of step with each other.
+
+		Blocks that are rendered while the device is freewheeling aren't counted.
+	*/
+	const CpuStats getCpuStats() const;
+
+	/** Clears the CPU stats. */
+	void resetCpuStats();
+
 	/** @internal */
 	void audioDeviceIOCallback (const float** inputChannelData,
 								int totalNumInputChannels,
@@ -47038,18 +48834,38 @@ public:
 private:
 
 	AudioProcessor* processor;
+	Atomic <AudioProcessor*> callbackProcessor;
+	Atomic <int> callbackCounter;  // (odd while the audio callback is running)
 	CriticalSection lock;
 	double sampleRate;
 	int blockSize;
 	bool isPrepared;
 
+	// (these are only ever written by the audio thread, apart from being reset)
+	struct CpuCounters
+	{
+		Atomic <int64> numBlocks, numOverruns, numDropouts, processingTicks, deadlineTicks;
+		Atomic <int> peakLoad, latestLoad; // (in 1/1000ths)
+		Atomic <int64> histogram [CpuStats::numHistogramBins];
+	};
+
+	CpuCounters cpuCounters;
+	double ticksPerSample;
+	int64 lastCallbackStartTicks, lastDeadlineTicks;
+
 	int numInputChans, numOutputChans;
 	float* channels [128];
 	AudioSampleBuffer tempBuffer;
 
+	AudioIODevice* currentDevice;
+	bool wasFreewheeling;
+
 	MidiBuffer incomingMidi;
 	MidiMessageCollector messageCollector;
 
+	void waitForCallbackToFinish() const;
+	void addBlockToCpuStats (int64 startTicks, int numSamples) noexcept;
+
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioProcessorPlayer);
 };
 
@@ -47788,7 +49604,8 @@ private:
 	A subclass of SynthesiserSound that represents a sampled audio clip.
 
 	This is a pretty basic sampler, and just attempts to load the whole audio stream
-	into memory.
+	into memory. To save space, the audio can be held in a CompressedAudioBuffer
+	instead, in which case each SamplerVoice decodes it as it plays.
 
 	To use it, create a Synthesiser, add some SamplerVoice objects to it, then
 	give it some SampledSound objects to play.
@@ -47816,6 +49633,9 @@ public:
 		@param releaseTimeSecs  the decay (fade-out) time, in seconds
 		@param maxSampleLengthSeconds   a maximum length of audio to read from the audio
 										source, in seconds
+		@param storeCompressed  if true, the audio is kept in a CompressedAudioBuffer rather
+								than an AudioSampleBuffer. This uses far less memory, at the
+								cost of some decoding work in the voices that play it
 	*/
 	SamplerSound (const String& name,
 				  AudioFormatReader& source,
@@ -47823,7 +49643,8 @@ public:
 				  int midiNoteForNormalPitch,
 				  double attackTimeSecs,
 				  double releaseTimeSecs,
-				  double maxSampleLengthSeconds);
+				  double maxSampleLengthSeconds,
+				  bool storeCompressed = false);
 
 	/** Destructor. */
 	~SamplerSound();
@@ -47832,10 +49653,16 @@ public:
 	const String& getName() const			   { return name; }
 
 	/** Returns the audio sample data.
-		This could be 0 if there was a problem loading it.
+		This could be 0 if there was a problem loading it, or if the sound was
+		created with the storeCompressed option.
 	*/
 	AudioSampleBuffer* getAudioData() const		 { return data; }
 
+	/** Returns the compressed audio data.
+		This will be 0 unless the sound was created with the storeCompressed option.
+	*/
+	CompressedAudioBuffer* getCompressedAudioData() const   { return compressedData; }
+
 	bool appliesToNote (const int midiNoteNumber);
 	bool appliesToChannel (const int midiChannel);
 
@@ -47845,6 +49672,7 @@ private:
 
 	String name;
 	ScopedPointer <AudioSampleBuffer> data;
+	ScopedPointer <CompressedAudioBuffer> compressedData;
 	double sourceSampleRate;
 	BigInteger midiNotes;
 	int length, attackSamples, releaseSamples;
@@ -47893,6 +49721,7 @@ private:
 	double sourceSamplePosition;
 	float lgain, rgain, attackReleaseLevel, attackDelta, releaseDelta;
 	bool isInAttack, isInRelease;
+	CompressedAudioBuffer::BlockCache blockCache;
 
 	JUCE_LEAK_DETECTOR (SamplerVoice);
 };
@@ -48207,9 +50036,13 @@ public:
 
 		Use stop() to stop the thread running.
 
+		If bindAddress is empty, connections are accepted on all the machine's network
+		interfaces; to only accept them from other processes on the same machine, you
+		can pass "127.0.0.1".
+
 		@see createConnectionObject, stop
 	*/
-	bool beginWaitingForSocket (int portNumber);
+	bool beginWaitingForSocket (int portNumber, const String& bindAddress = String::empty);
 
 	/** Terminates the listener thread, if it's active.
 
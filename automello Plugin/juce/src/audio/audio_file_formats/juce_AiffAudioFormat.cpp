@@ -480,6 +480,16 @@ public:
         return true;
     }
 
+    void readMaxLevels (int64 startSampleInFile, int64 numSamples,
+                        float& lowestLeft, float& highestLeft,
+                        float& lowestRight, float& highestRight)
+    {
+        if (! readMaxLevelsFromRawData (dataChunkStart, bytesPerFrame, littleEndian, startSampleInFile, numSamples,
+                                        lowestLeft, highestLeft, lowestRight, highestRight))
+            AudioFormatReader::readMaxLevels (startSampleInFile, numSamples,
+                                              lowestLeft, highestLeft, lowestRight, highestRight);
+    }
+
 private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AiffAudioFormatReader);
 };
@@ -694,6 +704,15 @@ const Array <int> AiffAudioFormat::getPossibleBitDepths()
 bool AiffAudioFormat::canDoStereo() { return true; }
 bool AiffAudioFormat::canDoMono()   { return true; }
 
+bool AiffAudioFormat::matchesStreamHeader (const void* headerData, const int numBytes) const
+{
+    const char* const d = static_cast <const char*> (headerData);
+
+    return numBytes >= 12
+            && memcmp (d, "FORM", 4) == 0
+            && (memcmp (d + 8, "AIFF", 4) == 0 || memcmp (d + 8, "AIFC", 4) == 0);
+}
+
 #if JUCE_MAC
 bool AiffAudioFormat::canHandleFile (const File& f)
 {
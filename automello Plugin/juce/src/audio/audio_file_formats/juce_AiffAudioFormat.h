@@ -50,6 +50,7 @@ public:
     const Array <int> getPossibleBitDepths();
     bool canDoStereo();
     bool canDoMono();
+    bool matchesStreamHeader (const void* headerData, int numBytes) const;
 
    #if JUCE_MAC
     bool canHandleFile (const File& fileToTest);
@@ -0,0 +1,231 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#include "../../core/juce_StandardHeader.h"
+
+BEGIN_JUCE_NAMESPACE
+
+#include "juce_AudioFileHeaderCache.h"
+
+
+//==============================================================================
+struct HeaderCacheEntry
+{
+    String path;
+    int64 fileSize, modificationTime;
+    AudioFileHeaderCache::HeaderInfo info;
+
+    bool matches (const File& file) const
+    {
+        return file.getSize() == fileSize
+                && file.getLastModificationTime().toMilliseconds() == modificationTime;
+    }
+
+    bool hasSameDetailsAs (const HeaderCacheEntry& other) const
+    {
+        return fileSize == other.fileSize
+                && modificationTime == other.modificationTime
+                && info.formatName == other.info.formatName
+                && info.sampleRate == other.info.sampleRate
+                && info.bitsPerSample == other.info.bitsPerSample
+                && info.numChannels == other.info.numChannels
+                && info.lengthInSamples == other.info.lengthInSamples
+                && info.usesFloatingPointData == other.info.usesFloatingPointData
+                && info.metadataValues == other.info.metadataValues;
+    }
+};
+
+//==============================================================================
+AudioFileHeaderCache::HeaderInfo::HeaderInfo()
+    : sampleRate (0),
+      bitsPerSample (0),
+      numChannels (0),
+      lengthInSamples (0),
+      usesFloatingPointData (false)
+{
+}
+
+AudioFileHeaderCache::HeaderInfo::HeaderInfo (const AudioFormatReader& reader)
+    : formatName (reader.getFormatName()),
+      sampleRate (reader.sampleRate),
+      bitsPerSample (reader.bitsPerSample),
+      numChannels (reader.numChannels),
+      lengthInSamples (reader.lengthInSamples),
+      usesFloatingPointData (reader.usesFloatingPointData),
+      metadataValues (reader.metadataValues)
+{
+}
+
+//==============================================================================
+AudioFileHeaderCache::AudioFileHeaderCache()
+    : changed (false)
+{
+}
+
+AudioFileHeaderCache::~AudioFileHeaderCache()
+{
+}
+
+//==============================================================================
+bool AudioFileHeaderCache::getHeader (const File& file, HeaderInfo& result) const
+{
+    const ScopedLock sl (lock);
+    const HeaderCacheEntry* const e = entriesByPath [file.getFullPathName()];
+
+    if (e == nullptr || ! e->matches (file))
+        return false;
+
+    result = e->info;
+    return true;
+}
+
+void AudioFileHeaderCache::addHeader (const File& file, const AudioFormatReader& reader)
+{
+    ScopedPointer <HeaderCacheEntry> e (new HeaderCacheEntry());
+    e->path = file.getFullPathName();
+    e->fileSize = file.getSize();
+    e->modificationTime = file.getLastModificationTime().toMilliseconds();
+    e->info = HeaderInfo (reader);
+
+    const ScopedLock sl (lock);
+    const HeaderCacheEntry* const existing = entriesByPath [e->path];
+
+    if (existing == nullptr || ! existing->hasSameDetailsAs (*e))
+    {
+        addEntry (e.release());
+        changed = true;
+    }
+}
+
+void AudioFileHeaderCache::addEntry (HeaderCacheEntry* const e)
+{
+    HeaderCacheEntry* const existing = entriesByPath [e->path];
+
+    if (existing != nullptr)
+        entries.removeObject (existing);
+
+    entries.add (e);
+    entriesByPath.set (e->path, e);
+}
+
+void AudioFileHeaderCache::removeHeader (const File& file)
+{
+    const ScopedLock sl (lock);
+    const String path (file.getFullPathName());
+    HeaderCacheEntry* const e = entriesByPath [path];
+
+    if (e != nullptr)
+    {
+        entriesByPath.remove (path);
+        entries.removeObject (e);
+        changed = true;
+    }
+}
+
+void AudioFileHeaderCache::clear()
+{
+    const ScopedLock sl (lock);
+
+    if (entries.size() > 0)
+    {
+        entriesByPath.clear();
+        entries.clear();
+        changed = true;
+    }
+}
+
+int AudioFileHeaderCache::getNumHeaders() const
+{
+    return entries.size();
+}
+
+//==============================================================================
+XmlElement* AudioFileHeaderCache::createXml() const
+{
+    XmlElement* const xml = new XmlElement ("AUDIOFILEHEADERS");
+
+    const ScopedLock sl (lock);
+
+    for (int i = 0; i < entries.size(); ++i)
+    {
+        const HeaderCacheEntry* const e = entries.getUnchecked (i);
+
+        XmlElement* const f = xml->createNewChildElement ("FILE");
+        f->setAttribute ("path", e->path);
+        f->setAttribute ("size", String (e->fileSize));
+        f->setAttribute ("modified", String (e->modificationTime));
+        f->setAttribute ("format", e->info.formatName);
+        f->setAttribute ("rate", e->info.sampleRate);
+        f->setAttribute ("bits", (int) e->info.bitsPerSample);
+        f->setAttribute ("channels", (int) e->info.numChannels);
+        f->setAttribute ("length", String (e->info.lengthInSamples));
+        f->setAttribute ("float", e->info.usesFloatingPointData);
+
+        const StringArray& keys = e->info.metadataValues.getAllKeys();
+        const StringArray& values = e->info.metadataValues.getAllValues();
+
+        for (int j = 0; j < keys.size(); ++j)
+        {
+            XmlElement* const m = f->createNewChildElement ("METADATA");
+            m->setAttribute ("key", keys[j]);
+            m->setAttribute ("value", values[j]);
+        }
+    }
+
+    return xml;
+}
+
+void AudioFileHeaderCache::restoreFromXml (const XmlElement& xml)
+{
+    const ScopedLock sl (lock);
+    clear();
+
+    if (xml.hasTagName ("AUDIOFILEHEADERS"))
+    {
+        forEachXmlChildElementWithTagName (xml, f, "FILE")
+        {
+            HeaderCacheEntry* const e = new HeaderCacheEntry();
+            e->path = f->getStringAttribute ("path");
+            e->fileSize = f->getStringAttribute ("size").getLargeIntValue();
+            e->modificationTime = f->getStringAttribute ("modified").getLargeIntValue();
+            e->info.formatName = f->getStringAttribute ("format");
+            e->info.sampleRate = f->getDoubleAttribute ("rate");
+            e->info.bitsPerSample = (unsigned int) f->getIntAttribute ("bits");
+            e->info.numChannels = (unsigned int) f->getIntAttribute ("channels");
+            e->info.lengthInSamples = f->getStringAttribute ("length").getLargeIntValue();
+            e->info.usesFloatingPointData = f->getBoolAttribute ("float");
+
+            forEachXmlChildElementWithTagName (*f, m, "METADATA")
+                e->info.metadataValues.set (m->getStringAttribute ("key"),
+                                            m->getStringAttribute ("value"));
+
+            addEntry (e);
+        }
+    }
+
+    changed = false;
+}
+
+END_JUCE_NAMESPACE
@@ -0,0 +1,166 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_AUDIOFILEHEADERCACHE_JUCEHEADER__
+#define __JUCE_AUDIOFILEHEADERCACHE_JUCEHEADER__
+
+#include "juce_AudioFormatReader.h"
+#include "../../io/files/juce_File.h"
+#include "../../containers/juce_OwnedArray.h"
+#include "../../containers/juce_HashMap.h"
+#include "../../text/juce_XmlElement.h"
+#include "../../threads/juce_CriticalSection.h"
+struct HeaderCacheEntry;
+
+
+//==============================================================================
+/**
+    Keeps a record of the properties of a set of audio files, so that they don't
+    need to be re-parsed each time they're needed.
+
+    Each entry stores the details that an AudioFormatReader pulled out of a file's
+    header (sample rate, channels, length, loop points and other metadata, etc.)
+    along with the file's size and modification time, so that if the file is changed,
+    its entry will be ignored.
+
+    If you give one of these to an AudioFormatManager, it'll add an entry for each
+    file that it opens, and will use the cached format name to go straight to the
+    right AudioFormat the next time a file is opened. The contents can be saved and
+    restored as XML, so that the cache can persist between sessions, and hasChanged()
+    tells you whether there's anything new that's worth saving.
+
+    @see AudioFormatManager::setHeaderCache
+*/
+class JUCE_API  AudioFileHeaderCache
+{
+public:
+    //==============================================================================
+    /** Creates an empty cache. */
+    AudioFileHeaderCache();
+
+    /** Destructor. */
+    ~AudioFileHeaderCache();
+
+    //==============================================================================
+    /** Holds the properties of an audio file that were read from its header. */
+    class JUCE_API  HeaderInfo
+    {
+    public:
+        /** Creates an empty HeaderInfo. */
+        HeaderInfo();
+
+        /** Creates a HeaderInfo that holds the properties of the given reader. */
+        explicit HeaderInfo (const AudioFormatReader& reader);
+
+        /** The name of the AudioFormat that was used to read the file. */
+        String formatName;
+
+        /** The sample-rate of the file. */
+        double sampleRate;
+
+        /** The number of bits per sample, e.g. 16, 24, 32. */
+        unsigned int bitsPerSample;
+
+        /** The number of channels in the file. */
+        unsigned int numChannels;
+
+        /** The total number of samples in the file. */
+        int64 lengthInSamples;
+
+        /** Indicates whether the data is floating-point or fixed. */
+        bool usesFloatingPointData;
+
+        /** The reader's metadata values, which includes any loop points that
+            the format understands.
+        */
+        StringPairArray metadataValues;
+    };
+
+    //==============================================================================
+    /** Looks for a cached entry for the given file.
+
+        If there's an entry for this file, and the file hasn't been modified since the
+        entry was added, this returns true and fills in the result object; otherwise it
+        returns false.
+    */
+    bool getHeader (const File& file, HeaderInfo& result) const;
+
+    /** Adds or replaces the entry for a file, using the properties of a reader that
+        has been opened on it.
+
+        If the cache already holds exactly the same details for this file, nothing
+        is changed.
+    */
+    void addHeader (const File& file, const AudioFormatReader& reader);
+
+    /** Removes any entry for the given file. */
+    void removeHeader (const File& file);
+
+    /** Removes all the entries. */
+    void clear();
+
+    /** Returns the number of files that have entries in the cache. */
+    int getNumHeaders() const;
+
+    //==============================================================================
+    /** Returns true if any entries have been added, replaced or removed since the
+        cache was created, restored with restoreFromXml(), or since clearChangedFlag()
+        was last called.
+
+        You can use this to avoid re-saving a cache that hasn't changed.
+    */
+    bool hasChanged() const noexcept                    { return changed; }
+
+    /** Resets the flag that hasChanged() returns, e.g. after the cache has been saved. */
+    void clearChangedFlag() noexcept                    { changed = false; }
+
+    //==============================================================================
+    /** Creates some XML that can be used to store the state of this cache.
+
+        The caller must delete the object that is returned.
+        @see restoreFromXml
+    */
+    XmlElement* createXml() const;
+
+    /** Replaces the contents of the cache with some XML that was created by
+        createXml().
+    */
+    void restoreFromXml (const XmlElement& xml);
+
+
+private:
+    //==============================================================================
+    OwnedArray <HeaderCacheEntry> entries;
+    HashMap <String, HeaderCacheEntry*> entriesByPath;
+    CriticalSection lock;
+    bool changed;
+
+    void addEntry (HeaderCacheEntry* entry);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioFileHeaderCache);
+};
+
+
+#endif   // __JUCE_AUDIOFILEHEADERCACHE_JUCEHEADER__
@@ -55,6 +55,7 @@ const String& AudioFormat::getFormatName() const                { return formatN
 const StringArray& AudioFormat::getFileExtensions() const       { return fileExtensions; }
 bool AudioFormat::isCompressed()                                { return false; }
 StringArray AudioFormat::getQualityOptions()                    { return StringArray(); }
+bool AudioFormat::matchesStreamHeader (const void*, int) const  { return false; }
 
 
 END_JUCE_NAMESPACE
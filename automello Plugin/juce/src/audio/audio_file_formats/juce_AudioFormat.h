@@ -70,6 +70,22 @@ public:
     */
     virtual bool canHandleFile (const File& fileToTest);
 
+    /** Returns true if the given bytes, taken from the start of a stream, look like
+        the header of a file in this format.
+
+        This is used by the AudioFormatManager to decide which format is most likely
+        to be able to open a stream, so that it doesn't need to make every format try
+        to parse it. It's only a hint: a format that returns true will still have to
+        successfully open the stream, and if none of the formats that match can do that,
+        the manager will fall back to trying the others. The base class implementation
+        returns false.
+
+        @param headerData   the first bytes of the stream
+        @param numBytes     the number of bytes available in headerData. This will be at
+                            least 16 unless the stream is shorter than that.
+    */
+    virtual bool matchesStreamHeader (const void* headerData, int numBytes) const;
+
     /** Returns a set of sample rates that the format can read and write. */
     virtual const Array <int> getPossibleSampleRates() = 0;
 
@@ -33,12 +33,17 @@ BEGIN_JUCE_NAMESPACE
 #include "juce_FlacAudioFormat.h"
 #include "juce_OggVorbisAudioFormat.h"
 #include "../../io/files/juce_FileInputStream.h"
+#include "../../io/streams/juce_PrefetchingInputStream.h"
 #include "../../memory/juce_ScopedPointer.h"
 
 
 //==============================================================================
 AudioFormatManager::AudioFormatManager()
-    : defaultFormatIndex (0)
+    : defaultFormatIndex (0),
+      headerCache (nullptr),
+      readAheadThread (nullptr),
+      numReadAheadBuffers (4),
+      readAheadBufferSize (65536)
 {
 }
 
@@ -151,6 +156,29 @@ String AudioFormatManager::getWildcardForAllFormats() const
     return s;
 }
 
+AudioFormat* AudioFormatManager::findFormatWithName (const String& formatName) const
+{
+    for (int i = 0; i < getNumKnownFormats(); ++i)
+        if (getKnownFormat(i)->getFormatName() == formatName)
+            return getKnownFormat(i);
+
+    return nullptr;
+}
+
+void AudioFormatManager::addFormatsMatchingHeader (InputStream& stream, Array<AudioFormat*>& formats) const
+{
+    const int64 originalStreamPos = stream.getPosition();
+
+    char header [16] = { 0 };
+    const int numBytes = stream.read (header, sizeof (header));
+    stream.setPosition (originalStreamPos);
+
+    if (numBytes > 0)
+        for (int i = 0; i < getNumKnownFormats(); ++i)
+            if (getKnownFormat(i)->matchesStreamHeader (header, numBytes))
+                formats.addIfNotAlreadyThere (getKnownFormat(i));
+}
+
 //==============================================================================
 AudioFormatReader* AudioFormatManager::createReaderFor (const File& file)
 {
@@ -158,25 +186,41 @@ AudioFormatReader* AudioFormatManager::createReaderFor (const File& file)
     // use them to open a file!
     jassert (getNumKnownFormats() > 0);
 
-    for (int i = 0; i < getNumKnownFormats(); ++i)
+    InputStream* in = file.createInputStream();
+
+    if (in == nullptr)
+        return nullptr;
+
+    if (readAheadThread != nullptr)
+        in = new PrefetchingInputStream (in, true, *readAheadThread, readAheadBufferSize, numReadAheadBuffers);
+
+    Array<AudioFormat*> formatsToTry;
+
+    if (headerCache != nullptr)
     {
-        AudioFormat* const af = getKnownFormat(i);
+        AudioFileHeaderCache::HeaderInfo info;
 
-        if (af->canHandleFile (file))
+        if (headerCache->getHeader (file, info))
         {
-            InputStream* const in = file.createInputStream();
-
-            if (in != nullptr)
-            {
-                AudioFormatReader* const r = af->createReaderFor (in, true);
+            AudioFormat* const af = findFormatWithName (info.formatName);
 
-                if (r != nullptr)
-                    return r;
-            }
+            if (af != nullptr)
+                formatsToTry.add (af);
         }
     }
 
-    return nullptr;
+    addFormatsMatchingHeader (*in, formatsToTry);
+
+    for (int i = 0; i < getNumKnownFormats(); ++i)
+        if (getKnownFormat(i)->canHandleFile (file))
+            formatsToTry.addIfNotAlreadyThere (getKnownFormat(i));
+
+    AudioFormatReader* const r = createReaderUsingFormats (in, formatsToTry);
+
+    if (r != nullptr && headerCache != nullptr)
+        headerCache->addHeader (file, *r);
+
+    return r;
 }
 
 AudioFormatReader* AudioFormatManager::createReaderFor (InputStream* audioFileStream)
@@ -185,32 +229,70 @@ AudioFormatReader* AudioFormatManager::createReaderFor (InputStream* audioFileSt
     // use them to open a file!
     jassert (getNumKnownFormats() > 0);
 
-    ScopedPointer <InputStream> in (audioFileStream);
+    if (audioFileStream == nullptr)
+        return nullptr;
 
-    if (in != nullptr)
-    {
-        const int64 originalStreamPos = in->getPosition();
+    Array<AudioFormat*> formatsToTry;
+    addFormatsMatchingHeader (*audioFileStream, formatsToTry);
 
-        for (int i = 0; i < getNumKnownFormats(); ++i)
-        {
-            AudioFormatReader* const r = getKnownFormat(i)->createReaderFor (in, false);
+    for (int i = 0; i < getNumKnownFormats(); ++i)
+        formatsToTry.addIfNotAlreadyThere (getKnownFormat(i));
 
-            if (r != nullptr)
-            {
-                in.release();
-                return r;
-            }
+    return createReaderUsingFormats (audioFileStream, formatsToTry);
+}
+
+AudioFormatReader* AudioFormatManager::createReaderUsingFormats (InputStream* const stream, const Array<AudioFormat*>& formatsToTry)
+{
+    ScopedPointer <InputStream> in (stream);
+    const int64 originalStreamPos = in->getPosition();
 
-            in->setPosition (originalStreamPos);
+    for (int i = 0; i < formatsToTry.size(); ++i)
+    {
+        AudioFormatReader* const r = formatsToTry.getUnchecked(i)->createReaderFor (in, false);
 
-            // the stream that is passed-in must be capable of being repositioned so
-            // that all the formats can have a go at opening it.
-            jassert (in->getPosition() == originalStreamPos);
+        if (r != nullptr)
+        {
+            in.release();
+            return r;
         }
+
+        in->setPosition (originalStreamPos);
+
+        // the stream that is passed-in must be capable of being repositioned so
+        // that all the formats can have a go at opening it.
+        jassert (in->getPosition() == originalStreamPos);
     }
 
     return nullptr;
 }
 
+//==============================================================================
+void AudioFormatManager::setHeaderCache (AudioFileHeaderCache* const newCache) noexcept
+{
+    headerCache = newCache;
+}
+
+void AudioFormatManager::setReadAheadThread (TimeSliceThread* const thread,
+                                             const int numBuffersToPrefetch,
+                                             const int bufferSize) noexcept
+{
+    readAheadThread = thread;
+    numReadAheadBuffers = numBuffersToPrefetch;
+    readAheadBufferSize = bufferSize;
+}
+
+bool AudioFormatManager::getHeaderInfo (const File& file, AudioFileHeaderCache::HeaderInfo& result)
+{
+    if (headerCache != nullptr && headerCache->getHeader (file, result))
+        return true;
+
+    const ScopedPointer <AudioFormatReader> r (createReaderFor (file));
+
+    if (r == nullptr)
+        return false;
+
+    result = AudioFileHeaderCache::HeaderInfo (*r);
+    return true;
+}
 
 END_JUCE_NAMESPACE
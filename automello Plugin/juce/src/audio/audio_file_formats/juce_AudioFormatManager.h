@@ -27,8 +27,10 @@
 #define __JUCE_AUDIOFORMATMANAGER_JUCEHEADER__
 
 #include "juce_AudioFormat.h"
+#include "juce_AudioFileHeaderCache.h"
 #include "../../core/juce_Singleton.h"
 #include "../../containers/juce_OwnedArray.h"
+#include "../../threads/juce_TimeSliceThread.h"
 
 
 //==============================================================================
@@ -112,6 +114,11 @@ public:
     /** Searches through the known formats to try to create a suitable reader for
         this file.
 
+        The formats whose signatures match the first few bytes of the file are tried
+        first (see AudioFormat::matchesStreamHeader()), followed by any others that
+        recognise the file's extension. If a header cache has been set, the format
+        that opened the file last time will be tried before any of these.
+
         If none of the registered formats can open the file, it'll return 0. If it
         returns a reader, it's the caller's responsibility to delete the reader.
     */
@@ -124,17 +131,70 @@ public:
         reader that is returned, so the caller should not keep any references to it.
 
         The stream that is passed-in must be capable of being repositioned so
-        that all the formats can have a go at opening it.
+        that all the formats can have a go at opening it. Any formats whose
+        signatures match the start of the stream will be given the first try.
 
         If none of the registered formats can open the stream, it'll return 0. If it
         returns a reader, it's the caller's responsibility to delete the reader.
     */
     AudioFormatReader* createReaderFor (InputStream* audioFileStream);
 
+    //==============================================================================
+    /** Gives the manager a cache in which to keep the header details of the files
+        that it opens.
+
+        Each time createReaderFor() opens a file, the file's details are stored in
+        the cache, and the next time it's opened, the format that worked before will
+        be tried first. The manager doesn't take ownership of the cache, so it must
+        not be deleted until it has been removed by calling this method with a null
+        pointer, or until the manager has been deleted.
+    */
+    void setHeaderCache (AudioFileHeaderCache* newCache) noexcept;
+
+    /** Returns the cache that was set with setHeaderCache(), or nullptr if there isn't one. */
+    AudioFileHeaderCache* getHeaderCache() const noexcept           { return headerCache; }
+
+    /** Makes the readers that createReaderFor() opens from files read ahead of
+        themselves, using a background thread.
+
+        Each file's stream gets wrapped in a PrefetchingInputStream, so a reader that's
+        going through a file from start to finish doesn't have to wait for the disk.
+        The manager doesn't take ownership of the thread, which must already be
+        running, and it must not be stopped or deleted until all the readers that were
+        created while it was set have been deleted. Pass nullptr to stop using it.
+
+        @param thread                   the thread to do the reading, which can be shared
+                                        with other streams
+        @param numBuffersToPrefetch     how many blocks beyond each reader's position
+                                        should be kept filled
+        @param bufferSize               the size of each block
+        @see PrefetchingInputStream
+    */
+    void setReadAheadThread (TimeSliceThread* thread,
+                             int numBuffersToPrefetch = 4,
+                             int bufferSize = 65536) noexcept;
+
+    /** Finds the sample rate, length, metadata, etc. of a file.
+
+        If a header cache has been set and it contains an up-to-date entry for this
+        file, that entry is returned without touching the file; otherwise, this will
+        open the file with createReaderFor(), which will also add it to the cache.
+
+        @returns true if the details were found, or false if the file couldn't be opened
+    */
+    bool getHeaderInfo (const File& audioFile, AudioFileHeaderCache::HeaderInfo& result);
+
 private:
     //==============================================================================
     OwnedArray<AudioFormat> knownFormats;
     int defaultFormatIndex;
+    AudioFileHeaderCache* headerCache;
+    TimeSliceThread* readAheadThread;
+    int numReadAheadBuffers, readAheadBufferSize;
+
+    AudioFormat* findFormatWithName (const String& formatName) const;
+    void addFormatsMatchingHeader (InputStream& stream, Array<AudioFormat*>& formats) const;
+    AudioFormatReader* createReaderUsingFormats (InputStream* stream, const Array<AudioFormat*>& formatsToTry);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioFormatManager);
 };
@@ -29,6 +29,7 @@ BEGIN_JUCE_NAMESPACE
 
 #include "juce_AudioFormat.h"
 #include "../dsp/juce_AudioSampleBuffer.h"
+#include "../../io/files/juce_FileInputStream.h"
 
 
 //==============================================================================
@@ -40,7 +41,8 @@ AudioFormatReader::AudioFormatReader (InputStream* const in,
       numChannels (0),
       usesFloatingPointData (false),
       input (in),
-      formatName (formatName_)
+      formatName (formatName_),
+      hasTriedToMapFile (false)
 {
 }
 
@@ -219,6 +221,384 @@ void AudioFormatReader::readMaxLevels (int64 startSampleInFile,
     }
 }
 
+//==============================================================================
+namespace RawLevelScanning
+{
+    template <class SampleType, class Endianness>
+    void scanIntegerData (const void* data, int numChannels, int numFrames, int* mins, int* maxes) noexcept
+    {
+        typedef AudioData::Pointer <SampleType, Endianness, AudioData::Interleaved, AudioData::Const> SourceType;
+
+        for (int chan = 0; chan < numChannels; ++chan)
+        {
+            SourceType src (addBytesToPointer (data, chan * SourceType::getBytesPerSample()), numChannels);
+            int lo = mins[chan], hi = maxes[chan];
+
+            for (int i = numFrames; --i >= 0;)
+            {
+                const int sample = src.getAsInt32();
+                ++src;
+
+                if (sample < lo) lo = sample;
+                if (sample > hi) hi = sample;
+            }
+
+            mins[chan] = lo;
+            maxes[chan] = hi;
+        }
+    }
+
+    void scanFloatData (const void* data, int numChannels, int numFrames, float* mins, float* maxes) noexcept
+    {
+        typedef AudioData::Pointer <AudioData::Float32, AudioData::LittleEndian, AudioData::Interleaved, AudioData::Const> SourceType;
+
+        for (int chan = 0; chan < numChannels; ++chan)
+        {
+            SourceType src (addBytesToPointer (data, chan * (int) sizeof (float)), numChannels);
+            float lo = mins[chan], hi = maxes[chan];
+
+            for (int i = numFrames; --i >= 0;)
+            {
+                const float sample = src.getAsFloat();
+                ++src;
+
+                if (sample < lo) lo = sample;
+                if (sample > hi) hi = sample;
+            }
+
+            mins[chan] = lo;
+            maxes[chan] = hi;
+        }
+    }
+
+   #if JUCE_USE_SSE_INTRINSICS
+    /*  These scan the interleaved data 16 bytes at a time. As long as the number of channels
+        divides evenly into the number of lanes in a register, each lane only ever sees samples
+        from the same channel, so the per-channel results can be pulled out of the lanes at the
+        end. They return the number of whole frames that were scanned, leaving any remainder
+        for the scalar versions.
+    */
+    template <bool isBigEndian>
+    int scanInt16DataSSE (const void* data, int numChannels, int numFrames, int* mins, int* maxes) noexcept
+    {
+        const int numBlocks = (numFrames * numChannels) / 8;
+
+        if ((8 % numChannels) != 0 || numBlocks == 0)
+            return 0;
+
+        const __m128i* src = static_cast <const __m128i*> (data);
+        __m128i lo = _mm_set1_epi16 (0x7fff);
+        __m128i hi = _mm_set1_epi16 ((short) 0x8000);
+
+        for (int i = numBlocks; --i >= 0;)
+        {
+            __m128i v = _mm_loadu_si128 (src++);
+
+            if (isBigEndian)
+                v = _mm_or_si128 (_mm_slli_epi16 (v, 8), _mm_srli_epi16 (v, 8));
+
+            lo = _mm_min_epi16 (lo, v);
+            hi = _mm_max_epi16 (hi, v);
+        }
+
+        int16 laneMins[8], laneMaxes[8];
+        _mm_storeu_si128 ((__m128i*) laneMins, lo);
+        _mm_storeu_si128 ((__m128i*) laneMaxes, hi);
+
+        for (int i = 0; i < 8; ++i)
+        {
+            const int chan = i % numChannels;
+            mins[chan]  = jmin (mins[chan],  (int) laneMins[i]  << 16);
+            maxes[chan] = jmax (maxes[chan], (int) laneMaxes[i] << 16);
+        }
+
+        return (numBlocks * 8) / numChannels;
+    }
+
+    template <bool isBigEndian>
+    int scanInt32DataSSE (const void* data, int numChannels, int numFrames, int* mins, int* maxes) noexcept
+    {
+        const int numBlocks = (numFrames * numChannels) / 4;
+
+        if ((4 % numChannels) != 0 || numBlocks == 0)
+            return 0;
+
+        const __m128i* src = static_cast <const __m128i*> (data);
+        __m128i lo = _mm_set1_epi32 (std::numeric_limits<int>::max());
+        __m128i hi = _mm_set1_epi32 (std::numeric_limits<int>::min());
+
+        for (int i = numBlocks; --i >= 0;)
+        {
+            __m128i v = _mm_loadu_si128 (src++);
+
+            if (isBigEndian)
+            {
+                v = _mm_or_si128 (_mm_slli_epi16 (v, 8), _mm_srli_epi16 (v, 8));
+                v = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (v, 0xb1), 0xb1);
+            }
+
+            // (SSE2 has no 32-bit integer min/max, so these are done with masks)
+            const __m128i lower = _mm_cmpgt_epi32 (lo, v);
+            lo = _mm_or_si128 (_mm_and_si128 (lower, v), _mm_andnot_si128 (lower, lo));
+
+            const __m128i higher = _mm_cmpgt_epi32 (v, hi);
+            hi = _mm_or_si128 (_mm_and_si128 (higher, v), _mm_andnot_si128 (higher, hi));
+        }
+
+        int32 laneMins[4], laneMaxes[4];
+        _mm_storeu_si128 ((__m128i*) laneMins, lo);
+        _mm_storeu_si128 ((__m128i*) laneMaxes, hi);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            const int chan = i % numChannels;
+            mins[chan]  = jmin (mins[chan],  (int) laneMins[i]);
+            maxes[chan] = jmax (maxes[chan], (int) laneMaxes[i]);
+        }
+
+        return (numBlocks * 4) / numChannels;
+    }
+
+    int scanFloatDataSSE (const void* data, int numChannels, int numFrames, float* mins, float* maxes) noexcept
+    {
+        const int numBlocks = (numFrames * numChannels) / 4;
+
+        if ((4 % numChannels) != 0 || numBlocks == 0)
+            return 0;
+
+        const float* src = static_cast <const float*> (data);
+        __m128 lo = _mm_loadu_ps (src);
+        __m128 hi = lo;
+
+        for (int i = numBlocks; --i > 0;)
+        {
+            src += 4;
+            const __m128 v = _mm_loadu_ps (src);
+            lo = _mm_min_ps (lo, v);
+            hi = _mm_max_ps (hi, v);
+        }
+
+        float laneMins[4], laneMaxes[4];
+        _mm_storeu_ps (laneMins, lo);
+        _mm_storeu_ps (laneMaxes, hi);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            const int chan = i % numChannels;
+            mins[chan]  = jmin (mins[chan],  laneMins[i]);
+            maxes[chan] = jmax (maxes[chan], laneMaxes[i]);
+        }
+
+        return (numBlocks * 4) / numChannels;
+    }
+   #endif
+
+    //==============================================================================
+    struct Scanner
+    {
+        Scanner (int numChannels_, int bitsPerSample_, bool isFloat_, bool isLittleEndian_)
+            : numChannels (numChannels_), bitsPerSample (bitsPerSample_),
+              isFloat (isFloat_), isLittleEndian (isLittleEndian_),
+              intLevels ((size_t) numChannels_ * 2), floatLevels ((size_t) numChannels_ * 2)
+        {
+            for (int i = 0; i < numChannels; ++i)
+            {
+                intLevels[i] = std::numeric_limits<int>::max();
+                intLevels[i + numChannels] = std::numeric_limits<int>::min();
+                floatLevels[i] = 1.0e6f;
+                floatLevels[i + numChannels] = -1.0e6f;
+            }
+        }
+
+        void scan (const void* data, int numFrames) noexcept
+        {
+            int* const mins = intLevels;
+            int* const maxes = intLevels + numChannels;
+
+            if (isFloat)
+            {
+                int done = 0;
+               #if JUCE_USE_SSE_INTRINSICS
+                done = scanFloatDataSSE (data, numChannels, numFrames, floatLevels, floatLevels + numChannels);
+               #endif
+                scanFloatData (skipFrames (data, done), numChannels, numFrames - done, floatLevels, floatLevels + numChannels);
+                return;
+            }
+
+            int done = 0;
+
+            switch (bitsPerSample)
+            {
+                case 16:
+                   #if JUCE_USE_SSE_INTRINSICS
+                    done = isLittleEndian ? scanInt16DataSSE<false> (data, numChannels, numFrames, mins, maxes)
+                                          : scanInt16DataSSE<true>  (data, numChannels, numFrames, mins, maxes);
+                   #endif
+                    if (isLittleEndian) scanIntegerData <AudioData::Int16, AudioData::LittleEndian> (skipFrames (data, done), numChannels, numFrames - done, mins, maxes);
+                    else                scanIntegerData <AudioData::Int16, AudioData::BigEndian>    (skipFrames (data, done), numChannels, numFrames - done, mins, maxes);
+                    break;
+
+                case 24:
+                    if (isLittleEndian) scanIntegerData <AudioData::Int24, AudioData::LittleEndian> (data, numChannels, numFrames, mins, maxes);
+                    else                scanIntegerData <AudioData::Int24, AudioData::BigEndian>    (data, numChannels, numFrames, mins, maxes);
+                    break;
+
+                case 32:
+                   #if JUCE_USE_SSE_INTRINSICS
+                    done = isLittleEndian ? scanInt32DataSSE<false> (data, numChannels, numFrames, mins, maxes)
+                                          : scanInt32DataSSE<true>  (data, numChannels, numFrames, mins, maxes);
+                   #endif
+                    if (isLittleEndian) scanIntegerData <AudioData::Int32, AudioData::LittleEndian> (skipFrames (data, done), numChannels, numFrames - done, mins, maxes);
+                    else                scanIntegerData <AudioData::Int32, AudioData::BigEndian>    (skipFrames (data, done), numChannels, numFrames - done, mins, maxes);
+                    break;
+
+                default:
+                    jassertfalse;
+                    break;
+            }
+        }
+
+        void includeSilence() noexcept
+        {
+            for (int i = 0; i < numChannels; ++i)
+            {
+                intLevels[i] = jmin (intLevels[i], 0);
+                intLevels[i + numChannels] = jmax (intLevels[i + numChannels], 0);
+                floatLevels[i] = jmin (floatLevels[i], 0.0f);
+                floatLevels[i + numChannels] = jmax (floatLevels[i + numChannels], 0.0f);
+            }
+        }
+
+        float getMin (int channel) const noexcept   { return getLevel (channel); }
+        float getMax (int channel) const noexcept   { return getLevel (channel + numChannels); }
+
+    private:
+        const int numChannels, bitsPerSample;
+        const bool isFloat, isLittleEndian;
+        HeapBlock<int> intLevels;
+        HeapBlock<float> floatLevels;
+
+        const void* skipFrames (const void* data, int numFrames) const noexcept
+        {
+            return addBytesToPointer (data, numFrames * numChannels * (bitsPerSample / 8));
+        }
+
+        float getLevel (int index) const noexcept
+        {
+            return isFloat ? floatLevels[index]
+                           : intLevels[index] / (float) std::numeric_limits<int>::max();
+        }
+
+        JUCE_DECLARE_NON_COPYABLE (Scanner);
+    };
+}
+
+bool AudioFormatReader::readMaxLevelsFromRawData (const int64 dataStartPosition,
+                                                  const int bytesPerFrame,
+                                                  const bool isLittleEndian,
+                                                  int64 startSampleInFile,
+                                                  int64 numSamples,
+                                                  float& lowestLeft, float& highestLeft,
+                                                  float& lowestRight, float& highestRight)
+{
+    const int bytesPerSample = (int) bitsPerSample / 8;
+
+    if (numChannels == 0
+         || bytesPerFrame != bytesPerSample * (int) numChannels
+         || ! (bitsPerSample == 16 || bitsPerSample == 24 || bitsPerSample == 32)
+         || (usesFloatingPointData && (bitsPerSample != 32 || ! isLittleEndian)))
+        return false;
+
+    if (numSamples <= 0)
+    {
+        lowestLeft = 0;
+        lowestRight = 0;
+        highestLeft = 0;
+        highestRight = 0;
+        return true;
+    }
+
+    RawLevelScanning::Scanner scanner ((int) numChannels, (int) bitsPerSample, usesFloatingPointData, isLittleEndian);
+
+    // Any part of the range that lies outside the stream would be read as silence..
+    if (startSampleInFile < 0 || startSampleInFile + numSamples > lengthInSamples)
+        scanner.includeSilence();
+
+    const int64 endSample = jmin (startSampleInFile + numSamples, lengthInSamples);
+    startSampleInFile = jmax ((int64) 0, startSampleInFile);
+    numSamples = endSample - startSampleInFile;
+
+    if (numSamples > 0)
+    {
+        const int64 startByte = dataStartPosition + startSampleInFile * bytesPerFrame;
+        const char* const mappedData = static_cast <const char*> (getMappedSection (startByte, numSamples * bytesPerFrame));
+        const int maxFramesPerBlock = 65536;
+
+        if (mappedData != nullptr)
+        {
+            for (int64 done = 0; done < numSamples;)
+            {
+                const int numThisTime = (int) jmin (numSamples - done, (int64) maxFramesPerBlock);
+                scanner.scan (mappedData + done * bytesPerFrame, numThisTime);
+                done += numThisTime;
+            }
+        }
+        else
+        {
+            const int bufferFrames = (int) jmin (numSamples, (int64) (maxFramesPerBlock / 4));
+            HeapBlock<char> buffer ((size_t) (bufferFrames * bytesPerFrame));
+
+            input->setPosition (startByte);
+
+            while (numSamples > 0)
+            {
+                const int numThisTime = (int) jmin (numSamples, (int64) bufferFrames);
+                const int bytesRead = input->read (buffer, numThisTime * bytesPerFrame);
+
+                if (bytesRead < numThisTime * bytesPerFrame)
+                {
+                    jassert (bytesRead >= 0);
+                    zeromem (buffer + jmax (0, bytesRead), numThisTime * bytesPerFrame - jmax (0, bytesRead));
+                }
+
+                scanner.scan (buffer, numThisTime);
+                numSamples -= numThisTime;
+            }
+        }
+    }
+
+    const int rightChannel = numChannels > 1 ? 1 : 0;
+
+    lowestLeft   = scanner.getMin (0);
+    highestLeft  = scanner.getMax (0);
+    lowestRight  = scanner.getMin (rightChannel);
+    highestRight = scanner.getMax (rightChannel);
+    return true;
+}
+
+const void* AudioFormatReader::getMappedSection (const int64 startByte, const int64 numBytes)
+{
+    if (! hasTriedToMapFile)
+    {
+        hasTriedToMapFile = true;
+        FileInputStream* const fileStream = dynamic_cast <FileInputStream*> (input);
+
+        if (fileStream != nullptr)
+        {
+            mappedFile = new MemoryMappedFile (fileStream->getFile(), MemoryMappedFile::readOnly);
+
+            if (mappedFile->getData() == nullptr)
+                mappedFile = nullptr;
+        }
+    }
+
+    if (mappedFile != nullptr && startByte >= 0 && startByte + numBytes <= (int64) mappedFile->getSize())
+        return static_cast <const char*> (mappedFile->getData()) + startByte;
+
+    return nullptr;
+}
+
+//==============================================================================
 int64 AudioFormatReader::searchForLevel (int64 startSample,
                                          int64 numSamplesToSearch,
                                          const double magnitudeRangeMinimum,
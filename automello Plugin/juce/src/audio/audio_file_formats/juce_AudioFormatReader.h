@@ -27,6 +27,8 @@
 #define __JUCE_AUDIOFORMATREADER_JUCEHEADER__
 
 #include "../../io/streams/juce_InputStream.h"
+#include "../../io/files/juce_MemoryMappedFile.h"
+#include "../../memory/juce_ScopedPointer.h"
 #include "../../text/juce_StringPairArray.h"
 #include "../dsp/juce_AudioDataConverters.h"
 class AudioFormat;
@@ -243,8 +245,40 @@ protected:
         }
     };
 
+    //==============================================================================
+    /** Used by AudioFormatReader subclasses to implement readMaxLevels() for uncompressed formats.
+
+        Rather than converting the samples to 32-bit integers and then scanning them, as the
+        default readMaxLevels() does, this finds the extremes of each channel by scanning the
+        raw interleaved data in its native format, using SSE where it's available. If the source
+        stream is a FileInputStream, the file is memory-mapped so that the data can be scanned
+        in-place; otherwise it's read from the input stream in large blocks.
+
+        16, 24 and 32-bit integer data and little-endian 32-bit float data are supported. For
+        anything else, this returns false, and the caller should fall back to the default
+        AudioFormatReader::readMaxLevels() method.
+
+        @param dataStartPosition    the byte position in the stream of the first sample frame
+        @param bytesPerFrame        the number of bytes occupied by one frame of interleaved samples
+        @param isLittleEndian       the byte-order of the sample data
+        @see readMaxLevels
+    */
+    bool readMaxLevelsFromRawData (int64 dataStartPosition,
+                                   int bytesPerFrame,
+                                   bool isLittleEndian,
+                                   int64 startSample,
+                                   int64 numSamples,
+                                   float& lowestLeft,
+                                   float& highestLeft,
+                                   float& lowestRight,
+                                   float& highestRight);
+
 private:
     String formatName;
+    ScopedPointer<MemoryMappedFile> mappedFile;
+    bool hasTriedToMapFile;
+
+    const void* getMappedSection (int64 startByte, int64 numBytes);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioFormatReader);
 };
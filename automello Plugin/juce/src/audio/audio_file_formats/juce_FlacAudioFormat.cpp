@@ -504,6 +504,13 @@ bool FlacAudioFormat::canDoStereo()     { return true; }
 bool FlacAudioFormat::canDoMono()       { return true; }
 bool FlacAudioFormat::isCompressed()    { return true; }
 
+bool FlacAudioFormat::matchesStreamHeader (const void* headerData, const int numBytes) const
+{
+    // (files with an ID3 tag in front of the FLAC stream aren't recognised here, but
+    // will still get opened when the manager falls back to trying each format)
+    return numBytes >= 4 && memcmp (headerData, "fLaC", 4) == 0;
+}
+
 AudioFormatReader* FlacAudioFormat::createReaderFor (InputStream* in,
                                                      const bool deleteStreamIfOpeningFails)
 {
@@ -423,6 +423,11 @@ bool OggVorbisAudioFormat::canDoStereo()    { return true; }
 bool OggVorbisAudioFormat::canDoMono()      { return true; }
 bool OggVorbisAudioFormat::isCompressed()   { return true; }
 
+bool OggVorbisAudioFormat::matchesStreamHeader (const void* headerData, const int numBytes) const
+{
+    return numBytes >= 4 && memcmp (headerData, "OggS", 4) == 0;
+}
+
 AudioFormatReader* OggVorbisAudioFormat::createReaderFor (InputStream* in,
                                                           const bool deleteStreamIfOpeningFails)
 {
@@ -54,6 +54,7 @@ public:
     bool canDoStereo();
     bool canDoMono();
     bool isCompressed();
+    bool matchesStreamHeader (const void* headerData, int numBytes) const;
     StringArray getQualityOptions();
 
     //==============================================================================
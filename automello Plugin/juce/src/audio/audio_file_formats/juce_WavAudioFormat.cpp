@@ -744,6 +744,16 @@ public:
         return true;
     }
 
+    void readMaxLevels (int64 startSampleInFile, int64 numSamples,
+                        float& lowestLeft, float& highestLeft,
+                        float& lowestRight, float& highestRight)
+    {
+        if (! readMaxLevelsFromRawData (dataChunkStart, bytesPerFrame, true, startSampleInFile, numSamples,
+                                        lowestLeft, highestLeft, lowestRight, highestRight))
+            AudioFormatReader::readMaxLevels (startSampleInFile, numSamples,
+                                              lowestLeft, highestLeft, lowestRight, highestRight);
+    }
+
     int64 bwavChunkStart, bwavSize;
 
 private:
@@ -1015,6 +1025,15 @@ const Array <int> WavAudioFormat::getPossibleBitDepths()
 bool WavAudioFormat::canDoStereo()  { return true; }
 bool WavAudioFormat::canDoMono()    { return true; }
 
+bool WavAudioFormat::matchesStreamHeader (const void* headerData, const int numBytes) const
+{
+    const char* const d = static_cast <const char*> (headerData);
+
+    return numBytes >= 12
+            && (memcmp (d, "RIFF", 4) == 0 || memcmp (d, "RF64", 4) == 0)
+            && memcmp (d + 8, "WAVE", 4) == 0;
+}
+
 AudioFormatReader* WavAudioFormat::createReaderFor (InputStream* sourceStream,
                                                     const bool deleteStreamIfOpeningFails)
 {
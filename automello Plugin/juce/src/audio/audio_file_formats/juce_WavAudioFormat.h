@@ -123,6 +123,7 @@ public:
     const Array <int> getPossibleBitDepths();
     bool canDoStereo();
     bool canDoMono();
+    bool matchesStreamHeader (const void* headerData, int numBytes) const;
 
     //==============================================================================
     AudioFormatReader* createReaderFor (InputStream* sourceStream,
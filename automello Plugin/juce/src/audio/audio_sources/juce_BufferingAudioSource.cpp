@@ -127,9 +127,24 @@ BufferingAudioSource::BufferingAudioSource (PositionableAudioSource* source_,
       numberOfSamplesToBuffer (jmax (1024, numberOfSamplesToBuffer_)),
       numberOfChannels (numberOfChannels_),
       buffer (numberOfChannels_, 0),
-      bufferValidStart (0),
-      bufferValidEnd (0),
+      fifo (1),
       nextPlayPos (0),
+      pendingSeekPos (0),
+      flushUpTo (0),
+      flushPosition (0),
+      flushSeekCount (0),
+      readAheadTarget (0),
+      minimumReadAhead (0),
+      sampleRate (0),
+      samplesRead (0),
+      samplesToSkip (0),
+      lastFlushSequence (0),
+      lastFlushSeekCount (0),
+      samplesWritten (0),
+      nextReadPos (0),
+      lastSeekCount (0),
+      lastNumUnderruns (0),
+      worstReadTimeMs (0),
       wasSourceLooping (false)
 {
     jassert (source_ != nullptr);
@@ -149,20 +164,31 @@ BufferingAudioSource::~BufferingAudioSource()
 //==============================================================================
 void BufferingAudioSource::prepareToPlay (int samplesPerBlockExpected, double sampleRate_)
 {
+    // make sure the background thread isn't using the buffer while it's resized..
+    SharedBufferingAudioSourceThread* const thread = SharedBufferingAudioSourceThread::getInstanceWithoutCreating();
+
+    if (thread != nullptr)
+        thread->removeSource (this);
+
     source->prepareToPlay (samplesPerBlockExpected, sampleRate_);
 
     sampleRate = sampleRate_;
 
-    buffer.setSize (numberOfChannels, jmax (samplesPerBlockExpected * 2, numberOfSamplesToBuffer));
+    const int bufferSize = jmax (samplesPerBlockExpected * 2, numberOfSamplesToBuffer);
+    buffer.setSize (numberOfChannels, bufferSize);
     buffer.clear();
+    fifo.setTotalSize (bufferSize);
 
-    bufferValidStart = 0;
-    bufferValidEnd = 0;
+    minimumReadAhead = jmin (((int) sampleRate_) / 4, bufferSize / 2);
+    readAheadTarget = minimumReadAhead;
+    worstReadTimeMs = 0;
+    numUnderruns = 0;
+    lastNumUnderruns = 0;
+    resetFifo();
 
     SharedBufferingAudioSourceThread::getInstance()->addSource (this);
 
-    while (bufferValidEnd - bufferValidStart < jmin (((int) sampleRate_) / 4,
-                                                     buffer.getNumSamples() / 2))
+    while (fifo.getNumReady() < minimumReadAhead)
     {
         SharedBufferingAudioSourceThread::getInstance()->notify();
         Thread::sleep (5);
@@ -180,62 +206,71 @@ void BufferingAudioSource::releaseResources()
     source->releaseResources();
 }
 
-void BufferingAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& info)
+void BufferingAudioSource::resetFifo()
 {
-    const ScopedLock sl (bufferStartPosLock);
+    // (this must only be called when neither the audio thread nor the background
+    // thread can be using the fifo)
+    fifo.reset();
+    samplesRead = samplesWritten = samplesToSkip = 0;
+    flushUpTo = 0;
+    nextReadPos = flushPosition = nextPlayPos;
+    lastSeekCount = lastFlushSeekCount = flushSeekCount = seekCount.get();
+    lastFlushSequence = flushSequence.get();
+    wasSourceLooping = isLooping();
+}
 
-    const int validStart = (int) (jlimit (bufferValidStart, bufferValidEnd, nextPlayPos) - nextPlayPos);
-    const int validEnd   = (int) (jlimit (bufferValidStart, bufferValidEnd, nextPlayPos + info.numSamples) - nextPlayPos);
+//==============================================================================
+bool BufferingAudioSource::catchUpWithBackgroundThread()
+{
+    const int sequence = flushSequence.get();
 
-    if (validStart == validEnd)
-    {
-        // total cache miss
-        info.clearActiveBufferRegion();
-    }
-    else
+    if (sequence != lastFlushSequence)
     {
-        if (validStart > 0)
-            info.buffer->clear (info.startSample, validStart);  // partial cache miss at start
+        // An odd number means the background thread is half-way through changing the values..
+        if ((sequence & 1) != 0)
+            return false;
+
+        const int64 upTo = flushUpTo;
+        const int64 newPosition = flushPosition;
+        const int newSeekCount = flushSeekCount;
 
-        if (validEnd < info.numSamples)
-            info.buffer->clear (info.startSample + validEnd,
-                                info.numSamples - validEnd);    // partial cache miss at end
+        if (flushSequence.get() != sequence)
+            return false;
 
-        if (validStart < validEnd)
+        // The background thread has moved to a new position, so everything it wrote before
+        // that point can be thrown away. If we've already played some of the samples it
+        // wrote after that point, then the play position needs to be moved on to match.
+        const int64 overshoot = samplesRead - upTo;
+
+        if (overshoot < 0)
         {
-            for (int chan = jmin (numberOfChannels, info.buffer->getNumChannels()); --chan >= 0;)
-            {
-                const int startBufferIndex = (int) ((validStart + nextPlayPos) % buffer.getNumSamples());
-                const int endBufferIndex = (int) ((validEnd + nextPlayPos) % buffer.getNumSamples());
-
-                if (startBufferIndex < endBufferIndex)
-                {
-                    info.buffer->copyFrom (chan, info.startSample + validStart,
-                                           buffer,
-                                           chan, startBufferIndex,
-                                           validEnd - validStart);
-                }
-                else
-                {
-                    const int initialSize = buffer.getNumSamples() - startBufferIndex;
-
-                    info.buffer->copyFrom (chan, info.startSample + validStart,
-                                           buffer,
-                                           chan, startBufferIndex,
-                                           initialSize);
-
-                    info.buffer->copyFrom (chan, info.startSample + validStart + initialSize,
-                                           buffer,
-                                           chan, 0,
-                                           (validEnd - validStart) - initialSize);
-                }
-            }
+            fifo.finishedRead ((int) -overshoot);
+            samplesRead = upTo;
         }
 
-        nextPlayPos += info.numSamples;
+        nextPlayPos = newPosition + jmax ((int64) 0, overshoot);
+        samplesToSkip = 0;
+        lastFlushSeekCount = newSeekCount;
+        lastFlushSequence = sequence;
+    }
 
-        if (source->isLooping() && nextPlayPos > 0)
-            nextPlayPos %= source->getTotalLength();
+    // if setNextReadPosition() has been called since then, the data that's in the
+    // buffer is no longer any use..
+    return seekCount.get() == lastFlushSeekCount;
+}
+
+void BufferingAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& info)
+{
+    // The background thread only ever holds the reader's side of the fifo for the moment it
+    // takes to discard some out-of-date data, and that data would be no use to us anyway.
+    if (readerClaim.compareAndSetBool (1, 0))
+    {
+        readFromFifo (info);
+        readerClaim = 0;
+    }
+    else
+    {
+        info.clearActiveBufferRegion();
     }
 
     SharedBufferingAudioSourceThread* const thread = SharedBufferingAudioSourceThread::getInstanceWithoutCreating();
@@ -244,6 +279,60 @@ void BufferingAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& info
         thread->notify();
 }
 
+void BufferingAudioSource::readFromFifo (const AudioSourceChannelInfo& info)
+{
+    if (! catchUpWithBackgroundThread())
+    {
+        info.clearActiveBufferRegion();
+        return;
+    }
+
+    if (samplesToSkip > 0)
+    {
+        // skip any samples that should have been played while the buffer was empty
+        const int numToSkip = (int) jmin (samplesToSkip, (int64) fifo.getNumReady());
+        fifo.finishedRead (numToSkip);
+        samplesRead += numToSkip;
+        samplesToSkip -= numToSkip;
+    }
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead (info.numSamples, start1, size1, start2, size2);
+    const int numRead = size1 + size2;
+
+    if (numRead == 0)
+    {
+        // total cache miss
+        info.clearActiveBufferRegion();
+        ++numUnderruns;
+        return;
+    }
+
+    for (int chan = jmin (numberOfChannels, info.buffer->getNumChannels()); --chan >= 0;)
+    {
+        info.buffer->copyFrom (chan, info.startSample, buffer, chan, start1, size1);
+
+        if (size2 > 0)
+            info.buffer->copyFrom (chan, info.startSample + size1, buffer, chan, start2, size2);
+    }
+
+    fifo.finishedRead (numRead);
+    samplesRead += numRead;
+
+    if (numRead < info.numSamples)
+    {
+        // partial cache miss at end
+        info.buffer->clear (info.startSample + numRead, info.numSamples - numRead);
+        samplesToSkip += info.numSamples - numRead;
+        ++numUnderruns;
+    }
+
+    nextPlayPos += info.numSamples;
+
+    if (source->isLooping() && nextPlayPos > 0)
+        nextPlayPos %= source->getTotalLength();
+}
+
 int64 BufferingAudioSource::getNextReadPosition() const
 {
     return (source->isLooping() && nextPlayPos > 0)
@@ -253,9 +342,9 @@ int64 BufferingAudioSource::getNextReadPosition() const
 
 void BufferingAudioSource::setNextReadPosition (int64 newPosition)
 {
-    const ScopedLock sl (bufferStartPosLock);
-
     nextPlayPos = newPosition;
+    pendingSeekPos = newPosition;
+    ++seekCount;
 
     SharedBufferingAudioSourceThread* const thread = SharedBufferingAudioSourceThread::getInstanceWithoutCreating();
 
@@ -263,85 +352,85 @@ void BufferingAudioSource::setNextReadPosition (int64 newPosition)
         thread->notify();
 }
 
+//==============================================================================
 bool BufferingAudioSource::readNextBufferChunk()
 {
-    int64 newBVS, newBVE, sectionToReadStart, sectionToReadEnd;
+    const int currentSeekCount = seekCount.get();
 
+    if (currentSeekCount != lastSeekCount || wasSourceLooping != isLooping())
     {
-        const ScopedLock sl (bufferStartPosLock);
-
-        if (wasSourceLooping != isLooping())
+        nextReadPos = (currentSeekCount != lastSeekCount) ? pendingSeekPos
+                                                          : (int64) nextPlayPos;
+        lastSeekCount = currentSeekCount;
+        wasSourceLooping = isLooping();
+
+        // Tell the audio thread that everything written up to now is out of date. (The
+        // sequence number is odd while the values are being changed).
+        ++flushSequence;
+        flushUpTo = samplesWritten;
+        flushPosition = nextReadPos;
+        flushSeekCount = currentSeekCount;
+        ++flushSequence;
+
+        // If the audio thread isn't busy reading, throw away the old data now, so that
+        // there's room to start buffering the new position straight away (e.g. when a
+        // transport is stopped, it won't be calling getNextAudioBlock() to do this).
+        if (readerClaim.compareAndSetBool (1, 0))
         {
-            wasSourceLooping = isLooping();
-            bufferValidStart = 0;
-            bufferValidEnd = 0;
+            catchUpWithBackgroundThread();
+            readerClaim = 0;
         }
+    }
 
-        newBVS = jmax ((int64) 0, nextPlayPos);
-        newBVE = newBVS + buffer.getNumSamples() - 4;
-        sectionToReadStart = 0;
-        sectionToReadEnd = 0;
+    const int underruns = numUnderruns.get();
 
-        const int maxChunkSize = 2048;
+    if (underruns != lastNumUnderruns)
+    {
+        lastNumUnderruns = underruns;
+        readAheadTarget = jmin (readAheadTarget * 2, fifo.getTotalSize() - 1);
+    }
 
-        if (newBVS < bufferValidStart || newBVS >= bufferValidEnd)
-        {
-            newBVE = jmin (newBVE, newBVS + maxChunkSize);
+    const int maxChunkSize = 2048;
+    const int numToRead = jmin (maxChunkSize,
+                                readAheadTarget - fifo.getNumReady(),
+                                fifo.getFreeSpace());
 
-            sectionToReadStart = newBVS;
-            sectionToReadEnd = newBVE;
+    if (numToRead <= 0)
+        return false;
 
-            bufferValidStart = 0;
-            bufferValidEnd = 0;
-        }
-        else if (std::abs ((int) (newBVS - bufferValidStart)) > 512
-                  || std::abs ((int) (newBVE - bufferValidEnd)) > 512)
-        {
-            newBVE = jmin (newBVE, bufferValidEnd + maxChunkSize);
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (numToRead, start1, size1, start2, size2);
 
-            sectionToReadStart = bufferValidEnd;
-            sectionToReadEnd = newBVE;
+    const double startTime = Time::getMillisecondCounterHiRes();
 
-            bufferValidStart = newBVS;
-            bufferValidEnd = jmin (bufferValidEnd, newBVE);
-        }
-    }
+    readBufferSection (nextReadPos, size1, start1);
 
-    if (sectionToReadStart != sectionToReadEnd)
-    {
-        const int bufferIndexStart = (int) (sectionToReadStart % buffer.getNumSamples());
-        const int bufferIndexEnd = (int) (sectionToReadEnd % buffer.getNumSamples());
+    if (size2 > 0)
+        readBufferSection (nextReadPos + size1, size2, start2);
 
-        if (bufferIndexStart < bufferIndexEnd)
-        {
-            readBufferSection (sectionToReadStart,
-                               (int) (sectionToReadEnd - sectionToReadStart),
-                               bufferIndexStart);
-        }
-        else
-        {
-            const int initialSize = buffer.getNumSamples() - bufferIndexStart;
+    updateReadAheadTarget (Time::getMillisecondCounterHiRes() - startTime);
 
-            readBufferSection (sectionToReadStart,
-                               initialSize,
-                               bufferIndexStart);
+    fifo.finishedWrite (size1 + size2);
+    samplesWritten += size1 + size2;
+    nextReadPos += size1 + size2;
 
-            readBufferSection (sectionToReadStart + initialSize,
-                               (int) (sectionToReadEnd - sectionToReadStart) - initialSize,
-                               0);
-        }
+    return true;
+}
 
-        const ScopedLock sl2 (bufferStartPosLock);
+void BufferingAudioSource::updateReadAheadTarget (const double millisecondsTaken)
+{
+    // The worst recent read time decays slowly, so that an occasional slow read keeps
+    // the buffer fuller for a while afterwards. Keeping four times that much data
+    // buffered leaves room for a few slow reads in a row.
+    worstReadTimeMs = jmax (millisecondsTaken, worstReadTimeMs * 0.995);
 
-        bufferValidStart = newBVS;
-        bufferValidEnd = newBVE;
+    const int wanted = jmax (minimumReadAhead, 4 * roundToInt (worstReadTimeMs * sampleRate / 1000.0));
 
-        return true;
-    }
-    else
-    {
-        return false;
-    }
+    // grow straight away, but shrink back gradually
+    const int newTarget = wanted >= readAheadTarget ? wanted
+                                                    : readAheadTarget - (readAheadTarget - wanted) / 256;
+
+    readAheadTarget = jlimit (minimumReadAhead, fifo.getTotalSize() - 1, newTarget);
 }
 
 void BufferingAudioSource::readBufferSection (const int64 start, const int length, const int bufferOffset)
@@ -30,6 +30,8 @@
 #include "../../threads/juce_Thread.h"
 #include "../dsp/juce_AudioSampleBuffer.h"
 #include "../../memory/juce_OptionalScopedPointer.h"
+#include "../../memory/juce_Atomic.h"
+#include "../../containers/juce_AbstractFifo.h"
 
 
 //==============================================================================
@@ -40,6 +42,12 @@
     a background thread to smooth out playback. You can either create one of these
     directly, or use it indirectly using an AudioTransportSource.
 
+    The buffer is a single-reader, single-writer FIFO, so the audio thread never has
+    to wait for the background thread. The amount of data that's kept buffered is
+    adjusted according to how long the source's reads are taking, and if the audio
+    thread ever catches up with the background thread, this is counted, so that you
+    can check for dropouts with getNumUnderruns().
+
     @see PositionableAudioSource, AudioTransportSource
 */
 class JUCE_API  BufferingAudioSource  : public PositionableAudioSource
@@ -89,19 +97,50 @@ public:
     /** Implements the PositionableAudioSource method. */
     bool isLooping() const                      { return source->isLooping(); }
 
+    //==============================================================================
+    /** Returns the number of times that the audio thread has run out of buffered data
+        since prepareToPlay() was called.
+
+        Each time this happens, some or all of a block will have been replaced by silence.
+    */
+    int getNumUnderruns() const noexcept        { return numUnderruns.get(); }
+
+    /** Returns the number of samples that the background thread is currently trying to
+        keep buffered ahead of the playback position.
+
+        This starts at a quarter of a second (or half the buffer if that's smaller), and
+        is increased if the source's reads start taking longer, or if there's an underrun.
+    */
+    int getReadAheadTarget() const noexcept     { return readAheadTarget; }
+
 private:
     //==============================================================================
     OptionalScopedPointer<PositionableAudioSource> source;
     int numberOfSamplesToBuffer, numberOfChannels;
     AudioSampleBuffer buffer;
-    CriticalSection bufferStartPosLock;
-    int64 volatile bufferValidStart, bufferValidEnd, nextPlayPos;
+    AbstractFifo fifo;
+    int64 volatile nextPlayPos, pendingSeekPos, flushUpTo, flushPosition;
+    int volatile flushSeekCount, readAheadTarget, minimumReadAhead;
+    Atomic<int> seekCount, flushSequence, numUnderruns, readerClaim;
     double volatile sampleRate;
+
+    // only used by whichever thread has set readerClaim..
+    int64 samplesRead, samplesToSkip;
+    int lastFlushSequence, lastFlushSeekCount;
+
+    // only used by the background thread..
+    int64 samplesWritten, nextReadPos;
+    int lastSeekCount, lastNumUnderruns;
+    double worstReadTimeMs;
     bool wasSourceLooping;
 
     friend class SharedBufferingAudioSourceThread;
     bool readNextBufferChunk();
     void readBufferSection (int64 start, int length, int bufferOffset);
+    bool catchUpWithBackgroundThread();
+    void readFromFifo (const AudioSourceChannelInfo& info);
+    void updateReadAheadTarget (double millisecondsTaken);
+    void resetFifo();
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BufferingAudioSource);
 };
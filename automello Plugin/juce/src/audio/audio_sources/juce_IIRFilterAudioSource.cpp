@@ -32,13 +32,12 @@ BEGIN_JUCE_NAMESPACE
 
 //==============================================================================
 IIRFilterAudioSource::IIRFilterAudioSource (AudioSource* const inputSource,
-                                            const bool deleteInputWhenDeleted)
-    : input (inputSource, deleteInputWhenDeleted)
+                                            const bool deleteInputWhenDeleted,
+                                            const int maxNumChannels)
+    : input (inputSource, deleteInputWhenDeleted),
+      filter (jmax (1, maxNumChannels), 1)
 {
     jassert (inputSource != nullptr);
-
-    for (int i = 2; --i >= 0;)
-        iirFilters.add (new IIRFilter());
 }
 
 IIRFilterAudioSource::~IIRFilterAudioSource()  {}
@@ -46,17 +45,14 @@ IIRFilterAudioSource::~IIRFilterAudioSource()  {}
 //==============================================================================
 void IIRFilterAudioSource::setFilterParameters (const IIRFilter& newSettings)
 {
-    for (int i = iirFilters.size(); --i >= 0;)
-        iirFilters.getUnchecked(i)->copyCoefficientsFrom (newSettings);
+    filter.setStage (0, newSettings);
 }
 
 //==============================================================================
 void IIRFilterAudioSource::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
 {
     input->prepareToPlay (samplesPerBlockExpected, sampleRate);
-
-    for (int i = iirFilters.size(); --i >= 0;)
-        iirFilters.getUnchecked(i)->reset();
+    filter.reset();
 }
 
 void IIRFilterAudioSource::releaseResources()
@@ -68,15 +64,8 @@ void IIRFilterAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& buff
 {
     input->getNextAudioBlock (bufferToFill);
 
-    const int numChannels = bufferToFill.buffer->getNumChannels();
-
-    while (numChannels > iirFilters.size())
-        iirFilters.add (new IIRFilter (*iirFilters.getUnchecked (0)));
-
-    for (int i = 0; i < numChannels; ++i)
-        iirFilters.getUnchecked(i)
-            ->processSamples (bufferToFill.buffer->getSampleData (i, bufferToFill.startSample),
-                              bufferToFill.numSamples);
+    // (if this asserts, the source needs to be created with a bigger maxNumChannels)
+    filter.processSamples (*bufferToFill.buffer, bufferToFill.startSample, bufferToFill.numSamples);
 }
 
 
@@ -27,14 +27,18 @@
 #define __JUCE_IIRFILTERAUDIOSOURCE_JUCEHEADER__
 
 #include "juce_AudioSource.h"
-#include "../dsp/juce_IIRFilter.h"
-#include "../../containers/juce_OwnedArray.h"
+#include "../dsp/juce_BiquadCascade.h"
 #include "../../memory/juce_OptionalScopedPointer.h"
 
 
 //==============================================================================
 /**
     An AudioSource that performs an IIR filter on another source.
+
+    All the channels are filtered together by a BiquadCascade, so the filter settings
+    can be changed while the source is playing without blocking the audio thread, and
+    the filter state for every channel is allocated up-front, so nothing needs to be
+    allocated while it's playing.
 */
 class JUCE_API  IIRFilterAudioSource  : public AudioSource
 {
@@ -45,9 +49,13 @@ public:
         @param inputSource              the input source to read from - this must not be null
         @param deleteInputWhenDeleted   if true, the input source will be deleted when
                                         this object is deleted
+        @param maxNumChannels           the largest number of channels that the source will be
+                                        asked to fill. Any channels beyond this will be passed
+                                        through without being filtered
     */
     IIRFilterAudioSource (AudioSource* inputSource,
-                          bool deleteInputWhenDeleted);
+                          bool deleteInputWhenDeleted,
+                          int maxNumChannels = 2);
 
     /** Destructor. */
     ~IIRFilterAudioSource();
@@ -64,7 +72,7 @@ public:
 private:
     //==============================================================================
     OptionalScopedPointer<AudioSource> input;
-    OwnedArray <IIRFilter> iirFilters;
+    BiquadCascade filter;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (IIRFilterAudioSource);
 };
@@ -145,8 +145,10 @@ void MixerAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& info)
 
         if (inputs.size() > 1)
         {
+            // (the buffer only ever grows here, so once it's reached the size that the
+            // callback needs, it won't be reallocated on the audio thread again)
             tempBuffer.setSize (jmax (1, info.buffer->getNumChannels()),
-                                info.buffer->getNumSamples());
+                                info.buffer->getNumSamples(), false, false, true);
 
             AudioSourceChannelInfo info2;
             info2.buffer = &tempBuffer;
@@ -23,6 +23,7 @@
   ==============================================================================
 */
 
+
 #include "../../core/juce_StandardHeader.h"
 
 BEGIN_JUCE_NAMESPACE
@@ -30,18 +31,162 @@ BEGIN_JUCE_NAMESPACE
 #include "juce_ResamplingAudioSource.h"
 
 
+//==============================================================================
+namespace ResamplerHelpers
+{
+    /*  The filters are Kaiser-windowed sincs. The cutoff is given as a proportion of the
+        sample rate, and is chosen so that the transition band ends at about the Nyquist
+        frequency for each filter length.
+    */
+    struct QualitySettings
+    {
+        int numTaps, numPhases;
+        double cutoff, kaiserBeta;
+    };
+
+    static const QualitySettings qualitySettings[] =
+    {
+        { 8,  64,  0.32,  4.5 },
+        { 24, 128, 0.41,  6.8 },
+        { 48, 256, 0.437, 8.9 }
+    };
+
+    enum
+    {
+        maxStretch = 8,
+        maxHalfTaps = 48 * maxStretch / 2
+    };
+
+    /* When down-sampling, the filter has to be stretched to lower its cutoff. The amount is
+       rounded up to a sixteenth, so that small changes to the ratio don't all need new filters.
+    */
+    inline double getFilterStretch (const double ratio) noexcept
+    {
+        return ratio <= 1.0 ? 1.0 : std::ceil (ratio * 16.0) / 16.0;
+    }
+
+    double besselI0 (const double x) noexcept
+    {
+        double sum = 1.0, term = 1.0;
+
+        for (int k = 1; k < 50 && term > sum * 1.0e-12; ++k)
+        {
+            const double t = x / (2 * k);
+            term *= t * t;
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    inline float convolve (const float* const src, const float* const coeffs,
+                           const int numTaps, const float alpha) noexcept
+    {
+        // (the coefficients for the next phase follow on directly from this one)
+        const float* const nextCoeffs = coeffs + numTaps;
+
+       #if JUCE_USE_SSE_INTRINSICS
+        __m128 sum1 = _mm_setzero_ps();
+        __m128 sum2 = _mm_setzero_ps();
+
+        for (int i = 0; i < numTaps; i += 4)
+        {
+            const __m128 s = _mm_loadu_ps (src + i);
+            sum1 = _mm_add_ps (sum1, _mm_mul_ps (s, _mm_loadu_ps (coeffs + i)));
+            sum2 = _mm_add_ps (sum2, _mm_mul_ps (s, _mm_loadu_ps (nextCoeffs + i)));
+        }
+
+        sum1 = _mm_add_ps (sum1, _mm_mul_ps (_mm_sub_ps (sum2, sum1), _mm_set1_ps (alpha)));
+        sum1 = _mm_add_ps (sum1, _mm_movehl_ps (sum1, sum1));
+        sum1 = _mm_add_ss (sum1, _mm_shuffle_ps (sum1, sum1, 1));
+        return _mm_cvtss_f32 (sum1);
+       #else
+        float sum1 = 0, sum2 = 0;
+
+        for (int i = 0; i < numTaps; ++i)
+        {
+            sum1 += src[i] * coeffs[i];
+            sum2 += src[i] * nextCoeffs[i];
+        }
+
+        return sum1 + (sum2 - sum1) * alpha;
+       #endif
+    }
+}
+
+//==============================================================================
+ResamplingAudioSource::FilterBank::FilterBank()
+    : numTaps (0), numPhases (0), stretch (0)
+{
+}
+
+void ResamplingAudioSource::FilterBank::design (const Quality quality, const double newStretch)
+{
+    using namespace ResamplerHelpers;
+    const QualitySettings& settings = qualitySettings [quality];
+
+    // the number of taps is kept to a multiple of 4 for the SSE code
+    numTaps = 4 * (int) std::ceil (settings.numTaps * jmin (newStretch, (double) maxStretch) / 4.0);
+    numPhases = settings.numPhases;
+    stretch = newStretch;
+
+    // each phase holds the taps for one fractional position between two input samples,
+    // with an extra one at the end so that the positions in between can be interpolated
+    coefficients.malloc ((size_t) ((numPhases + 1) * numTaps));
+
+    const double cutoff = settings.cutoff / newStretch;
+    const double halfLength = numTaps / 2;
+    const double windowScale = 1.0 / besselI0 (settings.kaiserBeta);
+
+    for (int phase = 0; phase <= numPhases; ++phase)
+    {
+        float* const c = coefficients + phase * numTaps;
+        const double offset = phase / (double) numPhases;
+        double total = 0;
+
+        for (int i = 0; i < numTaps; ++i)
+        {
+            const double t = i - (halfLength - 1.0) - offset;
+            const double x = t / halfLength;
+            const double window = besselI0 (settings.kaiserBeta * std::sqrt (jmax (0.0, 1.0 - x * x))) * windowScale;
+            const double sinc = t == 0 ? 1.0 : std::sin (double_Pi * 2.0 * cutoff * t) / (double_Pi * 2.0 * cutoff * t);
+
+            c[i] = (float) (2.0 * cutoff * sinc * window);
+            total += c[i];
+        }
+
+        // normalising each phase stops any DC ripple from creeping in
+        for (int i = 0; i < numTaps; ++i)
+            c[i] = (float) (c[i] / total);
+    }
+}
+
+void ResamplingAudioSource::FilterBank::swapWith (FilterBank& other) noexcept
+{
+    coefficients.swapWith (other.coefficients);
+    std::swap (numTaps, other.numTaps);
+    std::swap (numPhases, other.numPhases);
+    std::swap (stretch, other.stretch);
+}
+
 //==============================================================================
 ResamplingAudioSource::ResamplingAudioSource (AudioSource* const inputSource,
                                               const bool deleteInputWhenDeleted,
                                               const int numChannels_)
     : input (inputSource, deleteInputWhenDeleted),
       ratio (1.0),
-      lastRatio (1.0),
+      activeRatio (1.0),
+      quality (mediumQuality),
+      pendingFiltersChanged (false),
       buffer (numChannels_, 0),
-      sampsInBuffer (0),
+      readPos (0),
+      numBuffered (0),
+      subSampleOffset (0),
       numChannels (numChannels_)
 {
     jassert (input != nullptr);
+
+    activeFilters.design (quality, 1.0);
 }
 
 ResamplingAudioSource::~ResamplingAudioSource() {}
@@ -50,28 +195,85 @@ void ResamplingAudioSource::setResamplingRatio (const double samplesInPerOutputS
 {
     jassert (samplesInPerOutputSample > 0);
 
-    const SpinLock::ScopedLockType sl (ratioLock);
+    const SpinLock::ScopedLockType sl (pendingLock);
     ratio = jmax (0.0, samplesInPerOutputSample);
+    updatePendingFilters();
+}
+
+void ResamplingAudioSource::setQuality (const Quality newQuality)
+{
+    const SpinLock::ScopedLockType sl (pendingLock);
+    quality = newQuality;
+    activeFilters.design (quality, ResamplerHelpers::getFilterStretch (ratio));
+    pendingFiltersChanged = false;
+}
+
+void ResamplingAudioSource::updatePendingFilters()
+{
+    // (must be called with the pending lock held, which also stops the
+    // audio thread from swapping the active filters over)
+    const double stretch = ResamplerHelpers::getFilterStretch (ratio);
+    const FilterBank& latestFilters = pendingFiltersChanged ? pendingFilters : activeFilters;
+
+    if (stretch != latestFilters.stretch)
+    {
+        pendingFilters.design (quality, stretch);
+        pendingFiltersChanged = true;
+    }
+
+    newSettingsAvailable = 1;
 }
 
+void ResamplingAudioSource::applyPendingSettings() noexcept
+{
+    // The audio thread never waits for the lock - if someone's in the middle
+    // of changing the settings, it'll pick them up next time round.
+    if (newSettingsAvailable.get() != 0 && pendingLock.tryEnter())
+    {
+        if (pendingFiltersChanged)
+        {
+            activeFilters.swapWith (pendingFilters);
+            pendingFiltersChanged = false;
+        }
+
+        activeRatio = jmin (ratio, getMaxRatio());
+        newSettingsAvailable = 0;
+        pendingLock.exit();
+    }
+}
+
+double ResamplingAudioSource::getMaxRatio() const noexcept
+{
+    // the buffer must always have room for the history, a filter's worth of
+    // look-ahead, and the input for at least one output sample
+    return jmax (1.0, (double) (buffer.getNumSamples() - 2 * ResamplerHelpers::maxHalfTaps - 4));
+}
+
+//==============================================================================
 void ResamplingAudioSource::prepareToPlay (int samplesPerBlockExpected,
                                            double sampleRate)
 {
-    const SpinLock::ScopedLockType sl (ratioLock);
+    const SpinLock::ScopedLockType sl (pendingLock);
 
     input->prepareToPlay (samplesPerBlockExpected, sampleRate);
 
-    buffer.setSize (numChannels, roundToInt (samplesPerBlockExpected * ratio) + 32);
+    buffer.setSize (numChannels, 2 * ResamplerHelpers::maxHalfTaps + 4
+                                   + roundToInt (samplesPerBlockExpected * jmax (1.0, ratio)) + 32);
     buffer.clear();
-    sampsInBuffer = 0;
-    bufferPos = 0;
+
+    // the start of the buffer holds the history that the filters need to look back over
+    readPos = ResamplerHelpers::maxHalfTaps;
+    numBuffered = readPos;
     subSampleOffset = 0.0;
 
-    filterStates.calloc (numChannels);
-    srcBuffers.calloc (numChannels);
-    destBuffers.calloc (numChannels);
-    createLowPass (ratio);
-    resetFilters();
+    if (pendingFiltersChanged)
+    {
+        activeFilters.swapWith (pendingFilters);
+        pendingFiltersChanged = false;
+    }
+
+    activeRatio = jmin (ratio, getMaxRatio());
+    newSettingsAvailable = 0;
 }
 
 void ResamplingAudioSource::releaseResources()
@@ -82,187 +284,261 @@ void ResamplingAudioSource::releaseResources()
 
 void ResamplingAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& info)
 {
-    double localRatio;
+    applyPendingSettings();
+
+    for (int numDone = 0; numDone < info.numSamples;)
+        numDone += processChunk (info, info.startSample + numDone, info.numSamples - numDone);
+}
+
+int ResamplingAudioSource::processChunk (const AudioSourceChannelInfo& info,
+                                         const int startSample, const int numSamples) noexcept
+{
+    const double localRatio = activeRatio;
+    const int numTaps = activeFilters.numTaps;
+    const int numPhases = activeFilters.numPhases;
+    const int halfTaps = numTaps / 2;
+
+    // work out how many output samples we can make before the buffer's full..
+    const int numOutputs = jlimit (1, numSamples, (int) ((buffer.getNumSamples() - 2 - halfTaps
+                                                          - readPos - subSampleOffset) / localRatio));
+
+    const double endOffset = subSampleOffset + numOutputs * localRatio;
+    const int numNeeded = readPos + jmax ((int) (subSampleOffset + (numOutputs - 1) * localRatio) + halfTaps + 1,
+                                          (int) endOffset);
+
+    jassert (numNeeded <= buffer.getNumSamples());
 
+    if (numNeeded > numBuffered)
     {
-        const SpinLock::ScopedLockType sl (ratioLock);
-        localRatio = ratio;
+        AudioSourceChannelInfo readInfo;
+        readInfo.buffer = &buffer;
+        readInfo.startSample = numBuffered;
+        readInfo.numSamples = numNeeded - numBuffered;
+
+        input->getNextAudioBlock (readInfo);
+        numBuffered = numNeeded;
     }
 
-    if (lastRatio != localRatio)
+    const int channelsToProcess = jmin (numChannels, info.buffer->getNumChannels());
+
+    for (int channel = 0; channel < channelsToProcess; ++channel)
     {
-        createLowPass (localRatio);
-        lastRatio = localRatio;
+        float* const dest = info.buffer->getSampleData (channel, startSample);
+
+        if (localRatio == 1.0 && subSampleOffset == 0.0)
+        {
+            // when the rates are the same, the input can be passed straight through
+            memcpy (dest, buffer.getSampleData (channel, readPos), sizeof (float) * (size_t) numOutputs);
+        }
+        else
+        {
+            const float* const src = buffer.getSampleData (channel, readPos - halfTaps + 1);
+
+            for (int i = 0; i < numOutputs; ++i)
+            {
+                const double pos = subSampleOffset + i * localRatio;
+                const int index = (int) pos;
+                const double phase = (pos - index) * numPhases;
+                const int phaseIndex = (int) phase;
+
+                dest[i] = ResamplerHelpers::convolve (src + index, activeFilters.coefficients + phaseIndex * numTaps,
+                                                      numTaps, (float) (phase - phaseIndex));
+            }
+        }
     }
 
-    const int sampsNeeded = roundToInt (info.numSamples * localRatio) + 2;
+    readPos += (int) endOffset;
+    subSampleOffset = endOffset - (int) endOffset;
 
-    int bufferSize = buffer.getNumSamples();
+    // discard any input that's no longer needed, keeping enough history for the filters
+    const int numToDiscard = readPos - ResamplerHelpers::maxHalfTaps;
 
-    if (bufferSize < sampsNeeded + 8)
+    if (numToDiscard > 0)
     {
-        bufferPos %= bufferSize;
-        bufferSize = sampsNeeded + 32;
-        buffer.setSize (buffer.getNumChannels(), bufferSize, true, true);
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            float* const data = buffer.getSampleData (channel);
+            memmove (data, data + numToDiscard, sizeof (float) * (size_t) (numBuffered - numToDiscard));
+        }
+
+        readPos -= numToDiscard;
+        numBuffered -= numToDiscard;
     }
 
-    bufferPos %= bufferSize;
+    return numOutputs;
+}
 
-    int endOfBufferPos = bufferPos + sampsInBuffer;
-    const int channelsToProcess = jmin (numChannels, info.buffer->getNumChannels());
+//==============================================================================
+#if JUCE_UNIT_TESTS
 
-    while (sampsNeeded > sampsInBuffer)
-    {
-        endOfBufferPos %= bufferSize;
+#include "../../utilities/juce_UnitTest.h"
+#include "../../core/juce_Time.h"
 
-        int numToDo = jmin (sampsNeeded - sampsInBuffer,
-                            bufferSize - endOfBufferPos);
+class ResamplingAudioSourceTests  : public UnitTest
+{
+public:
+    ResamplingAudioSourceTests() : UnitTest ("ResamplingAudioSource") {}
 
-        AudioSourceChannelInfo readInfo;
-        readInfo.buffer = &buffer;
-        readInfo.numSamples = numToDo;
-        readInfo.startSample = endOfBufferPos;
+    //==============================================================================
+    class SineSource  : public AudioSource
+    {
+    public:
+        SineSource (const double frequency_) : frequency (frequency_), position (0) {}
 
-        input->getNextAudioBlock (readInfo);
+        void prepareToPlay (int, double)        {}
+        void releaseResources()                 {}
 
-        if (localRatio > 1.0001)
+        void getNextAudioBlock (const AudioSourceChannelInfo& info)
         {
-            // for down-sampling, pre-apply the filter..
+            for (int i = 0; i < info.numSamples; ++i)
+            {
+                const float sample = (float) (0.5 * std::sin (double_Pi * 2.0 * frequency * (double) position++));
 
-            for (int i = channelsToProcess; --i >= 0;)
-                applyFilter (buffer.getSampleData (i, endOfBufferPos), numToDo, filterStates[i]);
+                for (int ch = 0; ch < info.buffer->getNumChannels(); ++ch)
+                    info.buffer->getSampleData (ch, info.startSample)[i] = sample;
+            }
         }
 
-        sampsInBuffer += numToDo;
-        endOfBufferPos += numToDo;
-    }
+    private:
+        const double frequency;
+        int64 position;
+    };
 
-    for (int channel = 0; channel < channelsToProcess; ++channel)
+    //==============================================================================
+    void runTest()
     {
-        destBuffers[channel] = info.buffer->getSampleData (channel, info.startSample);
-        srcBuffers[channel] = buffer.getSampleData (channel, 0);
-    }
+        const char* const qualityNames[] = { "low", "medium", "high" };
+        const double minimumRejection[] = { 40.0, 60.0, 80.0 };
 
-    int nextPos = (bufferPos + 1) % bufferSize;
-    for (int m = info.numSamples; --m >= 0;)
-    {
-        const float alpha = (float) subSampleOffset;
-        const float invAlpha = 1.0f - alpha;
+        for (int q = ResamplingAudioSource::lowQuality; q <= ResamplingAudioSource::highQuality; ++q)
+        {
+            const ResamplingAudioSource::Quality quality = (ResamplingAudioSource::Quality) q;
+            beginTest (String (qualityNames[q]) + " quality");
 
-        for (int channel = 0; channel < channelsToProcess; ++channel)
-            *destBuffers[channel]++ = srcBuffers[channel][bufferPos] * invAlpha + srcBuffers[channel][nextPos] * alpha;
+            const double ratios[] = { 44100.0 / 48000.0, 48000.0 / 44100.0, 0.5, 2.0, 1.0 };
 
-        subSampleOffset += localRatio;
+            for (int i = 0; i < numElementsInArray (ratios); ++i)
+            {
+                const double ratio = ratios[i];
 
-        jassert (sampsInBuffer > 0);
+                // a 1kHz tone (at 44.1kHz) should come out cleanly..
+                const double thdPlusNoise = measureTone (quality, ratio, 1000.0 / 44100.0, true);
+                expect (thdPlusNoise < -minimumRejection[q], "THD+N is " + String (thdPlusNoise, 1) + "dB");
 
-        while (subSampleOffset >= 1.0)
-        {
-            if (++bufferPos >= bufferSize)
-                bufferPos = 0;
+                // ..and a tone that's above the output's Nyquist frequency should be removed
+                double rejection = 0;
 
-            --sampsInBuffer;
+                if (ratio > 1.0)
+                {
+                    rejection = measureTone (quality, ratio, jmin (0.48, 0.6 / ratio), false);
+                    expect (rejection < -minimumRejection[q], "aliasing is " + String (rejection, 1) + "dB");
+                }
 
-            nextPos = (bufferPos + 1) % bufferSize;
-            subSampleOffset -= 1.0;
+                double msPerSecond = measureSpeed (quality, ratio);
+
+                logMessage ("ratio " + String (ratio, 4) + ": THD+N " + String (thdPlusNoise, 1) + "dB, "
+                              + (ratio > 1.0 ? "alias " + String (rejection, 1) + "dB, " : String::empty)
+                              + String (msPerSecond, 3) + "ms of CPU per second of stereo output");
+            }
         }
     }
 
-    if (localRatio < 0.9999)
+    /* Returns the THD+N relative to the expected tone, or if expectTone is false, the
+       level of whatever gets through relative to the input.
+    */
+    double measureTone (ResamplingAudioSource::Quality quality, const double ratio,
+                        const double frequency, const bool expectTone)
     {
-        // for up-sampling, apply the filter after transposing..
-        for (int i = channelsToProcess; --i >= 0;)
-            applyFilter (info.buffer->getSampleData (i, info.startSample), info.numSamples, filterStates[i]);
-    }
-    else if (localRatio <= 1.0001)
-    {
-        // if the filter's not currently being applied, keep it stoked with the last couple of samples to avoid discontinuities
-        for (int i = channelsToProcess; --i >= 0;)
+        const int blockSize = 441;
+        const int numBlocks = 100;
+
+        ResamplingAudioSource resampler (new SineSource (frequency), true, 1);
+        resampler.setQuality (quality);
+        resampler.setResamplingRatio (ratio);
+        resampler.prepareToPlay (blockSize, 44100.0);
+
+        AudioSampleBuffer output (1, blockSize * numBlocks);
+
+        AudioSourceChannelInfo info;
+        info.buffer = &output;
+        info.numSamples = blockSize;
+
+        for (info.startSample = 0; info.startSample < output.getNumSamples(); info.startSample += blockSize)
+            resampler.getNextAudioBlock (info);
+
+        // skip the start, where the filter's history is still full of zeros
+        const int start = 200;
+        const int num = output.getNumSamples() - start;
+        const float* const data = output.getSampleData (0, start);
+
+        double signal = 0, residual = 0;
+
+        if (expectTone)
         {
-            const float* const endOfBuffer = info.buffer->getSampleData (i, info.startSample + info.numSamples - 1);
-            FilterState& fs = filterStates[i];
+            // do a least-squares fit of a sine and cosine of the expected frequency, and see what's left over..
+            const double w = double_Pi * 2.0 * frequency * ratio;
+            double ss = 0, cc = 0, sc = 0, ys = 0, yc = 0;
 
-            if (info.numSamples > 1)
+            for (int i = 0; i < num; ++i)
             {
-                fs.y2 = fs.x2 = *(endOfBuffer - 1);
+                const double s = std::sin (w * (start + i)), c = std::cos (w * (start + i));
+                ss += s * s;
+                cc += c * c;
+                sc += s * c;
+                ys += data[i] * s;
+                yc += data[i] * c;
             }
-            else
+
+            const double det = ss * cc - sc * sc;
+            const double sinAmount = (ys * cc - yc * sc) / det;
+            const double cosAmount = (yc * ss - ys * sc) / det;
+
+            for (int i = 0; i < num; ++i)
             {
-                fs.y2 = fs.y1;
-                fs.x2 = fs.x1;
+                const double fit = sinAmount * std::sin (w * (start + i)) + cosAmount * std::cos (w * (start + i));
+                signal += fit * fit;
+                residual += (data[i] - fit) * (data[i] - fit);
             }
+        }
+        else
+        {
+            signal = num * 0.125;
 
-            fs.y1 = fs.x1 = *endOfBuffer;
+            for (int i = 0; i < num; ++i)
+                residual += data[i] * data[i];
         }
+
+        return 10.0 * std::log10 (residual / signal + 1.0e-30);
     }
 
-    jassert (sampsInBuffer >= 0);
-}
+    double measureSpeed (ResamplingAudioSource::Quality quality, const double ratio)
+    {
+        const int blockSize = 512;
+        const int numBlocks = 2000;
 
-void ResamplingAudioSource::createLowPass (const double frequencyRatio)
-{
-    const double proportionalRate = (frequencyRatio > 1.0) ? 0.5 / frequencyRatio
-                                                           : 0.5 * frequencyRatio;
-
-    const double n = 1.0 / std::tan (double_Pi * jmax (0.001, proportionalRate));
-    const double nSquared = n * n;
-    const double c1 = 1.0 / (1.0 + std::sqrt (2.0) * n + nSquared);
-
-    setFilterCoefficients (c1,
-                           c1 * 2.0f,
-                           c1,
-                           1.0,
-                           c1 * 2.0 * (1.0 - nSquared),
-                           c1 * (1.0 - std::sqrt (2.0) * n + nSquared));
-}
+        ResamplingAudioSource resampler (new SineSource (0.01), true, 2);
+        resampler.setQuality (quality);
+        resampler.setResamplingRatio (ratio);
+        resampler.prepareToPlay (blockSize, 44100.0);
 
-void ResamplingAudioSource::setFilterCoefficients (double c1, double c2, double c3, double c4, double c5, double c6)
-{
-    const double a = 1.0 / c4;
-
-    c1 *= a;
-    c2 *= a;
-    c3 *= a;
-    c5 *= a;
-    c6 *= a;
-
-    coefficients[0] = c1;
-    coefficients[1] = c2;
-    coefficients[2] = c3;
-    coefficients[3] = c4;
-    coefficients[4] = c5;
-    coefficients[5] = c6;
-}
+        AudioSampleBuffer output (2, blockSize);
 
-void ResamplingAudioSource::resetFilters()
-{
-    filterStates.clear (numChannels);
-}
+        AudioSourceChannelInfo info;
+        info.buffer = &output;
+        info.startSample = 0;
+        info.numSamples = blockSize;
 
-void ResamplingAudioSource::applyFilter (float* samples, int num, FilterState& fs)
-{
-    while (--num >= 0)
-    {
-        const double in = *samples;
+        const double startTime = Time::getMillisecondCounterHiRes();
 
-        double out = coefficients[0] * in
-                     + coefficients[1] * fs.x1
-                     + coefficients[2] * fs.x2
-                     - coefficients[4] * fs.y1
-                     - coefficients[5] * fs.y2;
+        for (int i = 0; i < numBlocks; ++i)
+            resampler.getNextAudioBlock (info);
 
-       #if JUCE_INTEL
-        if (! (out < -1.0e-8 || out > 1.0e-8))
-            out = 0;
-       #endif
+        return (Time::getMillisecondCounterHiRes() - startTime) * 44100.0 / (blockSize * numBlocks);
+    }
+};
 
-        fs.x2 = fs.x1;
-        fs.x1 = in;
-        fs.y2 = fs.y1;
-        fs.y1 = out;
+static ResamplingAudioSourceTests resamplingAudioSourceTests;
 
-        *samples++ = (float) out;
-    }
-}
+#endif
 
 END_JUCE_NAMESPACE
@@ -29,12 +29,20 @@
 #include "juce_AudioSource.h"
 #include "../../threads/juce_SpinLock.h"
 #include "../../memory/juce_OptionalScopedPointer.h"
+#include "../../memory/juce_Atomic.h"
+#include "../../memory/juce_HeapBlock.h"
 
 
 //==============================================================================
 /**
     A type of AudioSource that takes an input source and changes its sample rate.
 
+    The resampling is done with a polyphase windowed-sinc filter, which is band-limited
+    to avoid aliasing when either up- or down-sampling, and works for any ratio. The
+    filter tables are built when the ratio or quality is changed rather than on the
+    audio thread, and all the memory that the audio thread needs is allocated in
+    prepareToPlay().
+
     @see AudioSource
 */
 class JUCE_API  ResamplingAudioSource  : public AudioSource
@@ -55,9 +63,35 @@ public:
     /** Destructor. */
     ~ResamplingAudioSource();
 
+    //==============================================================================
+    /** The different filter lengths that the resampler can use.
+
+        Longer filters have a sharper cutoff and reject more of the aliased signal,
+        but take more CPU to run.
+    */
+    enum Quality
+    {
+        lowQuality = 0,     /**< 8-tap filters, suitable for previewing or for heavily-loaded systems. */
+        mediumQuality,      /**< 24-tap filters, with around 70dB of alias rejection. */
+        highQuality         /**< 48-tap filters, with around 90dB of alias rejection. */
+    };
+
+    /** Changes the length of filter that is used.
+
+        This must be called before prepareToPlay(), and mustn't be called while the
+        source is running. The default is mediumQuality.
+    */
+    void setQuality (Quality newQuality);
+
+    /** Returns the quality setting that's in use. */
+    Quality getQuality() const noexcept                         { return quality; }
+
     /** Changes the resampling ratio.
 
-        (This value can be changed at any time, even while the source is running).
+        (This value can be changed at any time, even while the source is running, and
+        the new ratio is picked up at the start of the next block. When down-sampling,
+        a new set of filters may need to be built, so avoid calling this from the audio
+        thread if you're changing the ratio continuously).
 
         @param samplesInPerOutputSample     if set to 1.0, the input is passed through; higher
                                             values will speed it up; lower values will slow it
@@ -78,28 +112,35 @@ public:
 
 private:
     //==============================================================================
-    OptionalScopedPointer<AudioSource> input;
-    double ratio, lastRatio;
-    AudioSampleBuffer buffer;
-    int bufferPos, sampsInBuffer;
-    double subSampleOffset;
-    double coefficients[6];
-    SpinLock ratioLock;
-    const int numChannels;
-    HeapBlock<float*> destBuffers, srcBuffers;
+    struct FilterBank
+    {
+        FilterBank();
 
-    void setFilterCoefficients (double c1, double c2, double c3, double c4, double c5, double c6);
-    void createLowPass (double proportionalRate);
+        void design (Quality quality, double stretch);
+        void swapWith (FilterBank& other) noexcept;
 
-    struct FilterState
-    {
-        double x1, x2, y1, y2;
+        HeapBlock<float> coefficients;
+        int numTaps, numPhases;
+        double stretch;
     };
 
-    HeapBlock<FilterState> filterStates;
-    void resetFilters();
+    OptionalScopedPointer<AudioSource> input;
+    double ratio, activeRatio;
+    Quality quality;
+    FilterBank activeFilters, pendingFilters;
+    SpinLock pendingLock;
+    Atomic<int> newSettingsAvailable;
+    bool pendingFiltersChanged;
+
+    AudioSampleBuffer buffer;
+    int readPos, numBuffered;
+    double subSampleOffset;
+    const int numChannels;
 
-    void applyFilter (float* samples, int num, FilterState& fs);
+    void updatePendingFilters();
+    void applyPendingSettings() noexcept;
+    double getMaxRatio() const noexcept;
+    int processChunk (const AudioSourceChannelInfo& info, int startSample, int numSamples) noexcept;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResamplingAudioSource);
 };
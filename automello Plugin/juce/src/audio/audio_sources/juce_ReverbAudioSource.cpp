@@ -57,18 +57,13 @@ void ReverbAudioSource::getNextAudioBlock (const AudioSourceChannelInfo& bufferT
 
     if (! bypass)
     {
-        float* const firstChannel = bufferToFill.buffer->getSampleData (0, bufferToFill.startSample);
-
-        if (bufferToFill.buffer->getNumChannels() > 1)
-        {
-            reverb.processStereo (firstChannel,
-                                  bufferToFill.buffer->getSampleData (1, bufferToFill.startSample),
-                                  bufferToFill.numSamples);
-        }
-        else
-        {
-            reverb.processMono (firstChannel, bufferToFill.numSamples);
-        }
+        float* channels [Reverb::maxNumChannels];
+        const int numChannels = jmin (bufferToFill.buffer->getNumChannels(), (int) Reverb::maxNumChannels);
+
+        for (int i = 0; i < numChannels; ++i)
+            channels[i] = bufferToFill.buffer->getSampleData (i, bufferToFill.startSample);
+
+        reverb.processChannels (channels, numChannels, bufferToFill.numSamples);
     }
 }
 
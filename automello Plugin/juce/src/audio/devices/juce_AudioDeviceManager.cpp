@@ -611,6 +611,7 @@ void AudioDeviceManager::audioDeviceIOCallbackInt (const float** inputChannelDat
                                                    int numSamples)
 {
     const ScopedLock sl (audioCallbackLock);
+    const ScopedAudioThreadAllocationCheck allocationCheck;
 
     if (inputLevelMeasurementEnabledCount > 0 && numInputChannels > 0)
     {
@@ -705,6 +706,11 @@ void AudioDeviceManager::audioDeviceAboutToStartInt (AudioIODevice* const device
 
     {
         const ScopedLock sl (audioCallbackLock);
+
+        // make sure the callback won't need to enlarge this buffer
+        tempBuffer.setSize (jmax (1, device->getActiveOutputChannels().countNumberOfSetBits()),
+                            jmax (1, blockSize), false, false, true);
+
         for (int i = callbacks.size(); --i >= 0;)
             callbacks.getUnchecked(i)->audioDeviceAboutToStart (device);
     }
@@ -305,6 +305,27 @@ public:
     */
     virtual int getInputLatencyInSamples() = 0;
 
+    //==============================================================================
+    /** Returns true if the device is currently calling its callback as fast as it can,
+        rather than in real time.
+
+        JACK does this while its session is in "freewheel" mode, e.g. when something's
+        being bounced. Callbacks may want to switch their processing to an offline
+        mode while it's happening.
+
+        @see setFreewheeling, AudioProcessor::setNonRealtime
+    */
+    virtual bool isFreewheeling()                                   { return false; }
+
+    /** Asks the device to start or stop calling its callback as fast as it can, so that
+        the audio can be rendered faster than real time.
+
+        Returns false if the device can't do this. For JACK, this puts the whole session
+        into freewheel mode.
+
+        @see isFreewheeling
+    */
+    virtual bool setFreewheeling (bool /*shouldFreewheel*/)         { return false; }
 
     //==============================================================================
     /** True if this device can show a pop-up control panel for editing its settings.
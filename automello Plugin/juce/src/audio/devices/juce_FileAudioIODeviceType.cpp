@@ -0,0 +1,574 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#include "../../core/juce_StandardHeader.h"
+
+BEGIN_JUCE_NAMESPACE
+
+#include "juce_FileAudioIODeviceType.h"
+#include "../audio_file_formats/juce_AudioFormatManager.h"
+#include "../dsp/juce_AudioSampleBuffer.h"
+#include "../../threads/juce_Thread.h"
+#include "../../core/juce_Time.h"
+#include "../../memory/juce_Atomic.h"
+#include "../../io/files/juce_FileOutputStream.h"
+
+
+//==============================================================================
+namespace FileAudioIODeviceHelpers
+{
+    const char* const realTimeName = "Real time";
+    const char* const fastName     = "As fast as possible";
+
+    const double sampleRates[] = { 22050.0, 32000.0, 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+}
+
+//==============================================================================
+class FileAudioIODevice  : public AudioIODevice,
+                           private Thread
+{
+public:
+    FileAudioIODevice (const String& deviceName, const FileAudioIODeviceType::Settings& settings_,
+                       const bool realTime_)
+        : AudioIODevice (deviceName, "File"),
+          Thread ("Juce File Audio"),
+          settings (settings_),
+          realTime (realTime_ ? 1 : 0),
+          isOpen_ (false),
+          callback (nullptr),
+          sampleRate (0),
+          bufferSize (0),
+          numActiveInputs (0),
+          numActiveOutputs (0),
+          inputData (1, 1),
+          inputBuffer (1, 1),
+          outputBuffer (1, 1),
+          inputPosition (0),
+          numSamplesRendered (0)
+    {
+        formatManager.registerBasicFormats();
+    }
+
+    ~FileAudioIODevice()
+    {
+        close();
+    }
+
+    //==============================================================================
+    static const StringArray getChannelNames (const String& prefix, const int numChannels)
+    {
+        StringArray names;
+
+        for (int i = 0; i < numChannels; ++i)
+            names.add (prefix + String (i + 1));
+
+        return names;
+    }
+
+    StringArray getOutputChannelNames()         { return getChannelNames ("Output ", settings.numOutputChannels); }
+    StringArray getInputChannelNames()          { return getChannelNames ("Input ", settings.numInputChannels); }
+
+    int getNumSampleRates()                     { return numElementsInArray (FileAudioIODeviceHelpers::sampleRates); }
+    double getSampleRate (int index)            { return FileAudioIODeviceHelpers::sampleRates [jlimit (0, getNumSampleRates() - 1, index)]; }
+
+    int getNumBufferSizesAvailable()            { return 10; }
+    int getBufferSizeSamples (int index)        { return 16 << jlimit (0, getNumBufferSizesAvailable() - 1, index); }
+    int getDefaultBufferSize()                  { return 512; }
+
+    //==============================================================================
+    const String open (const BigInteger& inputChannels, const BigInteger& outputChannels,
+                       double sampleRate_, int bufferSizeSamples)
+    {
+        close();
+        lastError = String::empty;
+
+        sampleRate = sampleRate_ > 0 ? sampleRate_ : 44100.0;
+        bufferSize = bufferSizeSamples > 0 ? bufferSizeSamples : getDefaultBufferSize();
+
+        activeInputChannels = inputChannels;
+        activeInputChannels.setRange (settings.numInputChannels, activeInputChannels.getHighestBit() + 1, false);
+        activeOutputChannels = outputChannels;
+        activeOutputChannels.setRange (settings.numOutputChannels, activeOutputChannels.getHighestBit() + 1, false);
+
+        numActiveInputs = activeInputChannels.countNumberOfSetBits();
+        numActiveOutputs = activeOutputChannels.countNumberOfSetBits();
+
+        if (! loadInputFile() || ! createOutputFile())
+        {
+            close();
+            return lastError;
+        }
+
+        inputBuffer.setSize (jmax (1, numActiveInputs), bufferSize);
+        outputBuffer.setSize (jmax (1, numActiveOutputs), bufferSize);
+        inputBuffer.clear();
+        outputBuffer.clear();
+
+        inputPosition = 0;
+        numSamplesRendered = 0;
+        isOpen_ = true;
+        return lastError;
+    }
+
+    void close()
+    {
+        stop();
+
+        writer = nullptr;
+        inputData.setSize (1, 1);
+        isOpen_ = false;
+    }
+
+    void start (AudioIODeviceCallback* newCallback)
+    {
+        if (isOpen_ && newCallback != callback)
+        {
+            if (newCallback != nullptr)
+                newCallback->audioDeviceAboutToStart (this);
+
+            stopThread (-1);
+
+            AudioIODeviceCallback* const oldCallback = callback;
+            callback = newCallback;
+
+            if (oldCallback != nullptr)
+                oldCallback->audioDeviceStopped();
+
+            if (callback != nullptr)
+                startThread (realTime.get() != 0 ? 9 : 5);
+        }
+    }
+
+    void stop()
+    {
+        start (nullptr);
+    }
+
+    bool isOpen()                               { return isOpen_; }
+    bool isPlaying()                            { return callback != nullptr && isThreadRunning(); }
+    const String getLastError()                 { return lastError; }
+    int getCurrentBufferSizeSamples()           { return bufferSize; }
+    double getCurrentSampleRate()               { return sampleRate; }
+    int getCurrentBitDepth()                    { return 32; }
+    const BigInteger getActiveOutputChannels() const    { return activeOutputChannels; }
+    const BigInteger getActiveInputChannels() const     { return activeInputChannels; }
+    int getOutputLatencyInSamples()             { return 0; }
+    int getInputLatencyInSamples()              { return 0; }
+
+    bool isFreewheeling()                       { return realTime.get() == 0; }
+
+    bool setFreewheeling (const bool shouldFreewheel)
+    {
+        realTime = shouldFreewheel ? 0 : 1;
+        notify();
+        return true;
+    }
+
+    //==============================================================================
+    void run()
+    {
+        double nextCallbackTime = Time::getMillisecondCounterHiRes();
+
+        while (! threadShouldExit())
+        {
+            int numSamples = bufferSize;
+
+            if (settings.lengthToRender > 0)
+            {
+                numSamples = (int) jmin ((int64) bufferSize, settings.lengthToRender - numSamplesRendered);
+
+                if (numSamples <= 0)
+                {
+                    // (deleting the writer finishes the file, so it can be used straight away)
+                    writer = nullptr;
+                    break;
+                }
+            }
+
+            fillInputBuffer (numSamples);
+
+            callback->audioDeviceIOCallback (const_cast <const float**> (inputBuffer.getArrayOfChannels()), numActiveInputs,
+                                             outputBuffer.getArrayOfChannels(), numActiveOutputs, numSamples);
+
+            if (writer != nullptr && numActiveOutputs > 0)
+                writer->writeFromAudioSampleBuffer (outputBuffer, 0, numSamples);
+
+            numSamplesRendered += numSamples;
+
+            if (realTime.get() != 0)
+            {
+                const double blockLength = numSamples * 1000.0 / sampleRate;
+                nextCallbackTime += blockLength;
+
+                // If a callback overran by more than a whole block, a sound card would have
+                // glitched, so rather than trying to catch up, just carry on from now.
+                if (Time::getMillisecondCounterHiRes() > nextCallbackTime + blockLength)
+                    nextCallbackTime = Time::getMillisecondCounterHiRes();
+                else
+                    waitUntil (nextCallbackTime);
+            }
+            else
+            {
+                nextCallbackTime = Time::getMillisecondCounterHiRes();
+            }
+        }
+    }
+
+private:
+    //==============================================================================
+    FileAudioIODeviceType::Settings settings;
+    Atomic<int> realTime;
+    bool isOpen_;
+    AudioIODeviceCallback* callback;
+    String lastError;
+
+    double sampleRate;
+    int bufferSize;
+    BigInteger activeInputChannels, activeOutputChannels;
+    int numActiveInputs, numActiveOutputs;
+
+    AudioFormatManager formatManager;
+    AudioSampleBuffer inputData, inputBuffer, outputBuffer;
+    ScopedPointer<AudioFormatWriter> writer;
+    int inputPosition;
+    int64 numSamplesRendered;
+
+    //==============================================================================
+    bool loadInputFile()
+    {
+        inputData.setSize (1, 1);
+
+        if (settings.inputFile == File::nonexistent || numActiveInputs == 0)
+            return true;
+
+        ScopedPointer<AudioFormatReader> reader (formatManager.createReaderFor (settings.inputFile));
+
+        if (reader == nullptr || reader->lengthInSamples <= 0 || reader->lengthInSamples > 0x7fffffff)
+        {
+            lastError = "Couldn't read the input file " + settings.inputFile.getFullPathName();
+            return false;
+        }
+
+        const int numChannels = (int) reader->numChannels;
+        const int numSamples = (int) reader->lengthInSamples;
+        inputData.setSize (numChannels, numSamples);
+
+        reader->read (reinterpret_cast <int**> (inputData.getArrayOfChannels()), numChannels, 0, numSamples, false);
+
+        if (! reader->usesFloatingPointData)
+        {
+            const float multiplier = 1.0f / 0x7fffffff;
+
+            for (int i = 0; i < numChannels; ++i)
+            {
+                float* const d = inputData.getSampleData (i);
+
+                for (int j = 0; j < numSamples; ++j)
+                    d[j] = *reinterpret_cast <int*> (d + j) * multiplier;
+            }
+        }
+
+        return true;
+    }
+
+    bool createOutputFile()
+    {
+        writer = nullptr;
+
+        if (settings.outputFile == File::nonexistent)
+            return true;
+
+        AudioFormat* const format = formatManager.findFormatForFileExtension (settings.outputFile.getFileExtension());
+
+        if (format == nullptr)
+        {
+            lastError = "Unknown audio file type: " + settings.outputFile.getFullPathName();
+            return false;
+        }
+
+        settings.outputFile.deleteFile();
+        ScopedPointer<FileOutputStream> out (settings.outputFile.createOutputStream());
+
+        if (out != nullptr)
+            writer = format->createWriterFor (out, sampleRate, (unsigned int) jmax (1, numActiveOutputs),
+                                              settings.bitsPerSample, StringPairArray(), 0);
+
+        if (writer == nullptr)
+        {
+            lastError = "Couldn't write to " + settings.outputFile.getFullPathName();
+            return false;
+        }
+
+        out.release(); // (the writer owns it now)
+        return true;
+    }
+
+    void fillInputBuffer (const int numSamples)
+    {
+        const int length = inputData.getNumSamples();
+
+        if (length <= 1)
+        {
+            inputBuffer.clear();
+            return;
+        }
+
+        for (int done = 0; done < numSamples;)
+        {
+            const int num = jmin (numSamples - done, length - inputPosition);
+
+            for (int i = 0; i < numActiveInputs; ++i)
+                inputBuffer.copyFrom (i, done, inputData, i % inputData.getNumChannels(), inputPosition, num);
+
+            done += num;
+            inputPosition = (inputPosition + num) % length;
+        }
+    }
+
+    void waitUntil (const double targetTime)
+    {
+        // (sleeping gets to within a millisecond or so, then it spins for the rest)
+        for (;;)
+        {
+            const double timeLeft = targetTime - Time::getMillisecondCounterHiRes();
+
+            if (timeLeft <= 0 || threadShouldExit() || realTime.get() == 0)
+                break;
+
+            if (timeLeft > 2.0)
+                wait ((int) timeLeft - 1);
+            else
+                Thread::yield();
+        }
+    }
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FileAudioIODevice);
+};
+
+
+//==============================================================================
+FileAudioIODeviceType::FileAudioIODeviceType()
+    : AudioIODeviceType ("File")
+{
+    settings.bitsPerSample = 24;
+    settings.numInputChannels = 2;
+    settings.numOutputChannels = 2;
+    settings.lengthToRender = 0;
+}
+
+FileAudioIODeviceType::~FileAudioIODeviceType()
+{
+}
+
+void FileAudioIODeviceType::setInputFile (const File& audioFile)
+{
+    settings.inputFile = audioFile;
+}
+
+void FileAudioIODeviceType::setOutputFile (const File& audioFile, const int bitsPerSample)
+{
+    settings.outputFile = audioFile;
+    settings.bitsPerSample = bitsPerSample;
+}
+
+void FileAudioIODeviceType::setNumChannels (const int numInputChannels, const int numOutputChannels)
+{
+    jassert (numInputChannels >= 0 && numOutputChannels >= 0);
+    settings.numInputChannels = jmax (0, numInputChannels);
+    settings.numOutputChannels = jmax (0, numOutputChannels);
+}
+
+void FileAudioIODeviceType::setLengthToRender (const int64 numSamples)
+{
+    settings.lengthToRender = jmax ((int64) 0, numSamples);
+}
+
+//==============================================================================
+void FileAudioIODeviceType::scanForDevices()
+{
+}
+
+StringArray FileAudioIODeviceType::getDeviceNames (bool) const
+{
+    StringArray names;
+    names.add (FileAudioIODeviceHelpers::realTimeName);
+    names.add (FileAudioIODeviceHelpers::fastName);
+    return names;
+}
+
+int FileAudioIODeviceType::getDefaultDeviceIndex (bool) const
+{
+    return 0;
+}
+
+int FileAudioIODeviceType::getIndexOfDevice (AudioIODevice* device, bool) const
+{
+    return device != nullptr ? getDeviceNames (false).indexOf (device->getName()) : -1;
+}
+
+bool FileAudioIODeviceType::hasSeparateInputsAndOutputs() const
+{
+    return false;
+}
+
+AudioIODevice* FileAudioIODeviceType::createDevice (const String& outputDeviceName,
+                                                    const String& inputDeviceName)
+{
+    const String name (outputDeviceName.isNotEmpty() ? outputDeviceName : inputDeviceName);
+    const int index = getDeviceNames (false).indexOf (name);
+
+    if (index < 0)
+        return nullptr;
+
+    return new FileAudioIODevice (name, settings, index == 0);
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+#include "../../utilities/juce_UnitTest.h"
+
+class FileAudioIODeviceTypeTests  : public UnitTest
+{
+public:
+    FileAudioIODeviceTypeTests() : UnitTest ("FileAudioIODeviceType") {}
+
+    // Adds 0.5 to every sample in each block that passes through
+    class TestCallback  : public AudioIODeviceCallback
+    {
+    public:
+        TestCallback() : numCallbacks (0) {}
+
+        void audioDeviceIOCallback (const float** inputChannelData, int numInputChannels,
+                                    float** outputChannelData, int numOutputChannels, int numSamples)
+        {
+            ++numCallbacks;
+
+            for (int i = 0; i < numOutputChannels; ++i)
+                for (int j = 0; j < numSamples; ++j)
+                    outputChannelData[i][j] = (i < numInputChannels ? inputChannelData[i][j] : 0.0f) + 0.5f;
+        }
+
+        void audioDeviceAboutToStart (AudioIODevice*)   {}
+        void audioDeviceStopped()                       {}
+
+        Atomic<int> numCallbacks;
+    };
+
+    void render (FileAudioIODeviceType& type, const String& deviceName, TestCallback& callback,
+                 const double sampleRate, const int blockSize)
+    {
+        ScopedPointer<AudioIODevice> device (type.createDevice (deviceName, String::empty));
+        BigInteger channels;
+        channels.setRange (0, 2, true);
+
+        const String error (device->open (channels, channels, sampleRate, blockSize));
+        expect (error.isEmpty(), error);
+
+        if (error.isNotEmpty())
+            return;
+
+        device->start (&callback);
+
+        while (device->isPlaying())
+            Thread::sleep (1);
+
+        device->close();
+    }
+
+    void runTest()
+    {
+        const File inputFile (File::createTempFile (".wav"));
+        const File outputFile (File::createTempFile (".wav"));
+        const int length = 10000, blockSize = 256;
+
+        beginTest ("Rendering as fast as possible");
+        {
+            FileAudioIODeviceType type;
+            type.setOutputFile (inputFile, 24);
+            type.setLengthToRender (length);
+
+            TestCallback callback;
+            render (type, "As fast as possible", callback, 48000.0, blockSize);
+
+            expectEquals (callback.numCallbacks.get(), (length + blockSize - 1) / blockSize);
+
+            AudioFormatManager formatManager;
+            formatManager.registerBasicFormats();
+            ScopedPointer<AudioFormatReader> reader (formatManager.createReaderFor (inputFile));
+
+            expect (reader != nullptr);
+            expect (reader->lengthInSamples == length);
+            expect (reader->sampleRate == 48000.0);
+        }
+
+        beginTest ("Input file gets passed through");
+        {
+            FileAudioIODeviceType type;
+            type.setInputFile (inputFile);
+            type.setOutputFile (outputFile, 24);
+            type.setLengthToRender (length + 1000);
+
+            TestCallback callback;
+            render (type, "As fast as possible", callback, 48000.0, blockSize);
+
+            AudioFormatManager formatManager;
+            formatManager.registerBasicFormats();
+            ScopedPointer<AudioFormatReader> reader (formatManager.createReaderFor (outputFile));
+            expect (reader != nullptr);
+
+            AudioSampleBuffer result (2, length + 1000);
+            result.readFromAudioReader (reader, 0, length + 1000, 0, true, true);
+
+            // (the input was all 0.5, and it loops, so everything should now be 1.0)
+            expect (std::abs (*result.getSampleData (0, 0) - 1.0f) < 0.001f);
+            expect (std::abs (*result.getSampleData (1, length - 1) - 1.0f) < 0.001f);
+            expect (std::abs (*result.getSampleData (0, length + 500) - 1.0f) < 0.001f);
+        }
+
+        beginTest ("Real-time callbacks are paced");
+        {
+            FileAudioIODeviceType type;
+            type.setLengthToRender (4410);
+
+            TestCallback callback;
+            const double startTime = Time::getMillisecondCounterHiRes();
+            render (type, "Real time", callback, 44100.0, 441);
+            const double timeTaken = Time::getMillisecondCounterHiRes() - startTime;
+
+            expectEquals (callback.numCallbacks.get(), 10);
+            expect (timeTaken >= 85.0, "took " + String (timeTaken) + "ms");
+        }
+
+        inputFile.deleteFile();
+        outputFile.deleteFile();
+    }
+};
+
+static FileAudioIODeviceTypeTests fileAudioIODeviceTypeTests;
+
+#endif
+
+END_JUCE_NAMESPACE
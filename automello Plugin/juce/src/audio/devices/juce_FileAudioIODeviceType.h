@@ -0,0 +1,148 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_FILEAUDIOIODEVICETYPE_JUCEHEADER__
+#define __JUCE_FILEAUDIOIODEVICETYPE_JUCEHEADER__
+
+#include "juce_AudioIODeviceType.h"
+#include "../../io/files/juce_File.h"
+
+
+//==============================================================================
+/**
+    A type of audio device that doesn't need any hardware: its callbacks are driven
+    by a thread, reading their input from an audio file and writing their output
+    to another one.
+
+    This is handy for testing and benchmarking audio code on machines that don't have
+    a sound card, because it behaves the same way every time it's run.
+
+    It provides two devices:
+    - "Real time", which makes its callbacks at the rate that a sound card would, so
+      you can see whether your code keeps up with the deadlines.
+    - "As fast as possible", which makes the next callback as soon as the previous one
+      has returned, so you can measure throughput. This one returns true from
+      AudioIODevice::isFreewheeling().
+
+    The sample rate and block size are whatever you open the device with, like any
+    other device. The files and the number of channels are set on this object, and
+    are used by the devices that it creates afterwards.
+
+    This type isn't one of the ones that an AudioDeviceManager creates by default, so
+    to use it with one, override AudioDeviceManager::createAudioDeviceTypes(), e.g.
+    @code
+    class BenchmarkDeviceManager  : public AudioDeviceManager
+    {
+    public:
+        void createAudioDeviceTypes (OwnedArray <AudioIODeviceType>& types)
+        {
+            FileAudioIODeviceType* type = new FileAudioIODeviceType();
+            type->setInputFile (File ("~/test.wav"));
+            type->setOutputFile (File ("~/result.wav"));
+            type->setLengthToRender (44100 * 60);
+            types.add (type);
+        }
+    };
+    @endcode
+
+    @see AudioIODeviceType, AudioDeviceManager
+*/
+class JUCE_API  FileAudioIODeviceType  : public AudioIODeviceType
+{
+public:
+    //==============================================================================
+    /** Creates the device type.
+
+        Until they're changed, its devices will have two silent inputs and two outputs,
+        won't write their output anywhere, and will keep going until they're stopped.
+    */
+    FileAudioIODeviceType();
+
+    /** Destructor. */
+    ~FileAudioIODeviceType();
+
+    //==============================================================================
+    /** Sets the audio file that the devices will use as their input.
+
+        The whole file is loaded into memory when a device is opened, so that reading it
+        doesn't affect the timing, and it's played in a loop. Its sample rate is ignored,
+        and if it has fewer channels than the device, they get re-used in turn.
+
+        Pass File::nonexistent for the inputs to be silent.
+    */
+    void setInputFile (const File& audioFile);
+
+    /** Sets the file that the devices will write their output into.
+
+        The format is chosen from the file's extension, and any existing file is replaced
+        when a device is opened. The file is finished when the device is closed, or when
+        it has rendered the length set by setLengthToRender().
+
+        Pass File::nonexistent for the output to be thrown away.
+    */
+    void setOutputFile (const File& audioFile, int bitsPerSample = 24);
+
+    /** Sets how many input and output channels the devices will have. */
+    void setNumChannels (int numInputChannels, int numOutputChannels);
+
+    /** Makes the devices stop after they've rendered this many samples.
+
+        Once it's finished, the device's isPlaying() method will return false. If the
+        length is 0, the devices keep going until they're stopped.
+    */
+    void setLengthToRender (int64 numSamples);
+
+    //==============================================================================
+    /** @internal */
+    void scanForDevices();
+    /** @internal */
+    StringArray getDeviceNames (bool wantInputNames) const;
+    /** @internal */
+    int getDefaultDeviceIndex (bool forInput) const;
+    /** @internal */
+    int getIndexOfDevice (AudioIODevice* device, bool asInput) const;
+    /** @internal */
+    bool hasSeparateInputsAndOutputs() const;
+    /** @internal */
+    AudioIODevice* createDevice (const String& outputDeviceName, const String& inputDeviceName);
+
+private:
+    //==============================================================================
+    friend class FileAudioIODevice;
+
+    struct Settings
+    {
+        File inputFile, outputFile;
+        int bitsPerSample, numInputChannels, numOutputChannels;
+        int64 lengthToRender;
+    };
+
+    Settings settings;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FileAudioIODeviceType);
+};
+
+
+#endif   // __JUCE_FILEAUDIOIODEVICETYPE_JUCEHEADER__
@@ -0,0 +1,168 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+#include "../../core/juce_StandardHeader.h"
+
+BEGIN_JUCE_NAMESPACE
+
+#include "juce_AudioBufferPool.h"
+
+
+//==============================================================================
+class AudioBufferPool::Block
+{
+public:
+    enum
+    {
+        alignmentBytes = 64,
+        samplesPerCacheLine = alignmentBytes / sizeof (float)
+    };
+
+    Block (const int numChannels_, const int numSamples_)
+        : numChannels (numChannels_),
+          numSamples (numSamples_)
+    {
+        const int channelStride = (numSamples + samplesPerCacheLine - 1) & ~(samplesPerCacheLine - 1);
+
+        storage.malloc ((size_t) numChannels * channelStride * sizeof (float) + alignmentBytes);
+        channels.malloc ((size_t) numChannels + 1);
+
+        float* const alignedStart = reinterpret_cast <float*> ((reinterpret_cast <pointer_sized_int> (storage.getData())
+                                                                  + alignmentBytes - 1) & ~(pointer_sized_int) (alignmentBytes - 1));
+
+        for (int i = 0; i < numChannels; ++i)
+            channels[i] = alignedStart + i * channelStride;
+
+        channels [numChannels] = nullptr;
+    }
+
+    const int numChannels, numSamples;
+    HeapBlock <char> storage;
+    HeapBlock <float*> channels;
+    Atomic<int> inUse;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE (Block);
+};
+
+//==============================================================================
+AudioBufferPool::AudioBufferPool()
+    : maxChannels (0),
+      maxSamples (0)
+{
+}
+
+AudioBufferPool::~AudioBufferPool()
+{
+    release();
+}
+
+void AudioBufferPool::prepare (const int maxNumChannels, const int maxNumSamples, const int numBuffersPerSizeClass)
+{
+    release();
+
+    maxChannels = jmax (1, maxNumChannels);
+    maxSamples = jmax (1, maxNumSamples);
+
+    // the blocks are kept in order of size, so that acquire() finds the smallest one that fits
+    for (int sizeClass = 64;; sizeClass *= 2)
+    {
+        const int numSamples = jmin (sizeClass, maxSamples);
+
+        for (int i = 0; i < numBuffersPerSizeClass; ++i)
+            blocks.add (new Block (maxChannels, numSamples));
+
+        if (numSamples >= maxSamples)
+            break;
+    }
+}
+
+void AudioBufferPool::release()
+{
+   #if JUCE_DEBUG
+    for (int i = blocks.size(); --i >= 0;)
+    {
+        // you can't free a pool while its buffers are still being used!
+        jassert (blocks.getUnchecked(i)->inUse.get() == 0);
+    }
+   #endif
+
+    blocks.clear();
+    maxChannels = 0;
+    maxSamples = 0;
+}
+
+AudioBufferPool::Block* AudioBufferPool::acquire (const int numChannels, const int numSamples) noexcept
+{
+    if (numChannels <= maxChannels)
+    {
+        for (int i = 0; i < blocks.size(); ++i)
+        {
+            Block* const b = blocks.getUnchecked (i);
+
+            if (b->numSamples >= numSamples && b->inUse.compareAndSetBool (1, 0))
+                return b;
+        }
+    }
+
+    return nullptr;
+}
+
+//==============================================================================
+namespace AudioBufferPoolHelpers
+{
+    // used to initialise a Buffer's AudioSampleBuffer before it's given some real memory
+    float silentSample = 0;
+    float* silentChannel[] = { &silentSample, nullptr };
+}
+
+AudioBufferPool::Buffer::Buffer (AudioBufferPool& pool, const int numChannels, const int numSamples)
+    : block (pool.acquire (numChannels, numSamples)),
+      buffer (AudioBufferPoolHelpers::silentChannel, 1, 0)
+{
+    jassert (numChannels > 0 && numSamples >= 0);
+
+    if (block != nullptr)
+    {
+        buffer.setDataToReferTo (block->channels, numChannels, numSamples);
+    }
+    else
+    {
+        // The pool didn't have a big enough buffer free, so this one has to be allocated,
+        // which isn't something that should happen on the audio thread! Either the pool
+        // wasn't prepared, or you need to give it more channels, samples or buffers.
+        jassertfalse;
+        buffer.setSize (numChannels, numSamples);
+    }
+}
+
+AudioBufferPool::Buffer::~Buffer()
+{
+    if (block != nullptr)
+        block->inUse = 0;
+}
+
+END_JUCE_NAMESPACE
@@ -0,0 +1,154 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+#ifndef __JUCE_AUDIOBUFFERPOOL_JUCEHEADER__
+#define __JUCE_AUDIOBUFFERPOOL_JUCEHEADER__
+
+#include "juce_AudioSampleBuffer.h"
+#include "../../containers/juce_OwnedArray.h"
+#include "../../memory/juce_Atomic.h"
+#include "../../memory/juce_HeapBlock.h"
+
+
+//==============================================================================
+/**
+    A set of preallocated AudioSampleBuffers that can be borrowed by the audio thread.
+
+    When prepare() is called, the pool allocates a few buffers in each of a range of
+    size classes, from 64 samples up to the largest block size that you expect to process.
+    Each channel's data starts on a 64-byte boundary and is padded to a whole number of
+    cache lines, and all the channels of a buffer sit in a single contiguous block, so the
+    memory can also be used to hold interleaved data.
+
+    Buffers are borrowed using an AudioBufferPool::Buffer object, which picks the smallest
+    free buffer that's big enough, without locking or allocating, and hands it back when it's
+    deleted. E.g.
+    @code
+    void processBlock (AudioSampleBuffer& output)
+    {
+        AudioBufferPool::Buffer temp (pool, 2, output.getNumSamples());
+        temp.getBuffer().clear();
+        ...
+    }
+    @endcode
+
+    @see AudioSampleBuffer, ScopedAudioThreadAllocationCheck
+*/
+class JUCE_API  AudioBufferPool
+{
+public:
+    //==============================================================================
+    /** Creates an empty pool.
+        You'll need to call prepare() before any buffers can be borrowed from it.
+    */
+    AudioBufferPool();
+
+    /** Destructor.
+        None of the buffers may still be in use when the pool is deleted.
+    */
+    ~AudioBufferPool();
+
+    //==============================================================================
+    /** Allocates the buffers.
+
+        This frees any buffers that were previously allocated, so it mustn't be called
+        while any of them are being used - the best place to call it is from a
+        prepareToPlay() method.
+
+        @param maxNumChannels           the largest number of channels that will be asked for
+        @param maxNumSamples            the largest number of samples that will be asked for
+        @param numBuffersPerSizeClass   how many buffers to create in each size class - this is
+                                        the number of buffers that can be borrowed at the same
+                                        time
+    */
+    void prepare (int maxNumChannels, int maxNumSamples, int numBuffersPerSizeClass = 4);
+
+    /** Frees all the buffers.
+        As with prepare(), none of the buffers can be in use when this is called.
+    */
+    void release();
+
+    /** Returns the number of channels that each of the buffers has space for. */
+    int getMaxNumChannels() const noexcept          { return maxChannels; }
+
+    /** Returns the largest number of samples that a buffer can be borrowed for. */
+    int getMaxNumSamples() const noexcept           { return maxSamples; }
+
+private:
+    class Block;
+
+public:
+    //==============================================================================
+    /**
+        Borrows a buffer from an AudioBufferPool for as long as this object exists.
+
+        If the pool doesn't have a free buffer that's large enough, this will assert and
+        allocate a buffer instead, so that your code still works - but you should make
+        the pool bigger to avoid allocating on the audio thread.
+    */
+    class JUCE_API  Buffer
+    {
+    public:
+        /** Borrows a buffer from the pool.
+            The contents of the buffer are undefined, so you may want to clear it.
+        */
+        Buffer (AudioBufferPool& pool, int numChannels, int numSamples);
+
+        /** Returns the buffer to the pool. */
+        ~Buffer();
+
+        /** Returns the buffer, which has exactly the number of channels and samples
+            that were asked for.
+        */
+        AudioSampleBuffer& getBuffer() noexcept         { return buffer; }
+
+        /** Returns the buffer's memory as a single block of (numChannels * numSamples)
+            floats, which can be used to hold interleaved data.
+
+            This is the same memory that the AudioSampleBuffer's channels use, so you can't
+            use both at the same time.
+        */
+        float* getInterleavedData() noexcept            { return buffer.getSampleData (0); }
+
+    private:
+        Block* const block;
+        AudioSampleBuffer buffer;
+
+        JUCE_DECLARE_NON_COPYABLE (Buffer);
+    };
+
+private:
+    //==============================================================================
+    OwnedArray <Block> blocks;
+    int maxChannels, maxSamples;
+
+    Block* acquire (int numChannels, int numSamples) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioBufferPool);
+};
+
+
+#endif   // __JUCE_AUDIOBUFFERPOOL_JUCEHEADER__
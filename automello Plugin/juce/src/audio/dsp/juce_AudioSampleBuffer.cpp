@@ -28,10 +28,41 @@
 BEGIN_JUCE_NAMESPACE
 
 #include "juce_AudioSampleBuffer.h"
+#include "juce_FloatVectorOperations.h"
 #include "../audio_file_formats/juce_AudioFormatReader.h"
 #include "../audio_file_formats/juce_AudioFormatWriter.h"
 
 
+//==============================================================================
+namespace AudioSampleBufferHelpers
+{
+    /*  Each channel starts on a 16-byte boundary, so that the vector operations don't have
+        to deal with misaligned data. The 32 bytes that are always allocated on top of the
+        channel data leave room for the first channel to be moved up to an aligned address.
+    */
+    inline size_t getNumBytesToAllocate (const int numChannels, const int numSamples) noexcept
+    {
+        return (size_t) numChannels * ((size_t) (numSamples + 3) & ~(size_t) 3) * sizeof (float)
+                + (size_t) (numChannels + 1) * sizeof (float*) + 32;
+    }
+
+    inline void setChannelPointers (float** const channels, char* const data,
+                                    const int numChannels, const int numSamples) noexcept
+    {
+        const size_t channelListSize = (size_t) (numChannels + 1) * sizeof (float*);
+        float* chan = reinterpret_cast <float*> ((reinterpret_cast <pointer_sized_int> (data + channelListSize) + 15)
+                                                    & ~(pointer_sized_int) 15);
+
+        for (int i = 0; i < numChannels; ++i)
+        {
+            channels[i] = chan;
+            chan += (numSamples + 3) & ~3;
+        }
+
+        channels [numChannels] = 0;
+    }
+}
+
 //==============================================================================
 AudioSampleBuffer::AudioSampleBuffer (const int numChannels_,
                                       const int numSamples) noexcept
@@ -57,19 +88,11 @@ AudioSampleBuffer::AudioSampleBuffer (const AudioSampleBuffer& other) noexcept
 
 void AudioSampleBuffer::allocateData()
 {
-    const size_t channelListSize = (numChannels + 1) * sizeof (float*);
-    allocatedBytes = (int) (numChannels * size * sizeof (float) + channelListSize + 32);
+    allocatedBytes = AudioSampleBufferHelpers::getNumBytesToAllocate (numChannels, size);
     allocatedData.malloc (allocatedBytes);
     channels = reinterpret_cast <float**> (allocatedData.getData());
 
-    float* chan = (float*) (allocatedData + channelListSize);
-    for (int i = 0; i < numChannels; ++i)
-    {
-        channels[i] = chan;
-        chan += size;
-    }
-
-    channels [numChannels] = 0;
+    AudioSampleBufferHelpers::setChannelPointers (channels, allocatedData, numChannels, size);
 }
 
 AudioSampleBuffer::AudioSampleBuffer (float** dataToReferTo,
@@ -163,8 +186,7 @@ void AudioSampleBuffer::setSize (const int newNumChannels,
 
     if (newNumSamples != size || newNumChannels != numChannels)
     {
-        const size_t channelListSize = (newNumChannels + 1) * sizeof (float*);
-        const size_t newTotalBytes = (newNumChannels * newNumSamples * sizeof (float)) + channelListSize + 32;
+        const size_t newTotalBytes = AudioSampleBufferHelpers::getNumBytesToAllocate (newNumChannels, newNumSamples);
 
         if (keepExistingContent)
         {
@@ -175,13 +197,10 @@ void AudioSampleBuffer::setSize (const int newNumChannels,
             const size_t numBytesToCopy = sizeof (float) * jmin (newNumSamples, size);
 
             float** const newChannels = reinterpret_cast <float**> (newData.getData());
-            float* newChan = reinterpret_cast <float*> (newData + channelListSize);
+            AudioSampleBufferHelpers::setChannelPointers (newChannels, newData, newNumChannels, newNumSamples);
+
             for (int i = 0; i < numChansToCopy; ++i)
-            {
-                memcpy (newChan, channels[i], numBytesToCopy);
-                newChannels[i] = newChan;
-                newChan += newNumSamples;
-            }
+                memcpy (newChannels[i], channels[i], numBytesToCopy);
 
             allocatedData.swapWith (newData);
             allocatedBytes = (int) newTotalBytes;
@@ -201,15 +220,9 @@ void AudioSampleBuffer::setSize (const int newNumChannels,
                 channels = reinterpret_cast <float**> (allocatedData.getData());
             }
 
-            float* chan = reinterpret_cast <float*> (allocatedData + channelListSize);
-            for (int i = 0; i < newNumChannels; ++i)
-            {
-                channels[i] = chan;
-                chan += newNumSamples;
-            }
+            AudioSampleBufferHelpers::setChannelPointers (channels, allocatedData, newNumChannels, newNumSamples);
         }
 
-        channels [newNumChannels] = 0;
         size = newNumSamples;
         numChannels = newNumChannels;
     }
@@ -250,17 +263,12 @@ void AudioSampleBuffer::applyGain (const int channel,
 
     if (gain != 1.0f)
     {
-        float* d = channels [channel] + startSample;
+        float* const d = channels [channel] + startSample;
 
         if (gain == 0.0f)
-        {
-            zeromem (d, sizeof (float) * numSamples);
-        }
+            FloatVectorOperations::clear (d, numSamples);
         else
-        {
-            while (--numSamples >= 0)
-                *d++ *= gain;
-        }
+            FloatVectorOperations::multiply (d, gain, numSamples);
     }
 }
 
@@ -279,14 +287,8 @@ void AudioSampleBuffer::applyGainRamp (const int channel,
         jassert (isPositiveAndBelow (channel, numChannels));
         jassert (startSample >= 0 && startSample + numSamples <= size);
 
-        const float increment = (endGain - startGain) / numSamples;
-        float* d = channels [channel] + startSample;
-
-        while (--numSamples >= 0)
-        {
-            *d++ *= startGain;
-            startGain += increment;
-        }
+        FloatVectorOperations::multiplyWithRamp (channels [channel] + startSample,
+                                                 startGain, (endGain - startGain) / numSamples, numSamples);
     }
 }
 
@@ -314,19 +316,13 @@ void AudioSampleBuffer::addFrom (const int destChannel,
 
     if (gain != 0.0f && numSamples > 0)
     {
-        float* d = channels [destChannel] + destStartSample;
-        const float* s  = source.channels [sourceChannel] + sourceStartSample;
+        float* const d = channels [destChannel] + destStartSample;
+        const float* const s = source.channels [sourceChannel] + sourceStartSample;
 
         if (gain != 1.0f)
-        {
-            while (--numSamples >= 0)
-                *d++ += gain * *s++;
-        }
+            FloatVectorOperations::addWithMultiply (d, s, gain, numSamples);
         else
-        {
-            while (--numSamples >= 0)
-                *d++ += *s++;
-        }
+            FloatVectorOperations::add (d, s, numSamples);
     }
 }
 
@@ -342,18 +338,12 @@ void AudioSampleBuffer::addFrom (const int destChannel,
 
     if (gain != 0.0f && numSamples > 0)
     {
-        float* d = channels [destChannel] + destStartSample;
+        float* const d = channels [destChannel] + destStartSample;
 
         if (gain != 1.0f)
-        {
-            while (--numSamples >= 0)
-                *d++ += gain * *source++;
-        }
+            FloatVectorOperations::addWithMultiply (d, source, gain, numSamples);
         else
-        {
-            while (--numSamples >= 0)
-                *d++ += *source++;
-        }
+            FloatVectorOperations::add (d, source, numSamples);
     }
 }
 
@@ -380,14 +370,8 @@ void AudioSampleBuffer::addFromWithRamp (const int destChannel,
     {
         if (numSamples > 0 && (startGain != 0.0f || endGain != 0.0f))
         {
-            const float increment = (endGain - startGain) / numSamples;
-            float* d = channels [destChannel] + destStartSample;
-
-            while (--numSamples >= 0)
-            {
-                *d++ += startGain * *source++;
-                startGain += increment;
-            }
+            FloatVectorOperations::addWithRamp (channels [destChannel] + destStartSample, source,
+                                                startGain, (endGain - startGain) / numSamples, numSamples);
         }
     }
 }
@@ -442,19 +426,14 @@ void AudioSampleBuffer::copyFrom (const int destChannel,
 
     if (numSamples > 0)
     {
-        float* d = channels [destChannel] + destStartSample;
+        float* const d = channels [destChannel] + destStartSample;
 
         if (gain != 1.0f)
         {
             if (gain == 0)
-            {
-                zeromem (d, sizeof (float) * numSamples);
-            }
+                FloatVectorOperations::clear (d, numSamples);
             else
-            {
-                while (--numSamples >= 0)
-                    *d++ = gain * *source++;
-            }
+                FloatVectorOperations::copyWithMultiply (d, source, gain, numSamples);
         }
         else
         {
@@ -486,14 +465,8 @@ void AudioSampleBuffer::copyFromWithRamp (const int destChannel,
     {
         if (numSamples > 0 && (startGain != 0.0f || endGain != 0.0f))
         {
-            const float increment = (endGain - startGain) / numSamples;
-            float* d = channels [destChannel] + destStartSample;
-
-            while (--numSamples >= 0)
-            {
-                *d++ = startGain * *source++;
-                startGain += increment;
-            }
+            FloatVectorOperations::copyWithRamp (channels [destChannel] + destStartSample, source,
+                                                 startGain, (endGain - startGain) / numSamples, numSamples);
         }
     }
 }
@@ -507,7 +480,7 @@ void AudioSampleBuffer::findMinMax (const int channel,
     jassert (isPositiveAndBelow (channel, numChannels));
     jassert (startSample >= 0 && startSample + numSamples <= size);
 
-    findMinAndMax (channels [channel] + startSample, numSamples, minVal, maxVal);
+    FloatVectorOperations::findMinAndMax (channels [channel] + startSample, numSamples, minVal, maxVal);
 }
 
 float AudioSampleBuffer::getMagnitude (const int channel,
@@ -544,16 +517,7 @@ float AudioSampleBuffer::getRMSLevel (const int channel,
     if (numSamples <= 0 || channel < 0 || channel >= numChannels)
         return 0.0f;
 
-    const float* const data = channels [channel] + startSample;
-    double sum = 0.0;
-
-    for (int i = 0; i < numSamples; ++i)
-    {
-        const float sample = data [i];
-        sum += sample * sample;
-    }
-
-    return (float) std::sqrt (sum / numSamples);
+    return (float) std::sqrt (FloatVectorOperations::sumOfSquares (channels [channel] + startSample, numSamples) / numSamples);
 }
 
 void AudioSampleBuffer::readFromAudioReader (AudioFormatReader* reader,
@@ -35,6 +35,11 @@ class AudioFormatWriter;
 /**
     A multi-channel buffer of 32-bit floating point audio samples.
 
+    When the buffer allocates its own memory, the data for each channel starts on a
+    16-byte boundary, so that the FloatVectorOperations that it uses can work on it
+    efficiently.
+
+    @see FloatVectorOperations
 */
 class JUCE_API  AudioSampleBuffer
 {
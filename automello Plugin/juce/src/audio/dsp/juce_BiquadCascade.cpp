@@ -0,0 +1,404 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#include "../../core/juce_StandardHeader.h"
+
+BEGIN_JUCE_NAMESPACE
+
+#include "juce_BiquadCascade.h"
+
+
+//==============================================================================
+namespace BiquadCascadeHelpers
+{
+   #if JUCE_USE_SSE_INTRINSICS
+    /*  The active coefficients are stored with each value repeated in all four lanes, as
+        [stage][b0, b1, b2, a1, a2][lane], and the state as [group][stage][s1, s2][lane],
+        so both can be loaded straight into SSE registers.
+    */
+    inline __m128 processStages (__m128 x, const float* coeffs, float* state, int numStages) noexcept
+    {
+        while (--numStages >= 0)
+        {
+            const __m128 y = _mm_add_ps (_mm_mul_ps (_mm_load_ps (coeffs), x), _mm_load_ps (state));
+
+            _mm_store_ps (state, _mm_add_ps (_mm_sub_ps (_mm_mul_ps (_mm_load_ps (coeffs + 4), x),
+                                                         _mm_mul_ps (_mm_load_ps (coeffs + 12), y)),
+                                             _mm_load_ps (state + 4)));
+
+            _mm_store_ps (state + 4, _mm_sub_ps (_mm_mul_ps (_mm_load_ps (coeffs + 8), x),
+                                                 _mm_mul_ps (_mm_load_ps (coeffs + 16), y)));
+            x = y;
+            coeffs += 20;
+            state += 8;
+        }
+
+        return x;
+    }
+   #endif
+}
+
+//==============================================================================
+BiquadCascade::BiquadCascade (const int maxNumChannels, const int numStages_)
+    : numChannels (jmax (1, maxNumChannels)),
+      numStages (jmax (1, numStages_)),
+      numGroups ((numChannels + channelsPerGroup - 1) / channelsPerGroup)
+{
+    const int numCoefficientValues = numStages * numCoefficients * channelsPerGroup;
+    const int numStateValues = numGroups * numStages * 2 * channelsPerGroup;
+
+    // (the extra space is to allow the data to be aligned for SSE)
+    workspace.calloc ((size_t) (numCoefficientValues + numStateValues + 4));
+    activeCoefficients = reinterpret_cast <float*> ((reinterpret_cast <pointer_sized_int> (workspace.getData()) + 15) & ~(pointer_sized_int) 15);
+    state = activeCoefficients + numCoefficientValues;
+
+    pendingCoefficients.calloc ((size_t) (numStages * numCoefficients));
+
+    for (int i = 0; i < numStages; ++i)
+        setCoefficients (i, 1.0, 0.0, 0.0, 0.0, 0.0);
+
+    updateCoefficients();
+}
+
+BiquadCascade::~BiquadCascade()
+{
+}
+
+//==============================================================================
+void BiquadCascade::setStage (const int stageIndex, const IIRFilter& filterToCopy) noexcept
+{
+    float c[6];
+
+    {
+        const ScopedLock sl (filterToCopy.processLock);
+
+        if (! filterToCopy.active)
+        {
+            makeStageInactive (stageIndex);
+            return;
+        }
+
+        memcpy (c, filterToCopy.coefficients, sizeof (c));
+    }
+
+    // (the IIRFilter's coefficients are already normalised)
+    setCoefficients (stageIndex, c[0], c[1], c[2], c[4], c[5]);
+}
+
+void BiquadCascade::setStage (const int stageIndex,
+                              const double b0, const double b1, const double b2,
+                              const double a0, const double a1, const double a2) noexcept
+{
+    jassert (a0 != 0);
+    const double a = 1.0 / a0;
+
+    setCoefficients (stageIndex, b0 * a, b1 * a, b2 * a, a1 * a, a2 * a);
+}
+
+void BiquadCascade::makeStageInactive (const int stageIndex) noexcept
+{
+    setCoefficients (stageIndex, 1.0, 0.0, 0.0, 0.0, 0.0);
+}
+
+void BiquadCascade::setCoefficients (const int stageIndex, double b0, double b1, double b2, double a1, double a2) noexcept
+{
+    jassert (isPositiveAndBelow (stageIndex, numStages));
+
+    if (isPositiveAndBelow (stageIndex, numStages))
+    {
+        const SpinLock::ScopedLockType sl (pendingCoefficientsLock);
+
+        float* const c = pendingCoefficients + stageIndex * numCoefficients;
+        c[0] = (float) b0;
+        c[1] = (float) b1;
+        c[2] = (float) b2;
+        c[3] = (float) a1;
+        c[4] = (float) a2;
+
+        newCoefficientsAvailable = 1;
+    }
+}
+
+void BiquadCascade::reset() noexcept
+{
+    resetNeeded = 1;
+}
+
+//==============================================================================
+void BiquadCascade::updateCoefficients() noexcept
+{
+    // If another thread is in the middle of changing the coefficients, we'll just
+    // keep using the old ones, and pick up the new set next time.
+    if (newCoefficientsAvailable.get() != 0 && pendingCoefficientsLock.tryEnter())
+    {
+        for (int i = 0; i < numStages * numCoefficients; ++i)
+        {
+            float* const dest = activeCoefficients + i * channelsPerGroup;
+
+            for (int lane = 0; lane < channelsPerGroup; ++lane)
+                dest [lane] = pendingCoefficients [i];
+        }
+
+        newCoefficientsAvailable = 0;
+        pendingCoefficientsLock.exit();
+    }
+
+    if (resetNeeded.compareAndSetBool (0, 1))
+        zeromem (state, sizeof (float) * (size_t) (numGroups * numStages * 2 * channelsPerGroup));
+}
+
+void BiquadCascade::processSamples (float* const* const channels, int numChannelsToProcess, const int numSamples) noexcept
+{
+    // This cascade hasn't got enough channels for the data you're giving it!
+    jassert (numChannelsToProcess <= numChannels);
+    numChannelsToProcess = jmin (numChannelsToProcess, numChannels);
+
+    updateCoefficients();
+
+    if (numSamples <= 0)
+        return;
+
+    const ScopedNoDenormals noDenormals;
+
+    for (int group = 0; group * channelsPerGroup < numChannelsToProcess; ++group)
+    {
+        float* groupChannels [channelsPerGroup];
+
+        for (int lane = 0; lane < channelsPerGroup; ++lane)
+        {
+            const int channel = group * channelsPerGroup + lane;
+            groupChannels [lane] = channel < numChannelsToProcess ? channels [channel] : nullptr;
+        }
+
+        processGroup (groupChannels, group, numSamples);
+    }
+}
+
+void BiquadCascade::processSamples (AudioSampleBuffer& buffer, const int startSample, const int numSamples) noexcept
+{
+    jassert (startSample >= 0 && startSample + numSamples <= buffer.getNumSamples());
+
+    // This cascade hasn't got enough channels for the buffer you're giving it!
+    jassert (buffer.getNumChannels() <= numChannels);
+
+    float* channels [channelsPerGroup * 4];
+    const int numChannelsToProcess = jmin (buffer.getNumChannels(), numChannels);
+
+    if (numChannelsToProcess <= numElementsInArray (channels))
+    {
+        for (int i = 0; i < numChannelsToProcess; ++i)
+            channels[i] = buffer.getSampleData (i, startSample);
+
+        processSamples (channels, numChannelsToProcess, numSamples);
+    }
+    else
+    {
+        HeapBlock <float*> allChannels ((size_t) numChannelsToProcess);
+
+        for (int i = 0; i < numChannelsToProcess; ++i)
+            allChannels[i] = buffer.getSampleData (i, startSample);
+
+        processSamples (allChannels, numChannelsToProcess, numSamples);
+    }
+}
+
+void BiquadCascade::processGroup (float* const* const groupChannels, const int group, const int numSamples) noexcept
+{
+    float* const groupState = state + group * numStages * 2 * channelsPerGroup;
+
+   #if JUCE_USE_SSE_INTRINSICS
+    using namespace BiquadCascadeHelpers;
+
+    float* const c0 = groupChannels[0];
+    float* const c1 = groupChannels[1];
+    float* const c2 = groupChannels[2];
+    float* const c3 = groupChannels[3];
+    const float silence[4] = { 0 };
+    int i = 0;
+
+    // Each run of four samples is loaded from the four channels and transposed, so that
+    // each register holds one sample from every channel..
+    for (; i <= numSamples - 4; i += 4)
+    {
+        __m128 r0 = _mm_loadu_ps (c0 != nullptr ? c0 + i : silence);
+        __m128 r1 = _mm_loadu_ps (c1 != nullptr ? c1 + i : silence);
+        __m128 r2 = _mm_loadu_ps (c2 != nullptr ? c2 + i : silence);
+        __m128 r3 = _mm_loadu_ps (c3 != nullptr ? c3 + i : silence);
+
+        _MM_TRANSPOSE4_PS (r0, r1, r2, r3);
+
+        r0 = processStages (r0, activeCoefficients, groupState, numStages);
+        r1 = processStages (r1, activeCoefficients, groupState, numStages);
+        r2 = processStages (r2, activeCoefficients, groupState, numStages);
+        r3 = processStages (r3, activeCoefficients, groupState, numStages);
+
+        _MM_TRANSPOSE4_PS (r0, r1, r2, r3);
+
+        if (c0 != nullptr)  _mm_storeu_ps (c0 + i, r0);
+        if (c1 != nullptr)  _mm_storeu_ps (c1 + i, r1);
+        if (c2 != nullptr)  _mm_storeu_ps (c2 + i, r2);
+        if (c3 != nullptr)  _mm_storeu_ps (c3 + i, r3);
+    }
+
+    // ..and any left-over samples are done one at a time.
+    for (; i < numSamples; ++i)
+    {
+        float in [channelsPerGroup], out [channelsPerGroup];
+
+        for (int lane = 0; lane < channelsPerGroup; ++lane)
+            in [lane] = groupChannels [lane] != nullptr ? groupChannels [lane][i] : 0.0f;
+
+        _mm_storeu_ps (out, processStages (_mm_loadu_ps (in), activeCoefficients, groupState, numStages));
+
+        for (int lane = 0; lane < channelsPerGroup; ++lane)
+            if (groupChannels [lane] != nullptr)
+                groupChannels [lane][i] = out [lane];
+    }
+
+   #else
+    for (int lane = 0; lane < channelsPerGroup; ++lane)
+    {
+        float* const samples = groupChannels [lane];
+
+        if (samples == nullptr)
+            continue;
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float x = samples[i];
+            const float* c = activeCoefficients + lane;
+            float* s = groupState + lane;
+
+            for (int stage = 0; stage < numStages; ++stage)
+            {
+                float y = c[0] * x + s[0];
+
+               #if JUCE_INTEL
+                if (! (y < -1.0e-8 || y > 1.0e-8))
+                    y = 0;
+               #endif
+
+                s[0] = c[4] * x - c[12] * y + s[4];
+                s[4] = c[8] * x - c[16] * y;
+                x = y;
+                c += numCoefficients * channelsPerGroup;
+                s += 2 * channelsPerGroup;
+            }
+
+            samples[i] = x;
+        }
+    }
+   #endif
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+#include "../../utilities/juce_UnitTest.h"
+#include "../../maths/juce_Random.h"
+#include "../../core/juce_Time.h"
+#include "../../containers/juce_OwnedArray.h"
+
+class BiquadCascadeTests  : public UnitTest
+{
+public:
+    BiquadCascadeTests() : UnitTest ("BiquadCascade") {}
+
+    void runTest()
+    {
+        beginTest ("BiquadCascade");
+
+        compareWithIIRFilter (2);
+        compareWithIIRFilter (8);
+    }
+
+    void compareWithIIRFilter (const int numChannels)
+    {
+        const int numStages = 2;
+        const int blockSize = 512;
+        const int numBlocks = 2000;
+
+        IIRFilter settings[numStages];
+        settings[0].makeLowPass (44100.0, 5000.0);
+        settings[1].makeBandPass (44100.0, 1000.0, 1.0, 2.0f);
+
+        OwnedArray <IIRFilter> filters;
+        BiquadCascade cascade (numChannels, numStages);
+
+        for (int i = 0; i < numChannels * numStages; ++i)
+            filters.add (new IIRFilter (settings [i % numStages]));
+
+        for (int i = 0; i < numStages; ++i)
+            cascade.setStage (i, settings[i]);
+
+        AudioSampleBuffer original (numChannels, blockSize), viaFilters (numChannels, blockSize), viaCascade (numChannels, blockSize);
+
+        Random r (1234);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int i = 0; i < blockSize; ++i)
+                original.getSampleData (ch)[i] = r.nextFloat() * 2.0f - 1.0f;
+
+        double filterTime = 0, cascadeTime = 0;
+        float maxError = 0;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                viaFilters.copyFrom (ch, 0, original, ch, 0, blockSize);
+                viaCascade.copyFrom (ch, 0, original, ch, 0, blockSize);
+            }
+
+            double start = Time::getMillisecondCounterHiRes();
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int stage = 0; stage < numStages; ++stage)
+                    filters.getUnchecked (ch * numStages + stage)->processSamples (viaFilters.getSampleData (ch), blockSize);
+
+            filterTime += Time::getMillisecondCounterHiRes() - start;
+            start = Time::getMillisecondCounterHiRes();
+
+            cascade.processSamples (viaCascade, 0, blockSize);
+
+            cascadeTime += Time::getMillisecondCounterHiRes() - start;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                for (int i = 0; i < blockSize; ++i)
+                    maxError = jmax (maxError, std::abs (viaFilters.getSampleData (ch)[i] - viaCascade.getSampleData (ch)[i]));
+        }
+
+        expect (maxError < 1.0e-4f, "output differs from IIRFilter by " + String (maxError));
+
+        logMessage (String (numChannels) + " channels, " + String (numStages) + " stages: IIRFilter "
+                     + String (filterTime, 2) + " ms, BiquadCascade " + String (cascadeTime, 2) + " ms");
+    }
+};
+
+static BiquadCascadeTests biquadCascadeTests;
+
+#endif
+
+END_JUCE_NAMESPACE
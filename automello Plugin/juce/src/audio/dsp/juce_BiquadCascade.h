@@ -0,0 +1,138 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_BIQUADCASCADE_JUCEHEADER__
+#define __JUCE_BIQUADCASCADE_JUCEHEADER__
+
+#include "juce_IIRFilter.h"
+#include "juce_AudioSampleBuffer.h"
+#include "../../memory/juce_Atomic.h"
+#include "../../memory/juce_HeapBlock.h"
+#include "../../threads/juce_SpinLock.h"
+
+
+//==============================================================================
+/**
+    A chain of biquad filters that can process several channels of audio at once.
+
+    Each stage of the cascade is a second-order section, and every channel is run through
+    all the stages in turn, with each channel keeping its own filter state. The filters use
+    the transposed direct form II structure, and on Intel machines groups of four channels
+    are processed together in SSE registers, with denormals flushed to zero by the CPU
+    rather than being checked for on each sample.
+
+    The coefficients can be changed from any thread while audio is being processed: new
+    settings are picked up at the start of the next call to processSamples(), and the audio
+    thread never waits for a lock to get them.
+
+    @see IIRFilter, IIRFilterAudioSource
+*/
+class JUCE_API  BiquadCascade
+{
+public:
+    //==============================================================================
+    /** Creates a cascade.
+
+        Initially all the stages are inactive, so the cascade has no effect on the
+        samples that it processes.
+
+        @param maxNumChannels   the number of channels of state that should be kept
+        @param numStages        the number of biquad sections that each channel is passed through
+    */
+    BiquadCascade (int maxNumChannels, int numStages);
+
+    /** Destructor. */
+    ~BiquadCascade();
+
+    //==============================================================================
+    /** Returns the number of channels that this cascade was created for. */
+    int getNumChannels() const noexcept                 { return numChannels; }
+
+    /** Returns the number of stages in the cascade. */
+    int getNumStages() const noexcept                   { return numStages; }
+
+    //==============================================================================
+    /** Makes one of the stages use the same settings as an IIRFilter.
+
+        If the filter is inactive, the stage will pass its input straight through.
+    */
+    void setStage (int stageIndex, const IIRFilter& filterToCopy) noexcept;
+
+    /** Sets the coefficients of one of the stages.
+
+        The stage's transfer function is (b0 + b1 z^-1 + b2 z^-2) / (a0 + a1 z^-1 + a2 z^-2).
+    */
+    void setStage (int stageIndex,
+                   double b0, double b1, double b2,
+                   double a0, double a1, double a2) noexcept;
+
+    /** Makes a stage pass its input straight through. */
+    void makeStageInactive (int stageIndex) noexcept;
+
+    /** Clears the filter state of all the channels, ready to start a new stream of data.
+
+        This is safe to call from any thread - the state is actually cleared at the start
+        of the next call to processSamples().
+    */
+    void reset() noexcept;
+
+    //==============================================================================
+    /** Filters some channels of audio in-place.
+
+        @param channels         an array of pointers to the sample data for each channel. Any
+                                of these may be null, in which case that channel is skipped
+        @param numChannels      the number of channels in the array, which mustn't be more than
+                                the number that the cascade was created for
+        @param numSamples       the number of samples to process in each channel
+    */
+    void processSamples (float* const* channels, int numChannels, int numSamples) noexcept;
+
+    /** Filters a section of an AudioSampleBuffer in-place.
+
+        The buffer mustn't have more channels than the cascade was created for.
+    */
+    void processSamples (AudioSampleBuffer& buffer, int startSample, int numSamples) noexcept;
+
+
+private:
+    //==============================================================================
+    enum { numCoefficients = 5, channelsPerGroup = 4 };
+
+    const int numChannels, numStages, numGroups;
+    HeapBlock <float> pendingCoefficients, workspace;
+    float* activeCoefficients;
+    float* state;
+    SpinLock pendingCoefficientsLock;
+    Atomic<int> newCoefficientsAvailable, resetNeeded;
+
+    void setCoefficients (int stageIndex, double b0, double b1, double b2, double a1, double a2) noexcept;
+    void updateCoefficients() noexcept;
+    void processGroup (float* const* groupChannels, int group, int numSamples) noexcept;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BiquadCascade);
+};
+
+
+#endif   // __JUCE_BIQUADCASCADE_JUCEHEADER__
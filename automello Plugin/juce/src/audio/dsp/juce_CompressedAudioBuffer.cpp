@@ -0,0 +1,679 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#include "../../core/juce_StandardHeader.h"
+
+BEGIN_JUCE_NAMESPACE
+
+#include "juce_CompressedAudioBuffer.h"
+
+
+//==============================================================================
+namespace CompressedAudioHelpers
+{
+    /*  Each block holds the channels one after another. A channel starts with a single bit
+        which is 0 if it uses prediction, or 1 if its samples are stored verbatim as 32-bit
+        words. A predicted channel has its first two samples stored verbatim, followed by
+        the residuals of a second-order predictor, in partitions that each begin with a 5-bit
+        Rice parameter. Unusually large residuals are escaped with a run of ones and stored
+        verbatim.
+    */
+    enum
+    {
+        samplesPerPartition = 256,
+        escapeLength = 24
+    };
+
+    inline uint32 maskForBits (const int numBits) noexcept
+    {
+        return numBits >= 32 ? 0xffffffff : ((((uint32) 1) << numBits) - 1);
+    }
+
+    inline uint32 zigZagEncode (const int n) noexcept      { return (((uint32) n) << 1) ^ (uint32) (n >> 31); }
+    inline int zigZagDecode (const uint32 n) noexcept      { return (int) (n >> 1) ^ -(int) (n & 1); }
+
+    inline int predictionResidual (const int* const s, const int i) noexcept
+    {
+        return s[i] - 2 * s[i - 1] + s[i - 2];
+    }
+
+    //==============================================================================
+    class BitWriter
+    {
+    public:
+        BitWriter (MemoryOutputStream& out_) noexcept
+            : out (out_), buffer (0), numBits (0)
+        {
+        }
+
+        void write (const uint32 value, const int bitsToWrite)
+        {
+            buffer = (buffer << bitsToWrite) | (value & maskForBits (bitsToWrite));
+            numBits += bitsToWrite;
+
+            while (numBits >= 8)
+            {
+                numBits -= 8;
+                out.writeByte ((char) (buffer >> numBits));
+            }
+        }
+
+        void writeRiceCode (const uint32 value, const int riceParameter)
+        {
+            const uint32 quotient = value >> riceParameter;
+
+            if (quotient < escapeLength)
+            {
+                write (maskForBits ((int) quotient) << 1, (int) quotient + 1);
+                write (value, riceParameter);
+            }
+            else
+            {
+                write (maskForBits (escapeLength), escapeLength);
+                write (value, 32);
+            }
+        }
+
+        void flush()
+        {
+            if (numBits > 0)
+                write (0, 8 - numBits);
+        }
+
+    private:
+        MemoryOutputStream& out;
+        uint64 buffer;
+        int numBits;
+
+        JUCE_DECLARE_NON_COPYABLE (BitWriter);
+    };
+
+    //==============================================================================
+    class BitReader
+    {
+    public:
+        BitReader (const uint8* const data_) noexcept
+            : data (data_), buffer (0), numBits (0)
+        {
+        }
+
+        inline uint32 read (const int bitsToRead) noexcept
+        {
+            while (numBits < bitsToRead)
+            {
+                buffer = (buffer << 8) | *data++;
+                numBits += 8;
+            }
+
+            numBits -= bitsToRead;
+            return ((uint32) (buffer >> numBits)) & maskForBits (bitsToRead);
+        }
+
+        inline uint32 readRiceCode (const int riceParameter) noexcept
+        {
+            uint32 quotient = 0;
+
+            while (read (1) != 0)
+                if (++quotient == escapeLength)
+                    return read (32);
+
+            return (quotient << riceParameter) | read (riceParameter);
+        }
+
+    private:
+        const uint8* data;
+        uint64 buffer;
+        int numBits;
+
+        JUCE_DECLARE_NON_COPYABLE (BitReader);
+    };
+
+    //==============================================================================
+    int chooseRiceParameter (const int* const s, const int start, const int end) noexcept
+    {
+        uint64 total = 0;
+
+        for (int i = start; i < end; ++i)
+            total += zigZagEncode (predictionResidual (s, i));
+
+        // picks the parameter that's closest to log2 of the mean residual
+        int riceParameter = 0;
+
+        while (riceParameter < 31 && (((uint64) (end - start)) << (riceParameter + 1)) < total)
+            ++riceParameter;
+
+        return riceParameter;
+    }
+}
+
+//==============================================================================
+CompressedAudioBuffer::CompressedAudioBuffer (AudioFormatReader& source,
+                                              const int64 startSample,
+                                              const int numSamples_,
+                                              const int maxNumChannels)
+    : numChannels (jmax (1, jmin (maxNumChannels, (int) source.numChannels))),
+      numSamples (jmax (0, numSamples_)),
+      bitsPerSample ((int) source.bitsPerSample),
+      usesFloatingPointData (source.usesFloatingPointData)
+{
+    HeapBlock <int> buffer ((size_t) numChannels * samplesPerBlock);
+    HeapBlock <int*> channels (numChannels);
+
+    for (int i = 0; i < numChannels; ++i)
+        channels[i] = buffer + i * (int) samplesPerBlock;
+
+    MemoryOutputStream out;
+
+    for (int pos = 0; pos < numSamples; pos += samplesPerBlock)
+    {
+        const int numThisTime = jmin ((int) samplesPerBlock, numSamples - pos);
+
+        blockOffsets.add ((int) out.getDataSize());
+        source.read (channels, numChannels, startSample + pos, numThisTime, false);
+        encodeBlock (channels, numThisTime, out);
+    }
+
+    blockOffsets.add ((int) out.getDataSize());
+    data.append (out.getData(), out.getDataSize());
+}
+
+CompressedAudioBuffer::~CompressedAudioBuffer()
+{
+}
+
+//==============================================================================
+void CompressedAudioBuffer::encodeBlock (int* const* const samples, const int numSamplesInBlock,
+                                         MemoryOutputStream& out) const
+{
+    using namespace CompressedAudioHelpers;
+
+    BitWriter writer (out);
+    const int shift = 32 - bitsPerSample;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        int* const s = samples [ch];
+        bool canPredict = (! usesFloatingPointData) && bitsPerSample > 0 && bitsPerSample <= 24;
+
+        // the reader gives us left-justified samples, which need to be turned back into
+        // values of the original bit-depth, but only if that can be done without losing anything
+        for (int i = 0; canPredict && i < numSamplesInBlock; ++i)
+            canPredict = ((int) (((uint32) (s[i] >> shift)) << shift)) == s[i];
+
+        if (canPredict)
+        {
+            writer.write (0, 1);
+
+            for (int i = 0; i < numSamplesInBlock; ++i)
+                s[i] >>= shift;
+
+            for (int i = 0; i < jmin (2, numSamplesInBlock); ++i)
+                writer.write ((uint32) s[i], 32);
+
+            for (int start = 2; start < numSamplesInBlock; start += samplesPerPartition)
+            {
+                const int end = jmin (numSamplesInBlock, start + (int) samplesPerPartition);
+                const int riceParameter = chooseRiceParameter (s, start, end);
+
+                writer.write ((uint32) riceParameter, 5);
+
+                for (int i = start; i < end; ++i)
+                    writer.writeRiceCode (zigZagEncode (predictionResidual (s, i)), riceParameter);
+            }
+        }
+        else
+        {
+            writer.write (1, 1);
+
+            for (int i = 0; i < numSamplesInBlock; ++i)
+                writer.write ((uint32) s[i], 32);
+        }
+    }
+
+    writer.flush();
+}
+
+void CompressedAudioBuffer::decodeBlock (const int blockIndex, float* const* const destChannels) const noexcept
+{
+    using namespace CompressedAudioHelpers;
+
+    jassert (isPositiveAndBelow (blockIndex, getNumBlocks()));
+
+    const int numSamplesInBlock = jmin ((int) samplesPerBlock, numSamples - blockIndex * (int) samplesPerBlock);
+    const int shift = 32 - bitsPerSample;
+    const float multiplier = 1.0f / 0x7fffffff;
+
+    BitReader reader (static_cast <const uint8*> (data.getData()) + blockOffsets.getUnchecked (blockIndex));
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        float* const d = destChannels [ch];
+
+        if (reader.read (1) == 0)
+        {
+            int last = 0, secondLast = 0;
+
+            for (int i = 0; i < jmin (2, numSamplesInBlock); ++i)
+            {
+                secondLast = last;
+                last = (int) reader.read (32);
+                d[i] = ((int) (((uint32) last) << shift)) * multiplier;
+            }
+
+            for (int start = 2; start < numSamplesInBlock; start += samplesPerPartition)
+            {
+                const int end = jmin (numSamplesInBlock, start + (int) samplesPerPartition);
+                const int riceParameter = (int) reader.read (5);
+
+                for (int i = start; i < end; ++i)
+                {
+                    const int value = 2 * last - secondLast + zigZagDecode (reader.readRiceCode (riceParameter));
+                    secondLast = last;
+                    last = value;
+                    d[i] = ((int) (((uint32) value) << shift)) * multiplier;
+                }
+            }
+        }
+        else
+        {
+            for (int i = 0; i < numSamplesInBlock; ++i)
+            {
+                const uint32 value = reader.read (32);
+
+                if (usesFloatingPointData)
+                    memcpy (d + i, &value, sizeof (float));
+                else
+                    d[i] = ((int) value) * multiplier;
+            }
+        }
+
+        if (numSamplesInBlock < samplesPerBlock)
+            zeromem (d + numSamplesInBlock, sizeof (float) * (size_t) (samplesPerBlock - numSamplesInBlock));
+    }
+}
+
+//==============================================================================
+CompressedAudioBuffer::BlockCache::BlockCache (const int maxNumChannels)
+    : source (nullptr),
+      maxChannels (jmax (1, maxNumChannels)),
+      windowStart (0),
+      windowEnd (0)
+{
+    storage.malloc ((size_t) maxChannels * 2 * samplesPerBlock);
+
+    // the first set of pointers is for the start of the window, the second
+    // set points at its second half, where the following block goes
+    channels.malloc ((size_t) maxChannels * 2);
+
+    for (int i = 0; i < maxChannels; ++i)
+    {
+        channels [i] = storage + i * 2 * (int) samplesPerBlock;
+        channels [maxChannels + i] = channels [i] + (int) samplesPerBlock;
+    }
+}
+
+CompressedAudioBuffer::BlockCache::~BlockCache()
+{
+}
+
+void CompressedAudioBuffer::BlockCache::setSource (const CompressedAudioBuffer* const newSource) noexcept
+{
+    // this cache wasn't created with enough channels for this buffer!
+    jassert (newSource == nullptr || newSource->getNumChannels() <= maxChannels);
+
+    source = newSource;
+    windowStart = 0;
+    windowEnd = 0;
+}
+
+void CompressedAudioBuffer::BlockCache::moveWindow (const int samplePos) noexcept
+{
+    jassert (source != nullptr && samplePos >= 0);
+
+    const int blockIndex = samplePos / samplesPerBlock;
+    const int newStart = blockIndex * samplesPerBlock;
+    const int numBlocks = source->getNumBlocks();
+    const int numChannels = source->getNumChannels();
+
+    if (windowEnd > windowStart && newStart == windowStart + samplesPerBlock)
+    {
+        // moving forward by one block, so the second half is already decoded..
+        for (int i = 0; i < numChannels; ++i)
+            memcpy (channels [i], channels [maxChannels + i], sizeof (float) * samplesPerBlock);
+    }
+    else if (blockIndex < numBlocks)
+    {
+        source->decodeBlock (blockIndex, channels);
+    }
+    else
+    {
+        for (int i = 0; i < numChannels; ++i)
+            zeromem (channels [i], sizeof (float) * samplesPerBlock);
+    }
+
+    if (blockIndex + 1 < numBlocks)
+    {
+        source->decodeBlock (blockIndex + 1, channels + maxChannels);
+    }
+    else
+    {
+        for (int i = 0; i < numChannels; ++i)
+            zeromem (channels [maxChannels + i], sizeof (float) * samplesPerBlock);
+    }
+
+    windowStart = newStart;
+    windowEnd = newStart + 2 * samplesPerBlock;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+#include "../../utilities/juce_UnitTest.h"
+#include "../../maths/juce_Random.h"
+
+class CompressedAudioBufferTests  : public UnitTest
+{
+public:
+    CompressedAudioBufferTests() : UnitTest ("CompressedAudioBuffer") {}
+
+    //==============================================================================
+    enum SignalType
+    {
+        quietSine,
+        fullScaleNoise,
+        fullScaleSpikes,
+        unrepresentableValues
+    };
+
+    // A reader that serves up a generated signal from memory
+    class TestReader  : public AudioFormatReader
+    {
+    public:
+        TestReader (const int numChannels_, const int bitsPerSample_, const bool isFloat,
+                    const int length, const SignalType type, Random& r)
+            : AudioFormatReader (nullptr, "Test"),
+              samples ((size_t) (numChannels_ * length))
+        {
+            sampleRate = 44100.0;
+            numChannels = (unsigned int) numChannels_;
+            bitsPerSample = (unsigned int) bitsPerSample_;
+            usesFloatingPointData = isFloat;
+            lengthInSamples = length;
+
+            const int shift = 32 - bitsPerSample_;
+            const int maxValue = (int) CompressedAudioHelpers::maskForBits (bitsPerSample_ - 1);
+
+            for (int ch = 0; ch < numChannels_; ++ch)
+            {
+                for (int i = 0; i < length; ++i)
+                {
+                    int& s = samples [ch * length + i];
+                    const double sine = std::sin (i * 0.01 * (ch + 1));
+
+                    if (isFloat)
+                    {
+                        const float value = type == quietSine ? (float) (sine * 0.5) : (r.nextFloat() * 2.0f - 1.0f);
+                        memcpy (&s, &value, sizeof (int));
+                    }
+                    else
+                    {
+                        int value;
+
+                        switch (type)
+                        {
+                            case quietSine:         value = jlimit (-maxValue, maxValue, roundToInt (sine * maxValue * 0.5) + r.nextInt (3) - 1); break;
+                            case fullScaleNoise:    value = r.nextInt() >> shift; break;
+                            case fullScaleSpikes:   value = (i % 97) != 0 ? 0 : (r.nextBool() ? maxValue : -maxValue - 1); break;
+                            default:                value = r.nextInt(); break;
+                        }
+
+                        s = type == unrepresentableValues ? value : (int) (((uint32) value) << shift);
+                    }
+                }
+            }
+        }
+
+        bool readSamples (int** destSamples, int numDestChannels, int startOffsetInDestBuffer,
+                          int64 startSampleInFile, int numSamples)
+        {
+            for (int ch = 0; ch < numDestChannels; ++ch)
+                if (destSamples [ch] != nullptr)
+                    for (int i = 0; i < numSamples; ++i)
+                        destSamples [ch][startOffsetInDestBuffer + i] = getSample (ch, startSampleInFile + i);
+
+            return true;
+        }
+
+        int getSample (const int channel, const int64 index) const noexcept
+        {
+            return isPositiveAndBelow (index, lengthInSamples) ? samples [channel * (int) lengthInSamples + (int) index] : 0;
+        }
+
+        // the value that AudioSampleBuffer::readFromAudioReader() would produce
+        float getExpectedValue (const int channel, const int64 index) const noexcept
+        {
+            const int value = getSample (channel, index);
+
+            if (! usesFloatingPointData)
+                return value * (1.0f / 0x7fffffff);
+
+            float f;
+            memcpy (&f, &value, sizeof (float));
+            return f;
+        }
+
+    private:
+        HeapBlock <int> samples;
+    };
+
+    //==============================================================================
+    void runTest()
+    {
+        Random r (1234);
+
+        beginTest ("Integer data");
+
+        const int bitDepths[] = { 8, 16, 24 };
+
+        for (int i = 0; i < numElementsInArray (bitDepths); ++i)
+        {
+            checkAllLengths (bitDepths[i], false, quietSine, r);
+            checkAllLengths (bitDepths[i], false, fullScaleNoise, r);
+        }
+
+        beginTest ("Unrepresentable integer data");
+        checkAllLengths (16, false, unrepresentableValues, r);
+
+        beginTest ("Floating-point data");
+        checkAllLengths (32, true, quietSine, r);
+        checkAllLengths (32, true, fullScaleNoise, r);
+
+        beginTest ("Escape codes");
+
+        for (int i = 0; i < numElementsInArray (bitDepths); ++i)
+            checkAllLengths (bitDepths[i], false, fullScaleSpikes, r);
+
+        checkRiceCodes (r);
+
+        beginTest ("Offset and out-of-range sections");
+
+        {
+            TestReader reader (2, 24, false, 3 * samplesPerBlock, quietSine, r);
+            checkRoundTrip (reader, 10, samplesPerBlock + 5);
+            checkRoundTrip (reader, -5, samplesPerBlock);
+            checkRoundTrip (reader, 2 * samplesPerBlock + 7, 2 * samplesPerBlock);
+            checkRoundTrip (reader, 0, 0);
+        }
+
+        beginTest ("BlockCache");
+        checkBlockCache (r);
+    }
+
+    //==============================================================================
+    void checkAllLengths (const int bitsPerSample, const bool isFloat, const SignalType type, Random& r)
+    {
+        using namespace CompressedAudioHelpers;
+
+        const int lengths[] = { 1, 2, 3,
+                                samplesPerBlock,                                // exactly one block
+                                samplesPerBlock + 1,                            // last block shorter than 2 samples
+                                2 * samplesPerBlock + 100,                      // last block shorter than a partition
+                                samplesPerBlock + 2 + samplesPerPartition + 5,  // last block ends in a partial partition
+                                3 * samplesPerBlock - 1 };
+
+        for (int i = 0; i < numElementsInArray (lengths); ++i)
+        {
+            TestReader reader (2, bitsPerSample, isFloat, lengths[i], type, r);
+            checkRoundTrip (reader, 0, lengths[i]);
+        }
+    }
+
+    void checkRoundTrip (const TestReader& reader, const int startSample, const int numSamples)
+    {
+        const int numChannels = (int) reader.numChannels;
+        CompressedAudioBuffer buffer (const_cast <TestReader&> (reader), startSample, numSamples, numChannels);
+
+        expectEquals (buffer.getNumChannels(), numChannels);
+        expectEquals (buffer.getNumSamples(), numSamples);
+        expectEquals (buffer.getNumBlocks(), (numSamples + samplesPerBlock - 1) / samplesPerBlock);
+
+        HeapBlock <float> decoded ((size_t) (numChannels * samplesPerBlock));
+        HeapBlock <float*> channels (numChannels);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            channels [ch] = decoded + ch * (int) samplesPerBlock;
+
+        int numErrors = 0;
+
+        for (int block = 0; block < buffer.getNumBlocks(); ++block)
+        {
+            buffer.decodeBlock (block, channels);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                for (int i = 0; i < samplesPerBlock; ++i)
+                {
+                    const int pos = block * samplesPerBlock + i;
+                    const float expected = pos < numSamples ? reader.getExpectedValue (ch, startSample + pos) : 0.0f;
+
+                    if (channels [ch][i] != expected)
+                        ++numErrors;
+                }
+            }
+        }
+
+        expect (numErrors == 0, String (numErrors) + " samples differ, with " + String ((int) reader.bitsPerSample)
+                                  + " bits, " + String (numSamples) + " samples from " + String (startSample));
+    }
+
+    void checkRiceCodes (Random& r)
+    {
+        using namespace CompressedAudioHelpers;
+
+        // values whose quotient is just below, at, and well beyond the escape length
+        const int numValues = 1000;
+        uint32 values [numValues];
+        int parameters [numValues];
+
+        for (int i = 0; i < numValues; ++i)
+        {
+            parameters[i] = r.nextInt (32);
+            const uint32 quotient = (uint32) (escapeLength - 2 + r.nextInt (4));
+
+            values[i] = (i % 4) == 0 ? (uint32) r.nextInt()
+                                     : (uint32) jmin ((uint64) 0xffffffff, (((uint64) quotient) << parameters[i]) | (r.nextInt() & maskForBits (parameters[i])));
+        }
+
+        MemoryOutputStream out;
+
+        {
+            BitWriter writer (out);
+
+            for (int i = 0; i < numValues; ++i)
+                writer.writeRiceCode (values[i], parameters[i]);
+
+            writer.flush();
+        }
+
+        BitReader reader (static_cast <const uint8*> (out.getData()));
+        int numErrors = 0;
+
+        for (int i = 0; i < numValues; ++i)
+            if (reader.readRiceCode (parameters[i]) != values[i])
+                ++numErrors;
+
+        expectEquals (numErrors, 0);
+    }
+
+    void checkBlockCache (Random& r)
+    {
+        const int numChannels = 3;
+        const int numSamples = 4 * samplesPerBlock + 37;
+
+        TestReader reader (numChannels, 24, false, numSamples, quietSine, r);
+        CompressedAudioBuffer buffer (reader, 0, numSamples, numChannels);
+        CompressedAudioBuffer::BlockCache cache (numChannels);
+        cache.setSource (&buffer);
+
+        int numErrors = 0;
+
+        for (int pos = 0; pos < numSamples; ++pos)
+            numErrors += checkCacheWindow (cache, reader, pos, numSamples);
+
+        expect (numErrors == 0, String (numErrors) + " samples wrong when stepping forward");
+
+        for (int i = 0; i < 2000; ++i)
+            numErrors += checkCacheWindow (cache, reader, r.nextInt (numSamples + samplesPerBlock), numSamples);
+
+        expect (numErrors == 0, String (numErrors) + " samples wrong after seeking");
+    }
+
+    static int checkCacheWindow (CompressedAudioBuffer::BlockCache& cache, const TestReader& reader,
+                                 const int pos, const int numSamples)
+    {
+        cache.prepareToRead (pos);
+
+        int numErrors = 0;
+
+        for (int ch = 0; ch < (int) reader.numChannels; ++ch)
+        {
+            const float* const d = cache.getSampleData (ch) + (pos - cache.getStartSample());
+
+            for (int i = 0; i < 2; ++i)
+                if (d[i] != (pos + i < numSamples ? reader.getExpectedValue (ch, pos + i) : 0.0f))
+                    ++numErrors;
+        }
+
+        return numErrors;
+    }
+
+    enum { samplesPerBlock = CompressedAudioBuffer::samplesPerBlock };
+};
+
+static CompressedAudioBufferTests compressedAudioBufferTests;
+
+#endif
+
+END_JUCE_NAMESPACE
@@ -0,0 +1,171 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_COMPRESSEDAUDIOBUFFER_JUCEHEADER__
+#define __JUCE_COMPRESSEDAUDIOBUFFER_JUCEHEADER__
+
+#include "../audio_file_formats/juce_AudioFormatReader.h"
+#include "../../containers/juce_Array.h"
+#include "../../io/streams/juce_MemoryOutputStream.h"
+#include "../../memory/juce_HeapBlock.h"
+#include "../../memory/juce_MemoryBlock.h"
+
+
+//==============================================================================
+/**
+    Holds a block of audio in memory in a losslessly-compressed form, from which any
+    section can be decoded on demand.
+
+    The audio is divided into fixed-size blocks of samplesPerBlock frames, each of which
+    is compressed independently (using a second-order fixed predictor with Rice-coded
+    residuals, similar to FLAC's "fixed" subframes), so any block can be decoded without
+    touching the rest of the data. Typical 16 or 24-bit material takes up around a third
+    of the space that it'd need as an AudioSampleBuffer.
+
+    The decoded samples are exactly the same values that AudioSampleBuffer::readFromAudioReader()
+    would have produced from the same reader. Floating-point sources (and anything else that
+    can't be represented as integers of the reader's bit depth) are stored verbatim.
+
+    To play the audio back, use a BlockCache, which keeps a couple of decoded blocks around
+    the current playback position.
+
+    @see SamplerSound
+*/
+class JUCE_API  CompressedAudioBuffer
+{
+public:
+    //==============================================================================
+    /** Reads and compresses a section of audio from a reader.
+
+        @param source           the reader to read from. This isn't retained after the
+                                constructor returns
+        @param startSample      the first sample in the reader to read
+        @param numSamples       the number of samples to read. Any part of this range that lies
+                                beyond the end of the reader will be filled with silence
+        @param maxNumChannels   the maximum number of channels to keep; if the source has more
+                                than this, the extra ones are ignored
+    */
+    CompressedAudioBuffer (AudioFormatReader& source,
+                           int64 startSample,
+                           int numSamples,
+                           int maxNumChannels);
+
+    /** Destructor. */
+    ~CompressedAudioBuffer();
+
+    //==============================================================================
+    /** The number of sample frames in each independently-decodable block. */
+    enum { samplesPerBlock = 2048 };
+
+    /** Returns the number of channels of audio held. */
+    int getNumChannels() const noexcept                 { return numChannels; }
+
+    /** Returns the number of samples held in each channel. */
+    int getNumSamples() const noexcept                  { return numSamples; }
+
+    /** Returns the number of blocks that the audio has been divided into. */
+    int getNumBlocks() const noexcept                   { return blockOffsets.size() - 1; }
+
+    /** Returns the number of bytes used to hold the compressed data. */
+    size_t getCompressedSize() const noexcept           { return data.getSize(); }
+
+    //==============================================================================
+    /** Decodes one of the blocks.
+
+        @param blockIndex       the block to decode, from 0 to getNumBlocks() - 1
+        @param destChannels     an array of getNumChannels() pointers, each of which must have space
+                                for samplesPerBlock floats. If the block is the last one and is shorter
+                                than samplesPerBlock, the remainder is filled with zeros.
+    */
+    void decodeBlock (int blockIndex, float* const* destChannels) const noexcept;
+
+    //==============================================================================
+    /**
+        Keeps a window of decoded samples from a CompressedAudioBuffer.
+
+        The window covers two adjacent blocks, so that an interpolating player can always
+        read a sample and its successor from it. As playback moves on, the later block is
+        shifted down and the next one is decoded, so each block of source material is only
+        decoded once for forward playback.
+
+        The memory is allocated when the object is created, so a cache can be used on the
+        audio thread without allocating.
+    */
+    class JUCE_API  BlockCache
+    {
+    public:
+        /** Creates a cache with space for the given number of channels. */
+        explicit BlockCache (int maxNumChannels);
+
+        /** Destructor. */
+        ~BlockCache();
+
+        /** Discards any decoded data and sets the buffer that should be read from.
+            The buffer mustn't have more channels than this cache was created for.
+        */
+        void setSource (const CompressedAudioBuffer* source) noexcept;
+
+        /** Makes sure that the samples at samplePos and samplePos + 1 are decoded. */
+        inline void prepareToRead (const int samplePos) noexcept
+        {
+            if (samplePos < windowStart || samplePos + 1 >= windowEnd)
+                moveWindow (samplePos);
+        }
+
+        /** Returns a pointer to the decoded sample data for a channel.
+
+            The data starts at the sample index returned by getStartSample(), and is only valid
+            until the next call to prepareToRead().
+        */
+        const float* getSampleData (const int channel) const noexcept   { return channels [channel]; }
+
+        /** Returns the index in the source buffer of the first sample in the decoded window. */
+        int getStartSample() const noexcept                             { return windowStart; }
+
+    private:
+        const CompressedAudioBuffer* source;
+        HeapBlock <float> storage;
+        HeapBlock <float*> channels;
+        int maxChannels, windowStart, windowEnd;
+
+        void moveWindow (int samplePos) noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BlockCache);
+    };
+
+private:
+    //==============================================================================
+    MemoryBlock data;
+    Array <int> blockOffsets;
+    int numChannels, numSamples, bitsPerSample;
+    bool usesFloatingPointData;
+
+    void encodeBlock (int* const* samples, int numSamplesInBlock, MemoryOutputStream& out) const;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CompressedAudioBuffer);
+};
+
+
+#endif   // __JUCE_COMPRESSEDAUDIOBUFFER_JUCEHEADER__
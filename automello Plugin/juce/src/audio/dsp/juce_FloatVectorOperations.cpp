@@ -0,0 +1,457 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+#include "../../core/juce_StandardHeader.h"
+
+BEGIN_JUCE_NAMESPACE
+
+#include "juce_FloatVectorOperations.h"
+
+
+//==============================================================================
+/*  The SSE loops use unaligned loads and stores throughout: on current processors these
+    run at full speed when the data does happen to be aligned, so there's no need to have
+    separate versions of each loop for aligned and unaligned arrays.
+*/
+#if JUCE_USE_SSE_INTRINSICS
+namespace FloatVectorHelpers
+{
+    // returns the gains for four consecutive samples of a ramp
+    inline __m128 getRampGains (const float startGain, const float increment) noexcept
+    {
+        return _mm_add_ps (_mm_set1_ps (startGain),
+                           _mm_mul_ps (_mm_set1_ps (increment), _mm_setr_ps (0.0f, 1.0f, 2.0f, 3.0f)));
+    }
+}
+#endif
+
+//==============================================================================
+void FloatVectorOperations::clear (float* dest, int numValues) noexcept
+{
+    if (numValues > 0)
+        zeromem (dest, sizeof (float) * (size_t) numValues);
+}
+
+void FloatVectorOperations::copyWithMultiply (float* dest, const float* src, const float multiplier, int numValues) noexcept
+{
+   #if JUCE_USE_SSE_INTRINSICS
+    const __m128 m = _mm_set1_ps (multiplier);
+
+    for (; numValues >= 4; numValues -= 4, dest += 4, src += 4)
+        _mm_storeu_ps (dest, _mm_mul_ps (_mm_loadu_ps (src), m));
+   #endif
+
+    while (--numValues >= 0)
+        *dest++ = *src++ * multiplier;
+}
+
+void FloatVectorOperations::copyWithRamp (float* dest, const float* src, float startGain, const float increment, int numValues) noexcept
+{
+   #if JUCE_USE_SSE_INTRINSICS
+    if (numValues >= 4)
+    {
+        __m128 gain = FloatVectorHelpers::getRampGains (startGain, increment);
+        const __m128 step = _mm_set1_ps (increment * 4.0f);
+        const int numVectorValues = numValues & ~3;
+
+        for (int i = numVectorValues; i > 0; i -= 4, dest += 4, src += 4)
+        {
+            _mm_storeu_ps (dest, _mm_mul_ps (_mm_loadu_ps (src), gain));
+            gain = _mm_add_ps (gain, step);
+        }
+
+        startGain += increment * numVectorValues;
+        numValues -= numVectorValues;
+    }
+   #endif
+
+    while (--numValues >= 0)
+    {
+        *dest++ = *src++ * startGain;
+        startGain += increment;
+    }
+}
+
+void FloatVectorOperations::add (float* dest, const float* src, int numValues) noexcept
+{
+   #if JUCE_USE_SSE_INTRINSICS
+    for (; numValues >= 4; numValues -= 4, dest += 4, src += 4)
+        _mm_storeu_ps (dest, _mm_add_ps (_mm_loadu_ps (dest), _mm_loadu_ps (src)));
+   #endif
+
+    while (--numValues >= 0)
+        *dest++ += *src++;
+}
+
+void FloatVectorOperations::addWithMultiply (float* dest, const float* src, const float multiplier, int numValues) noexcept
+{
+   #if JUCE_USE_SSE_INTRINSICS
+    const __m128 m = _mm_set1_ps (multiplier);
+
+    for (; numValues >= 4; numValues -= 4, dest += 4, src += 4)
+        _mm_storeu_ps (dest, _mm_add_ps (_mm_loadu_ps (dest), _mm_mul_ps (_mm_loadu_ps (src), m)));
+   #endif
+
+    while (--numValues >= 0)
+        *dest++ += *src++ * multiplier;
+}
+
+void FloatVectorOperations::addWithRamp (float* dest, const float* src, float startGain, const float increment, int numValues) noexcept
+{
+   #if JUCE_USE_SSE_INTRINSICS
+    if (numValues >= 4)
+    {
+        __m128 gain = FloatVectorHelpers::getRampGains (startGain, increment);
+        const __m128 step = _mm_set1_ps (increment * 4.0f);
+        const int numVectorValues = numValues & ~3;
+
+        for (int i = numVectorValues; i > 0; i -= 4, dest += 4, src += 4)
+        {
+            _mm_storeu_ps (dest, _mm_add_ps (_mm_loadu_ps (dest), _mm_mul_ps (_mm_loadu_ps (src), gain)));
+            gain = _mm_add_ps (gain, step);
+        }
+
+        startGain += increment * numVectorValues;
+        numValues -= numVectorValues;
+    }
+   #endif
+
+    while (--numValues >= 0)
+    {
+        *dest++ += *src++ * startGain;
+        startGain += increment;
+    }
+}
+
+void FloatVectorOperations::multiply (float* dest, const float multiplier, int numValues) noexcept
+{
+   #if JUCE_USE_SSE_INTRINSICS
+    const __m128 m = _mm_set1_ps (multiplier);
+
+    for (; numValues >= 4; numValues -= 4, dest += 4)
+        _mm_storeu_ps (dest, _mm_mul_ps (_mm_loadu_ps (dest), m));
+   #endif
+
+    while (--numValues >= 0)
+        *dest++ *= multiplier;
+}
+
+void FloatVectorOperations::multiplyWithRamp (float* dest, float startGain, const float increment, int numValues) noexcept
+{
+   #if JUCE_USE_SSE_INTRINSICS
+    if (numValues >= 4)
+    {
+        __m128 gain = FloatVectorHelpers::getRampGains (startGain, increment);
+        const __m128 step = _mm_set1_ps (increment * 4.0f);
+        const int numVectorValues = numValues & ~3;
+
+        for (int i = numVectorValues; i > 0; i -= 4, dest += 4)
+        {
+            _mm_storeu_ps (dest, _mm_mul_ps (_mm_loadu_ps (dest), gain));
+            gain = _mm_add_ps (gain, step);
+        }
+
+        startGain += increment * numVectorValues;
+        numValues -= numVectorValues;
+    }
+   #endif
+
+    while (--numValues >= 0)
+    {
+        *dest++ *= startGain;
+        startGain += increment;
+    }
+}
+
+//==============================================================================
+void FloatVectorOperations::findMinAndMax (const float* src, int numValues, float& minResult, float& maxResult) noexcept
+{
+    if (numValues <= 0)
+    {
+        minResult = 0;
+        maxResult = 0;
+        return;
+    }
+
+    float mn = *src, mx = mn;
+
+   #if JUCE_USE_SSE_INTRINSICS
+    if (numValues >= 4)
+    {
+        __m128 vmin = _mm_loadu_ps (src);
+        __m128 vmax = vmin;
+
+        for (src += 4, numValues -= 4; numValues >= 4; numValues -= 4, src += 4)
+        {
+            const __m128 v = _mm_loadu_ps (src);
+            vmin = _mm_min_ps (vmin, v);
+            vmax = _mm_max_ps (vmax, v);
+        }
+
+        vmin = _mm_min_ps (vmin, _mm_movehl_ps (vmin, vmin));
+        vmax = _mm_max_ps (vmax, _mm_movehl_ps (vmax, vmax));
+        mn = _mm_cvtss_f32 (_mm_min_ss (vmin, _mm_shuffle_ps (vmin, vmin, 1)));
+        mx = _mm_cvtss_f32 (_mm_max_ss (vmax, _mm_shuffle_ps (vmax, vmax, 1)));
+    }
+   #endif
+
+    while (--numValues >= 0)
+    {
+        const float v = *src++;
+
+        if (mx < v)  mx = v;
+        if (v < mn)  mn = v;
+    }
+
+    minResult = mn;
+    maxResult = mx;
+}
+
+double FloatVectorOperations::sumOfSquares (const float* src, int numValues) noexcept
+{
+    double sum = 0;
+
+   #if JUCE_USE_SSE_INTRINSICS
+    __m128d sum1 = _mm_setzero_pd();
+    __m128d sum2 = _mm_setzero_pd();
+
+    for (; numValues >= 4; numValues -= 4, src += 4)
+    {
+        const __m128 v = _mm_loadu_ps (src);
+        const __m128d lo = _mm_cvtps_pd (v);
+        const __m128d hi = _mm_cvtps_pd (_mm_movehl_ps (v, v));
+
+        sum1 = _mm_add_pd (sum1, _mm_mul_pd (lo, lo));
+        sum2 = _mm_add_pd (sum2, _mm_mul_pd (hi, hi));
+    }
+
+    sum1 = _mm_add_pd (sum1, sum2);
+    sum = _mm_cvtsd_f64 (_mm_add_sd (sum1, _mm_unpackhi_pd (sum1, sum1)));
+   #endif
+
+    while (--numValues >= 0)
+    {
+        const double v = *src++;
+        sum += v * v;
+    }
+
+    return sum;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+#include "../../utilities/juce_UnitTest.h"
+#include "../../maths/juce_Random.h"
+#include "../../core/juce_Time.h"
+#include "juce_AudioSampleBuffer.h"
+
+class FloatVectorOperationsTests  : public UnitTest
+{
+public:
+    FloatVectorOperationsTests() : UnitTest ("FloatVectorOperations") {}
+
+    void runTest()
+    {
+        beginTest ("Results");
+
+        Random r (1234);
+        HeapBlock <float> src (4100), dest (4100), expected (4100);
+
+        // try lots of lengths and misalignments, to exercise the ends of the loops
+        for (int num = 0; num < 40; ++num)
+        {
+            for (int offset = 0; offset < 4; ++offset)
+            {
+                for (int i = 0; i < num + offset; ++i)
+                {
+                    src[i] = r.nextFloat() * 2.0f - 1.0f;
+                    dest[i] = expected[i] = r.nextFloat() * 2.0f - 1.0f;
+                }
+
+                float* const d = dest + offset;
+                float* const e = expected + offset;
+                const float* const s = src + offset;
+
+                FloatVectorOperations::addWithRamp (d, s, 0.25f, 0.01f, num);
+
+                for (int i = 0; i < num; ++i)
+                    e[i] += s[i] * (0.25f + 0.01f * i);
+
+                FloatVectorOperations::multiply (d, 0.7f, num);
+
+                for (int i = 0; i < num; ++i)
+                    e[i] *= 0.7f;
+
+                FloatVectorOperations::addWithMultiply (d, s, -0.3f, num);
+
+                for (int i = 0; i < num; ++i)
+                    e[i] += s[i] * -0.3f;
+
+                FloatVectorOperations::multiplyWithRamp (d, 1.0f, -0.02f, num);
+
+                for (int i = 0; i < num; ++i)
+                    e[i] *= 1.0f - 0.02f * i;
+
+                FloatVectorOperations::add (d, s, num);
+
+                for (int i = 0; i < num; ++i)
+                    e[i] += s[i];
+
+                expectNearlyEqual (d, e, num);
+
+                float mn, mx, expectedMin, expectedMax;
+                FloatVectorOperations::findMinAndMax (d, num, mn, mx);
+                findMinAndMax (e, num, expectedMin, expectedMax);
+                expect (std::abs (mn - expectedMin) < 1.0e-5f && std::abs (mx - expectedMax) < 1.0e-5f);
+
+                double expectedSum = 0;
+
+                for (int i = 0; i < num; ++i)
+                    expectedSum += s[i] * (double) s[i];
+
+                expect (std::abs (FloatVectorOperations::sumOfSquares (s, num) - expectedSum) < 1.0e-9);
+
+                FloatVectorOperations::copyWithRamp (d, s, 0.5f, 0.05f, num);
+
+                for (int i = 0; i < num; ++i)
+                    e[i] = s[i] * (0.5f + 0.05f * i);
+
+                expectNearlyEqual (d, e, num);
+
+                FloatVectorOperations::copyWithMultiply (d, s, 3.0f, num);
+
+                for (int i = 0; i < num; ++i)
+                    e[i] = s[i] * 3.0f;
+
+                expectNearlyEqual (d, e, num);
+            }
+        }
+
+        beginTest ("Speed");
+
+        for (int blockSize = 16; blockSize <= 4096; blockSize *= 2)
+            compareSpeeds (blockSize);
+    }
+
+    void expectNearlyEqual (const float* const d, const float* const e, const int num)
+    {
+        float maxError = 0;
+
+        for (int i = 0; i < num; ++i)
+            maxError = jmax (maxError, std::abs (d[i] - e[i]));
+
+        expect (maxError < 1.0e-5f, "error: " + String (maxError));
+    }
+
+    /* Times the AudioSampleBuffer methods against the plain loops that they used to be
+       implemented with, mixing a stereo buffer into another one the way a synth or a
+       graph would.
+    */
+    void compareSpeeds (const int blockSize)
+    {
+        const int numRepeats = jmax (1, (1 << 22) / blockSize);
+
+        AudioSampleBuffer source (2, blockSize), dest (2, blockSize);
+        source.clear();
+        dest.clear();
+
+        double start = Time::getMillisecondCounterHiRes();
+
+        for (int n = 0; n < numRepeats; ++n)
+        {
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                float* const d = dest.getSampleData (ch);
+                const float* const s = source.getSampleData (ch);
+                float gain = 0.5f;
+
+                for (int i = 0; i < blockSize; ++i)
+                {
+                    d[i] += s[i] * gain;
+                    gain += 0.0001f;
+                }
+
+                for (int i = 0; i < blockSize; ++i)
+                    d[i] += s[i] * 0.7f;
+
+                for (int i = 0; i < blockSize; ++i)
+                    d[i] *= 0.9f;
+            }
+        }
+
+        const double scalarTime = Time::getMillisecondCounterHiRes() - start;
+        start = Time::getMillisecondCounterHiRes();
+
+        for (int n = 0; n < numRepeats; ++n)
+        {
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                dest.addFromWithRamp (ch, 0, source.getSampleData (ch), blockSize, 0.5f, 0.5f + 0.0001f * blockSize);
+                dest.addFrom (ch, 0, source, ch, 0, blockSize, 0.7f);
+                dest.applyGain (ch, 0, blockSize, 0.9f);
+            }
+        }
+
+        const double vectorTime = Time::getMillisecondCounterHiRes() - start;
+
+        // (the totals are only there to stop the compiler optimising the loops away)
+        float total = 0;
+        start = Time::getMillisecondCounterHiRes();
+
+        for (int n = 0; n < numRepeats; ++n)
+        {
+            float mn, mx;
+            findMinAndMax (dest.getSampleData (0), blockSize, mn, mx);
+
+            const float* const d = dest.getSampleData (1);
+            double sum = 0;
+
+            for (int i = 0; i < blockSize; ++i)
+                sum += d[i] * d[i];
+
+            total += jmax (mn, -mn, mx, -mx) + (float) std::sqrt (sum / blockSize);
+        }
+
+        const double scalarMeteringTime = Time::getMillisecondCounterHiRes() - start;
+        start = Time::getMillisecondCounterHiRes();
+
+        for (int n = 0; n < numRepeats; ++n)
+            total += dest.getMagnitude (0, 0, blockSize) + dest.getRMSLevel (1, 0, blockSize);
+
+        const double vectorMeteringTime = Time::getMillisecondCounterHiRes() - start;
+
+        logMessage ("block size " + String (blockSize) + ": mixing " + String (scalarTime, 2)
+                     + " ms -> " + String (vectorTime, 2) + " ms, metering " + String (scalarMeteringTime, 2)
+                     + " ms -> " + String (vectorMeteringTime, 2) + " ms" + (total < 0 ? " " : ""));
+    }
+};
+
+static FloatVectorOperationsTests floatVectorOperationsTests;
+
+#endif
+
+END_JUCE_NAMESPACE
@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+#ifndef __JUCE_FLOATVECTOROPERATIONS_JUCEHEADER__
+#define __JUCE_FLOATVECTOROPERATIONS_JUCEHEADER__
+
+
+//==============================================================================
+/**
+    A collection of simple vector operations on arrays of floats, accelerated with
+    SSE instructions where they're available.
+
+    These are the loops that sit underneath AudioSampleBuffer's gain, mixing and
+    metering methods. The arrays don't need to be aligned, but they'll run fastest if
+    they start on a 16-byte boundary, which is always the case for the channels of an
+    AudioSampleBuffer that has allocated its own memory.
+
+    In all of these methods, the source and destination arrays must either be the
+    same array, or not overlap at all.
+
+    @see AudioSampleBuffer
+*/
+class JUCE_API  FloatVectorOperations
+{
+public:
+    //==============================================================================
+    /** Clears a vector of floats. */
+    static void clear (float* dest, int numValues) noexcept;
+
+    /** Copies a vector of floats, multiplying each value by a given multiplier. */
+    static void copyWithMultiply (float* dest, const float* src, float multiplier, int numValues) noexcept;
+
+    /** Copies a vector of floats, multiplying them by a gain which changes by a fixed
+        increment on each sample.
+    */
+    static void copyWithRamp (float* dest, const float* src, float startGain, float increment, int numValues) noexcept;
+
+    /** Adds the source values to the destination values. */
+    static void add (float* dest, const float* src, int numValues) noexcept;
+
+    /** Multiplies each source value by the given multiplier, then adds it to the destination value. */
+    static void addWithMultiply (float* dest, const float* src, float multiplier, int numValues) noexcept;
+
+    /** Multiplies each source value by a gain which changes by a fixed increment on each
+        sample, and adds it to the destination value.
+    */
+    static void addWithRamp (float* dest, const float* src, float startGain, float increment, int numValues) noexcept;
+
+    /** Multiplies each of the destination values by a fixed multiplier. */
+    static void multiply (float* dest, float multiplier, int numValues) noexcept;
+
+    /** Multiplies each of the destination values by a gain which changes by a fixed
+        increment on each sample.
+    */
+    static void multiplyWithRamp (float* dest, float startGain, float increment, int numValues) noexcept;
+
+    //==============================================================================
+    /** Finds the lowest and highest values in a vector.
+        If the vector is empty, both results are set to zero.
+    */
+    static void findMinAndMax (const float* src, int numValues, float& minResult, float& maxResult) noexcept;
+
+    /** Returns the sum of the squares of all the values in a vector.
+        The total is accumulated in double precision, so that long vectors don't lose accuracy.
+    */
+    static double sumOfSquares (const float* src, int numValues) noexcept;
+
+private:
+    FloatVectorOperations();
+
+    JUCE_DECLARE_NON_COPYABLE (FloatVectorOperations);
+};
+
+
+#endif   // __JUCE_FLOATVECTOROPERATIONS_JUCEHEADER__
@@ -31,9 +31,17 @@
 /**
     Performs a simple reverb effect on a stream of audio data.
 
-    This is a simple stereo reverb, based on the technique and tunings used in FreeVerb.
-    Use setSampleRate() to prepare it, and then call processStereo() or processMono() to
-    apply the reverb to your audio data.
+    This is a simple reverb, based on the technique and tunings used in FreeVerb.
+    Use setSampleRate() to prepare it, and then call processStereo(), processMono() or
+    processChannels() to apply the reverb to your audio data.
+
+    Each channel has a bank of eight comb filters, which are run side-by-side in SSE
+    registers where possible, followed by four all-pass filters. Up to four channels
+    can be processed, each with slightly different delay times, so mono, stereo and
+    quad buses all get a decorrelated tail.
+
+    Parameter changes are faded in over the next block that gets processed, so the
+    settings can be moved while audio is playing without causing clicks.
 
     @see ReverbAudioSource
 */
@@ -47,6 +55,9 @@ public:
         setSampleRate (44100.0);
     }
 
+    /** The maximum number of channels that processChannels() can handle. */
+    enum { maxNumChannels = 4 };
+
     //==============================================================================
     /** Holds the parameters being used by a Reverb object. */
     struct Parameters
@@ -74,6 +85,7 @@ public:
     const Parameters& getParameters() const noexcept    { return parameters; }
 
     /** Applies a new set of parameters to the reverb.
+        The new settings are ramped in over the course of the next block that's processed.
         Note that this doesn't attempt to lock the reverb, so if you call this in parallel with
         the process method, you may get artifacts.
     */
@@ -83,10 +95,10 @@ public:
         const float dryScaleFactor = 2.0f;
 
         const float wet = newParams.wetLevel * wetScaleFactor;
-        wet1 = wet * (newParams.width * 0.5f + 0.5f);
-        wet2 = wet * (1.0f - newParams.width) * 0.5f;
-        dry = newParams.dryLevel * dryScaleFactor;
-        gain = isFrozen (newParams.freezeMode) ? 0.0f : 0.015f;
+        wet1.setTarget (wet * (newParams.width * 0.5f + 0.5f));
+        wet2.setTarget (wet * (1.0f - newParams.width) * 0.5f);
+        dry.setTarget (newParams.dryLevel * dryScaleFactor);
+        gain.setTarget (isFrozen (newParams.freezeMode) ? 0.0f : 0.015f);
         parameters = newParams;
         shouldUpdateDamping = true;
     }
@@ -104,34 +116,35 @@ public:
         const int stereoSpread = 23;
         const int intSampleRate = (int) sampleRate;
 
-        int i;
-        for (i = 0; i < numCombs; ++i)
+        for (int j = 0; j < maxNumChannels; ++j)
         {
-            comb[0][i].setSize ((intSampleRate * combTunings[i]) / 44100);
-            comb[1][i].setSize ((intSampleRate * (combTunings[i] + stereoSpread)) / 44100);
-        }
+            int combSizes [numCombs];
 
-        for (i = 0; i < numAllPasses; ++i)
-        {
-            allPass[0][i].setSize ((intSampleRate * allPassTunings[i]) / 44100);
-            allPass[1][i].setSize ((intSampleRate * (allPassTunings[i] + stereoSpread)) / 44100);
+            int i;
+            for (i = 0; i < numCombs; ++i)
+                combSizes[i] = (intSampleRate * (combTunings[i] + j * stereoSpread)) / 44100;
+
+            comb[j].setSizes (combSizes);
+
+            for (i = 0; i < numAllPasses; ++i)
+                allPass[j][i].setSize ((intSampleRate * (allPassTunings[i] + j * stereoSpread)) / 44100);
         }
 
-        shouldUpdateDamping = true;
+        snapParametersToTargets();
     }
 
     /** Clears the reverb's buffers. */
     void reset()
     {
-        for (int j = 0; j < numChannels; ++j)
+        for (int j = 0; j < maxNumChannels; ++j)
         {
-            int i;
-            for (i = 0; i < numCombs; ++i)
-                comb[j][i].clear();
+            comb[j].clear();
 
-            for (i = 0; i < numAllPasses; ++i)
+            for (int i = 0; i < numAllPasses; ++i)
                 allPass[j][i].clear();
         }
+
+        snapParametersToTargets();
     }
 
     //==============================================================================
@@ -140,30 +153,8 @@ public:
     {
         jassert (left != nullptr && right != nullptr);
 
-        if (shouldUpdateDamping)
-            updateDamping();
-
-        for (int i = 0; i < numSamples; ++i)
-        {
-            const float input = (left[i] + right[i]) * gain;
-            float outL = 0, outR = 0;
-
-            int j;
-            for (j = 0; j < numCombs; ++j)  // accumulate the comb filters in parallel
-            {
-                outL += comb[0][j].process (input);
-                outR += comb[1][j].process (input);
-            }
-
-            for (j = 0; j < numAllPasses; ++j)  // run the allpass filters in series
-            {
-                outL = allPass[0][j].process (outL);
-                outR = allPass[1][j].process (outR);
-            }
-
-            left[i]  = outL * wet1 + outR * wet2 + left[i]  * dry;
-            right[i] = outR * wet1 + outL * wet2 + right[i] * dry;
-        }
+        float* const channels[] = { left, right };
+        processChannels (channels, 2, numSamples);
     }
 
     /** Applies the reverb to a single mono channel of audio data. */
@@ -171,31 +162,105 @@ public:
     {
         jassert (samples != nullptr);
 
+        processChannels (&samples, 1, numSamples);
+    }
+
+    /** Applies the reverb to between one and four channels of audio data.
+
+        The channels are mixed together to feed the reverb, and each one gets its own
+        tail. The width parameter controls how much of each channel's tail is mixed into
+        its neighbour's, where channels are paired as 0 & 1 and 2 & 3.
+    */
+    void processChannels (float* const* const channels, const int numChannels, const int numSamples) noexcept
+    {
+        jassert (numChannels > 0 && numChannels <= maxNumChannels);
+        const int numToProcess = jmin (numChannels, (int) maxNumChannels);
+
+        if (numToProcess <= 0 || numSamples <= 0)
+            return;
+
         if (shouldUpdateDamping)
             updateDamping();
 
+        gain.startRamp (numSamples);
+        wet1.startRamp (numSamples);
+        wet2.startRamp (numSamples);
+        dry.startRamp (numSamples);
+        feedback.startRamp (numSamples);
+        damping.startRamp (numSamples);
+
+        const ScopedNoDenormals noDenormals;
+
+        // (this keeps a quad bus at the same input level as a stereo one)
+        const float inputScale = numToProcess > 2 ? 2.0f / numToProcess : 1.0f;
+
         for (int i = 0; i < numSamples; ++i)
         {
-            const float input = samples[i] * gain;
-            float output = 0;
+            float input = 0;
 
             int j;
-            for (j = 0; j < numCombs; ++j)  // accumulate the comb filters in parallel
-                output += comb[0][j].process (input);
+            for (j = 0; j < numToProcess; ++j)
+                input += channels[j][i];
 
-            for (j = 0; j < numAllPasses; ++j)  // run the allpass filters in series
-                output = allPass[0][j].process (output);
+            input *= gain.getNextValue() * inputScale;
 
-            samples[i] = output * wet1 + input * dry;
+            const float feedbackNow = feedback.getNextValue();
+            const float dampingNow = damping.getNextValue();
+            float outputs [maxNumChannels];
+
+            for (j = 0; j < numToProcess; ++j)
+            {
+                float output = comb[j].process (input, feedbackNow, dampingNow);
+
+                for (int k = 0; k < numAllPasses; ++k)  // run the allpass filters in series
+                    output = allPass[j][k].process (output);
+
+                outputs[j] = output;
+            }
+
+            const float wet1Now = wet1.getNextValue();
+            const float wet2Now = wet2.getNextValue();
+            const float dryNow = dry.getNextValue();
+
+            for (j = 0; j < numToProcess; ++j)
+            {
+                const int partner = j ^ 1;
+                float output = outputs[j] * wet1Now + channels[j][i] * dryNow;
+
+                if (partner < numToProcess)
+                    output += outputs [partner] * wet2Now;
+
+                channels[j][i] = output;
+            }
         }
+
+        // (avoids any rounding errors that the ramps may have accumulated)
+        snapParametersToTargets();
     }
 
 private:
     //==============================================================================
+    enum { numCombs = 8, numAllPasses = 4 };
+
+    //==============================================================================
+    class LinearSmoothedValue
+    {
+    public:
+        LinearSmoothedValue() noexcept  : current (0), target (0), step (0) {}
+
+        void setTarget (const float newTarget) noexcept     { target = newTarget; }
+        void snapToTarget() noexcept                        { current = target; step = 0; }
+        void startRamp (const int numSamples) noexcept      { step = (target - current) / numSamples; }
+        inline float getNextValue() noexcept                { return current += step; }
+
+    private:
+        float current, target, step;
+    };
+
     Parameters parameters;
 
     volatile bool shouldUpdateDamping;
-    float gain, wet1, wet2, dry;
+    LinearSmoothedValue gain, wet1, wet2, dry, feedback, damping;
 
     inline static bool isFrozen (const float freezeMode) noexcept  { return freezeMode >= 0.5f; }
 
@@ -208,32 +273,62 @@ private:
         shouldUpdateDamping = false;
 
         if (isFrozen (parameters.freezeMode))
-            setDamping (1.0f, 0.0f);
+        {
+            damping.setTarget (0.0f);
+            feedback.setTarget (1.0f);
+        }
         else
-            setDamping (parameters.damping * dampScaleFactor,
-                        parameters.roomSize * roomScaleFactor + roomOffset);
+        {
+            damping.setTarget (parameters.damping * dampScaleFactor);
+            feedback.setTarget (parameters.roomSize * roomScaleFactor + roomOffset);
+        }
     }
 
-    void setDamping (const float dampingToUse, const float roomSizeToUse) noexcept
+    void snapParametersToTargets() noexcept
     {
-        for (int j = 0; j < numChannels; ++j)
-            for (int i = numCombs; --i >= 0;)
-                comb[j][i].setFeedbackAndDamp (roomSizeToUse, dampingToUse);
+        if (shouldUpdateDamping)
+            updateDamping();
+
+        gain.snapToTarget();
+        wet1.snapToTarget();
+        wet2.snapToTarget();
+        dry.snapToTarget();
+        feedback.snapToTarget();
+        damping.snapToTarget();
     }
 
     //==============================================================================
-    class CombFilter
+    /*  The eight comb filters for one channel. Their delay lines are interleaved in a
+        single circular buffer with a row of eight values per sample, so that all the
+        combs can write their new values with a couple of vector stores.
+    */
+    class CombFilterBank
     {
     public:
-        CombFilter() noexcept  : bufferSize (0), bufferIndex (0) {}
+        CombFilterBank() noexcept  : buffer (nullptr), last (nullptr), mask (0), writeIndex (0) {}
 
-        void setSize (const int size)
+        void setSizes (const int* const newSizes)
         {
-            if (size != bufferSize)
+            int maxSize = 1;
+
+            for (int i = 0; i < numCombs; ++i)
             {
-                bufferIndex = 0;
-                buffer.malloc (size);
-                bufferSize = size;
+                sizes[i] = jmax (1, newSizes[i]);
+                maxSize = jmax (maxSize, sizes[i]);
+            }
+
+            int numRows = 1;
+
+            while (numRows <= maxSize)
+                numRows <<= 1;
+
+            if (buffer == nullptr || numRows != mask + 1)
+            {
+                // (with space for the filter states, and some extra to align it all for SSE)
+                storage.malloc ((size_t) ((numRows + 1) * numCombs + 4));
+                buffer = reinterpret_cast <float*> ((reinterpret_cast <pointer_sized_int> (storage.getData()) + 15) & ~(pointer_sized_int) 15);
+                last = buffer + numRows * numCombs;
+                mask = numRows - 1;
             }
 
             clear();
@@ -241,36 +336,73 @@ private:
 
         void clear() noexcept
         {
-            last = 0;
-            buffer.clear (bufferSize);
-        }
+            writeIndex = 0;
 
-        void setFeedbackAndDamp (const float f, const float d) noexcept
-        {
-            damp1 = d;
-            damp2 = 1.0f - d;
-            feedback = f;
+            if (buffer != nullptr)
+                zeromem (buffer, sizeof (float) * (size_t) ((mask + 2) * numCombs));
         }
 
-        inline float process (const float input) noexcept
+        /** Runs a sample through all the combs, and returns the sum of their outputs. */
+        inline float process (const float input, const float feedback, const float damp) noexcept
         {
-            const float output = buffer [bufferIndex];
-            last = (output * damp2) + (last * damp1);
-            JUCE_UNDENORMALISE (last);
+            float* const row = buffer + writeIndex * numCombs;
 
-            float temp = input + (last * feedback);
-            JUCE_UNDENORMALISE (temp);
-            buffer [bufferIndex] = temp;
-            bufferIndex = (bufferIndex + 1) % bufferSize;
-            return output;
+           #if JUCE_USE_SSE_INTRINSICS
+            const __m128 in = _mm_set1_ps (input);
+            const __m128 fb = _mm_set1_ps (feedback);
+            const __m128 damp1 = _mm_set1_ps (damp);
+            const __m128 damp2 = _mm_set1_ps (1.0f - damp);
+            __m128 sum = _mm_setzero_ps();
+
+            for (int i = 0; i < numCombs; i += 4)
+            {
+                const __m128 output = _mm_setr_ps (getDelayedSample (i),     getDelayedSample (i + 1),
+                                                   getDelayedSample (i + 2), getDelayedSample (i + 3));
+
+                const __m128 l = _mm_add_ps (_mm_mul_ps (output, damp2), _mm_mul_ps (_mm_load_ps (last + i), damp1));
+                _mm_store_ps (last + i, l);
+                _mm_store_ps (row + i, _mm_add_ps (in, _mm_mul_ps (l, fb)));
+                sum = _mm_add_ps (sum, output);
+            }
+
+            sum = _mm_add_ps (sum, _mm_movehl_ps (sum, sum));
+            sum = _mm_add_ss (sum, _mm_shuffle_ps (sum, sum, 1));
+
+            writeIndex = (writeIndex + 1) & mask;
+            return _mm_cvtss_f32 (sum);
+           #else
+            float sum = 0;
+
+            for (int i = 0; i < numCombs; ++i)
+            {
+                const float output = getDelayedSample (i);
+                last[i] = (output * (1.0f - damp)) + (last[i] * damp);
+                JUCE_UNDENORMALISE (last[i]);
+
+                float temp = input + (last[i] * feedback);
+                JUCE_UNDENORMALISE (temp);
+                row[i] = temp;
+                sum += output;
+            }
+
+            writeIndex = (writeIndex + 1) & mask;
+            return sum;
+           #endif
         }
 
     private:
-        HeapBlock<float> buffer;
-        int bufferSize, bufferIndex;
-        float feedback, last, damp1, damp2;
+        HeapBlock<float> storage;
+        float* buffer;
+        float* last;
+        int sizes [numCombs];
+        int mask, writeIndex;
 
-        JUCE_DECLARE_NON_COPYABLE (CombFilter);
+        inline float getDelayedSample (const int combIndex) const noexcept
+        {
+            return buffer [((writeIndex - sizes [combIndex]) & mask) * numCombs + combIndex];
+        }
+
+        JUCE_DECLARE_NON_COPYABLE (CombFilterBank);
     };
 
     //==============================================================================
@@ -302,7 +434,10 @@ private:
             float temp = input + (bufferedValue * 0.5f);
             JUCE_UNDENORMALISE (temp);
             buffer [bufferIndex] = temp;
-            bufferIndex = (bufferIndex + 1) % bufferSize;
+
+            if (++bufferIndex >= bufferSize)
+                bufferIndex = 0;
+
             return bufferedValue - input;
         }
 
@@ -313,10 +448,8 @@ private:
         JUCE_DECLARE_NON_COPYABLE (AllPassFilter);
     };
 
-    enum { numCombs = 8, numAllPasses = 4, numChannels = 2 };
-
-    CombFilter comb [numChannels][numCombs];
-    AllPassFilter allPass [numChannels][numAllPasses];
+    CombFilterBank comb [maxNumChannels];
+    AllPassFilter allPass [maxNumChannels][numAllPasses];
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Reverb);
 };
@@ -32,20 +32,29 @@ BEGIN_JUCE_NAMESPACE
 
 //==============================================================================
 MidiBuffer::MidiBuffer() noexcept
-    : bytesUsed (0)
+    : bytesUsed (0),
+      numEvents (0),
+      numEventOffsetsAllocated (0)
 {
 }
 
 MidiBuffer::MidiBuffer (const MidiMessage& message) noexcept
-    : bytesUsed (0)
+    : bytesUsed (0),
+      numEvents (0),
+      numEventOffsetsAllocated (0)
 {
     addEvent (message, 0);
 }
 
 MidiBuffer::MidiBuffer (const MidiBuffer& other) noexcept
     : data (other.data),
-      bytesUsed (other.bytesUsed)
+      bytesUsed (other.bytesUsed),
+      numEvents (0),
+      numEventOffsetsAllocated (0)
 {
+    ensureIndexSize (other.numEvents);
+    memcpy (eventOffsets, other.eventOffsets, sizeof (int) * (size_t) other.numEvents);
+    numEvents = other.numEvents;
 }
 
 MidiBuffer& MidiBuffer::operator= (const MidiBuffer& other) noexcept
@@ -53,6 +62,10 @@ MidiBuffer& MidiBuffer::operator= (const MidiBuffer& other) noexcept
     bytesUsed = other.bytesUsed;
     data = other.data;
 
+    ensureIndexSize (other.numEvents);
+    memcpy (eventOffsets, other.eventOffsets, sizeof (int) * (size_t) other.numEvents);
+    numEvents = other.numEvents;
+
     return *this;
 }
 
@@ -60,6 +73,9 @@ void MidiBuffer::swapWith (MidiBuffer& other) noexcept
 {
     data.swapWith (other.data);
     std::swap (bytesUsed, other.bytesUsed);
+    eventOffsets.swapWith (other.eventOffsets);
+    std::swap (numEvents, other.numEvents);
+    std::swap (numEventOffsetsAllocated, other.numEventOffsetsAllocated);
 }
 
 MidiBuffer::~MidiBuffer()
@@ -86,24 +102,48 @@ inline uint16 MidiBuffer::getEventTotalSize (const void* const d) noexcept
     return getEventDataSize (d) + sizeof (int) + sizeof (uint16);
 }
 
+inline uint8* MidiBuffer::getEventAtIndex (const int index) const noexcept
+{
+    return getData() + (index < numEvents ? eventOffsets [index] : bytesUsed);
+}
+
+void MidiBuffer::ensureIndexSize (const int minNumEvents)
+{
+    if (minNumEvents > numEventOffsetsAllocated)
+    {
+        numEventOffsetsAllocated = (minNumEvents + minNumEvents / 2 + 8) & ~7;
+        eventOffsets.realloc ((size_t) numEventOffsetsAllocated);
+    }
+}
+
 void MidiBuffer::clear() noexcept
 {
     bytesUsed = 0;
+    numEvents = 0;
 }
 
 void MidiBuffer::clear (const int startSample, const int numSamples)
 {
-    uint8* const start = findEventAfter (getData(), startSample - 1);
-    uint8* const end   = findEventAfter (start, startSample + numSamples - 1);
+    const int startIndex = findIndexOfEventAfter (startSample - 1);
+    const int endIndex   = findIndexOfEventAfter (startSample + numSamples - 1);
 
-    if (end > start)
+    if (endIndex > startIndex)
     {
+        uint8* const start = getEventAtIndex (startIndex);
+        uint8* const end   = getEventAtIndex (endIndex);
+        const int numBytesRemoved = (int) (end - start);
         const int bytesToMove = bytesUsed - (int) (end - getData());
 
         if (bytesToMove > 0)
             memmove (start, end, bytesToMove);
 
-        bytesUsed -= (int) (end - start);
+        bytesUsed -= numBytesRemoved;
+
+        const int numEventsRemoved = endIndex - startIndex;
+        numEvents -= numEventsRemoved;
+
+        for (int i = startIndex; i < numEvents; ++i)
+            eventOffsets[i] = eventOffsets [i + numEventsRemoved] - numBytesRemoved;
     }
 }
 
@@ -150,14 +190,32 @@ void MidiBuffer::addEvent (const void* const newData, const int maxBytes, const
 
     if (numBytes > 0)
     {
-        int spaceNeeded = bytesUsed + numBytes + sizeof (int) + sizeof (uint16);
+        const int eventSize = numBytes + sizeof (int) + sizeof (uint16);
+        const int spaceNeeded = bytesUsed + eventSize;
         data.ensureSize ((spaceNeeded + spaceNeeded / 2 + 8) & ~7);
+        ensureIndexSize (numEvents + 1);
 
-        uint8* d = findEventAfter (getData(), sampleNumber);
-        const int bytesToMove = bytesUsed - (int) (d - getData());
+        uint8* d;
 
-        if (bytesToMove > 0)
-            memmove (d + numBytes + sizeof (int) + sizeof (uint16), d, bytesToMove);
+        if (numEvents == 0 || sampleNumber >= getEventTime (getData() + eventOffsets [numEvents - 1]))
+        {
+            // the usual case, where events arrive in order and can just be appended..
+            d = getData() + bytesUsed;
+            eventOffsets [numEvents] = bytesUsed;
+        }
+        else
+        {
+            const int index = findIndexOfEventAfter (sampleNumber);
+            const int offset = eventOffsets [index];
+
+            d = getData() + offset;
+            memmove (d + eventSize, d, (size_t) (bytesUsed - offset));
+
+            for (int i = numEvents; i > index; --i)
+                eventOffsets[i] = eventOffsets [i - 1] + eventSize;
+        }
+
+        ++numEvents;
 
         *reinterpret_cast <int*> (d) = sampleNumber;
         d += sizeof (int);
@@ -166,7 +224,7 @@ void MidiBuffer::addEvent (const void* const newData, const int maxBytes, const
 
         memcpy (d, newData, numBytes);
 
-        bytesUsed += numBytes + sizeof (int) + sizeof (uint16);
+        bytesUsed += eventSize;
     }
 }
 
@@ -191,6 +249,7 @@ void MidiBuffer::addEvents (const MidiBuffer& otherBuffer,
 void MidiBuffer::ensureSize (size_t minimumNumBytes)
 {
     data.ensureSize (minimumNumBytes);
+    ensureIndexSize ((int) (minimumNumBytes / (sizeof (int) + sizeof (uint16) + 1)));
 }
 
 bool MidiBuffer::isEmpty() const noexcept
@@ -200,17 +259,7 @@ bool MidiBuffer::isEmpty() const noexcept
 
 int MidiBuffer::getNumEvents() const noexcept
 {
-    int n = 0;
-    const uint8* d = getData();
-    const uint8* const end = d + bytesUsed;
-
-    while (d < end)
-    {
-        d += getEventTotalSize (d);
-        ++n;
-    }
-
-    return n;
+    return numEvents;
 }
 
 int MidiBuffer::getFirstEventTime() const noexcept
@@ -220,31 +269,25 @@ int MidiBuffer::getFirstEventTime() const noexcept
 
 int MidiBuffer::getLastEventTime() const noexcept
 {
-    if (bytesUsed == 0)
-        return 0;
+    return numEvents > 0 ? getEventTime (getData() + eventOffsets [numEvents - 1]) : 0;
+}
 
-    const uint8* d = getData();
-    const uint8* const endData = d + bytesUsed;
+int MidiBuffer::findIndexOfEventAfter (const int samplePosition) const noexcept
+{
+    const uint8* const d = getData();
+    int start = 0, end = numEvents;
 
-    for (;;)
+    while (start < end)
     {
-        const uint8* const nextOne = d + getEventTotalSize (d);
-
-        if (nextOne >= endData)
-            return getEventTime (d);
+        const int middle = (start + end) / 2;
 
-        d = nextOne;
+        if (getEventTime (d + eventOffsets [middle]) <= samplePosition)
+            start = middle + 1;
+        else
+            end = middle;
     }
-}
-
-uint8* MidiBuffer::findEventAfter (uint8* d, const int samplePosition) const noexcept
-{
-    const uint8* const endData = getData() + bytesUsed;
 
-    while (d < endData && getEventTime (d) <= samplePosition)
-        d += getEventTotalSize (d);
-
-    return d;
+    return start;
 }
 
 //==============================================================================
@@ -261,11 +304,7 @@ MidiBuffer::Iterator::~Iterator() noexcept
 //==============================================================================
 void MidiBuffer::Iterator::setNextSamplePosition (const int samplePosition) noexcept
 {
-    data = buffer.getData();
-    const uint8* dataEnd = data + buffer.bytesUsed;
-
-    while (data < dataEnd && getEventTime (data) < samplePosition)
-        data += getEventTotalSize (data);
+    data = buffer.getEventAtIndex (buffer.findIndexOfEventAfter (samplePosition - 1));
 }
 
 bool MidiBuffer::Iterator::getNextEvent (const uint8* &midiData, int& numBytes, int& samplePosition) noexcept
@@ -296,5 +335,179 @@ bool MidiBuffer::Iterator::getNextEvent (MidiMessage& result, int& samplePositio
     return true;
 }
 
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+#include "../../utilities/juce_UnitTest.h"
+#include "../../maths/juce_Random.h"
+#include "../../core/juce_Time.h"
+
+class MidiBufferTests  : public UnitTest
+{
+public:
+    MidiBufferTests() : UnitTest ("MidiBuffer") {}
+
+    void runTest()
+    {
+        beginTest ("Ordering");
+
+        Random r (4321);
+        MidiBuffer buffer;
+        Array <int> times, notes;   // a reference copy, kept in the order the buffer should have
+
+        for (int i = 0; i < 2000; ++i)
+        {
+            const int time = (i % 3 == 0) ? r.nextInt (500) : i / 4;
+            const int note = i % 128;
+
+            buffer.addEvent (MidiMessage::noteOn (1, note, 0.5f), time);
+
+            int index = times.size();
+            while (index > 0 && times.getUnchecked (index - 1) > time)
+                --index;
+
+            times.insert (index, time);
+            notes.insert (index, note);
+        }
+
+        expectMatches (buffer, times, notes);
+        expectEquals (buffer.getFirstEventTime(), times.getFirst());
+        expectEquals (buffer.getLastEventTime(), times.getLast());
+
+        beginTest ("Seeking and clearing");
+
+        for (int pos = -1; pos < 510; pos += 7)
+        {
+            MidiBuffer::Iterator i (buffer);
+            i.setNextSamplePosition (pos);
+
+            int expectedIndex = 0;
+            while (expectedIndex < times.size() && times.getUnchecked (expectedIndex) < pos)
+                ++expectedIndex;
+
+            const uint8* data;
+            int size, time;
+
+            if (expectedIndex < times.size())
+            {
+                expect (i.getNextEvent (data, size, time));
+                expectEquals (time, times.getUnchecked (expectedIndex));
+                expectEquals ((int) data[1], notes.getUnchecked (expectedIndex));
+            }
+            else
+            {
+                expect (! i.getNextEvent (data, size, time));
+            }
+        }
+
+        MidiBuffer copy (buffer);
+        copy.clear (100, 50);
+
+        for (int i = times.size(); --i >= 0;)
+        {
+            if (times.getUnchecked (i) >= 100 && times.getUnchecked (i) < 150)
+            {
+                times.remove (i);
+                notes.remove (i);
+            }
+        }
+
+        expectMatches (copy, times, notes);
+
+        copy.addEvent (MidiMessage::noteOff (1, 64), 120);
+        expectEquals (copy.getNumEvents(), times.size() + 1);
+
+        MidiBuffer other;
+        other.swapWith (copy);
+        expect (copy.isEmpty() && copy.getNumEvents() == 0);
+        expectEquals (other.getNumEvents(), times.size() + 1);
+
+        beginTest ("Speed");
+
+        for (int numEvents = 256; numEvents <= 16384; numEvents *= 4)
+            compareSpeeds (numEvents);
+    }
+
+    void expectMatches (const MidiBuffer& buffer, const Array<int>& times, const Array<int>& notes)
+    {
+        expectEquals (buffer.getNumEvents(), times.size());
+
+        MidiBuffer::Iterator i (buffer);
+        const uint8* data;
+        int size, time, index = 0;
+        bool allMatched = true;
+
+        while (i.getNextEvent (data, size, time))
+        {
+            allMatched = allMatched && index < times.size()
+                           && time == times.getUnchecked (index)
+                           && data[1] == notes.getUnchecked (index);
+            ++index;
+        }
+
+        expect (allMatched && index == times.size());
+    }
+
+    /* Fills a buffer with dense controller data, then seeks to the start of each block
+       of samples in it, the way a synth does when it renders a long buffer in sections.
+       The linear seek is what setNextSamplePosition() used to do.
+    */
+    void compareSpeeds (const int numEvents)
+    {
+        const int numSeeks = 4096;
+
+        double start = Time::getMillisecondCounterHiRes();
+
+        MidiBuffer buffer;
+
+        for (int i = 0; i < numEvents; ++i)
+            buffer.addEvent (MidiMessage::controllerEvent (1, 1, i & 127), i);
+
+        const double fillTime = Time::getMillisecondCounterHiRes() - start;
+
+        int total = 0;
+        start = Time::getMillisecondCounterHiRes();
+
+        for (int n = 0; n < numSeeks; ++n)
+        {
+            const int pos = (n * 7919) % numEvents;
+            MidiBuffer::Iterator i (buffer);
+            const uint8* data;
+            int size, time;
+
+            while (i.getNextEvent (data, size, time) && time < pos)
+            {}
+
+            total += time;
+        }
+
+        const double linearTime = Time::getMillisecondCounterHiRes() - start;
+        start = Time::getMillisecondCounterHiRes();
+
+        for (int n = 0; n < numSeeks; ++n)
+        {
+            const int pos = (n * 7919) % numEvents;
+            MidiBuffer::Iterator i (buffer);
+            i.setNextSamplePosition (pos);
+
+            const uint8* data;
+            int size, time;
+            i.getNextEvent (data, size, time);
+
+            total -= time;
+        }
+
+        const double indexedTime = Time::getMillisecondCounterHiRes() - start;
+
+        expectEquals (total, 0);
+        logMessage (String (numEvents) + " events: filled in " + String (fillTime, 3)
+                      + "ms, " + String (numSeeks) + " seeks: linear " + String (linearTime, 2)
+                      + "ms, indexed " + String (indexedTime, 2) + "ms");
+    }
+};
+
+static MidiBufferTests midiBufferTests;
+
+#endif
 
 END_JUCE_NAMESPACE
@@ -27,6 +27,7 @@
 #define __JUCE_MIDIBUFFER_JUCEHEADER__
 
 #include "../../memory/juce_MemoryBlock.h"
+#include "../../memory/juce_HeapBlock.h"
 #include "juce_MidiMessage.h"
 
 
@@ -37,6 +38,11 @@
     Analogous to the AudioSampleBuffer, this holds a set of midi events with
     integer time-stamps. The buffer is kept sorted in order of the time-stamps.
 
+    The events are packed together in a single block of memory, alongside an index
+    of where each one starts. Adding an event whose time is at or after the last one
+    in the buffer is a quick append, and finding the events at a particular time is
+    done with a binary search, so large or dense buffers can be handled efficiently.
+
     @see MidiMessage
 */
 class JUCE_API  MidiBuffer
@@ -75,12 +81,7 @@ public:
     */
     bool isEmpty() const noexcept;
 
-    /** Counts the number of events in the buffer.
-
-        This is actually quite a slow operation, as it has to iterate through all
-        the events, so you might prefer to call isEmpty() if that's all you need
-        to know.
-    */
+    /** Returns the number of events in the buffer. */
     int getNumEvents() const noexcept;
 
     /** Adds an event to the buffer.
@@ -92,6 +93,9 @@ public:
         If an event is added whose sample position is the same as one or more events
         already in the buffer, the new event will be placed after the existing ones.
 
+        Adding events in time order is the fastest way to fill a buffer, as each one
+        can just be appended to the end.
+
         To retrieve events, use a MidiBuffer::Iterator object
     */
     void addEvent (const MidiMessage& midiMessage, int sampleNumber);
@@ -157,7 +161,8 @@ public:
 
     /** Preallocates some memory for the buffer to use.
         This helps to avoid needing to reallocate space when the buffer has messages
-        added to it.
+        added to it. The index is given enough space for as many of the shortest
+        possible events as would fit into this number of bytes.
     */
     void ensureSize (size_t minimumNumBytes);
 
@@ -183,6 +188,8 @@ public:
         //==============================================================================
         /** Repositions the iterator so that the next event retrieved will be the first
             one whose sample position is at greater than or equal to the given position.
+
+            This does a binary search of the buffer's events.
         */
         void setNextSamplePosition (int samplePosition) noexcept;
 
@@ -226,9 +233,13 @@ private:
     friend class MidiBuffer::Iterator;
     MemoryBlock data;
     int bytesUsed;
+    HeapBlock <int> eventOffsets;
+    int numEvents, numEventOffsetsAllocated;
 
     uint8* getData() const noexcept;
-    uint8* findEventAfter (uint8* d, int samplePosition) const noexcept;
+    void ensureIndexSize (int minNumEvents);
+    int findIndexOfEventAfter (int samplePosition) const noexcept;
+    uint8* getEventAtIndex (int index) const noexcept;
     static int getEventTime (const void* d) noexcept;
     static uint16 getEventDataSize (const void* d) noexcept;
     static uint16 getEventTotalSize (const void* d) noexcept;
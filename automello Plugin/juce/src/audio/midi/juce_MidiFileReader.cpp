@@ -0,0 +1,616 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+#include "../../core/juce_StandardHeader.h"
+
+BEGIN_JUCE_NAMESPACE
+
+#include "juce_MidiFileReader.h"
+
+
+//==============================================================================
+namespace MidiFileReaderHelpers
+{
+    inline bool readVariableLengthValue (const uint8*& data, const uint8* const end, uint32& result) noexcept
+    {
+        result = 0;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            if (data >= end)
+                return false;
+
+            const uint8 byte = *data++;
+            result = (result << 7) | (byte & 0x7f);
+
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    inline bool isNoteOff (const uint8* const data, const int size) noexcept
+    {
+        return size >= 3 && ((data[0] & 0xf0) == 0x80
+                              || ((data[0] & 0xf0) == 0x90 && data[2] == 0));
+    }
+}
+
+//==============================================================================
+MidiFileReader::MidiFileReader (const File& file)
+    : timeFormat (0),
+      valid (false)
+{
+    mappedFile = new MemoryMappedFile (file, MemoryMappedFile::readOnly);
+
+    if (mappedFile->getData() != nullptr)
+        parse (static_cast <const uint8*> (mappedFile->getData()), mappedFile->getSize());
+}
+
+MidiFileReader::MidiFileReader (const void* const midiFileData, const size_t dataSize)
+    : timeFormat (0),
+      valid (false)
+{
+    if (midiFileData != nullptr)
+        parse (static_cast <const uint8*> (midiFileData), dataSize);
+}
+
+MidiFileReader::~MidiFileReader()
+{
+}
+
+void MidiFileReader::parse (const uint8* d, const size_t dataSize)
+{
+    const uint8* const end = d + dataSize;
+
+    if (dataSize < 14)
+        return;
+
+    // (a RIFF-wrapped file has the normal header somewhere near the start)
+    if (ByteOrder::bigEndianInt (d) == ByteOrder::bigEndianInt ("RIFF"))
+    {
+        for (int i = 0; i < 8 && d + 18 <= end; ++i)
+        {
+            d += 4;
+
+            if (ByteOrder::bigEndianInt (d) == ByteOrder::bigEndianInt ("MThd"))
+                break;
+        }
+    }
+
+    if (ByteOrder::bigEndianInt (d) != ByteOrder::bigEndianInt ("MThd"))
+        return;
+
+    const uint32 headerSize = ByteOrder::bigEndianInt (d + 4);
+    const int numTracksExpected = (int) ByteOrder::bigEndianShort (d + 10);
+    timeFormat = (short) ByteOrder::bigEndianShort (d + 12);
+
+    if (headerSize < 6 || headerSize > (uint32) (end - d - 8))
+        return;
+
+    d += 8 + headerSize;
+
+    while (end - d >= 8 && tracks.size() < numTracksExpected)
+    {
+        const uint32 chunkType = ByteOrder::bigEndianInt (d);
+        const int chunkSize = (int) jmin ((uint32) (end - d - 8), ByteOrder::bigEndianInt (d + 4));
+        d += 8;
+
+        if (chunkType == ByteOrder::bigEndianInt ("MTrk"))
+        {
+            TrackInfo t;
+            t.data = d;
+            t.size = chunkSize;
+            tracks.add (t);
+        }
+
+        d += chunkSize;
+    }
+
+    valid = true;
+}
+
+//==============================================================================
+MidiFileReader::TrackCursor::TrackCursor (const MidiFileReader& reader, const int trackIndex_)
+    : trackStart (nullptr),
+      trackEnd (nullptr),
+      eventData (nullptr),
+      eventSize (0),
+      trackIndex (trackIndex_)
+{
+    if (isPositiveAndBelow (trackIndex, reader.getNumTracks()))
+    {
+        const TrackInfo& t = reader.tracks.getReference (trackIndex);
+        trackStart = t.data;
+        trackEnd = t.data + t.size;
+    }
+
+    rewind();
+}
+
+MidiFileReader::TrackCursor::~TrackCursor()
+{
+}
+
+void MidiFileReader::TrackCursor::rewind() noexcept
+{
+    position = trackStart;
+    eventData = nullptr;
+    eventSize = 0;
+    tick = 0;
+    runningStatus = 0;
+}
+
+bool MidiFileReader::TrackCursor::next() noexcept
+{
+    using namespace MidiFileReaderHelpers;
+
+    while (position < trackEnd)
+    {
+        uint32 delta;
+
+        if (! readVariableLengthValue (position, trackEnd, delta) || position >= trackEnd)
+            break;
+
+        tick += delta;
+        const uint8 firstByte = *position;
+
+        if (firstByte == 0xff)
+        {
+            // a meta-event, which is stored in the file in the same form as a MidiMessage uses
+            const uint8* const start = position;
+
+            if (trackEnd - position < 2)
+                break;
+
+            position += 2;
+
+            uint32 length;
+            if (! readVariableLengthValue (position, trackEnd, length)
+                  || length > (uint32) (trackEnd - position))
+                break;
+
+            position += length;
+            eventData = start;
+            eventSize = (int) (position - start);
+
+            // nothing that comes after an end-of-track event counts as part of the track
+            if (start[1] == 0x2f)
+                position = trackEnd;
+
+            return true;
+        }
+
+        if (firstByte == 0xf0 || firstByte == 0xf7)
+        {
+            ++position;
+            runningStatus = 0;
+
+            uint32 length;
+            if (! readVariableLengthValue (position, trackEnd, length)
+                  || length > (uint32) (trackEnd - position))
+                break;
+
+            if (firstByte == 0xf0)
+            {
+                // the length of a sysex message is stored between the 0xf0 and the rest
+                // of the message, so it has to be copied to make it into a normal one
+                sysexData.ensureSize (length + 1);
+                uint8* const d = static_cast <uint8*> (sysexData.getData());
+                d[0] = 0xf0;
+                memcpy (d + 1, position, length);
+
+                eventData = d;
+                eventSize = (int) length + 1;
+            }
+            else
+            {
+                // an "escape" event holds some raw bytes to send as they are
+                eventData = position;
+                eventSize = (int) length;
+            }
+
+            position += length;
+
+            if (eventSize > 0)
+                return true;
+
+            continue;
+        }
+
+        if (firstByte >= 0x80)
+        {
+            eventSize = MidiMessage::getMessageLengthFromFirstByte (firstByte);
+
+            if (eventSize > trackEnd - position)
+                break;
+
+            eventData = position;
+            position += eventSize;
+            runningStatus = firstByte < 0xf0 ? firstByte : 0;
+            return true;
+        }
+
+        // running status - the status byte is missing, so the message has to be rebuilt
+        if (runningStatus == 0)
+            break;
+
+        eventSize = MidiMessage::getMessageLengthFromFirstByte (runningStatus);
+
+        if (eventSize - 1 > trackEnd - position)
+            break;
+
+        shortMessage[0] = runningStatus;
+
+        for (int i = 1; i < eventSize; ++i)
+            shortMessage[i] = *position++;
+
+        eventData = shortMessage;
+        return true;
+    }
+
+    // either the end of the track, or some data that couldn't be parsed
+    position = trackEnd;
+    eventData = nullptr;
+    eventSize = 0;
+    return false;
+}
+
+MidiMessage MidiFileReader::TrackCursor::getMessage() const
+{
+    jassert (eventSize > 0); // you need to call next() before using the cursor!
+
+    return MidiMessage (eventData, eventSize, (double) tick);
+}
+
+//==============================================================================
+MidiFileReader::Iterator::Iterator (const MidiFileReader& reader)
+    : queue ((size_t) jmax (1, reader.getNumTracks())),
+      current (nullptr),
+      queueSize (0),
+      timeFormat (reader.getTimeFormat()),
+      lastTick (0),
+      timeInSeconds (0),
+      secondsPerTick (timeFormat > 0 ? 0.5 / timeFormat : 0.0),
+      needsToAdvance (false)
+{
+    for (int i = 0; i < reader.getNumTracks(); ++i)
+    {
+        TrackCursor* const c = new TrackCursor (reader, i);
+        cursors.add (c);
+
+        if (c->next())
+            queue [queueSize++] = c;
+    }
+
+    for (int i = queueSize / 2; --i >= 0;)
+        sortDown (i);
+}
+
+MidiFileReader::Iterator::~Iterator()
+{
+}
+
+bool MidiFileReader::Iterator::comesBefore (const TrackCursor* const a, const TrackCursor* const b) noexcept
+{
+    using namespace MidiFileReaderHelpers;
+
+    if (a->getTick() != b->getTick())
+        return a->getTick() < b->getTick();
+
+    const bool aIsNoteOff = isNoteOff (a->getData(), a->getDataSize());
+
+    if (aIsNoteOff != isNoteOff (b->getData(), b->getDataSize()))
+        return aIsNoteOff;
+
+    return a->getTrackIndex() < b->getTrackIndex();
+}
+
+void MidiFileReader::Iterator::sortDown (int index) noexcept
+{
+    // the queue is a binary heap, with the earliest cursor at the top
+    for (;;)
+    {
+        const int left = index * 2 + 1;
+        const int right = left + 1;
+        int earliest = index;
+
+        if (left < queueSize && comesBefore (queue [left], queue [earliest]))
+            earliest = left;
+
+        if (right < queueSize && comesBefore (queue [right], queue [earliest]))
+            earliest = right;
+
+        if (earliest == index)
+            break;
+
+        std::swap (queue [index], queue [earliest]);
+        index = earliest;
+    }
+}
+
+void MidiFileReader::Iterator::removeFromQueue() noexcept
+{
+    queue[0] = queue [--queueSize];
+    sortDown (0);
+}
+
+bool MidiFileReader::Iterator::next() noexcept
+{
+    if (needsToAdvance)
+    {
+        if (current->next())
+            sortDown (0);
+        else
+            removeFromQueue();
+    }
+
+    needsToAdvance = queueSize > 0;
+
+    if (! needsToAdvance)
+        return false;
+
+    current = queue[0];
+    const int64 tick = current->getTick();
+
+    if (timeFormat > 0)
+    {
+        timeInSeconds += (tick - lastTick) * secondsPerTick;
+        lastTick = tick;
+
+        const uint8* const d = current->getData();
+
+        if (current->getDataSize() == 6 && d[0] == 0xff && d[1] == 0x51 && d[2] == 3)
+        {
+            const int microsecondsPerQuarterNote = (d[3] << 16) | (d[4] << 8) | d[5];
+            secondsPerTick = microsecondsPerQuarterNote * 0.000001 / timeFormat;
+        }
+    }
+    else
+    {
+        // SMPTE timing, where the upper byte is the negative of the frame rate
+        const int framesPerSecond = -(int) (signed char) (timeFormat >> 8);
+        const int ticksPerFrame = timeFormat & 0xff;
+
+        timeInSeconds = tick / (double) jmax (1, framesPerSecond * ticksPerFrame);
+    }
+
+    return true;
+}
+
+MidiMessage MidiFileReader::Iterator::getMessage() const
+{
+    jassert (current != nullptr); // you need to call next() before using the iterator!
+
+    return MidiMessage (current->getData(), current->getDataSize(), timeInSeconds);
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+#include "../../utilities/juce_UnitTest.h"
+#include "../../maths/juce_Random.h"
+#include "../../core/juce_Time.h"
+#include "../../io/streams/juce_MemoryInputStream.h"
+#include "../../io/streams/juce_MemoryOutputStream.h"
+#include "juce_MidiFile.h"
+
+class MidiFileReaderTests  : public UnitTest
+{
+public:
+    MidiFileReaderTests() : UnitTest ("MidiFileReader") {}
+
+    void runTest()
+    {
+        beginTest ("Same results as MidiFile");
+
+        MemoryOutputStream fileData;
+        writeTestFile (fileData, 4, 2000, 960);
+
+        MidiFile midiFile;
+        MemoryInputStream in (fileData.getData(), fileData.getDataSize(), false);
+        expect (midiFile.readFrom (in));
+
+        MidiFileReader reader (fileData.getData(), fileData.getDataSize());
+        expect (reader.isValid());
+        expectEquals (reader.getNumTracks(), midiFile.getNumTracks());
+        expectEquals ((int) reader.getTimeFormat(), (int) midiFile.getTimeFormat());
+
+        bool allMatched = true;
+
+        for (int track = 0; track < reader.getNumTracks(); ++track)
+        {
+            const MidiMessageSequence& seq = *midiFile.getTrack (track);
+            MidiFileReader::TrackCursor cursor (reader, track);
+            int index = 0;
+
+            while (cursor.next())
+            {
+                allMatched = allMatched && index < seq.getNumEvents()
+                               && matches (seq.getEventPointer (index)->message, cursor.getData(), cursor.getDataSize())
+                               && seq.getEventPointer (index)->message.getTimeStamp() == (double) cursor.getTick();
+                ++index;
+            }
+
+            allMatched = allMatched && index == seq.getNumEvents();
+        }
+
+        expect (allMatched);
+
+        // now check the merged stream against MidiFile's times in seconds..
+        midiFile.convertTimestampTicksToSeconds();
+
+        HeapBlock <int> nextIndex;
+        nextIndex.calloc ((size_t) reader.getNumTracks());
+        MidiFileReader::Iterator i (reader);
+        int64 lastTick = 0;
+        int numEvents = 0;
+        double maxTimeError = 0;
+
+        while (i.next())
+        {
+            const MidiMessage& m = midiFile.getTrack (i.getTrackIndex())->getEventPointer (nextIndex [i.getTrackIndex()]++)->message;
+
+            allMatched = allMatched && i.getTick() >= lastTick && matches (m, i.getData(), i.getDataSize());
+            maxTimeError = jmax (maxTimeError, std::abs (m.getTimeStamp() - i.getTimeInSeconds()));
+            lastTick = i.getTick();
+            ++numEvents;
+        }
+
+        int totalEvents = 0;
+        for (int track = 0; track < midiFile.getNumTracks(); ++track)
+            totalEvents += midiFile.getTrack (track)->getNumEvents();
+
+        expect (allMatched);
+        expectEquals (numEvents, totalEvents);
+        expect (maxTimeError < 1.0e-9, "time error: " + String (maxTimeError));
+
+        beginTest ("Running status and sysex");
+
+        const uint8 track[] = { 0x00, 0x90, 0x3c, 0x64,                         // note-on
+                                0x10, 0x3e, 0x64,                               // note-on, using running status
+                                0x00, 0xf0, 0x05, 0x7e, 0x7f, 0x09, 0x01, 0xf7, // sysex
+                                0x20, 0x80, 0x3c, 0x00,                         // note-off
+                                0x00, 0xff, 0x2f, 0x00 };                       // end of track
+        MemoryOutputStream handMade;
+        handMade.writeIntBigEndian ((int) ByteOrder::bigEndianInt ("MThd"));
+        handMade.writeIntBigEndian (6);
+        handMade.writeShortBigEndian (0);
+        handMade.writeShortBigEndian (1);
+        handMade.writeShortBigEndian (96);
+        handMade.writeIntBigEndian ((int) ByteOrder::bigEndianInt ("MTrk"));
+        handMade.writeIntBigEndian ((int) sizeof (track));
+        handMade.write (track, sizeof (track));
+
+        MidiFileReader handMadeReader (handMade.getData(), handMade.getDataSize());
+        MidiFileReader::TrackCursor c (handMadeReader, 0);
+
+        expect (c.next() && c.getMessage().isNoteOn() && c.getMessage().getNoteNumber() == 0x3c && c.getTick() == 0);
+        expect (c.next() && c.getMessage().isNoteOn() && c.getMessage().getNoteNumber() == 0x3e && c.getTick() == 0x10);
+        expect (c.next() && c.getMessage().isSysEx() && c.getMessage().getSysExDataSize() == 4
+                  && c.getMessage().getSysExData()[0] == 0x7e);
+        expect (c.next() && c.getMessage().isNoteOff() && c.getTick() == 0x30);
+        expect (c.next() && c.getMessage().isEndOfTrackMetaEvent());
+        expect (! c.next());
+
+        // a truncated file mustn't read past the end of its data
+        MidiFileReader truncated (handMade.getData(), handMade.getDataSize() - 6);
+        MidiFileReader::TrackCursor t (truncated, 0);
+        int numRead = 0;
+
+        while (t.next())
+            ++numRead;
+
+        expectEquals (numRead, 3); // the two note-ons and the sysex, but not the cut-off note-off
+
+        beginTest ("Speed");
+
+        MemoryOutputStream bigFile;
+        writeTestFile (bigFile, 16, 10000, 480);
+
+        double start = Time::getMillisecondCounterHiRes();
+        MidiFile loaded;
+        MemoryInputStream bigIn (bigFile.getData(), bigFile.getDataSize(), false);
+        loaded.readFrom (bigIn);
+        loaded.convertTimestampTicksToSeconds();
+        const double midiFileTime = Time::getMillisecondCounterHiRes() - start;
+
+        start = Time::getMillisecondCounterHiRes();
+        MidiFileReader bigReader (bigFile.getData(), bigFile.getDataSize());
+        MidiFileReader::Iterator bigIterator (bigReader);
+        double total = 0;
+
+        while (bigIterator.next())
+            total += bigIterator.getTimeInSeconds() + bigIterator.getDataSize();
+
+        const double readerTime = Time::getMillisecondCounterHiRes() - start;
+
+        expect (total > 0);
+        logMessage (String ((int) (bigFile.getDataSize() / 1024)) + "KB file: MidiFile " + String (midiFileTime, 2)
+                      + "ms, MidiFileReader::Iterator " + String (readerTime, 2) + "ms");
+    }
+
+    static bool matches (const MidiMessage& m, const uint8* const data, const int size)
+    {
+        return m.getRawDataSize() == size && memcmp (m.getRawData(), data, (size_t) size) == 0;
+    }
+
+    /* Writes a file with a tempo track and some tracks of notes and controllers. Each track
+       only has one event per tick, so that MidiFile won't need to re-order anything.
+    */
+    static void writeTestFile (OutputStream& out, const int numTracks, const int numEventsPerTrack, const int ticksPerQuarterNote)
+    {
+        MidiFile file;
+        file.setTicksPerQuarterNote (ticksPerQuarterNote);
+
+        MidiMessageSequence tempoTrack;
+        tempoTrack.addEvent (MidiMessage::tempoMetaEvent (500000), 0);
+        tempoTrack.addEvent (MidiMessage::timeSignatureMetaEvent (3, 4), 0);
+        tempoTrack.addEvent (MidiMessage::tempoMetaEvent (650000), ticksPerQuarterNote * 4.0);
+        tempoTrack.addEvent (MidiMessage::tempoMetaEvent (420000), ticksPerQuarterNote * 9.0 + 7.0);
+        file.addTrack (tempoTrack);
+
+        Random r (numTracks);
+
+        for (int track = 1; track < numTracks; ++track)
+        {
+            MidiMessageSequence seq;
+            double tick = 0;
+
+            for (int i = 0; i < numEventsPerTrack;)
+            {
+                const int channel = 1 + r.nextInt (16);
+
+                if (r.nextBool())
+                {
+                    const int note = r.nextInt (128);
+                    seq.addEvent (MidiMessage::noteOn (channel, note, (uint8) (1 + r.nextInt (127))), tick += 1 + r.nextInt (60));
+                    seq.addEvent (MidiMessage::noteOff (channel, note), tick += 1 + r.nextInt (60));
+                    i += 2;
+                }
+                else
+                {
+                    // a run of controllers on the same channel, which gets written with running status
+                    for (int j = 0; j < 8; ++j)
+                        seq.addEvent (MidiMessage::controllerEvent (channel, 7, r.nextInt (128)), tick += 1 + r.nextInt (10));
+
+                    i += 8;
+                }
+            }
+
+            file.addTrack (seq);
+        }
+
+        file.writeTo (out);
+    }
+};
+
+static MidiFileReaderTests midiFileReaderTests;
+
+#endif
+
+END_JUCE_NAMESPACE
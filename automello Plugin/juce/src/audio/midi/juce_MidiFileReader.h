@@ -0,0 +1,229 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+#ifndef __JUCE_MIDIFILEREADER_JUCEHEADER__
+#define __JUCE_MIDIFILEREADER_JUCEHEADER__
+
+#include "juce_MidiMessage.h"
+#include "../../containers/juce_Array.h"
+#include "../../containers/juce_OwnedArray.h"
+#include "../../io/files/juce_MemoryMappedFile.h"
+#include "../../memory/juce_HeapBlock.h"
+#include "../../memory/juce_MemoryBlock.h"
+#include "../../memory/juce_ScopedPointer.h"
+
+
+//==============================================================================
+/**
+    Reads the events from a standard midi file without loading it into MidiMessageSequences.
+
+    Unlike MidiFile, which parses everything into MidiMessage objects when it's loaded, this
+    just finds where the tracks begin. The events are decoded one at a time by a TrackCursor,
+    directly from the file's data, which is usually memory-mapped. To play back all the tracks
+    together, use an Iterator, which merges them into a single stream in time order, and keeps
+    track of the tempo so that it can tell you the time of each event in seconds.
+
+    Apart from the occasional sysex message, no memory is allocated while reading events, and
+    nothing is ever copied except for messages that use running status, so this is a good
+    way to feed large numbers of files to something like an offline renderer.
+    @code
+    MidiFileReader reader (File ("~/song.mid"));
+    MidiFileReader::Iterator i (reader);
+
+    while (i.next())
+        doSomething (i.getData(), i.getDataSize(), i.getTimeInSeconds());
+    @endcode
+
+    @see MidiFile
+*/
+class JUCE_API  MidiFileReader
+{
+public:
+    //==============================================================================
+    /** Memory-maps a file and reads its header.
+        Use isValid() to find out whether this succeeded.
+    */
+    explicit MidiFileReader (const File& file);
+
+    /** Reads a midi file that's already in memory.
+
+        The data isn't copied, so it must not be changed or deleted while this object or
+        any of its cursors or iterators still exist.
+    */
+    MidiFileReader (const void* midiFileData, size_t dataSize);
+
+    /** Destructor. */
+    ~MidiFileReader();
+
+    //==============================================================================
+    /** Returns true if the data was a valid midi file. */
+    bool isValid() const noexcept                       { return valid; }
+
+    /** Returns the number of tracks in the file. */
+    int getNumTracks() const noexcept                   { return tracks.size(); }
+
+    /** Returns the file's time format, in the same form as MidiFile::getTimeFormat(). */
+    short getTimeFormat() const noexcept                { return timeFormat; }
+
+    //==============================================================================
+    /**
+        Steps through the events in one of the tracks of a MidiFileReader.
+
+        The timestamps are the number of ticks since the start of the track.
+    */
+    class JUCE_API  TrackCursor
+    {
+    public:
+        /** Creates a cursor which is positioned before the first event of a track.
+            You'll need to call next() to read the first event.
+        */
+        TrackCursor (const MidiFileReader& reader, int trackIndex);
+
+        /** Destructor. */
+        ~TrackCursor();
+
+        /** Moves on to the next event.
+            @returns false if there are no more events in the track, or if the data is corrupt
+        */
+        bool next() noexcept;
+
+        /** Goes back to the start of the track. */
+        void rewind() noexcept;
+
+        /** Returns the current event's position, in ticks from the start of the track. */
+        int64 getTick() const noexcept                      { return tick; }
+
+        /** Returns the current event's raw midi data.
+
+            This usually points straight into the file, and is only valid until the cursor
+            is moved. The data is in the same form that a MidiMessage would hold it.
+        */
+        const uint8* getData() const noexcept               { return eventData; }
+
+        /** Returns the number of bytes in the current event. */
+        int getDataSize() const noexcept                    { return eventSize; }
+
+        /** Creates a MidiMessage for the current event, with its timestamp set to the tick. */
+        MidiMessage getMessage() const;
+
+        /** Returns the index of the track that this cursor is reading. */
+        int getTrackIndex() const noexcept                  { return trackIndex; }
+
+    private:
+        const uint8* trackStart;
+        const uint8* trackEnd;
+        const uint8* position;
+        const uint8* eventData;
+        int eventSize, trackIndex;
+        int64 tick;
+        uint8 runningStatus;
+        uint8 shortMessage [4];
+        MemoryBlock sysexData;
+
+        JUCE_DECLARE_NON_COPYABLE (TrackCursor);
+    };
+
+    //==============================================================================
+    /**
+        Merges all the tracks of a MidiFileReader into a single stream of events,
+        sorted by time.
+
+        Events that happen at the same time are returned with any note-offs first, then in
+        order of their track numbers.
+    */
+    class JUCE_API  Iterator
+    {
+    public:
+        /** Creates an iterator which is positioned before the first event in the file.
+            You'll need to call next() to read the first event.
+        */
+        explicit Iterator (const MidiFileReader& reader);
+
+        /** Destructor. */
+        ~Iterator();
+
+        /** Moves on to the next event.
+            @returns false if all the tracks have finished
+        */
+        bool next() noexcept;
+
+        /** Returns the current event's position in ticks. */
+        int64 getTick() const noexcept                      { return current->getTick(); }
+
+        /** Returns the current event's position in seconds, taking into account all the
+            tempo changes that have happened before it.
+        */
+        double getTimeInSeconds() const noexcept            { return timeInSeconds; }
+
+        /** Returns the current event's raw midi data - see TrackCursor::getData(). */
+        const uint8* getData() const noexcept               { return current->getData(); }
+
+        /** Returns the number of bytes in the current event. */
+        int getDataSize() const noexcept                    { return current->getDataSize(); }
+
+        /** Returns the index of the track that the current event came from. */
+        int getTrackIndex() const noexcept                  { return current->getTrackIndex(); }
+
+        /** Creates a MidiMessage for the current event, with its timestamp set to the time in seconds. */
+        MidiMessage getMessage() const;
+
+    private:
+        OwnedArray <TrackCursor> cursors;
+        HeapBlock <TrackCursor*> queue;
+        TrackCursor* current;
+        int queueSize;
+        const short timeFormat;
+        int64 lastTick;
+        double timeInSeconds, secondsPerTick;
+        bool needsToAdvance;
+
+        static bool comesBefore (const TrackCursor* a, const TrackCursor* b) noexcept;
+        void removeFromQueue() noexcept;
+        void sortDown (int index) noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE (Iterator);
+    };
+
+private:
+    //==============================================================================
+    struct TrackInfo
+    {
+        const uint8* data;
+        int size;
+    };
+
+    ScopedPointer <MemoryMappedFile> mappedFile;
+    Array <TrackInfo> tracks;
+    short timeFormat;
+    bool valid;
+
+    void parse (const uint8* data, size_t dataSize);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiFileReader);
+};
+
+
+#endif   // __JUCE_MIDIFILEREADER_JUCEHEADER__
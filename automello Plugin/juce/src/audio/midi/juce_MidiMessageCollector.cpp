@@ -34,6 +34,11 @@ BEGIN_JUCE_NAMESPACE
 //==============================================================================
 MidiMessageCollector::MidiMessageCollector()
     : lastCallbackTime (0),
+      messageFifo (maxQueuedMessages),
+      sysexFifo (sysexBufferSize),
+      messages ((size_t) maxQueuedMessages),
+      sysexData ((size_t) sysexBufferSize),
+      sysexScratch ((size_t) sysexBufferSize),
       sampleRate (44100.0001)
 {
 }
@@ -47,9 +52,11 @@ void MidiMessageCollector::reset (const double sampleRate_)
 {
     jassert (sampleRate_ > 0);
 
-    const ScopedLock sl (midiCallbackLock);
+    const SpinLock::ScopedLockType sl (writerLock);
     sampleRate = sampleRate_;
-    incomingMessages.clear();
+    messageFifo.reset();
+    sysexFifo.reset();
+    numDroppedMessages = 0;
     lastCallbackTime = Time::getMillisecondCounterHiRes();
 }
 
@@ -62,17 +69,58 @@ void MidiMessageCollector::addMessageToQueue (const MidiMessage& message)
     // for details of what the number should be.
     jassert (message.getTimeStamp() != 0);
 
-    const ScopedLock sl (midiCallbackLock);
+    const uint8* const data = message.getRawData();
+    const int numBytes = message.getRawDataSize();
 
-    const int sampleNumber
-        = (int) ((message.getTimeStamp() - 0.001 * lastCallbackTime) * sampleRate);
+    // (this lock only stops several writers from treading on each other - the
+    // audio thread never touches it)
+    const SpinLock::ScopedLockType sl (writerLock);
 
-    incomingMessages.addEvent (message, sampleNumber);
+    if (messageFifo.getFreeSpace() < 1
+         || (numBytes > maxInlineBytes && sysexFifo.getFreeSpace() < numBytes))
+    {
+        ++numDroppedMessages;
+        return;
+    }
+
+    int start1, size1, start2, size2;
+
+    if (numBytes > maxInlineBytes)
+    {
+        sysexFifo.prepareToWrite (numBytes, start1, size1, start2, size2);
+        memcpy (sysexData + start1, data, (size_t) size1);
+        memcpy (sysexData + start2, data + size1, (size_t) size2);
+        sysexFifo.finishedWrite (numBytes);
+    }
+
+    messageFifo.prepareToWrite (1, start1, size1, start2, size2);
+    jassert (size1 == 1);
+
+    QueuedMessage& m = messages [start1];
+    m.timeStamp = message.getTimeStamp();
+    m.numBytes = numBytes;
 
-    // if the messages don't get used for over a second, we'd better
-    // get rid of any old ones to avoid the queue getting too big
-    if (sampleNumber > sampleRate)
-        incomingMessages.clear (0, sampleNumber - (int) sampleRate);
+    if (numBytes <= maxInlineBytes)
+        memcpy (m.data, data, (size_t) numBytes);
+
+    messageFifo.finishedWrite (1);
+}
+
+const uint8* MidiMessageCollector::readMessageData (const QueuedMessage& m) noexcept
+{
+    if (m.numBytes <= maxInlineBytes)
+        return m.data;
+
+    // long messages are copied out of the fifo, as they may be split across its end
+    int start1, size1, start2, size2;
+    sysexFifo.prepareToRead (m.numBytes, start1, size1, start2, size2);
+    jassert (size1 + size2 == m.numBytes);
+
+    memcpy (sysexScratch, sysexData + start1, (size_t) size1);
+    memcpy (sysexScratch + size1, sysexData + start2, (size_t) size2);
+    sysexFifo.finishedRead (size1 + size2);
+
+    return sysexScratch;
 }
 
 void MidiMessageCollector::removeNextBlockOfMessages (MidiBuffer& destBuffer,
@@ -82,24 +130,20 @@ void MidiMessageCollector::removeNextBlockOfMessages (MidiBuffer& destBuffer,
     jassert (sampleRate != 44100.0001);
 
     const double timeNow = Time::getMillisecondCounterHiRes();
+    const double blockStartTime = 0.001 * lastCallbackTime;
     const double msElapsed = timeNow - lastCallbackTime;
-
-    const ScopedLock sl (midiCallbackLock);
     lastCallbackTime = timeNow;
 
-    if (! incomingMessages.isEmpty())
+    const int numReady = messageFifo.getNumReady();
+
+    if (numReady > 0)
     {
         int numSourceSamples = jmax (1, roundToInt (msElapsed * 0.001 * sampleRate));
-
         int startSample = 0;
-        int scale = 1 << 16;
-
-        const uint8* midiData;
-        int numBytes, samplePosition;
+        int scale = 1 << 10;
+        const bool squeezeEvents = numSourceSamples > numSamples;
 
-        MidiBuffer::Iterator iter (incomingMessages);
-
-        if (numSourceSamples > numSamples)
+        if (squeezeEvents)
         {
             // if our list of events is longer than the buffer we're being
             // asked for, scale them down to squeeze them all in..
@@ -109,33 +153,44 @@ void MidiMessageCollector::removeNextBlockOfMessages (MidiBuffer& destBuffer,
             {
                 startSample = numSourceSamples - maxBlockLengthToUse;
                 numSourceSamples = maxBlockLengthToUse;
-                iter.setNextSamplePosition (startSample);
             }
 
             scale = (numSamples << 10) / numSourceSamples;
-
-            while (iter.getNextEvent (midiData, numBytes, samplePosition))
-            {
-                samplePosition = ((samplePosition - startSample) * scale) >> 10;
-
-                destBuffer.addEvent (midiData, numBytes,
-                                     jlimit (0, numSamples - 1, samplePosition));
-            }
         }
         else
         {
             // if our event list is shorter than the number we need, put them
             // towards the end of the buffer
-            startSample = numSamples - numSourceSamples;
+            startSample = numSourceSamples - numSamples;
+        }
+
+        int start1, size1, start2, size2;
+        messageFifo.prepareToRead (numReady, start1, size1, start2, size2);
+
+        for (int i = 0; i < size1 + size2; ++i)
+        {
+            const QueuedMessage& m = messages [i < size1 ? start1 + i : start2 + i - size1];
+            const uint8* const midiData = readMessageData (m);
 
-            while (iter.getNextEvent (midiData, numBytes, samplePosition))
+            int samplePosition = (int) ((m.timeStamp - blockStartTime) * sampleRate);
+
+            if (squeezeEvents)
+            {
+                // any events from before the start of the squeezed-down section are dropped
+                if (samplePosition < startSample)
+                    continue;
+
+                samplePosition = ((samplePosition - startSample) * scale) >> 10;
+            }
+            else
             {
-                destBuffer.addEvent (midiData, numBytes,
-                                     jlimit (0, numSamples - 1, samplePosition + startSample));
+                samplePosition -= startSample;
             }
+
+            destBuffer.addEvent (midiData, m.numBytes, jlimit (0, numSamples - 1, samplePosition));
         }
 
-        incomingMessages.clear();
+        messageFifo.finishedRead (size1 + size2);
     }
 }
 
@@ -161,5 +216,128 @@ void MidiMessageCollector::handleIncomingMidiMessage (MidiInput*, const MidiMess
     addMessageToQueue (message);
 }
 
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+#include "../../utilities/juce_UnitTest.h"
+#include "../../threads/juce_Thread.h"
+
+class MidiMessageCollectorTests  : public UnitTest
+{
+public:
+    MidiMessageCollectorTests() : UnitTest ("MidiMessageCollector") {}
+
+    enum { numMessagesToSend = 20000 };
+
+    /* Floods the collector with numbered pitch-wheel messages, plus the occasional sysex
+       message, the way a busy midi input thread would.
+    */
+    class WriterThread  : public Thread
+    {
+    public:
+        WriterThread (MidiMessageCollector& collector_)
+            : Thread ("midi writer"), collector (collector_)
+        {
+        }
+
+        void run()
+        {
+            for (int i = 0; i < numMessagesToSend; ++i)
+            {
+                MidiMessage m (MidiMessage::pitchWheel (1 + i / 16384, i % 16384));
+
+                if (i % 100 == 0)
+                {
+                    uint8 sysex [200];
+
+                    for (int j = 0; j < numElementsInArray (sysex); ++j)
+                        sysex[j] = (uint8) ((i / 100 + j) & 0x7f);
+
+                    m = MidiMessage::createSysExMessage (sysex, numElementsInArray (sysex));
+                }
+
+                m.setTimeStamp (Time::getMillisecondCounterHiRes() * 0.001);
+                collector.addMessageToQueue (m);
+
+                if (i % 200 == 0)
+                    Thread::sleep (1);
+            }
+        }
+
+    private:
+        MidiMessageCollector& collector;
+    };
+
+    void runTest()
+    {
+        beginTest ("Messages arrive intact and in order");
+
+        MidiMessageCollector collector;
+        collector.reset (44100.0);
+
+        WriterThread writer (collector);
+        writer.startThread();
+
+        MidiBuffer buffer;
+        buffer.ensureSize (65536);
+
+        int numReceived = 0, lastIndex = -1;
+        bool allInOrder = true, sysexIntact = true;
+        double worstCallbackTime = 0;
+
+        for (;;)
+        {
+            const bool writerHasFinished = ! writer.isThreadRunning();
+            Thread::sleep (1);
+
+            buffer.clear();
+            const double start = Time::getMillisecondCounterHiRes();
+            collector.removeNextBlockOfMessages (buffer, 256);
+            worstCallbackTime = jmax (worstCallbackTime, Time::getMillisecondCounterHiRes() - start);
+
+            MidiBuffer::Iterator i (buffer);
+            MidiMessage m (0xf8);
+            int pos;
+
+            while (i.getNextEvent (m, pos))
+            {
+                ++numReceived;
+                allInOrder = allInOrder && pos >= 0 && pos < 256;
+
+                if (m.isSysEx())
+                {
+                    const uint8* const data = m.getSysExData();
+                    sysexIntact = sysexIntact && m.getSysExDataSize() == 200;
+
+                    for (int j = 1; j < m.getSysExDataSize(); ++j)
+                        sysexIntact = sysexIntact && data[j] == ((data[j - 1] + 1) & 0x7f);
+                }
+                else
+                {
+                    // messages can be dropped, but the ones that get through must be in order
+                    const int index = (m.getChannel() - 1) * 16384 + m.getPitchWheelValue();
+                    allInOrder = allInOrder && index > lastIndex;
+                    lastIndex = index;
+                }
+            }
+
+            if (writerHasFinished && buffer.isEmpty())
+                break;
+        }
+
+        writer.stopThread (1000);
+
+        expect (allInOrder);
+        expect (sysexIntact);
+        expectEquals (numReceived + collector.getNumDroppedMessages(), (int) numMessagesToSend);
+
+        logMessage ("received " + String (numReceived) + ", dropped " + String (collector.getNumDroppedMessages())
+                      + ", slowest removeNextBlockOfMessages(): " + String (worstCallbackTime, 3) + "ms");
+    }
+};
+
+static MidiMessageCollectorTests midiMessageCollectorTests;
+
+#endif
 
 END_JUCE_NAMESPACE
@@ -28,6 +28,10 @@
 
 #include "juce_MidiInput.h"
 #include "juce_MidiKeyboardState.h"
+#include "../../containers/juce_AbstractFifo.h"
+#include "../../memory/juce_Atomic.h"
+#include "../../memory/juce_HeapBlock.h"
+#include "../../threads/juce_SpinLock.h"
 
 
 //==============================================================================
@@ -38,6 +42,11 @@
     The class can also be used as either a MidiKeyboardStateListener or a MidiInputCallback
     so it can easily use a midi input or keyboard component as its source.
 
+    Incoming messages are stored in a lock-free FIFO along with their timestamps, and are
+    only converted into sample positions when the audio thread collects them, so the audio
+    thread never has to wait for a midi input thread. Messages that arrive while the FIFO
+    is full are dropped - getNumDroppedMessages() tells you whether this has happened.
+
     @see MidiMessage, MidiInput
 */
 class JUCE_API  MidiMessageCollector    : public MidiKeyboardStateListener,
@@ -55,7 +64,8 @@ public:
     /** Clears any messages from the queue.
 
         You need to call this method before starting to use the collector, so that
-        it knows the correct sample rate to use.
+        it knows the correct sample rate to use. It mustn't be called while another
+        thread is inside removeNextBlockOfMessages().
     */
     void reset (double sampleRate);
 
@@ -65,7 +75,8 @@ public:
         of the block returned by the next call to removeNextBlockOfMessages().
 
         This method is fully thread-safe when overlapping calls are made with
-        removeNextBlockOfMessages().
+        removeNextBlockOfMessages(), and never blocks the thread that's calling that.
+        If several threads call it at once, they'll briefly wait for each other.
     */
     void addMessageToQueue (const MidiMessage& message);
 
@@ -79,10 +90,19 @@ public:
         midi event positions.
 
         This method is fully thread-safe when overlapping calls are made with
-        addMessageToQueue().
+        addMessageToQueue(). It doesn't lock or allocate, although the destination
+        buffer may need to grow if it hasn't had enough space reserved with
+        MidiBuffer::ensureSize().
     */
     void removeNextBlockOfMessages (MidiBuffer& destBuffer, int numSamples);
 
+    /** Returns the number of messages that have been thrown away because they arrived
+        when the queue was full.
+
+        This is reset to zero by reset().
+    */
+    int getNumDroppedMessages() const noexcept          { return numDroppedMessages.get(); }
+
 
     //==============================================================================
     /** @internal */
@@ -94,11 +114,30 @@ public:
 
 private:
     //==============================================================================
+    enum
+    {
+        maxQueuedMessages = 2048,
+        sysexBufferSize = 65536,
+        maxInlineBytes = 20
+    };
+
+    struct QueuedMessage
+    {
+        double timeStamp;
+        int numBytes;
+        uint8 data [maxInlineBytes];    // longer messages go into sysexData instead
+    };
+
     double lastCallbackTime;
-    CriticalSection midiCallbackLock;
-    MidiBuffer incomingMessages;
+    SpinLock writerLock;
+    AbstractFifo messageFifo, sysexFifo;
+    HeapBlock <QueuedMessage> messages;
+    HeapBlock <uint8> sysexData, sysexScratch;
+    Atomic<int> numDroppedMessages;
     double sampleRate;
 
+    const uint8* readMessageData (const QueuedMessage& message) noexcept;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MidiMessageCollector);
 };
 
@@ -31,17 +31,69 @@ BEGIN_JUCE_NAMESPACE
 #include "../../containers/juce_Array.h"
 
 
+//==============================================================================
+namespace MidiMessageSequenceHelpers
+{
+    enum { minBlockSize = 32, maxBlockSize = 8192 };
+
+    struct SortEntry
+    {
+        double time;
+        MidiMessageSequence::MidiEventHolder* event;
+    };
+
+    // A stable merge sort on the timestamps, which are copied into a flat array first
+    // so that the comparisons don't have to chase pointers out to the event holders.
+    void sortEntries (SortEntry* entries, const int numEntries)
+    {
+        HeapBlock <SortEntry> scratch ((size_t) numEntries);
+        SortEntry* source = entries;
+        SortEntry* dest = scratch;
+
+        for (int runLength = 1; runLength < numEntries; runLength *= 2)
+        {
+            for (int start = 0; start < numEntries; start += 2 * runLength)
+            {
+                const int middle = jmin (start + runLength, numEntries);
+                const int end = jmin (start + 2 * runLength, numEntries);
+                int i = start, j = middle, k = start;
+
+                while (i < middle && j < end)
+                    dest[k++] = (source[j].time < source[i].time) ? source[j++] : source[i++];
+
+                while (i < middle)  dest[k++] = source[i++];
+                while (j < end)     dest[k++] = source[j++];
+            }
+
+            std::swap (source, dest);
+        }
+
+        if (source != entries)
+            memcpy (entries, source, sizeof (SortEntry) * (size_t) numEntries);
+    }
+}
+
 //==============================================================================
 MidiMessageSequence::MidiMessageSequence()
+    : numUsedInLastBlock (0), lastBlockSize (0)
 {
 }
 
 MidiMessageSequence::MidiMessageSequence (const MidiMessageSequence& other)
+    : numUsedInLastBlock (0), lastBlockSize (0)
 {
-    list.ensureStorageAllocated (other.list.size());
+    const int numEvents = other.list.size();
 
-    for (int i = 0; i < other.list.size(); ++i)
-        list.add (new MidiEventHolder (other.list.getUnchecked(i)->message));
+    if (numEvents > 0)
+    {
+        // put all the copies into a single block
+        lastBlockSize = jmax ((int) MidiMessageSequenceHelpers::minBlockSize, numEvents);
+        eventBlocks.add (new HeapBlock <MidiEventHolder> ((size_t) lastBlockSize));
+        list.ensureStorageAllocated (numEvents);
+
+        for (int i = 0; i < numEvents; ++i)
+            list.add (createEvent (other.list.getUnchecked(i)->message));
+    }
 }
 
 MidiMessageSequence& MidiMessageSequence::operator= (const MidiMessageSequence& other)
@@ -54,15 +106,60 @@ MidiMessageSequence& MidiMessageSequence::operator= (const MidiMessageSequence&
 void MidiMessageSequence::swapWith (MidiMessageSequence& other) noexcept
 {
     list.swapWithArray (other.list);
+    eventBlocks.swapWithArray (other.eventBlocks);
+    freeEvents.swapWithArray (other.freeEvents);
+    std::swap (numUsedInLastBlock, other.numUsedInLastBlock);
+    std::swap (lastBlockSize, other.lastBlockSize);
 }
 
 MidiMessageSequence::~MidiMessageSequence()
 {
+    deleteAllEvents();
 }
 
 void MidiMessageSequence::clear()
 {
+    deleteAllEvents();
     list.clear();
+    freeEvents.clear();
+    eventBlocks.clear();
+    numUsedInLastBlock = 0;
+    lastBlockSize = 0;
+}
+
+//==============================================================================
+MidiMessageSequence::MidiEventHolder* MidiMessageSequence::createEvent (const MidiMessage& message)
+{
+    MidiEventHolder* e = freeEvents.remove (freeEvents.size() - 1);
+
+    if (e == nullptr)
+    {
+        if (numUsedInLastBlock >= lastBlockSize)
+        {
+            lastBlockSize = jlimit ((int) MidiMessageSequenceHelpers::minBlockSize,
+                                    (int) MidiMessageSequenceHelpers::maxBlockSize,
+                                    lastBlockSize * 2);
+
+            eventBlocks.add (new HeapBlock <MidiEventHolder> ((size_t) lastBlockSize));
+            numUsedInLastBlock = 0;
+        }
+
+        e = eventBlocks.getLast()->getData() + numUsedInLastBlock++;
+    }
+
+    return new (e) MidiEventHolder (message);
+}
+
+void MidiMessageSequence::deleteEventObject (MidiEventHolder* const event)
+{
+    event->~MidiEventHolder();
+    freeEvents.add (event);
+}
+
+void MidiMessageSequence::deleteAllEvents()
+{
+    for (int i = list.size(); --i >= 0;)
+        list.getUnchecked(i)->~MidiEventHolder();
 }
 
 int MidiMessageSequence::getNumEvents() const
@@ -89,24 +186,48 @@ int MidiMessageSequence::getIndexOfMatchingKeyUp (const int index) const
 {
     const MidiEventHolder* const meh = list [index];
 
-    return meh != nullptr ? list.indexOf (meh->noteOffObject) : -1;
+    return meh != nullptr && meh->noteOffObject != nullptr ? getIndexOf (meh->noteOffObject) : -1;
 }
 
 int MidiMessageSequence::getIndexOf (MidiEventHolder* const event) const
 {
+    if (event != nullptr)
+    {
+        // look around where the event's timestamp says it should be first..
+        const double time = event->message.getTimeStamp();
+        const int numEvents = list.size();
+
+        for (int i = getNextIndexAtTime (time); i < numEvents; ++i)
+        {
+            const MidiEventHolder* const e = list.getUnchecked (i);
+
+            if (e == event)
+                return i;
+
+            if (e->message.getTimeStamp() > time)
+                break;
+        }
+    }
+
     return list.indexOf (event);
 }
 
 int MidiMessageSequence::getNextIndexAtTime (const double timeStamp) const
 {
-    const int numEvents = list.size();
+    int start = 0;
+    int end = list.size();
 
-    int i;
-    for (i = 0; i < numEvents; ++i)
-        if (list.getUnchecked(i)->message.getTimeStamp() >= timeStamp)
-            break;
+    while (start < end)
+    {
+        const int middle = (start + end) / 2;
+
+        if (list.getUnchecked (middle)->message.getTimeStamp() < timeStamp)
+            start = middle + 1;
+        else
+            end = middle;
+    }
 
-    return i;
+    return start;
 }
 
 //==============================================================================
@@ -138,7 +259,7 @@ double MidiMessageSequence::getEventTime (const int index) const
 void MidiMessageSequence::addEvent (const MidiMessage& newMessage,
                                     double timeAdjustment)
 {
-    MidiEventHolder* const newOne = new MidiEventHolder (newMessage);
+    MidiEventHolder* const newOne = createEvent (newMessage);
 
     timeAdjustment += newMessage.getTimeStamp();
     newOne->message.setTimeStamp (timeAdjustment);
@@ -159,7 +280,7 @@ void MidiMessageSequence::deleteEvent (const int index,
         if (deleteMatchingNoteUp)
             deleteEvent (getIndexOfMatchingKeyUp (index), false);
 
-        list.remove (index);
+        deleteEventObject (list.remove (index));
     }
 }
 
@@ -178,7 +299,7 @@ void MidiMessageSequence::addSequence (const MidiMessageSequence& other,
 
         if (t >= firstAllowableTime && t < endOfAllowableDestTimes)
         {
-            MidiEventHolder* const newOne = new MidiEventHolder (m);
+            MidiEventHolder* const newOne = createEvent (m);
             newOne->message.setTimeStamp (timeAdjustment + t);
 
             list.add (newOne);
@@ -200,45 +321,89 @@ int MidiMessageSequence::compareElements (const MidiMessageSequence::MidiEventHo
 
 void MidiMessageSequence::sort()
 {
-    list.sort (*this, true);
+    using namespace MidiMessageSequenceHelpers;
+
+    const int numEvents = list.size();
+    MidiEventHolder** const events = list.getRawDataPointer();
+    HeapBlock <SortEntry> entries ((size_t) numEvents);
+    bool isSorted = true;
+
+    for (int i = 0; i < numEvents; ++i)
+    {
+        entries[i].time = events[i]->message.getTimeStamp();
+        entries[i].event = events[i];
+
+        if (i > 0 && entries[i].time < entries[i - 1].time)
+            isSorted = false;
+    }
+
+    if (! isSorted)
+    {
+        sortEntries (entries, numEvents);
+
+        for (int i = 0; i < numEvents; ++i)
+            events[i] = entries[i].event;
+    }
 }
 
 //==============================================================================
 void MidiMessageSequence::updateMatchedPairs()
 {
-    for (int i = 0; i < list.size(); ++i)
+    // for each channel and note, the note-on that's still waiting for its note-off
+    HeapBlock <MidiEventHolder*> unmatchedNoteOns;
+    unmatchedNoteOns.calloc (16 * 128);
+
+    Array <MidiEventHolder*> newList;
+    bool needsNewList = false;
+    const int numEvents = list.size();
+
+    for (int i = 0; i < numEvents; ++i)
     {
-        const MidiMessage& m1 = list.getUnchecked(i)->message;
+        MidiEventHolder* const meh = list.getUnchecked(i);
+        const MidiMessage& m = meh->message;
 
-        if (m1.isNoteOn())
+        if (m.isNoteOn())
         {
-            list.getUnchecked(i)->noteOffObject = nullptr;
-            const int note = m1.getNoteNumber();
-            const int chan = m1.getChannel();
-            const int len = list.size();
+            const int chan = m.getChannel();
+            const int note = m.getNoteNumber();
+            MidiEventHolder*& unmatched = unmatchedNoteOns [(chan - 1) * 128 + note];
 
-            for (int j = i + 1; j < len; ++j)
+            if (unmatched != nullptr)
             {
-                const MidiMessage& m = list.getUnchecked(j)->message;
-
-                if (m.getNoteNumber() == note && m.getChannel() == chan)
+                // a note-on that's still playing needs a note-off before the next one starts..
+                if (! needsNewList)
                 {
-                    if (m.isNoteOff())
-                    {
-                        list.getUnchecked(i)->noteOffObject = list[j];
-                        break;
-                    }
-                    else if (m.isNoteOn())
-                    {
-                        list.insert (j, new MidiEventHolder (MidiMessage::noteOff (chan, note)));
-                        list.getUnchecked(j)->message.setTimeStamp (m.getTimeStamp());
-                        list.getUnchecked(i)->noteOffObject = list[j];
-                        break;
-                    }
+                    needsNewList = true;
+                    newList.ensureStorageAllocated (numEvents + 16);
+                    newList.addArray (list, 0, i);
                 }
+
+                MidiEventHolder* const noteOff = createEvent (MidiMessage::noteOff (chan, note));
+                noteOff->message.setTimeStamp (m.getTimeStamp());
+                unmatched->noteOffObject = noteOff;
+                newList.add (noteOff);
             }
+
+            meh->noteOffObject = nullptr;
+            unmatched = meh;
         }
+        else if (m.isNoteOff())
+        {
+            MidiEventHolder*& unmatched = unmatchedNoteOns [(m.getChannel() - 1) * 128 + m.getNoteNumber()];
+
+            if (unmatched != nullptr)
+            {
+                unmatched->noteOffObject = meh;
+                unmatched = nullptr;
+            }
+        }
+
+        if (needsNewList)
+            newList.add (meh);
     }
+
+    if (needsNewList)
+        list.swapWithArray (newList);
 }
 
 void MidiMessageSequence::addTimeToMessages (const double delta)
@@ -278,16 +443,36 @@ void MidiMessageSequence::extractSysExMessages (MidiMessageSequence& destSequenc
 
 void MidiMessageSequence::deleteMidiChannelMessages (const int channelNumberToRemove)
 {
-    for (int i = list.size(); --i >= 0;)
-        if (list.getUnchecked(i)->message.isForChannel (channelNumberToRemove))
-            list.remove(i);
+    int numKept = 0;
+
+    for (int i = 0; i < list.size(); ++i)
+    {
+        MidiEventHolder* const meh = list.getUnchecked(i);
+
+        if (meh->message.isForChannel (channelNumberToRemove))
+            deleteEventObject (meh);
+        else
+            list.getReference (numKept++) = meh;
+    }
+
+    list.removeRange (numKept, list.size() - numKept);
 }
 
 void MidiMessageSequence::deleteSysExMessages()
 {
-    for (int i = list.size(); --i >= 0;)
-        if (list.getUnchecked(i)->message.isSysEx())
-            list.remove(i);
+    int numKept = 0;
+
+    for (int i = 0; i < list.size(); ++i)
+    {
+        MidiEventHolder* const meh = list.getUnchecked(i);
+
+        if (meh->message.isSysEx())
+            deleteEventObject (meh);
+        else
+            list.getReference (numKept++) = meh;
+    }
+
+    list.removeRange (numKept, list.size() - numKept);
 }
 
 //==============================================================================
@@ -347,4 +532,198 @@ MidiMessageSequence::MidiEventHolder::~MidiEventHolder()
 {
 }
 
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+#include "../../utilities/juce_UnitTest.h"
+#include "../../maths/juce_Random.h"
+#include "../../core/juce_Time.h"
+
+class MidiMessageSequenceTests  : public UnitTest
+{
+public:
+    MidiMessageSequenceTests() : UnitTest ("MidiMessageSequence") {}
+
+    void runTest()
+    {
+        beginTest ("Matched pairs");
+
+        Random r (123);
+
+        for (int iteration = 0; iteration < 20; ++iteration)
+        {
+            MidiMessageSequence seq;
+            OwnedArray <ReferenceEvent> reference;
+            double time = 0;
+
+            for (int i = 0; i < 3000; ++i)
+            {
+                const int channel = 1 + r.nextInt (2);
+                const int note = 60 + r.nextInt (4);
+                MidiMessage m (r.nextInt (3) == 0 ? MidiMessage::noteOff (channel, note)
+                                                  : (r.nextBool() ? MidiMessage::noteOn (channel, note, (uint8) r.nextInt (128))
+                                                                  : MidiMessage::controllerEvent (channel, note, 1)));
+                m.setTimeStamp (time += r.nextInt (3));
+
+                seq.addEvent (m);
+                reference.add (new ReferenceEvent (m));
+            }
+
+            seq.updateMatchedPairs();
+            updateReferencePairs (reference);
+
+            bool matches = seq.getNumEvents() == reference.size();
+
+            for (int i = 0; matches && i < reference.size(); ++i)
+            {
+                const MidiMessage& m = seq.getEventPointer (i)->message;
+                const MidiMessage& ref = reference.getUnchecked(i)->message;
+
+                matches = m.getRawDataSize() == ref.getRawDataSize()
+                           && memcmp (m.getRawData(), ref.getRawData(), (size_t) m.getRawDataSize()) == 0
+                           && m.getTimeStamp() == ref.getTimeStamp()
+                           && (m.isNoteOn() ? seq.getIndexOfMatchingKeyUp (i) == reference.indexOf (reference.getUnchecked(i)->noteOffObject)
+                                            : true);
+            }
+
+            expect (matches);
+        }
+
+        beginTest ("Sorting and editing");
+
+        {
+            MidiMessageSequence a, b;
+
+            for (int i = 0; i < 100; ++i)
+            {
+                a.addEvent (MidiMessage::controllerEvent (1, 1, i % 128), i * 2.0);
+                b.addEvent (MidiMessage::controllerEvent (2, 1, i % 128), 99 - i);
+            }
+
+            a.addSequence (b, 0.0, 0.0, 1000.0);
+            expectEquals (a.getNumEvents(), 200);
+
+            bool isSorted = true, isStable = true;
+
+            for (int i = 1; i < a.getNumEvents(); ++i)
+            {
+                const MidiMessage& m1 = a.getEventPointer (i - 1)->message;
+                const MidiMessage& m2 = a.getEventPointer (i)->message;
+
+                isSorted = isSorted && m1.getTimeStamp() <= m2.getTimeStamp();
+
+                // events from the original sequence must stay in front of ones that are added at the same time
+                isStable = isStable && ! (m1.getTimeStamp() == m2.getTimeStamp() && m1.getChannel() == 2 && m2.getChannel() == 1);
+            }
+
+            expect (isSorted);
+            expect (isStable);
+            expectEquals (a.getNextIndexAtTime (50.0), 75);
+            expectEquals (a.getNextIndexAtTime (50.5), 77);
+            expectEquals (a.getNextIndexAtTime (1000.0), 200);
+
+            a.deleteMidiChannelMessages (2);
+            expectEquals (a.getNumEvents(), 100);
+            expectEquals (a.getNextIndexAtTime (50.0), 25);
+
+            MidiMessageSequence copy (a);
+            a.clear();
+            expectEquals (copy.getNumEvents(), 100);
+            expectEquals (copy.getEndTime(), 198.0);
+
+            for (int i = 0; i < 200; ++i)
+                copy.addEvent (MidiMessage::noteOn (1, 64, (uint8) 100), 10.0 * i);
+
+            for (int i = copy.getNumEvents(); --i >= 0;)
+                if (copy.getEventPointer (i)->message.isNoteOn())
+                    copy.deleteEvent (i, false);
+
+            expectEquals (copy.getNumEvents(), 100);
+        }
+
+        beginTest ("Speed");
+
+        {
+            const int numEvents = 1000000;
+            MidiMessageSequence seq;
+
+            double start = Time::getMillisecondCounterHiRes();
+
+            for (int i = 0; i < numEvents / 2; ++i)
+            {
+                const int note = r.nextInt (128);
+                seq.addEvent (MidiMessage::noteOn (1 + (i & 15), note, (uint8) 100), i * 10.0);
+                seq.addEvent (MidiMessage::noteOff (1 + (i & 15), note), i * 10.0 + 1 + r.nextInt (200));
+            }
+
+            const double addTime = Time::getMillisecondCounterHiRes() - start;
+            start = Time::getMillisecondCounterHiRes();
+
+            seq.updateMatchedPairs();
+
+            const double matchTime = Time::getMillisecondCounterHiRes() - start;
+            start = Time::getMillisecondCounterHiRes();
+
+            MidiMessageSequence other (seq);
+            seq.addSequence (other, 5.0, 0.0, numEvents * 100.0);
+
+            const double mergeTime = Time::getMillisecondCounterHiRes() - start;
+
+            expectEquals (seq.getNumEvents(), other.getNumEvents() * 2);
+
+            logMessage (String (numEvents) + " events: adding " + String (addTime, 1) + "ms, matching pairs "
+                          + String (matchTime, 1) + "ms, merging a copy " + String (mergeTime, 1) + "ms");
+        }
+    }
+
+private:
+    struct ReferenceEvent
+    {
+        ReferenceEvent (const MidiMessage& m) : message (m), noteOffObject (nullptr) {}
+
+        MidiMessage message;
+        ReferenceEvent* noteOffObject;
+    };
+
+    // the original quadratic algorithm, to check the new one against
+    static void updateReferencePairs (OwnedArray <ReferenceEvent>& list)
+    {
+        for (int i = 0; i < list.size(); ++i)
+        {
+            const MidiMessage& m1 = list.getUnchecked(i)->message;
+
+            if (m1.isNoteOn())
+            {
+                list.getUnchecked(i)->noteOffObject = nullptr;
+                const int note = m1.getNoteNumber();
+                const int chan = m1.getChannel();
+
+                for (int j = i + 1; j < list.size(); ++j)
+                {
+                    const MidiMessage& m = list.getUnchecked(j)->message;
+
+                    if (m.getNoteNumber() == note && m.getChannel() == chan)
+                    {
+                        if (m.isNoteOff())
+                        {
+                            list.getUnchecked(i)->noteOffObject = list[j];
+                            break;
+                        }
+                        else if (m.isNoteOn())
+                        {
+                            list.insert (j, new ReferenceEvent (MidiMessage (MidiMessage::noteOff (chan, note), m.getTimeStamp())));
+                            list.getUnchecked(i)->noteOffObject = list[j];
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+};
+
+static MidiMessageSequenceTests midiMessageSequenceTests;
+
+#endif
+
 END_JUCE_NAMESPACE
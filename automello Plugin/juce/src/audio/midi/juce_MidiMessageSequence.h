@@ -28,6 +28,7 @@
 
 #include "juce_MidiMessage.h"
 #include "../../containers/juce_OwnedArray.h"
+#include "../../memory/juce_HeapBlock.h"
 
 
 //==============================================================================
@@ -61,6 +62,10 @@ public:
         These structures act as 'handles' on the events as they are moved about in
         the list, and make it quick to find the matching note-offs for note-on events.
 
+        The sequence allocates its holders in large blocks rather than individually,
+        so a pointer to one stays valid until that event is deleted or the sequence
+        is cleared.
+
         @see MidiMessageSequence::getEventPointer
     */
     class MidiEventHolder
@@ -123,7 +128,8 @@ public:
     /** Returns the index of the first event on or after the given timestamp.
 
         If the time is beyond the end of the sequence, this will return the
-        number of events.
+        number of events. This does a binary search, so it relies on the sequence
+        being sorted.
     */
     int getNextIndexAtTime (double timeStamp) const;
 
@@ -197,6 +203,9 @@ public:
         Call this after moving messages about or deleting/adding messages, and it
         will scan the list and make sure all the note-offs in the MidiEventHolder
         structures are pointing at the correct ones.
+
+        If a note-on is followed by another note-on for the same note and channel
+        before any note-off, a note-off is inserted just before the second one.
     */
     void updateMatchedPairs();
 
@@ -273,8 +282,14 @@ public:
 private:
     //==============================================================================
     friend class MidiFile;
-    OwnedArray <MidiEventHolder> list;
-
+    Array <MidiEventHolder*> list;
+    OwnedArray <HeapBlock <MidiEventHolder> > eventBlocks;
+    Array <MidiEventHolder*> freeEvents;
+    int numUsedInLastBlock, lastBlockSize;
+
+    MidiEventHolder* createEvent (const MidiMessage& message);
+    void deleteEventObject (MidiEventHolder* event);
+    void deleteAllEvents();
     void sort();
 
     JUCE_LEAK_DETECTOR (MidiMessageSequence);
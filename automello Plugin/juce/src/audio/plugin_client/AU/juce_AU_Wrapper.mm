@@ -764,6 +764,7 @@ public:
                 }
                 else
                 {
+                    const ScopedAudioThreadAllocationCheck allocationCheck;
                     juceFilter->processBlock (buffer, midiEvents);
                 }
             }
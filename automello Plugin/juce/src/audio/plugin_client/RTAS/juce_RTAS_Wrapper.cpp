@@ -595,6 +595,7 @@ protected:
 
                 AudioSampleBuffer chans (channels, totalChans, numSamples);
 
+                const ScopedAudioThreadAllocationCheck allocationCheck;
                 juceFilter->processBlock (chans, midiEvents);
             }
         }
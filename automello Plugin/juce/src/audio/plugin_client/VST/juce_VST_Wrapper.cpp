@@ -313,6 +313,7 @@ public:
          hasShutdown (false),
          firstProcessCallback (true),
          shouldDeleteEditor (false),
+         tempChannels (1, 1),
          hostWindow (0)
     {
         filter->setPlayConfigDetails (numInChans, numOutChans, 0, 0);
@@ -365,7 +366,7 @@ public:
             jassert (editorComp == 0);
 
             channels.free();
-            deleteTempChannels();
+            tempChannels.setSize (1, 1);
 
             jassert (activePlugins.contains (this));
             activePlugins.removeValue (this);
@@ -556,6 +557,7 @@ public:
 
         {
             const ScopedLock sl (filter->getCallbackLock());
+            const ScopedAudioThreadAllocationCheck allocationCheck;
 
             const int numIn = numInChans;
             const int numOut = numOutChans;
@@ -567,26 +569,28 @@ public:
             }
             else
             {
+                // (the temp channels are allocated in resume(), but this catches any
+                // hosts that go over the block size that they told us about)
+                jassert (numSamples <= tempChannels.getNumSamples() && numOut <= tempChannels.getNumChannels());
+
+                if (numSamples > tempChannels.getNumSamples() || numOut > tempChannels.getNumChannels())
+                    tempChannels.setSize (jmax (numOut, tempChannels.getNumChannels()),
+                                          jmax ((int) numSamples, tempChannels.getNumSamples()));
+
                 int i;
                 for (i = 0; i < numOut; ++i)
                 {
-                    float* chan = tempChannels.getUnchecked(i);
+                    float* chan = outputs[i];
 
-                    if (chan == 0)
+                    // if some output channels are disabled, some hosts supply the same buffer
+                    // for multiple channels - this buggers up our method of copying the
+                    // inputs over the outputs, so we need to use unique temp buffers in this case..
+                    for (int j = i; --j >= 0;)
                     {
-                        chan = outputs[i];
-
-                        // if some output channels are disabled, some hosts supply the same buffer
-                        // for multiple channels - this buggers up our method of copying the
-                        // inputs over the outputs, so we need to create unique temp buffers in this case..
-                        for (int j = i; --j >= 0;)
+                        if (outputs[j] == chan)
                         {
-                            if (outputs[j] == chan)
-                            {
-                                chan = new float [blockSize * 2];
-                                tempChannels.set (i, chan);
-                                break;
-                            }
+                            chan = tempChannels.getSampleData (i);
+                            break;
                         }
                     }
 
@@ -671,7 +675,7 @@ public:
             filter->setNonRealtime (getCurrentProcessLevel() == 4 /* kVstProcessLevelOffline */);
             filter->setPlayConfigDetails (numInChans, numOutChans, rate, blockSize);
 
-            deleteTempChannels();
+            tempChannels.setSize (jmax (1, numOutChans), blockSize * 2);
 
             filter->prepareToPlay (rate, blockSize);
 
@@ -704,7 +708,7 @@ public:
             isProcessing = false;
             channels.free();
 
-            deleteTempChannels();
+            tempChannels.setSize (1, 1);
         }
     }
 
@@ -1360,7 +1364,7 @@ private:
     int numInChans, numOutChans;
     bool isProcessing, hasShutdown, firstProcessCallback, shouldDeleteEditor;
     HeapBlock<float*> channels;
-    Array<float*> tempChannels;  // see note in processReplacing()
+    AudioSampleBuffer tempChannels;  // see note in processReplacing()
 
    #if JUCE_MAC
     void* hostWindow;
@@ -1405,18 +1409,6 @@ private:
     static void checkWhetherMessageThreadIsCorrect() {}
    #endif
 
-    //==============================================================================
-    void deleteTempChannels()
-    {
-        for (int i = tempChannels.size(); --i >= 0;)
-            delete[] (tempChannels.getUnchecked(i));
-
-        tempChannels.clear();
-
-        if (filter != nullptr)
-            tempChannels.insertMultiple (0, 0, filter->getNumInputChannels() + filter->getNumOutputChannels());
-    }
-
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (JuceVSTWrapper);
 };
 
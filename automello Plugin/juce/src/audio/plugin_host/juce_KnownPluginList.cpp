@@ -29,6 +29,8 @@ BEGIN_JUCE_NAMESPACE
 
 #include "juce_KnownPluginList.h"
 #include "juce_AudioPluginFormatManager.h"
+#include "../../io/streams/juce_MemoryInputStream.h"
+#include "../../io/streams/juce_MemoryOutputStream.h"
 
 
 //==============================================================================
@@ -38,6 +40,7 @@ KnownPluginList::KnownPluginList()
 
 KnownPluginList::~KnownPluginList()
 {
+    saveScanCacheIfNeeded();
 }
 
 void KnownPluginList::clear()
@@ -109,6 +112,274 @@ namespace
     }
 }
 
+//==============================================================================
+class KnownPluginList::ScanCache
+{
+public:
+    ScanCache (const File& file_)
+        : file (file_), needsSaving (false)
+    {
+        load();
+    }
+
+    // Finds the types that were in this file when it was last scanned, or returns
+    // false if it's not in the cache, or has changed since then.
+    bool findTypes (const String& formatName, const String& fileOrIdentifier,
+                    OwnedArray <PluginDescription>& results) const
+    {
+        const Entry* const e = findEntry (formatName, fileOrIdentifier);
+        int64 size, modTime;
+
+        if (e == nullptr
+             || ! getFileDetails (fileOrIdentifier, size, modTime)
+             || e->size != size || e->modTime != modTime)
+            return false;
+
+        for (int i = 0; i < e->types.size(); ++i)
+            results.add (new PluginDescription (*e->types.getUnchecked(i)));
+
+        return true;
+    }
+
+    void storeTypes (const String& formatName, const String& fileOrIdentifier,
+                     const OwnedArray <PluginDescription>& types)
+    {
+        int64 size, modTime;
+
+        if (! getFileDetails (fileOrIdentifier, size, modTime))
+            return;
+
+        Entry* e = findEntry (formatName, fileOrIdentifier);
+
+        if (e == nullptr)
+        {
+            e = new Entry();
+            e->formatName = formatName;
+            e->fileOrIdentifier = fileOrIdentifier;
+            entries.add (e);
+        }
+
+        e->size = size;
+        e->modTime = modTime;
+        e->types.clear();
+
+        for (int i = 0; i < types.size(); ++i)
+            e->types.add (new PluginDescription (*types.getUnchecked(i)));
+
+        needsSaving = true;
+    }
+
+    bool saveIfNeeded()
+    {
+        if (! needsSaving)
+            return true;
+
+        // Forget about any files that have been deleted since they were scanned..
+        for (int i = entries.size(); --i >= 0;)
+            if (! File (entries.getUnchecked(i)->fileOrIdentifier).exists())
+                entries.remove (i);
+
+        MemoryOutputStream out;
+        out.writeInt (fileMagicNumber);
+        out.writeInt (fileVersion);
+        out.writeCompressedInt (entries.size());
+
+        for (int i = 0; i < entries.size(); ++i)
+        {
+            const Entry* const e = entries.getUnchecked(i);
+
+            out.writeString (e->formatName);
+            out.writeString (e->fileOrIdentifier);
+            out.writeInt64 (e->size);
+            out.writeInt64 (e->modTime);
+            out.writeCompressedInt (e->types.size());
+
+            for (int j = 0; j < e->types.size(); ++j)
+                writeDescription (out, *e->types.getUnchecked(j));
+        }
+
+        out.writeInt (fileMagicNumber);
+
+        if (! file.replaceWithData (out.getData(), out.getDataSize()))
+            return false;
+
+        needsSaving = false;
+        return true;
+    }
+
+    const File file;
+
+private:
+    //==============================================================================
+    struct Entry
+    {
+        String formatName, fileOrIdentifier;
+        int64 size, modTime;
+        OwnedArray <PluginDescription> types;
+    };
+
+    OwnedArray <Entry> entries;
+    bool needsSaving;
+
+    enum { fileMagicNumber = 0x4a504c43, fileVersion = 1 };
+
+    Entry* findEntry (const String& formatName, const String& fileOrIdentifier) const
+    {
+        for (int i = entries.size(); --i >= 0;)
+        {
+            Entry* const e = entries.getUnchecked(i);
+
+            if (e->fileOrIdentifier == fileOrIdentifier && e->formatName == formatName)
+                return e;
+        }
+
+        return nullptr;
+    }
+
+    static bool getFileDetails (const String& fileOrIdentifier, int64& size, int64& modTime)
+    {
+        const Time t (getPluginFileModTime (fileOrIdentifier));
+
+        if (t == Time())
+            return false;
+
+        size = File (fileOrIdentifier).getSize();
+        modTime = t.toMilliseconds();
+        return true;
+    }
+
+    static void writeDescription (OutputStream& out, const PluginDescription& d)
+    {
+        out.writeString (d.name);
+        out.writeString (d.descriptiveName);
+        out.writeString (d.pluginFormatName);
+        out.writeString (d.category);
+        out.writeString (d.manufacturerName);
+        out.writeString (d.version);
+        out.writeString (d.fileOrIdentifier);
+        out.writeInt64 (d.lastFileModTime.toMilliseconds());
+        out.writeInt (d.uid);
+        out.writeBool (d.isInstrument);
+        out.writeCompressedInt (d.numInputChannels);
+        out.writeCompressedInt (d.numOutputChannels);
+    }
+
+    static void readDescription (InputStream& in, PluginDescription& d)
+    {
+        d.name = in.readString();
+        d.descriptiveName = in.readString();
+        d.pluginFormatName = in.readString();
+        d.category = in.readString();
+        d.manufacturerName = in.readString();
+        d.version = in.readString();
+        d.fileOrIdentifier = in.readString();
+        d.lastFileModTime = Time (in.readInt64());
+        d.uid = in.readInt();
+        d.isInstrument = in.readBool();
+        d.numInputChannels = in.readCompressedInt();
+        d.numOutputChannels = in.readCompressedInt();
+    }
+
+    void load()
+    {
+        MemoryBlock data;
+
+        if (! file.loadFileAsData (data))
+            return;
+
+        MemoryInputStream in (data, false);
+
+        if (in.readInt() != fileMagicNumber || in.readInt() != fileVersion)
+            return;
+
+        OwnedArray <Entry> loaded;
+
+        for (int numEntries = in.readCompressedInt(); --numEntries >= 0 && ! in.isExhausted();)
+        {
+            Entry* const e = new Entry();
+            loaded.add (e);
+
+            e->formatName = in.readString();
+            e->fileOrIdentifier = in.readString();
+            e->size = in.readInt64();
+            e->modTime = in.readInt64();
+
+            for (int numTypes = in.readCompressedInt(); --numTypes >= 0 && ! in.isExhausted();)
+            {
+                PluginDescription* const d = new PluginDescription();
+                e->types.add (d);
+                readDescription (in, *d);
+            }
+        }
+
+        // (the file ends with another copy of the magic number, so if it's been
+        // truncated, none of it gets used)
+        if (in.readInt() == fileMagicNumber)
+            entries.swapWithArray (loaded);
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (ScanCache);
+};
+
+void KnownPluginList::setScanCacheFile (const File& cacheFile)
+{
+    if (scanCache != nullptr)
+    {
+        if (scanCache->file == cacheFile)
+            return;
+
+        saveScanCacheIfNeeded();
+    }
+
+    scanCache = cacheFile != File::nonexistent ? new ScanCache (cacheFile) : nullptr;
+}
+
+bool KnownPluginList::saveScanCacheIfNeeded()
+{
+    return scanCache == nullptr || scanCache->saveIfNeeded();
+}
+
+bool KnownPluginList::addTypesFromScanCache (const String& fileOrIdentifier, AudioPluginFormat& format,
+                                             OwnedArray <PluginDescription>& typesFound)
+{
+    OwnedArray <PluginDescription> found;
+
+    if (scanCache == nullptr || ! scanCache->findTypes (format.getName(), fileOrIdentifier, found))
+        return false;
+
+    for (int i = 0; i < found.size(); ++i)
+    {
+        addType (*found.getUnchecked(i));
+        typesFound.add (found.getUnchecked(i));
+    }
+
+    found.clear (false);
+    return true;
+}
+
+bool KnownPluginList::addScannedTypes (const String& fileOrIdentifier, AudioPluginFormat& format,
+                                       const OwnedArray <PluginDescription>& found,
+                                       OwnedArray <PluginDescription>& typesFound)
+{
+    bool addedOne = false;
+
+    for (int i = 0; i < found.size(); ++i)
+    {
+        PluginDescription* const desc = found.getUnchecked(i);
+        jassert (desc != nullptr);
+
+        if (addType (*desc))
+            addedOne = true;
+
+        typesFound.add (new PluginDescription (*desc));
+    }
+
+    if (scanCache != nullptr)
+        scanCache->storeTypes (format.getName(), fileOrIdentifier, found);
+
+    return addedOne;
+}
+
 bool KnownPluginList::isListingUpToDate (const String& fileOrIdentifier) const
 {
     if (getTypeForFile (fileOrIdentifier) == 0)
@@ -133,8 +404,6 @@ bool KnownPluginList::scanAndAddFile (const String& fileOrIdentifier,
                                       OwnedArray <PluginDescription>& typesFound,
                                       AudioPluginFormat& format)
 {
-    bool addedOne = false;
-
     if (dontRescanIfAlreadyInList
          && getTypeForFile (fileOrIdentifier) != nullptr)
     {
@@ -157,21 +426,18 @@ bool KnownPluginList::scanAndAddFile (const String& fileOrIdentifier,
             return false;
     }
 
-    OwnedArray <PluginDescription> found;
-    format.findAllTypesForFile (found, fileOrIdentifier);
-
-    for (int i = 0; i < found.size(); ++i)
+    if (dontRescanIfAlreadyInList)
     {
-        PluginDescription* const desc = found.getUnchecked(i);
-        jassert (desc != nullptr);
+        const int numTypesBefore = types.size();
 
-        if (addType (*desc))
-            addedOne = true;
-
-        typesFound.add (new PluginDescription (*desc));
+        if (addTypesFromScanCache (fileOrIdentifier, format, typesFound))
+            return types.size() > numTypesBefore;
     }
 
-    return addedOne;
+    OwnedArray <PluginDescription> found;
+    format.findAllTypesForFile (found, fileOrIdentifier);
+
+    return addScannedTypes (fileOrIdentifier, format, found, typesFound);
 }
 
 void KnownPluginList::scanAndAddDragAndDroppedFiles (const StringArray& files,
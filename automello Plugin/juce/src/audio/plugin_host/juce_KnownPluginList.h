@@ -30,6 +30,7 @@
 #include "juce_AudioPluginFormat.h"
 #include "../../events/juce_ChangeBroadcaster.h"
 #include "../../gui/components/menus/juce_PopupMenu.h"
+#include "../../memory/juce_ScopedPointer.h"
 
 
 //==============================================================================
@@ -112,6 +113,40 @@ public:
     void scanAndAddDragAndDroppedFiles (const StringArray& filenames,
                                         OwnedArray <PluginDescription>& typesFound);
 
+    //==============================================================================
+    /** Gives the list a file in which to remember what it found in each plugin file
+        that it has scanned.
+
+        Each file's entry is keyed by its path, size and modification time, and includes
+        the files that turned out not to contain any plugins. When scanAndAddFile() is
+        asked not to rescan, it'll take the types from the cache instead of loading a
+        file whose entry still matches, so even after the list has been cleared, a
+        rescan of a folder full of unchanged plugins only needs to look at the files'
+        sizes and dates.
+
+        The cache is kept in a compact binary format, separately from the XML that
+        createXml() makes, and any existing contents of the file are loaded by this
+        method. Only plugins that are identified by a file path can be cached.
+        To make a scan load every file again, pass false for its dontRescanIfAlreadyInList
+        parameter.
+
+        Pass File::nonexistent to stop using a cache.
+
+        @see saveScanCacheIfNeeded
+    */
+    void setScanCacheFile (const File& cacheFile);
+
+    /** Writes the scan cache to its file, if anything has been added to it since it
+        was loaded.
+
+        This is called automatically when the list is deleted, and when a
+        PluginDirectoryScanner finishes with it. Returns false if the file couldn't
+        be written.
+
+        @see setScanCacheFile
+    */
+    bool saveScanCacheIfNeeded();
+
     //==============================================================================
     /** Sort methods used to change the order of the plugins in the list.
     */
@@ -161,6 +196,17 @@ private:
     //==============================================================================
     OwnedArray <PluginDescription> types;
 
+    class ScanCache;
+    friend class ScanCache;
+    friend class PluginDirectoryScanner;
+    ScopedPointer <ScanCache> scanCache;
+
+    bool addTypesFromScanCache (const String& fileOrIdentifier, AudioPluginFormat& format,
+                                OwnedArray <PluginDescription>& typesFound);
+    bool addScannedTypes (const String& fileOrIdentifier, AudioPluginFormat& format,
+                          const OwnedArray <PluginDescription>& found,
+                          OwnedArray <PluginDescription>& typesFound);
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (KnownPluginList);
 };
 
@@ -23,6 +23,16 @@
   ==============================================================================
 */
 
+#include "../../core/juce_TargetPlatform.h"
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+#else
+ #include <sys/types.h>
+ #include <signal.h>
+ #include <unistd.h>
+#endif
+
 #include "../../core/juce_StandardHeader.h"
 
 BEGIN_JUCE_NAMESPACE
@@ -30,6 +40,371 @@ BEGIN_JUCE_NAMESPACE
 #include "juce_PluginDirectoryScanner.h"
 #include "juce_AudioPluginFormat.h"
 #include "../../io/files/juce_DirectoryIterator.h"
+#include "../../events/juce_InterprocessConnection.h"
+#include "../../events/juce_InterprocessConnectionServer.h"
+#include "../../threads/juce_WaitableEvent.h"
+#include "../../threads/juce_ThreadPool.h"
+#include "../../threads/juce_Process.h"
+#include "../../text/juce_XmlDocument.h"
+#include "../../maths/juce_Random.h"
+#include "../../core/juce_Time.h"
+
+
+//==============================================================================
+namespace PluginScannerHelpers
+{
+    const char* const commandLineFlag = "--juce-plugin-scanner";
+
+    int getCurrentProcessId()
+    {
+       #if JUCE_WINDOWS
+        return (int) GetCurrentProcessId();
+       #else
+        return (int) getpid();
+       #endif
+    }
+
+    // These don't run any static destructors or exit handlers, which might not
+    // return if another thread is stuck inside a plugin.
+    void terminateCurrentProcessNow()
+    {
+       #if JUCE_WINDOWS
+        TerminateProcess (GetCurrentProcess(), 1);
+       #else
+        _exit (1);
+       #endif
+    }
+
+    void killProcess (const int processId)
+    {
+       #if JUCE_WINDOWS
+        HANDLE h = OpenProcess (PROCESS_TERMINATE, FALSE, (DWORD) processId);
+
+        if (h != 0)
+        {
+            TerminateProcess (h, 1);
+            CloseHandle (h);
+        }
+       #else
+        kill ((pid_t) processId, SIGKILL);
+       #endif
+    }
+
+    MemoryBlock xmlToMessage (const XmlElement& xml)
+    {
+        const String text (xml.createDocument (String::empty, true, false));
+        return MemoryBlock (text.toUTF8(), text.getNumBytesAsUTF8());
+    }
+
+    XmlElement* messageToXml (const MemoryBlock& message)
+    {
+        return XmlDocument::parse (String::fromUTF8 (static_cast <const char*> (message.getData()), (int) message.getSize()));
+    }
+
+    //==============================================================================
+    // The scanner process's end of the connection
+    class ScannerConnection  : public InterprocessConnection
+    {
+    public:
+        ScannerConnection (const uint32 magicNumber)
+            : InterprocessConnection (false, magicNumber),
+              isLost (false)
+        {
+        }
+
+        ~ScannerConnection()
+        {
+            disconnect();
+        }
+
+        void connectionMade()   {}
+
+        void connectionLost()
+        {
+            {
+                const ScopedLock sl (lock);
+                isLost = true;
+            }
+
+            newMessage.signal();
+        }
+
+        void messageReceived (const MemoryBlock& message)
+        {
+            XmlElement* const xml = messageToXml (message);
+
+            if (xml != nullptr)
+            {
+                const ScopedLock sl (lock);
+                requests.add (xml);
+            }
+
+            newMessage.signal();
+        }
+
+        // Blocks until a request arrives, or returns nullptr if the connection goes away
+        XmlElement* waitForNextRequest()
+        {
+            for (;;)
+            {
+                {
+                    const ScopedLock sl (lock);
+
+                    if (requests.size() > 0)
+                        return requests.removeAndReturn (0);
+
+                    if (isLost)
+                        return nullptr;
+                }
+
+                newMessage.wait (500);
+            }
+        }
+
+    private:
+        CriticalSection lock;
+        OwnedArray <XmlElement> requests;
+        WaitableEvent newMessage;
+        bool isLost;
+
+        JUCE_DECLARE_NON_COPYABLE (ScannerConnection);
+    };
+
+    //==============================================================================
+    // Kills the scanner process if a plugin takes too long to load
+    class ScannerWatchdog  : public Thread
+    {
+    public:
+        ScannerWatchdog() : Thread ("Juce plugin scan watchdog")    {}
+        ~ScannerWatchdog()                                          { stopThread (2000); }
+
+        void run()
+        {
+            while (! threadShouldExit())
+            {
+                wait (50);
+                const uint32 time = deadline.get();
+
+                if (time != 0 && Time::getMillisecondCounter() > time)
+                    terminateCurrentProcessNow();
+            }
+        }
+
+        Atomic <uint32> deadline;
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE (ScannerWatchdog);
+    };
+}
+
+//==============================================================================
+class PluginDirectoryScanner::ChildProcessPool  : public InterprocessConnectionServer
+{
+public:
+    ChildProcessPool (const File& executable_, const int numProcesses_, const int timeoutMs_)
+        : executable (executable_),
+          numProcesses (jmax (1, numProcesses_)),
+          timeoutMs (jmax (1, timeoutMs_)),
+          magicNumber ((uint32) Random::getSystemRandom().nextInt() | 1),
+          port (0),
+          numLaunching (0),
+          lastLaunchTime (0)
+    {
+    }
+
+    ~ChildProcessPool()
+    {
+        stop();
+
+        // (the connections have to be deleted without holding the lock, because
+        // their threads might be waiting for it)
+        OwnedArray <Connection> toDelete;
+
+        {
+            const ScopedLock sl (lock);
+            toDelete.swapWithArray (connections);
+        }
+
+        // Any processes that are still there might be stuck in a plugin, so rather
+        // than asking them to quit, they get killed.
+        for (int i = toDelete.size(); --i >= 0;)
+            toDelete.getUnchecked(i)->killProcess();
+    }
+
+    bool start()
+    {
+        // Only processes on this machine can connect, and they need to know the magic number
+        for (int i = 0; i < 50; ++i)
+        {
+            port = 20000 + Random::getSystemRandom().nextInt (40000);
+
+            if (beginWaitingForSocket (port, "127.0.0.1"))
+                return true;
+        }
+
+        return false;
+    }
+
+    void launchProcess()
+    {
+        String args;
+        args << PluginScannerHelpers::commandLineFlag << ' ' << port << ' '
+             << String::toHexString ((int) magicNumber) << ' ' << timeoutMs;
+
+        if (executable.startAsProcess (args))
+        {
+            ++numLaunching;
+            lastLaunchTime = Time::getMillisecondCounter();
+        }
+    }
+
+    //==============================================================================
+    class Connection  : public InterprocessConnection
+    {
+    public:
+        Connection (ChildProcessPool& owner_)
+            : InterprocessConnection (false, owner_.magicNumber),
+              owner (owner_),
+              startTime (0),
+              processId (0),
+              isDead (false)
+        {
+        }
+
+        ~Connection()
+        {
+            disconnect();
+        }
+
+        void connectionMade()   {}
+
+        void connectionLost()
+        {
+            const ScopedLock sl (owner.lock);
+            isDead = true;
+            owner.resultArrived.signal();
+        }
+
+        void messageReceived (const MemoryBlock& message)
+        {
+            XmlElement* const xml = PluginScannerHelpers::messageToXml (message);
+
+            const ScopedLock sl (owner.lock);
+
+            if (xml != nullptr && xml->hasTagName ("SCANNER"))
+            {
+                processId = xml->getIntAttribute ("pid");
+                delete xml;
+                return;
+            }
+
+            result = xml;
+            owner.resultArrived.signal();
+        }
+
+        // The process still has its end of the socket open while we're connected,
+        // so while that's true, the pid can't have been re-used by anything else.
+        void killProcess()
+        {
+            if (processId != 0 && isConnected())
+                PluginScannerHelpers::killProcess (processId);
+        }
+
+        ChildProcessPool& owner;
+        String currentFile;
+        uint32 startTime;
+        int processId;
+        ScopedPointer <XmlElement> result;
+        bool isDead;
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE (Connection);
+    };
+
+    InterprocessConnection* createConnectionObject()
+    {
+        const ScopedLock sl (lock);
+        numLaunching = jmax (0, numLaunching - 1);
+        resultArrived.signal();
+
+        Connection* const c = new Connection (*this);
+        connections.add (c);
+        return c;
+    }
+
+    //==============================================================================
+    const File executable;
+    const int numProcesses, timeoutMs;
+    const uint32 magicNumber;
+    int port, numLaunching;
+    uint32 lastLaunchTime;
+
+    CriticalSection lock;
+    OwnedArray <Connection> connections;
+    WaitableEvent resultArrived;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE (ChildProcessPool);
+};
+
+//==============================================================================
+class PluginDirectoryScanner::ScanThreadPool
+{
+public:
+    ScanThreadPool (const int numThreads_)
+        : numThreads (jmax (1, numThreads_)),
+          pool (numThreads)
+    {
+    }
+
+    ~ScanThreadPool()
+    {
+        // (a job can't be interrupted while it's loading a plugin, so this has to wait for them)
+        pool.removeAllJobs (false, -1);
+    }
+
+    //==============================================================================
+    class Job  : public ThreadPoolJob
+    {
+    public:
+        Job (ScanThreadPool& owner_, AudioPluginFormat& format_, const String& file_)
+            : ThreadPoolJob ("Plugin scan"),
+              owner (owner_),
+              format (format_),
+              file (file_)
+        {
+        }
+
+        JobStatus runJob()
+        {
+            format.findAllTypesForFile (found, file);
+
+            finished = 1;
+            owner.jobFinished.signal();
+            return jobHasFinished;
+        }
+
+        ScanThreadPool& owner;
+        AudioPluginFormat& format;
+        const String file;
+        OwnedArray <PluginDescription> found;
+        Atomic <int> finished;
+
+    private:
+        JUCE_DECLARE_NON_COPYABLE (Job);
+    };
+
+    //==============================================================================
+    const int numThreads;
+    ThreadPool pool;
+
+    CriticalSection lock;
+    OwnedArray <Job> jobs;
+    WaitableEvent jobFinished;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE (ScanThreadPool);
+};
 
 
 //==============================================================================
@@ -42,7 +417,8 @@ PluginDirectoryScanner::PluginDirectoryScanner (KnownPluginList& listToAddTo,
       format (formatToLookFor),
       deadMansPedalFile (deadMansPedalFile_),
       nextIndex (0),
-      progress (0)
+      progress (0),
+      numFilesFinished (0)
 {
     directoriesToSearch.removeRedundantPaths();
 
@@ -64,22 +440,99 @@ PluginDirectoryScanner::PluginDirectoryScanner (KnownPluginList& listToAddTo,
 
 PluginDirectoryScanner::~PluginDirectoryScanner()
 {
+    if (scanThreads != nullptr)
+    {
+        // If the scan's been cancelled, let the plugins that are being loaded finish,
+        // and keep what they found, but don't start any more. None of the files that
+        // were handed out have crashed, so they all come off the dead-man's-pedal list.
+        scanThreads->pool.removeAllJobs (false, -1, false);
+
+        StringArray crashedPlugins (getDeadMansPedalFile());
+        const int oldSize = crashedPlugins.size();
+
+        for (int i = 0; i < scanThreads->jobs.size(); ++i)
+        {
+            ScanThreadPool::Job* const job = scanThreads->jobs.getUnchecked(i);
+
+            if (job->finished.get() != 0)
+            {
+                OwnedArray <PluginDescription> typesFound;
+                list.addScannedTypes (job->file, format, job->found, typesFound);
+            }
+
+            crashedPlugins.removeString (job->file);
+        }
+
+        if (crashedPlugins.size() != oldSize)
+            setDeadMansPedalFile (crashedPlugins);
+
+        scanThreads = nullptr;
+    }
+
+    childProcesses = nullptr;
+
+    list.saveScanCacheIfNeeded();
 }
 
 //==============================================================================
 const String PluginDirectoryScanner::getNextPluginFileThatWillBeScanned() const
 {
+    if (childProcesses != nullptr)
+    {
+        StringArray names;
+
+        const ScopedLock sl (childProcesses->lock);
+
+        for (int i = 0; i < childProcesses->connections.size(); ++i)
+        {
+            const String& file = childProcesses->connections.getUnchecked(i)->currentFile;
+
+            if (file.isNotEmpty())
+                names.add (format.getNameOfPluginFromIdentifier (file));
+        }
+
+        if (names.size() > 0)
+            return names.joinIntoString ("\n");
+    }
+
+    if (scanThreads != nullptr)
+    {
+        StringArray names;
+
+        const ScopedLock sl (scanThreads->lock);
+
+        for (int i = 0; i < scanThreads->jobs.size(); ++i)
+            names.add (format.getNameOfPluginFromIdentifier (scanThreads->jobs.getUnchecked(i)->file));
+
+        if (names.size() > 0)
+            return names.joinIntoString ("\n");
+    }
+
     return format.getNameOfPluginFromIdentifier (filesOrIdentifiersToScan [nextIndex]);
 }
 
 bool PluginDirectoryScanner::scanNextFile (const bool dontRescanIfAlreadyInList)
 {
+    if (childProcesses != nullptr)
+        return scanNextFilesInChildProcesses (dontRescanIfAlreadyInList);
+
+    if (scanThreads != nullptr)
+        return scanNextFilesInThreads (dontRescanIfAlreadyInList);
+
     String file (filesOrIdentifiersToScan [nextIndex]);
 
     if (file.isNotEmpty() && ! list.isListingUpToDate (file))
     {
         OwnedArray <PluginDescription> typesFound;
 
+        if (dontRescanIfAlreadyInList && list.addTypesFromScanCache (file, format, typesFound))
+        {
+            if (typesFound.size() == 0)
+                failedFiles.add (file);
+
+            return skipNextFile();
+        }
+
         // Add this plugin to the end of the dead-man's pedal list in case it crashes...
         StringArray crashedPlugins (getDeadMansPedalFile());
         crashedPlugins.removeString (file);
@@ -107,10 +560,314 @@ bool PluginDirectoryScanner::skipNextFile()
     if (nextIndex >= filesOrIdentifiersToScan.size())
         return false;
 
+    ++numFilesFinished;
     progress = ++nextIndex / (float) filesOrIdentifiersToScan.size();
     return nextIndex < filesOrIdentifiersToScan.size();
 }
 
+// Moves past any files that don't need to be loaded, either because the list is up to
+// date with them, or because their types could be taken from the list's scan cache.
+const String PluginDirectoryScanner::getNextFileThatNeedsScanning (const bool dontRescanIfAlreadyInList)
+{
+    while (nextIndex < filesOrIdentifiersToScan.size())
+    {
+        const String file (filesOrIdentifiersToScan [nextIndex++]);
+
+        if (file.isNotEmpty() && ! list.isListingUpToDate (file))
+        {
+            OwnedArray <PluginDescription> typesFound;
+
+            if (! (dontRescanIfAlreadyInList && list.addTypesFromScanCache (file, format, typesFound)))
+                return file;
+
+            if (typesFound.size() == 0)
+                failedFiles.add (file);
+        }
+
+        ++numFilesFinished;
+    }
+
+    return String::empty;
+}
+
+//==============================================================================
+void PluginDirectoryScanner::scanInChildProcesses (const File& scannerExecutable, const int numProcesses, const int timeoutMs)
+{
+    scanThreads = nullptr;
+    childProcesses = new ChildProcessPool (scannerExecutable, numProcesses, timeoutMs);
+
+    if (! childProcesses->start())
+        childProcesses = nullptr;
+}
+
+bool PluginDirectoryScanner::scanNextFilesInChildProcesses (const bool dontRescanIfAlreadyInList)
+{
+    typedef ChildProcessPool::Connection Connection;
+
+    ChildProcessPool& pool = *childProcesses;
+    OwnedArray <Connection> deadConnections;
+    const uint32 now = Time::getMillisecondCounter();
+    bool anyInProgress = false, anyRunning = false;
+
+    {
+        const ScopedLock sl (pool.lock);
+
+        // Collect the results, and get rid of any processes that have crashed or hung..
+        for (int i = pool.connections.size(); --i >= 0;)
+        {
+            Connection* const c = pool.connections.getUnchecked(i);
+
+            if (c->result != nullptr)
+            {
+                OwnedArray <PluginDescription> found, typesFound;
+
+                forEachXmlChildElement (*c->result, e)
+                {
+                    ScopedPointer <PluginDescription> desc (new PluginDescription());
+
+                    if (desc->loadFromXml (*e))
+                        found.add (desc.release());
+                }
+
+                list.addScannedTypes (c->currentFile, format, found, typesFound);
+                fileFinished (c->currentFile, found.size(), false);
+                c->result = nullptr;
+                c->currentFile = String::empty;
+            }
+
+            if (c->isDead || (c->currentFile.isNotEmpty() && now - c->startTime > (uint32) pool.timeoutMs + 2000))
+            {
+                if (c->currentFile.isNotEmpty())
+                    fileFinished (c->currentFile, 0, true);
+
+                if (! c->isDead)
+                    c->killProcess();
+
+                deadConnections.add (pool.connections.removeAndReturn (i));
+            }
+        }
+
+        // ..then give the idle ones something to do..
+        for (int i = 0; i < pool.connections.size(); ++i)
+        {
+            Connection* const c = pool.connections.getUnchecked(i);
+
+            while (c->currentFile.isEmpty() && nextIndex < filesOrIdentifiersToScan.size())
+            {
+                const String file (getNextFileThatNeedsScanning (dontRescanIfAlreadyInList));
+
+                if (file.isEmpty())
+                    break;
+
+                XmlElement request ("SCAN");
+                request.setAttribute ("format", format.getName());
+                request.setAttribute ("file", file);
+
+                c->currentFile = file;
+                c->startTime = now;
+
+                if (! c->sendMessage (PluginScannerHelpers::xmlToMessage (request)))
+                    c->isDead = true;
+            }
+
+            anyInProgress = anyInProgress || c->currentFile.isNotEmpty();
+        }
+
+        // ..and start some more processes if there's still work for them.
+        const int numFilesLeft = filesOrIdentifiersToScan.size() - nextIndex;
+        const int numToLaunch = jmin (numFilesLeft, pool.numProcesses - (pool.connections.size() + pool.numLaunching));
+
+        for (int i = 0; i < numToLaunch; ++i)
+            pool.launchProcess();
+
+        anyRunning = pool.connections.size() > 0
+                      || (pool.numLaunching > 0 && Time::getMillisecondCounter() - pool.lastLaunchTime < 15000);
+    }
+
+    deadConnections.clear();
+
+    if (! (anyInProgress || anyRunning))
+    {
+        // None of the processes managed to start up, so carry on scanning in this one.
+        childProcesses = nullptr;
+        return nextIndex < filesOrIdentifiersToScan.size();
+    }
+
+    if (! anyInProgress && nextIndex >= filesOrIdentifiersToScan.size())
+    {
+        progress = 1.0f;
+        return false;
+    }
+
+    pool.resultArrived.wait (200);
+    progress = numFilesFinished / (float) filesOrIdentifiersToScan.size();
+    return true;
+}
+
+//==============================================================================
+void PluginDirectoryScanner::scanInThreads (const int numThreads)
+{
+    childProcesses = nullptr;
+    scanThreads = new ScanThreadPool (numThreads);
+}
+
+bool PluginDirectoryScanner::scanNextFilesInThreads (const bool dontRescanIfAlreadyInList)
+{
+    typedef ScanThreadPool::Job Job;
+
+    ScanThreadPool& threads = *scanThreads;
+
+    // Collect the results from any jobs that have finished..
+    for (int i = 0; i < threads.jobs.size(); ++i)
+    {
+        Job* const job = threads.jobs.getUnchecked(i);
+
+        if (job->finished.get() != 0)
+        {
+            // (it might still be on its way out of runJob())
+            threads.pool.waitForJobToFinish (job, -1);
+
+            {
+                const ScopedLock sl (threads.lock);
+                threads.jobs.removeObject (job, false);
+            }
+
+            const ScopedPointer <Job> deleter (job);
+            OwnedArray <PluginDescription> typesFound;
+
+            list.addScannedTypes (job->file, format, job->found, typesFound);
+            fileFinished (job->file, job->found.size(), false);
+            --i;
+        }
+    }
+
+    // ..and give the idle threads some more to do.
+    while (threads.jobs.size() < threads.numThreads)
+    {
+        const String file (getNextFileThatNeedsScanning (dontRescanIfAlreadyInList));
+
+        if (file.isEmpty())
+            break;
+
+        // Add this plugin to the end of the dead-man's pedal list in case it crashes...
+        StringArray crashedPlugins (getDeadMansPedalFile());
+        crashedPlugins.removeString (file);
+        crashedPlugins.add (file);
+        setDeadMansPedalFile (crashedPlugins);
+
+        Job* const job = new Job (threads, format, file);
+
+        {
+            const ScopedLock sl (threads.lock);
+            threads.jobs.add (job);
+        }
+
+        threads.pool.addJob (job);
+    }
+
+    if (threads.jobs.size() == 0)
+    {
+        progress = 1.0f;
+        return false;
+    }
+
+    threads.jobFinished.wait (200);
+    progress = numFilesFinished / (float) filesOrIdentifiersToScan.size();
+    return true;
+}
+
+void PluginDirectoryScanner::fileFinished (const String& file, const int numTypesFound, const bool crashed)
+{
+    ++numFilesFinished;
+
+    if (numTypesFound == 0)
+        failedFiles.add (file);
+
+    // A plugin that crashed or hung goes on the dead-man's-pedal list, so that any scans
+    // which run in this process will leave it until last.
+    StringArray crashedPlugins (getDeadMansPedalFile());
+    const int oldSize = crashedPlugins.size();
+    crashedPlugins.removeString (file);
+
+    if (crashed)
+        crashedPlugins.add (file);
+
+    if (crashed || crashedPlugins.size() != oldSize)
+        setDeadMansPedalFile (crashedPlugins);
+}
+
+//==============================================================================
+bool PluginDirectoryScanner::handleScannerProcessCommandLine (const String& commandLine)
+{
+    using namespace PluginScannerHelpers;
+
+    StringArray tokens;
+    tokens.addTokens (commandLine, true);
+    tokens.removeEmptyStrings();
+
+    const int index = tokens.indexOf (commandLineFlag);
+
+    if (index < 0 || index + 3 >= tokens.size())
+        return false;
+
+    const int port = tokens [index + 1].getIntValue();
+    const uint32 magicNumber = (uint32) tokens [index + 2].getHexValue32();
+    const int timeoutMs = tokens [index + 3].getIntValue();
+
+    ScannerConnection connection (magicNumber);
+
+    if (! connection.connectToSocket ("127.0.0.1", port, 5000))
+        return true;
+
+    // Tell the host which process this is, so that it can kill it if it hangs
+    XmlElement hello ("SCANNER");
+    hello.setAttribute ("pid", getCurrentProcessId());
+
+    if (! connection.sendMessage (xmlToMessage (hello)))
+        return true;
+
+    ScannerWatchdog watchdog;
+    watchdog.startThread();
+
+    for (;;)
+    {
+        ScopedPointer <XmlElement> request (connection.waitForNextRequest());
+
+        if (request == nullptr)
+            break;
+
+        const String file (request->getStringAttribute ("file"));
+        const String formatName (request->getStringAttribute ("format"));
+
+        XmlElement reply ("RESULT");
+        reply.setAttribute ("file", file);
+
+        for (int i = 0; i < AudioPluginFormatManager::getInstance()->getNumFormats(); ++i)
+        {
+            AudioPluginFormat* const f = AudioPluginFormatManager::getInstance()->getFormat (i);
+
+            if (f->getName() == formatName)
+            {
+                OwnedArray <PluginDescription> found;
+
+                watchdog.deadline = Time::getMillisecondCounter() + (uint32) jmax (1, timeoutMs);
+                f->findAllTypesForFile (found, file);
+                watchdog.deadline = 0;
+
+                for (int j = 0; j < found.size(); ++j)
+                    reply.addChildElement (found.getUnchecked(j)->createXml());
+
+                break;
+            }
+        }
+
+        if (! connection.sendMessage (xmlToMessage (reply)))
+            break;
+    }
+
+    return true;
+}
+
 StringArray PluginDirectoryScanner::getDeadMansPedalFile()
 {
     StringArray lines;
@@ -130,5 +887,165 @@ void PluginDirectoryScanner::setDeadMansPedalFile (const StringArray& newContent
         deadMansPedalFile.replaceWithText (newContents.joinIntoString ("\n"), true, true);
 }
 
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+#include "../../utilities/juce_UnitTest.h"
+
+class PluginDirectoryScannerTests  : public UnitTest
+{
+public:
+    PluginDirectoryScannerTests() : UnitTest ("PluginDirectoryScanner") {}
+
+    // Pretends that any ".scantest" file whose name begins with "plugin" contains a plugin
+    class TestFormat  : public AudioPluginFormat
+    {
+    public:
+        TestFormat() {}
+
+        String getName() const                                          { return "ScanTest"; }
+        AudioPluginInstance* createInstanceFromDescription (const PluginDescription&)   { return nullptr; }
+        bool fileMightContainThisPluginType (const String& f)          { return File (f).hasFileExtension (".scantest"); }
+        String getNameOfPluginFromIdentifier (const String& f)         { return File (f).getFileNameWithoutExtension(); }
+        bool doesPluginStillExist (const PluginDescription& desc)      { return File (desc.fileOrIdentifier).exists(); }
+        FileSearchPath getDefaultLocationsToSearch()                    { return FileSearchPath(); }
+
+        void findAllTypesForFile (OwnedArray <PluginDescription>& results, const String& fileOrIdentifier)
+        {
+            ++numLoads;
+            Thread::sleep (20);
+
+            const File file (fileOrIdentifier);
+
+            if (file.getFileName().startsWith ("plugin"))
+            {
+                PluginDescription* const desc = new PluginDescription();
+                desc->name = file.getFileNameWithoutExtension();
+                desc->pluginFormatName = getName();
+                desc->fileOrIdentifier = fileOrIdentifier;
+                desc->lastFileModTime = file.getLastModificationTime();
+                desc->uid = desc->name.hashCode();
+                desc->numOutputChannels = 2;
+                results.add (desc);
+            }
+        }
+
+        StringArray searchPathsForPlugins (const FileSearchPath& directoriesToSearch, bool recursive)
+        {
+            StringArray files;
+
+            for (int i = 0; i < directoriesToSearch.getNumPaths(); ++i)
+            {
+                DirectoryIterator iter (directoriesToSearch[i], recursive, "*.scantest");
+
+                while (iter.next())
+                    files.add (iter.getFile().getFullPathName());
+            }
+
+            return files;
+        }
+
+        Atomic<int> numLoads;
+    };
+
+    void scan (TestFormat& format, const File& folder, const File& cacheFile,
+               const int numThreads, int& numTypes, int& numFailed)
+    {
+        KnownPluginList list;
+        list.setScanCacheFile (cacheFile);
+
+        PluginDirectoryScanner scanner (list, format, FileSearchPath (folder.getFullPathName()), false, File::nonexistent);
+
+        if (numThreads > 1)
+            scanner.scanInThreads (numThreads);
+
+        while (scanner.scanNextFile (true))
+        {}
+
+        numTypes = list.getNumTypes();
+        numFailed = scanner.getFailedFiles().size();
+    }
+
+    void runTest()
+    {
+        const File folder (File::createTempFile ("scantest"));
+        const File cacheFile (folder.getSiblingFile (folder.getFileName() + "_cache"));
+        folder.createDirectory();
+
+        for (int i = 0; i < 8; ++i)
+            folder.getChildFile ("plugin" + String (i) + ".scantest").replaceWithText ("plugin");
+
+        for (int i = 0; i < 2; ++i)
+            folder.getChildFile ("notaplugin" + String (i) + ".scantest").replaceWithText ("not a plugin");
+
+        TestFormat format;
+        int numTypes = 0, numFailed = 0;
+
+        beginTest ("Scanning in threads");
+        {
+            scan (format, folder, cacheFile, 4, numTypes, numFailed);
+
+            expectEquals (numTypes, 8);
+            expectEquals (numFailed, 2);
+            expectEquals (format.numLoads.get(), 10);
+            expect (cacheFile.existsAsFile());
+        }
+
+        beginTest ("Unchanged files come from the cache");
+        {
+            scan (format, folder, cacheFile, 1, numTypes, numFailed);
+
+            expectEquals (numTypes, 8);
+            expectEquals (numFailed, 2);
+            expectEquals (format.numLoads.get(), 10);
+        }
+
+        beginTest ("Changed files get loaded again");
+        {
+            folder.getChildFile ("plugin3.scantest").appendText ("changed");
+            scan (format, folder, cacheFile, 4, numTypes, numFailed);
+
+            expectEquals (numTypes, 8);
+            expectEquals (format.numLoads.get(), 11);
+        }
+
+        beginTest ("A damaged cache file is ignored");
+        {
+            MemoryBlock data;
+            cacheFile.loadFileAsData (data);
+            cacheFile.replaceWithData (data.getData(), data.getSize() / 2);
+
+            scan (format, folder, cacheFile, 4, numTypes, numFailed);
+
+            expectEquals (numTypes, 8);
+            expectEquals (format.numLoads.get(), 21);
+        }
+
+        beginTest ("Cancelling a threaded scan");
+        {
+            const File pedalFile (folder.getSiblingFile (folder.getFileName() + "_pedal"));
+            KnownPluginList list;
+
+            {
+                PluginDirectoryScanner scanner (list, format, FileSearchPath (folder.getFullPathName()), false, pedalFile);
+                scanner.scanInThreads (4);
+                scanner.scanNextFile (true);
+            }
+
+            // (at least two of the four files that were handed out are plugins)
+            expect (list.getNumTypes() >= 2);
+            expect (pedalFile.loadFileAsString().trim().isEmpty());
+            pedalFile.deleteFile();
+        }
+
+        folder.deleteRecursively();
+        cacheFile.deleteFile();
+    }
+};
+
+static PluginDirectoryScannerTests pluginDirectoryScannerTests;
+
+#endif
+
 
 END_JUCE_NAMESPACE
@@ -28,6 +28,7 @@
 
 #include "juce_KnownPluginList.h"
 #include "juce_AudioPluginFormatManager.h"
+#include "../../memory/juce_ScopedPointer.h"
 
 
 //==============================================================================
@@ -105,6 +106,58 @@ public:
     */
     const StringArray& getFailedFiles() const noexcept              { return failedFiles; }
 
+    //==============================================================================
+    /** Makes the scanner load the plugins in some separate processes, rather than in
+        this one.
+
+        This means that a plugin which crashes or hangs while it's being loaded can't take
+        your app down with it, and several plugins can be scanned at once. After calling
+        this, each call to scanNextFile() collects any results that have come back, hands
+        out more files to the processes that are idle, and then waits briefly for them.
+
+        The scanner processes are launched by running scannerExecutable - normally
+        this will be your own app, e.g. File::getSpecialLocation (File::currentExecutableFile),
+        which must call handleScannerProcessCommandLine() when it starts up.
+
+        @param scannerExecutable    the program to run for each scanner process
+        @param numProcesses         how many processes to run at once
+        @param timeoutMs            how long a plugin may take to load before it's treated
+                                    as having failed, and its process gets killed
+
+        If the processes can't be launched, the scanner goes back to loading the
+        plugins itself.
+    */
+    void scanInChildProcesses (const File& scannerExecutable, int numProcesses, int timeoutMs);
+
+    /** Runs a plugin scanner process, if this is the command line that a
+        PluginDirectoryScanner used to launch it.
+
+        If your app is used for scanInChildProcesses(), call this at the start of your
+        JUCEApplication::initialise() method, after adding your plugin formats to the
+        AudioPluginFormatManager. If it returns true, the scanning has been done, and
+        your app should quit without doing anything else. If it returns false, the app
+        wasn't launched as a scanner, and should carry on as usual.
+    */
+    static bool handleScannerProcessCommandLine (const String& commandLine);
+
+    //==============================================================================
+    /** Makes the scanner load several plugins at once, using a pool of threads in
+        this process.
+
+        After calling this, each call to scanNextFile() collects the types found by
+        any threads that have finished, gives the idle threads some more files, and
+        then waits briefly for them.
+
+        This is quicker than scanInChildProcesses() because nothing has to be launched,
+        but a plugin that crashes while it's being loaded will take your app down with
+        it. Only use it for formats whose plugins can safely be opened away from the
+        message thread, and by several threads at the same time.
+
+        Plugins that the KnownPluginList can find in its scan cache are added straight
+        away without being given to a thread - see KnownPluginList::setScanCacheFile().
+    */
+    void scanInThreads (int numThreads);
+
 private:
     //==============================================================================
     KnownPluginList& list;
@@ -115,8 +168,21 @@ private:
     int nextIndex;
     float progress;
 
+    class ChildProcessPool;
+    friend class ChildProcessPool;
+    ScopedPointer<ChildProcessPool> childProcesses;
+    int numFilesFinished;
+
+    class ScanThreadPool;
+    friend class ScanThreadPool;
+    ScopedPointer<ScanThreadPool> scanThreads;
+
     StringArray getDeadMansPedalFile();
     void setDeadMansPedalFile (const StringArray& newContents);
+    const String getNextFileThatNeedsScanning (bool dontRescanIfAlreadyInList);
+    bool scanNextFilesInChildProcesses (bool dontRescanIfAlreadyInList);
+    bool scanNextFilesInThreads (bool dontRescanIfAlreadyInList);
+    void fileFinished (const String& file, int numTypesFound, bool crashed);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluginDirectoryScanner);
 };
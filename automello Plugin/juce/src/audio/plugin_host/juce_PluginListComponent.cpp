@@ -44,7 +44,10 @@ PluginListComponent::PluginListComponent (KnownPluginList& listToEdit,
     : list (listToEdit),
       deadMansPedalFile (deadMansPedalFile_),
       optionsButton ("Options..."),
-      propertiesToUse (propertiesToUse_)
+      propertiesToUse (propertiesToUse_),
+      numScannerProcesses (0),
+      scannerTimeoutMs (0),
+      numScanThreads (0)
 {
     listBox.setModel (this);
     addAndMakeVisible (&listBox);
@@ -63,6 +66,18 @@ PluginListComponent::~PluginListComponent()
     list.removeChangeListener (this);
 }
 
+void PluginListComponent::setScanInChildProcesses (const File& scannerExecutable_, const int numProcesses, const int timeoutMs)
+{
+    scannerExecutable = scannerExecutable_;
+    numScannerProcesses = numProcesses;
+    scannerTimeoutMs = timeoutMs;
+}
+
+void PluginListComponent::setScanInThreads (const int numThreads)
+{
+    numScanThreads = numThreads;
+}
+
 void PluginListComponent::resized()
 {
     listBox.setBounds (0, 0, getWidth(), getHeight() - 30);
@@ -296,6 +311,11 @@ void PluginListComponent::scanFor (AudioPluginFormat* format)
 
     PluginDirectoryScanner scanner (list, *format, path, true, deadMansPedalFile);
 
+    if (scannerExecutable != File::nonexistent)
+        scanner.scanInChildProcesses (scannerExecutable, numScannerProcesses, scannerTimeoutMs);
+    else if (numScanThreads > 1)
+        scanner.scanInThreads (numScanThreads);
+
     for (;;)
     {
         aw.setMessage (TRANS("Testing:\n\n")
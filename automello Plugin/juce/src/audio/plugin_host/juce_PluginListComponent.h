@@ -60,6 +60,19 @@ public:
     /** Destructor. */
     ~PluginListComponent();
 
+    /** Makes the component's scans load the plugins in separate processes.
+
+        See PluginDirectoryScanner::scanInChildProcesses() for details.
+    */
+    void setScanInChildProcesses (const File& scannerExecutable, int numProcesses, int timeoutMs);
+
+    /** Makes the component's scans load several plugins at once in this process.
+
+        This is ignored if setScanInChildProcesses() has been used. See
+        PluginDirectoryScanner::scanInThreads() for details.
+    */
+    void setScanInThreads (int numThreads);
+
     //==============================================================================
     /** @internal */
     void resized();
@@ -88,6 +101,8 @@ private:
     TextButton optionsButton;
     PropertiesFile* propertiesToUse;
     int typeToScan;
+    File scannerExecutable;
+    int numScannerProcesses, scannerTimeoutMs, numScanThreads;
 
     void scanFor (AudioPluginFormat* format);
     static void optionsMenuStaticCallback (int result, PluginListComponent*);
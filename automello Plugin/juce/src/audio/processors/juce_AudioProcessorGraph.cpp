@@ -28,7 +28,9 @@
 BEGIN_JUCE_NAMESPACE
 
 #include "juce_AudioProcessorGraph.h"
-#include "../../events/juce_MessageManager.h"
+#include "../../threads/juce_Thread.h"
+#include "../../containers/juce_SortedSet.h"
+#include "../../containers/juce_HashMap.h"
 
 const int AudioProcessorGraph::midiChannelIndex = 0x1000;
 
@@ -36,6 +38,35 @@ const int AudioProcessorGraph::midiChannelIndex = 0x1000;
 namespace GraphRenderingOps
 {
 
+//==============================================================================
+/** Collects the shared buffers that some rendering ops read and write, so that
+    the graph can tell which ops are free to run at the same time.
+
+    Each audio channel and midi buffer gets its own number. The empty channel 0 is
+    included, because nothing stops a processor writing into an unconnected input, so
+    the ops that use it have to stay in the same order as they would when rendering
+    serially. The graph's own audio and midi outputs are included too, because the
+    output nodes add into them.
+*/
+struct BufferUsage
+{
+    BufferUsage (const int numAudioChannels_, const int numMidiBuffers_) noexcept
+        : numAudioChannels (numAudioChannels_), numMidiBuffers (numMidiBuffers_)
+    {}
+
+    void readsAudio (const int channel)     { reads.add (channel); }
+    void writesAudio (const int channel)    { writes.add (channel); }
+    void readsMidi (const int buffer)       { reads.add (numAudioChannels + buffer); }
+    void writesMidi (const int buffer)      { writes.add (numAudioChannels + buffer); }
+    void writesGraphAudioOutput()           { writes.add (numAudioChannels + numMidiBuffers); }
+    void writesGraphMidiOutput()            { writes.add (numAudioChannels + numMidiBuffers + 1); }
+
+    int getNumBuffers() const noexcept      { return numAudioChannels + numMidiBuffers + 2; }
+
+    const int numAudioChannels, numMidiBuffers;
+    SortedSet<int> reads, writes;
+};
+
 //==============================================================================
 class AudioGraphRenderingOp
 {
@@ -47,6 +78,8 @@ public:
                           const OwnedArray <MidiBuffer>& sharedMidiBuffers,
                           const int numSamples) = 0;
 
+    virtual void addBuffersUsed (BufferUsage& usage) const = 0;
+
     JUCE_LEAK_DETECTOR (AudioGraphRenderingOp);
 };
 
@@ -63,6 +96,11 @@ public:
         sharedBufferChans.clear (channelNum, 0, numSamples);
     }
 
+    void addBuffersUsed (BufferUsage& usage) const
+    {
+        usage.writesAudio (channelNum);
+    }
+
 private:
     const int channelNum;
 
@@ -83,6 +121,12 @@ public:
         sharedBufferChans.copyFrom (dstChannelNum, 0, sharedBufferChans, srcChannelNum, 0, numSamples);
     }
 
+    void addBuffersUsed (BufferUsage& usage) const
+    {
+        usage.readsAudio (srcChannelNum);
+        usage.writesAudio (dstChannelNum);
+    }
+
 private:
     const int srcChannelNum, dstChannelNum;
 
@@ -103,6 +147,12 @@ public:
         sharedBufferChans.addFrom (dstChannelNum, 0, sharedBufferChans, srcChannelNum, 0, numSamples);
     }
 
+    void addBuffersUsed (BufferUsage& usage) const
+    {
+        usage.readsAudio (srcChannelNum);
+        usage.writesAudio (dstChannelNum);
+    }
+
 private:
     const int srcChannelNum, dstChannelNum;
 
@@ -122,6 +172,11 @@ public:
         sharedMidiBuffers.getUnchecked (bufferNum)->clear();
     }
 
+    void addBuffersUsed (BufferUsage& usage) const
+    {
+        usage.writesMidi (bufferNum);
+    }
+
 private:
     const int bufferNum;
 
@@ -142,6 +197,12 @@ public:
         *sharedMidiBuffers.getUnchecked (dstBufferNum) = *sharedMidiBuffers.getUnchecked (srcBufferNum);
     }
 
+    void addBuffersUsed (BufferUsage& usage) const
+    {
+        usage.readsMidi (srcBufferNum);
+        usage.writesMidi (dstBufferNum);
+    }
+
 private:
     const int srcBufferNum, dstBufferNum;
 
@@ -163,6 +224,12 @@ public:
             ->addEvents (*sharedMidiBuffers.getUnchecked (srcBufferNum), 0, numSamples, 0);
     }
 
+    void addBuffersUsed (BufferUsage& usage) const
+    {
+        usage.readsMidi (srcBufferNum);
+        usage.writesMidi (dstBufferNum);
+    }
+
 private:
     const int srcBufferNum, dstBufferNum;
 
@@ -170,35 +237,129 @@ private:
 };
 
 //==============================================================================
-class DelayChannelOp : public AudioGraphRenderingOp
+/*  The delay lines that keep the inputs of one node lined up, for latency compensation.
+
+    Each delayed input gets a lane in a single block of memory. The lanes are power-of-two
+    ring buffers, long enough for the graph's maximum latency plus a block, so audio goes
+    in and out with a couple of memcpys, and changing the amount of delay just moves the
+    read position. A node's DelayLines get carried over when the graph rebuilds its rendering
+    sequence, so the audio in them isn't lost and nothing gets reallocated.
+*/
+class DelayLines  : public ReferenceCountedObject
 {
 public:
-    DelayChannelOp (const int channel_, const int numSamplesDelay_)
-        : channel (channel_),
-          bufferSize (numSamplesDelay_ + 1),
-          readIndex (0), writeIndex (numSamplesDelay_)
+    DelayLines (const uint32 nodeId_, const Array<int64>& laneKeys_, const int minimumSize)
+        : nodeId (nodeId_), laneKeys (laneKeys_), size (1)
+    {
+        while (size < minimumSize)
+            size <<= 1;
+
+        storage.calloc ((size_t) (size * laneKeys.size()));
+        writePositions.calloc ((size_t) laneKeys.size());
+    }
+
+    static int64 getLaneKey (const int inputChannel, const uint32 sourceNodeId, const int sourceChannel) noexcept
     {
-        buffer.calloc (bufferSize);
+        return (((int64) sourceNodeId) << 32) | ((inputChannel & 0xffff) << 16) | (sourceChannel & 0xffff);
     }
 
-    void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray <MidiBuffer>&, const int numSamples)
+    bool canBeUsedFor (const uint32 nodeId_, const Array<int64>& keys, const int minimumSize) const
+    {
+        if (nodeId_ != nodeId || size < minimumSize)
+            return false;
+
+        for (int i = keys.size(); --i >= 0;)
+            if (! laneKeys.contains (keys.getUnchecked (i)))
+                return false;
+
+        return true;
+    }
+
+    int getLane (const int64 laneKey) const     { return laneKeys.indexOf (laneKey); }
+
+    void process (const int lane, float* data, int numSamples, const int numSamplesDelay) noexcept
     {
-        float* data = sharedBufferChans.getSampleData (channel, 0);
+        jassert (isPositiveAndBelow (lane, laneKeys.size()) && isPositiveAndBelow (numSamplesDelay, size));
+
+        float* const ring = storage + lane * size;
+        int& writePos = writePositions [lane];
+
+        // (blocks that are longer than the lines were made for get done in pieces)
+        const int maxChunk = size - numSamplesDelay;
 
-        for (int i = numSamples; --i >= 0;)
+        while (numSamples > 0)
         {
-            buffer [writeIndex] = *data;
-            *data++ = buffer [readIndex];
+            const int num = jmin (numSamples, maxChunk);
 
-            if (++readIndex  >= bufferSize) readIndex = 0;
-            if (++writeIndex >= bufferSize) writeIndex = 0;
+            copyIntoRing (ring, writePos, data, num);
+            copyOutOfRing (ring, (writePos - numSamplesDelay) & (size - 1), data, num);
+
+            writePos = (writePos + num) & (size - 1);
+            data += num;
+            numSamples -= num;
         }
     }
 
+    typedef ReferenceCountedObjectPtr<DelayLines> Ptr;
+
+private:
+    const uint32 nodeId;
+    const Array<int64> laneKeys;
+    int size;
+    HeapBlock<float> storage;
+    HeapBlock<int> writePositions;
+
+    void copyIntoRing (float* const ring, const int pos, const float* const src, const int num) const noexcept
+    {
+        const int num1 = jmin (num, size - pos);
+        memcpy (ring + pos, src, sizeof (float) * (size_t) num1);
+        memcpy (ring, src + num1, sizeof (float) * (size_t) (num - num1));
+    }
+
+    void copyOutOfRing (const float* const ring, const int pos, float* const dest, const int num) const noexcept
+    {
+        const int num1 = jmin (num, size - pos);
+        memcpy (dest, ring + pos, sizeof (float) * (size_t) num1);
+        memcpy (dest + num1, ring, sizeof (float) * (size_t) (num - num1));
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (DelayLines);
+};
+
+//==============================================================================
+class DelayChannelOp : public AudioGraphRenderingOp
+{
+public:
+    DelayChannelOp (const int channel_, const int numSamplesDelay_, const int64 laneKey_)
+        : laneKey (laneKey_), numSamplesDelay (numSamplesDelay_),
+          channel (channel_), lane (0)
+    {
+    }
+
+    void setDelayLines (DelayLines* const lines)
+    {
+        delayLines = lines;
+        lane = lines->getLane (laneKey);
+        jassert (lane >= 0);
+    }
+
+    void perform (AudioSampleBuffer& sharedBufferChans, const OwnedArray <MidiBuffer>&, const int numSamples)
+    {
+        delayLines->process (lane, sharedBufferChans.getSampleData (channel, 0), numSamples, numSamplesDelay);
+    }
+
+    void addBuffersUsed (BufferUsage& usage) const
+    {
+        usage.writesAudio (channel);
+    }
+
+    const int64 laneKey;
+    const int numSamplesDelay;
+
 private:
-    HeapBlock<float> buffer;
-    const int channel, bufferSize;
-    int readIndex, writeIndex;
+    DelayLines::Ptr delayLines;
+    const int channel;
+    int lane;
 
     JUCE_DECLARE_NON_COPYABLE (DelayChannelOp);
 };
@@ -234,6 +395,26 @@ public:
         processor->processBlock (buffer, *sharedMidiBuffers.getUnchecked (midiBufferToUse));
     }
 
+    void addBuffersUsed (BufferUsage& usage) const
+    {
+        // (input-only channels get counted as writes too, as nothing stops the processor changing them)
+        for (int i = totalChans; --i >= 0;)
+            usage.writesAudio (audioChannelsToUse.getUnchecked (i));
+
+        usage.writesMidi (midiBufferToUse);
+
+        const AudioProcessorGraph::AudioGraphIOProcessor* const ioProc
+            = dynamic_cast <const AudioProcessorGraph::AudioGraphIOProcessor*> (processor);
+
+        if (ioProc != nullptr)
+        {
+            if (ioProc->getType() == AudioProcessorGraph::AudioGraphIOProcessor::audioOutputNode)
+                usage.writesGraphAudioOutput();
+            else if (ioProc->getType() == AudioProcessorGraph::AudioGraphIOProcessor::midiOutputNode)
+                usage.writesGraphMidiOutput();
+        }
+    }
+
     const AudioProcessorGraph::Node::Ptr node;
     AudioProcessor* const processor;
 
@@ -256,9 +437,14 @@ public:
     //==============================================================================
     RenderingOpSequenceCalculator (AudioProcessorGraph& graph_,
                                    const Array<void*>& orderedNodes_,
-                                   Array<void*>& renderingOps)
+                                   Array<void*>& renderingOps,
+                                   const ReferenceCountedArray<ReferenceCountedObject>& oldDelayLines_,
+                                   ReferenceCountedArray<ReferenceCountedObject>& newDelayLines_)
         : graph (graph_),
           orderedNodes (orderedNodes_),
+          oldDelayLines (oldDelayLines_),
+          newDelayLines (newDelayLines_),
+          numHostChannels (0),
           totalLatency (0)
     {
         nodeIds.add ((uint32) zeroNodeID); // first buffer is read-only zeros
@@ -266,30 +452,108 @@ public:
 
         midiNodeIds.add ((uint32) zeroNodeID);
 
+        if (canUseHostBuffer())
+        {
+            // The next few buffers are the host's own channels. The graph's audio input node just
+            // leaves its data where it is, and the output node's channels get rendered straight
+            // into them, so neither of them needs to copy anything..
+            numHostChannels = jmax (graph.getNumInputChannels(), graph.getNumOutputChannels());
+
+            // (once nothing needs the input that's in them, they get handed out like any other free
+            // buffer, which means that whatever gets rendered into them may not need copying at all)
+            for (int i = 0; i < numHostChannels; ++i)
+            {
+                nodeIds.add ((uint32) freeNodeID);
+                channels.add (0);
+                hostChannelsWritten.add (false);
+            }
+        }
+
         for (int i = 0; i < orderedNodes.size(); ++i)
         {
-            createRenderingOpsForNode ((AudioProcessorGraph::Node*) orderedNodes.getUnchecked(i),
-                                       renderingOps, i);
+            AudioProcessorGraph::Node* const node = (AudioProcessorGraph::Node*) orderedNodes.getUnchecked(i);
+
+            createRenderingOpsForNode (node, renderingOps, i);
+            assignDelayLines (node->nodeId);
 
             markAnyUnusedBuffersAsFree (i);
         }
 
+        // the host's channels that didn't get an output written to them may still have its input, or
+        // some other node's data in them..
+        for (int i = 0; i < numHostChannels; ++i)
+            if (! hostChannelsWritten.getUnchecked (i))
+                renderingOps.add (new ClearChannelOp (getHostChannelBuffer (i)));
+
         graph.setLatencySamples (totalLatency);
     }
 
     int getNumBuffersNeeded() const         { return nodeIds.size(); }
     int getNumMidiBuffersNeeded() const     { return midiNodeIds.size(); }
 
+    /** Returns the number of the host's channels that the ops work on directly, or 0 if the
+        graph's input and output have to be copied in and out instead.
+
+        These are buffers 1 to numHostChannels of the ones that the ops refer to.
+    */
+    int getNumHostChannels() const          { return numHostChannels; }
+
 private:
     //==============================================================================
     AudioProcessorGraph& graph;
-    const Array<void*>& orderedNodes;
+    Array<void*> orderedNodes;
+    const ReferenceCountedArray<ReferenceCountedObject>& oldDelayLines;
+    ReferenceCountedArray<ReferenceCountedObject>& newDelayLines;
+    Array<DelayChannelOp*> delayOpsForNode;
     Array <int> channels;
     Array <uint32> nodeIds, midiNodeIds;
 
-    enum { freeNodeID = 0xffffffff, zeroNodeID = 0xfffffffe };
+    enum { freeNodeID = 0xffffffff, zeroNodeID = 0xfffffffe, hostOutputID = 0xfffffffd };
+
+    static bool isNodeBusy (uint32 nodeID) noexcept
+    {
+        return nodeID != freeNodeID && nodeID != zeroNodeID && nodeID != hostOutputID;
+    }
+
+    int numHostChannels;
+    Array <bool> hostChannelsWritten;
+
+    static int getHostChannelBuffer (const int hostChannel) noexcept    { return hostChannel + 1; }
+
+    static bool isIONode (const AudioProcessorGraph::Node* const node,
+                          const AudioProcessorGraph::AudioGraphIOProcessor::IODeviceType type)
+    {
+        const AudioProcessorGraph::AudioGraphIOProcessor* const ioProc
+            = dynamic_cast <const AudioProcessorGraph::AudioGraphIOProcessor*> (node->getProcessor());
+
+        return ioProc != nullptr && ioProc->getType() == type;
+    }
+
+    bool canUseHostBuffer()
+    {
+        // With more than one audio input node, the host's input has to stay intact until they've all
+        // copied it, so only the old way of doing things will work..
+        int inputNodeIndex = -1;
+
+        for (int i = 0; i < orderedNodes.size(); ++i)
+        {
+            if (isIONode ((const AudioProcessorGraph::Node*) orderedNodes.getUnchecked(i),
+                          AudioProcessorGraph::AudioGraphIOProcessor::audioInputNode))
+            {
+                if (inputNodeIndex >= 0)
+                    return false;
+
+                inputNodeIndex = i;
+            }
+        }
+
+        // The input node has no inputs of its own, so it can always go first, before anything has
+        // had a chance to write into the host's channels.
+        if (inputNodeIndex > 0)
+            orderedNodes.move (inputNodeIndex, 0);
 
-    static bool isNodeBusy (uint32 nodeID) noexcept { return nodeID != freeNodeID && nodeID != zeroNodeID; }
+        return true;
+    }
 
     Array <uint32> nodeDelayIDs;
     Array <int> nodeDelays;
@@ -336,6 +600,16 @@ private:
         const int numOuts = node->getProcessor()->getNumOutputChannels();
         const int totalChans = jmax (numIns, numOuts);
 
+        if (numHostChannels > 0 && isIONode (node, AudioProcessorGraph::AudioGraphIOProcessor::audioInputNode))
+        {
+            // the input node's outputs are already sitting in the host's channels..
+            for (int i = jmin (numOuts, numHostChannels); --i >= 0;)
+                markBufferAsContaining (getHostChannelBuffer (i), node->nodeId, i);
+
+            setNodeDelay (node->nodeId, 0);
+            return;
+        }
+
         Array <int> audioChannelsToUse;
         int midiBufferToUse = -1;
 
@@ -389,7 +663,10 @@ private:
                     jassert (bufIndex >= 0);
                 }
 
-                if (inputChan < numOuts
+                const int nodeDelay = getNodeDelay (srcNode);
+
+                // (delaying the channel changes it too, even if this node doesn't have an output for it)
+                if ((inputChan < numOuts || nodeDelay < maxLatency)
                      && isBufferNeededLater (ourRenderingIndex,
                                              inputChan,
                                              srcNode, srcChan))
@@ -403,10 +680,8 @@ private:
                     bufIndex = newFreeBuffer;
                 }
 
-                const int nodeDelay = getNodeDelay (srcNode);
-
                 if (nodeDelay < maxLatency)
-                    renderingOps.add (new DelayChannelOp (bufIndex, maxLatency - nodeDelay));
+                    addDelayOp (renderingOps, bufIndex, maxLatency - nodeDelay, inputChan, srcNode, srcChan);
             }
             else
             {
@@ -432,7 +707,8 @@ private:
 
                         const int nodeDelay = getNodeDelay (sourceNodes.getUnchecked (i));
                         if (nodeDelay < maxLatency)
-                            renderingOps.add (new DelayChannelOp (sourceBufIndex, maxLatency - nodeDelay));
+                            addDelayOp (renderingOps, sourceBufIndex, maxLatency - nodeDelay, inputChan,
+                                        sourceNodes.getUnchecked (i), sourceOutputChans.getUnchecked (i));
 
                         break;
                     }
@@ -460,7 +736,8 @@ private:
                     const int nodeDelay = getNodeDelay (sourceNodes.getFirst());
 
                     if (nodeDelay < maxLatency)
-                        renderingOps.add (new DelayChannelOp (bufIndex, maxLatency - nodeDelay));
+                        addDelayOp (renderingOps, bufIndex, maxLatency - nodeDelay, inputChan,
+                                    sourceNodes.getUnchecked (0), sourceOutputChans.getUnchecked (0));
                 }
 
                 for (int j = 0; j < sourceNodes.size(); ++j)
@@ -479,13 +756,16 @@ private:
                                                            sourceNodes.getUnchecked(j),
                                                            sourceOutputChans.getUnchecked(j)))
                                 {
-                                    renderingOps.add (new DelayChannelOp (srcIndex, maxLatency - nodeDelay));
+                                    addDelayOp (renderingOps, srcIndex, maxLatency - nodeDelay, inputChan,
+                                                sourceNodes.getUnchecked (j), sourceOutputChans.getUnchecked (j));
+                                    renderingOps.add (new AddChannelOp (srcIndex, bufIndex));
                                 }
                                 else // buffer is reused elsewhere, can't be delayed
                                 {
                                     const int bufferToDelay = getFreeBuffer (false);
                                     renderingOps.add (new CopyChannelOp (srcIndex, bufferToDelay));
-                                    renderingOps.add (new DelayChannelOp (bufferToDelay, maxLatency - nodeDelay));
+                                    addDelayOp (renderingOps, bufferToDelay, maxLatency - nodeDelay, inputChan,
+                                                sourceNodes.getUnchecked (j), sourceOutputChans.getUnchecked (j));
                                     renderingOps.add (new AddChannelOp (bufferToDelay, bufIndex));
                                 }
                             }
@@ -619,8 +899,111 @@ private:
         if (numOuts == 0)
             totalLatency = maxLatency;
 
-        renderingOps.add (new ProcessBufferOp (node, audioChannelsToUse,
-                                               totalChans, midiBufferToUse));
+        if (numHostChannels > 0 && isIONode (node, AudioProcessorGraph::AudioGraphIOProcessor::audioOutputNode))
+            writeHostOutputChannels (renderingOps, audioChannelsToUse, ourRenderingIndex);
+        else
+            renderingOps.add (new ProcessBufferOp (node, audioChannelsToUse,
+                                                   totalChans, midiBufferToUse));
+    }
+
+    void writeHostOutputChannels (Array<void*>& renderingOps, Array<int>& audioChannelsToUse, const int ourRenderingIndex)
+    {
+        const int numChans = jmin (audioChannelsToUse.size(), numHostChannels);
+
+        for (int chan = 0; chan < numChans; ++chan)
+        {
+            const int bufIndex = audioChannelsToUse.getUnchecked (chan);
+            const int hostIndex = getHostChannelBuffer (chan);
+
+            if (bufIndex == getReadOnlyEmptyBuffer())
+                continue; // (nothing's connected to this channel)
+
+            if (hostChannelsWritten.getUnchecked (chan))
+            {
+                // another output node has already written to this channel..
+                renderingOps.add (new AddChannelOp (bufIndex, hostIndex));
+                continue;
+            }
+
+            if (bufIndex != hostIndex)
+            {
+                bool neededByLaterChannel = false;
+
+                for (int i = chan + 1; i < numChans; ++i)
+                    if (audioChannelsToUse.getUnchecked (i) == hostIndex)
+                        neededByLaterChannel = true;
+
+                if (neededByLaterChannel
+                     || (isNodeBusy (nodeIds.getUnchecked (hostIndex))
+                          && isBufferNeededLater (ourRenderingIndex + 1, -1,
+                                                  nodeIds.getUnchecked (hostIndex),
+                                                  channels.getUnchecked (hostIndex))))
+                {
+                    // the host channel still holds something that's needed, so move that out of the way first..
+                    const int newFreeBuffer = getFreeBuffer (false);
+                    renderingOps.add (new CopyChannelOp (hostIndex, newFreeBuffer));
+                    markBufferAsContaining (newFreeBuffer, nodeIds.getUnchecked (hostIndex), channels.getUnchecked (hostIndex));
+
+                    for (int i = chan + 1; i < numChans; ++i)
+                        if (audioChannelsToUse.getUnchecked (i) == hostIndex)
+                            audioChannelsToUse.set (i, newFreeBuffer);
+                }
+
+                renderingOps.add (new CopyChannelOp (bufIndex, hostIndex));
+            }
+
+            nodeIds.set (hostIndex, (uint32) hostOutputID);
+            hostChannelsWritten.set (chan, true);
+        }
+    }
+
+    //==============================================================================
+    void addDelayOp (Array<void*>& renderingOps, const int bufIndex, const int numSamplesDelay,
+                     const int inputChan, const uint32 sourceNodeId, const int sourceChan)
+    {
+        DelayChannelOp* const op = new DelayChannelOp (bufIndex, numSamplesDelay,
+                                                       DelayLines::getLaneKey (inputChan, sourceNodeId, sourceChan));
+        renderingOps.add (op);
+        delayOpsForNode.add (op);
+    }
+
+    void assignDelayLines (const uint32 nodeId)
+    {
+        if (delayOpsForNode.size() == 0)
+            return;
+
+        Array<int64> laneKeys;
+        int longestDelay = 0;
+        int i;
+
+        for (i = 0; i < delayOpsForNode.size(); ++i)
+        {
+            laneKeys.addIfNotAlreadyThere (delayOpsForNode.getUnchecked(i)->laneKey);
+            longestDelay = jmax (longestDelay, delayOpsForNode.getUnchecked(i)->numSamplesDelay);
+        }
+
+        const int minimumSize = jmax (graph.getMaxLatencyCompensation(), longestDelay) + jmax (1, graph.getBlockSize());
+
+        // re-use the node's old delay lines if they're big enough, so that their contents carry on..
+        DelayLines* lines = nullptr;
+
+        for (i = 0; i < oldDelayLines.size() && lines == nullptr; ++i)
+        {
+            DelayLines* const d = static_cast <DelayLines*> (oldDelayLines.getUnchecked(i).getObject());
+
+            if (d->canBeUsedFor (nodeId, laneKeys, minimumSize))
+                lines = d;
+        }
+
+        if (lines == nullptr)
+            lines = new DelayLines (nodeId, laneKeys, minimumSize);
+
+        newDelayLines.add (lines);
+
+        for (i = 0; i < delayOpsForNode.size(); ++i)
+            delayOpsForNode.getUnchecked(i)->setDelayLines (lines);
+
+        delayOpsForNode.clearQuick();
     }
 
     //==============================================================================
@@ -750,137 +1133,361 @@ private:
 };
 
 //==============================================================================
-// Holds a fast lookup table for checking which nodes are inputs to others.
-class ConnectionLookupTable
+struct ConnectionSorter
+{
+    static int compareElements (const AudioProcessorGraph::Connection* const first,
+                                const AudioProcessorGraph::Connection* const second) noexcept
+    {
+        if      (first->sourceNodeId < second->sourceNodeId)                return -1;
+        else if (first->sourceNodeId > second->sourceNodeId)                return 1;
+        else if (first->destNodeId < second->destNodeId)                    return -1;
+        else if (first->destNodeId > second->destNodeId)                    return 1;
+        else if (first->sourceChannelIndex < second->sourceChannelIndex)    return -1;
+        else if (first->sourceChannelIndex > second->sourceChannelIndex)    return 1;
+        else if (first->destChannelIndex < second->destChannelIndex)        return -1;
+        else if (first->destChannelIndex > second->destChannelIndex)        return 1;
+
+        return 0;
+    }
+};
+
+}
+
+//==============================================================================
+/*  For each of the rendering ops, a list of the other ops that have to finish before
+    it can start.
+
+    Two ops are ordered if they touch any of the same shared buffers and at least one
+    of them writes to it, so a buffer that the sequence calculator reuses for something
+    else only gets reused once everything reading the old contents has finished with it.
+    Every op gets its own task (rather than one per node), so that a node whose input
+    also gets copied elsewhere only has to wait for the copies, not the nodes they feed.
+*/
+class AudioProcessorGraph::RenderingTaskList
 {
 public:
-    explicit ConnectionLookupTable (const OwnedArray<AudioProcessorGraph::Connection>& connections)
+    RenderingTaskList (const Array<void*>& ops, const int numAudioChannels, const int numMidiBuffers)
     {
-        for (int i = 0; i < connections.size(); ++i)
+        const int numBuffers = GraphRenderingOps::BufferUsage (numAudioChannels, numMidiBuffers).getNumBuffers();
+
+        Array<int> lastWriter;
+        lastWriter.insertMultiple (0, -1, numBuffers);
+
+        OwnedArray<Array<int> > readersSinceWrite;
+
+        for (int i = numBuffers; --i >= 0;)
+            readersSinceWrite.add (new Array<int>());
+
+        for (int taskIndex = 0; taskIndex < ops.size(); ++taskIndex)
         {
-            const AudioProcessorGraph::Connection* const c = connections.getUnchecked(i);
+            Task* const task = new Task();
+            task->op = (GraphRenderingOps::AudioGraphRenderingOp*) ops.getUnchecked (taskIndex);
+
+            GraphRenderingOps::BufferUsage usage (numAudioChannels, numMidiBuffers);
+            task->op->addBuffersUsed (usage);
 
-            int index;
-            Entry* entry = findEntry (c->destNodeId, index);
+            SortedSet<int> dependencies;
+            int j;
 
-            if (entry == nullptr)
+            for (j = 0; j < usage.reads.size(); ++j)
+                if (lastWriter.getUnchecked (usage.reads.getUnchecked (j)) >= 0)
+                    dependencies.add (lastWriter.getUnchecked (usage.reads.getUnchecked (j)));
+
+            for (j = 0; j < usage.writes.size(); ++j)
+            {
+                const int buffer = usage.writes.getUnchecked (j);
+
+                if (lastWriter.getUnchecked (buffer) >= 0)
+                    dependencies.add (lastWriter.getUnchecked (buffer));
+
+                const Array<int>& readers = *readersSinceWrite.getUnchecked (buffer);
+
+                for (int k = 0; k < readers.size(); ++k)
+                    dependencies.add (readers.getUnchecked (k));
+            }
+
+            for (j = 0; j < usage.writes.size(); ++j)
             {
-                entry = new Entry (c->destNodeId);
-                entries.insert (index, entry);
+                lastWriter.set (usage.writes.getUnchecked (j), taskIndex);
+                readersSinceWrite.getUnchecked (usage.writes.getUnchecked (j))->clearQuick();
             }
 
-            entry->srcNodes.add (c->sourceNodeId);
+            for (j = 0; j < usage.reads.size(); ++j)
+                if (! usage.writes.contains (usage.reads.getUnchecked (j)))
+                    readersSinceWrite.getUnchecked (usage.reads.getUnchecked (j))->add (taskIndex);
+
+            task->numDependencies = dependencies.size();
+
+            for (j = 0; j < dependencies.size(); ++j)
+                tasks.getUnchecked (dependencies.getUnchecked (j))->dependents.add (taskIndex);
+
+            tasks.add (task);
         }
     }
 
-    bool isAnInputTo (const uint32 possibleInputId,
-                      const uint32 possibleDestinationId) const noexcept
+    //==============================================================================
+    struct Task
     {
-        return isAnInputToRecursive (possibleInputId, possibleDestinationId, entries.size());
-    }
+        GraphRenderingOps::AudioGraphRenderingOp* op;
+        int numDependencies;
+        Atomic<int> dependenciesLeft;
+        Array<int> dependents;
+    };
+
+    int size() const noexcept                       { return tasks.size(); }
+    Task& getTask (const int index) const noexcept  { return *tasks.getUnchecked (index); }
 
 private:
-    //==============================================================================
-    struct Entry
-    {
-        explicit Entry (const uint32 destNodeId_) noexcept : destNodeId (destNodeId_) {}
+    OwnedArray<Task> tasks;
 
-        const uint32 destNodeId;
-        SortedSet<uint32> srcNodes;
+    JUCE_DECLARE_NON_COPYABLE (RenderingTaskList);
+};
 
-        JUCE_DECLARE_NON_COPYABLE (Entry);
-    };
+//==============================================================================
+/*  Runs a RenderingTaskList on the audio thread plus some helper threads.
+
+    The tasks are handed out strictly in order from a shared counter, and whoever
+    takes one waits for its dependencies to be done before running it. Because the
+    list is in the same order as the serial sequence, anything a task is waiting for
+    has always been taken by a thread that's already busy with it, so it can't get
+    stuck. Nothing here allocates or locks while a block is being rendered.
+*/
+class AudioProcessorGraph::RenderThreadPool
+{
+public:
+    RenderThreadPool (const int numHelperThreads)
+        : tasks (nullptr), buffers (nullptr), midiBuffers (nullptr), numSamples (0)
+    {
+        for (int i = 0; i < numHelperThreads; ++i)
+            threads.add (new HelperThread (*this));
 
-    OwnedArray<Entry> entries;
+        for (int i = 0; i < threads.size(); ++i)
+            threads.getUnchecked (i)->startThread (9);
+    }
 
-    bool isAnInputToRecursive (const uint32 possibleInputId,
-                               const uint32 possibleDestinationId,
-                               int recursionCheck) const noexcept
+    ~RenderThreadPool()
     {
-        int index;
-        const Entry* const entry = findEntry (possibleDestinationId, index);
+        threads.clear();
+    }
 
-        if (entry != nullptr)
-        {
-            const SortedSet<uint32>& srcNodes = entry->srcNodes;
+    void render (const RenderingTaskList& tasks_, AudioSampleBuffer& buffers_,
+                 const OwnedArray<MidiBuffer>& midiBuffers_, const int numSamples_)
+    {
+        tasks = &tasks_;
+        buffers = &buffers_;
+        midiBuffers = &midiBuffers_;
+        numSamples = numSamples_;
 
-            if (srcNodes.contains (possibleInputId))
-                return true;
+        const int numTasks = tasks_.size();
 
-            if (--recursionCheck >= 0)
-            {
-                for (int i = 0; i < srcNodes.size(); ++i)
-                    if (isAnInputToRecursive (possibleInputId, srcNodes.getUnchecked(i), recursionCheck))
-                        return true;
-            }
+        for (int i = 0; i < numTasks; ++i)
+        {
+            RenderingTaskList::Task& task = tasks_.getTask (i);
+            task.dependenciesLeft.set (task.numDependencies);
         }
 
-        return false;
+        numTasksDone.set (0);
+        nextTask.set (((int64) numTasks) << 32);
+
+        for (int i = 0; i < threads.size(); ++i)
+            threads.getUnchecked (i)->notify();
+
+        performTasks();
+
+        for (int spins = 0; numTasksDone.get() < numTasks;)
+            if (++spins > 100)
+                Thread::yield();
+
+        nextTask.set (0);
     }
 
-    Entry* findEntry (const uint32 destNodeId, int& insertIndex) const noexcept
+private:
+    //==============================================================================
+    class HelperThread  : public Thread
     {
-        Entry* result = nullptr;
+    public:
+        HelperThread (RenderThreadPool& owner_)
+            : Thread ("Graph render"), owner (owner_)
+        {
+        }
 
-        int start = 0;
-        int end = entries.size();
+        ~HelperThread()
+        {
+            signalThreadShouldExit();
+            notify();
+            waitForThreadToExit (-1);
+        }
 
-        for (;;)
+        void run()
         {
-            if (start >= end)
-            {
-                break;
-            }
-            else if (destNodeId == entries.getUnchecked (start)->destNodeId)
+            for (;;)
             {
-                result = entries.getUnchecked (start);
-                break;
-            }
-            else
-            {
-                const int halfway = (start + end) / 2;
-
-                if (halfway == start)
-                {
-                    if (destNodeId >= entries.getUnchecked (halfway)->destNodeId)
-                        ++start;
+                wait (-1);
 
+                if (threadShouldExit())
                     break;
-                }
-                else if (destNodeId >= entries.getUnchecked (halfway)->destNodeId)
-                    start = halfway;
-                else
-                    end = halfway;
+
+                owner.performTasks();
             }
         }
 
-        insertIndex = start;
-        return result;
-    }
+    private:
+        RenderThreadPool& owner;
 
-    JUCE_DECLARE_NON_COPYABLE (ConnectionLookupTable);
-};
+        JUCE_DECLARE_NON_COPYABLE (HelperThread);
+    };
 
-//==============================================================================
-struct ConnectionSorter
-{
-    static int compareElements (const AudioProcessorGraph::Connection* const first,
-                                const AudioProcessorGraph::Connection* const second) noexcept
+    OwnedArray<HelperThread> threads;
+
+    // the number of tasks in the top half, and the index of the next one to take in the
+    // bottom half, so that a thread that's late for one block can't take a task from the next
+    Atomic<int64> nextTask;
+    Atomic<int> numTasksDone;
+
+    const RenderingTaskList* tasks;
+    AudioSampleBuffer* buffers;
+    const OwnedArray<MidiBuffer>* midiBuffers;
+    int numSamples;
+
+    void performTasks()
     {
-        if      (first->sourceNodeId < second->sourceNodeId)                return -1;
-        else if (first->sourceNodeId > second->sourceNodeId)                return 1;
-        else if (first->destNodeId < second->destNodeId)                    return -1;
-        else if (first->destNodeId > second->destNodeId)                    return 1;
-        else if (first->sourceChannelIndex < second->sourceChannelIndex)    return -1;
-        else if (first->sourceChannelIndex > second->sourceChannelIndex)    return 1;
-        else if (first->destChannelIndex < second->destChannelIndex)        return -1;
-        else if (first->destChannelIndex > second->destChannelIndex)        return 1;
+        for (;;)
+        {
+            const int64 state = nextTask.get();
+            const int index = (int) (state & 0xffffffff);
 
-        return 0;
+            if (index >= (int) (state >> 32))
+                break;
+
+            if (nextTask.compareAndSetBool (state + 1, state))
+                performTask (tasks->getTask (index));
+        }
     }
+
+    void performTask (RenderingTaskList::Task& task)
+    {
+        for (int spins = 0; task.dependenciesLeft.get() > 0;)
+            if (++spins > 100)
+                Thread::yield();
+
+        task.op->perform (*buffers, *midiBuffers, numSamples);
+
+        for (int i = 0; i < task.dependents.size(); ++i)
+            --(tasks->getTask (task.dependents.getUnchecked (i)).dependenciesLeft);
+
+        ++numTasksDone;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE (RenderThreadPool);
 };
 
-}
+//==============================================================================
+/*  Everything the audio thread needs to render one version of the graph: the ops,
+    the shared buffers they work on, and the task list for rendering them in parallel.
+
+    These get built away from the audio thread and handed over to it in one go, so
+    that nothing it's using ever gets changed or resized underneath it.
+*/
+class AudioProcessorGraph::RenderSequence
+{
+public:
+    RenderSequence()
+        : renderingBuffers (1, 1), sharedBuffers (1, 1), numHostChannels (0), nextRetired (nullptr)
+    {
+    }
+
+    ~RenderSequence()
+    {
+        for (int i = ops.size(); --i >= 0;)
+            delete (GraphRenderingOps::AudioGraphRenderingOp*) ops.getUnchecked(i);
+    }
+
+    void prepareBuffers (const int numRenderingBuffersNeeded, const int numMidiBuffersNeeded,
+                         const int numHostChannels_, const int blockSize)
+    {
+        renderingBuffers.setSize (numRenderingBuffersNeeded, jmax (1, blockSize));
+        renderingBuffers.clear();
+
+        // The ops work on this set of channels, which is the same as renderingBuffers except that
+        // the host's channels get swapped in at the start of each block
+        numHostChannels = numHostChannels_;
+        sharedBuffers.setDataToReferTo (renderingBuffers.getArrayOfChannels(),
+                                        numRenderingBuffersNeeded, renderingBuffers.getNumSamples());
+
+        while (midiBuffers.size() < numMidiBuffersNeeded)
+            midiBuffers.add (new MidiBuffer());
+
+        tasks = new RenderingTaskList (ops, numRenderingBuffersNeeded, numMidiBuffersNeeded);
+    }
+
+    void perform (RenderThreadPool* const threads, AudioSampleBuffer& hostBuffer, const int numSamples)
+    {
+        float** const channels = sharedBuffers.getArrayOfChannels();
+
+        for (int i = 0; i < numHostChannels; ++i)
+        {
+            if (i < hostBuffer.getNumChannels())
+            {
+                channels [i + 1] = hostBuffer.getSampleData (i);
+            }
+            else
+            {
+                // if the host's given us fewer channels than expected, the missing ones read as silence
+                channels [i + 1] = renderingBuffers.getSampleData (i + 1);
+                renderingBuffers.clear (i + 1, 0, numSamples);
+            }
+        }
+
+        if (threads != nullptr && tasks->size() > 1)
+        {
+            threads->render (*tasks, sharedBuffers, midiBuffers, numSamples);
+        }
+        else
+        {
+            for (int i = 0; i < ops.size(); ++i)
+                ((GraphRenderingOps::AudioGraphRenderingOp*) ops.getUnchecked(i))
+                    ->perform (sharedBuffers, midiBuffers, numSamples);
+        }
+    }
+
+    Array<void*> ops;
+    ScopedPointer<RenderingTaskList> tasks;
+    AudioSampleBuffer renderingBuffers, sharedBuffers;
+    OwnedArray<MidiBuffer> midiBuffers;
+
+    // if this is more than 0, the ops render straight into the host's buffer
+    int numHostChannels;
+
+    // (used to chain together the sequences that the audio thread has finished with)
+    RenderSequence* nextRetired;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE (RenderSequence);
+};
+
+//==============================================================================
+/*  Deletes the sequences that the audio thread has swapped out, on the message thread.
+*/
+class AudioProcessorGraph::RetiredSequenceDeleter  : public AsyncUpdater
+{
+public:
+    RetiredSequenceDeleter (AudioProcessorGraph& owner_) : owner (owner_) {}
+
+    ~RetiredSequenceDeleter()
+    {
+        cancelPendingUpdate();
+    }
+
+    void handleAsyncUpdate()
+    {
+        owner.deleteRetiredSequences();
+    }
+
+private:
+    AudioProcessorGraph& owner;
+
+    JUCE_DECLARE_NON_COPYABLE (RetiredSequenceDeleter);
+};
 
 //==============================================================================
 AudioProcessorGraph::Connection::Connection (const uint32 sourceNodeId_, const int sourceChannelIndex_,
@@ -890,15 +1497,58 @@ AudioProcessorGraph::Connection::Connection (const uint32 sourceNodeId_, const i
 {
 }
 
+//==============================================================================
+/*  Triggers a rebuild of the graph when a node's latency changes, so that its latency
+    compensation can be updated.
+*/
+class AudioProcessorGraph::Node::LatencyWatcher  : public AudioProcessorListener
+{
+public:
+    LatencyWatcher (AudioProcessorGraph& graph_, AudioProcessor& processor_)
+        : graph (graph_), processor (processor_)
+    {
+        compiledLatency = processor.getLatencySamples();
+        processor.addListener (this);
+    }
+
+    ~LatencyWatcher()
+    {
+        processor.removeListener (this);
+    }
+
+    void audioProcessorParameterChanged (AudioProcessor*, int, float)  {}
+
+    void audioProcessorChanged (AudioProcessor*)
+    {
+        if (processor.getLatencySamples() != compiledLatency.get())
+            graph.triggerAsyncUpdate();
+    }
+
+    // the latency that the current rendering sequence was worked out for
+    Atomic<int> compiledLatency;
+
+private:
+    AudioProcessorGraph& graph;
+    AudioProcessor& processor;
+
+    JUCE_DECLARE_NON_COPYABLE (LatencyWatcher);
+};
+
 //==============================================================================
 AudioProcessorGraph::Node::Node (const uint32 nodeId_, AudioProcessor* const processor_) noexcept
     : nodeId (nodeId_),
       processor (processor_),
-      isPrepared (false)
+      isPrepared (false),
+      renderIndex (0)
 {
     jassert (processor_ != nullptr);
 }
 
+AudioProcessorGraph::Node::~Node()
+{
+    latencyWatcher = nullptr;
+}
+
 void AudioProcessorGraph::Node::prepare (const double sampleRate, const int blockSize,
                                          AudioProcessorGraph* const graph)
 {
@@ -932,9 +1582,12 @@ void AudioProcessorGraph::Node::unprepare()
 //==============================================================================
 AudioProcessorGraph::AudioProcessorGraph()
     : lastNodeId (0),
-      renderingBuffers (1, 1),
-      currentAudioOutputBuffer (1, 1)
+      activeSequence (nullptr),
+      numRenderThreads (1),
+      maxLatencyCompensation (8192),
+      currentAudioOutputBuffer (nullptr)
 {
+    retiredSequenceDeleter = new RetiredSequenceDeleter (*this);
 }
 
 AudioProcessorGraph::~AudioProcessorGraph()
@@ -951,6 +1604,9 @@ const String AudioProcessorGraph::getName() const
 //==============================================================================
 void AudioProcessorGraph::clear()
 {
+    const ScopedLock sl (graphLock);
+
+    renderOrder.clear();
     nodes.clear();
     connections.clear();
     triggerAsyncUpdate();
@@ -973,6 +1629,8 @@ AudioProcessorGraph::Node* AudioProcessorGraph::addNode (AudioProcessor* const n
         return nullptr;
     }
 
+    const ScopedLock sl (graphLock);
+
     if (nodeId == 0)
     {
         nodeId = ++lastNodeId;
@@ -988,7 +1646,11 @@ AudioProcessorGraph::Node* AudioProcessorGraph::addNode (AudioProcessor* const n
     }
 
     Node* const n = new Node (nodeId, newProcessor);
+    n->latencyWatcher = new Node::LatencyWatcher (*this, *newProcessor);
     nodes.add (n);
+
+    n->renderIndex = renderOrder.size();
+    renderOrder.add (n);
     triggerAsyncUpdate();
 
     AudioProcessorGraph::AudioGraphIOProcessor* const ioProc
@@ -1002,18 +1664,28 @@ AudioProcessorGraph::Node* AudioProcessorGraph::addNode (AudioProcessor* const n
 
 bool AudioProcessorGraph::removeNode (const uint32 nodeId)
 {
+    const ScopedLock sl (graphLock);
+
     disconnectNode (nodeId);
 
     for (int i = nodes.size(); --i >= 0;)
     {
-        if (nodes.getUnchecked(i)->nodeId == nodeId)
+        Node* const n = nodes.getUnchecked(i);
+
+        if (n->nodeId == nodeId)
         {
             AudioProcessorGraph::AudioGraphIOProcessor* const ioProc
-                = dynamic_cast <AudioProcessorGraph::AudioGraphIOProcessor*> (static_cast<AudioProcessor*> (nodes.getUnchecked(i)->processor));
+                = dynamic_cast <AudioProcessorGraph::AudioGraphIOProcessor*> (static_cast<AudioProcessor*> (n->processor));
 
             if (ioProc != nullptr)
                 ioProc->setParentGraph (nullptr);
 
+            // removing a node can't break the ordering of the others, so they just move up
+            renderOrder.remove (n->renderIndex);
+
+            for (int j = n->renderIndex; j < renderOrder.size(); ++j)
+                renderOrder.getUnchecked(j)->renderIndex = j;
+
             nodes.remove (i);
             triggerAsyncUpdate();
 
@@ -1086,12 +1758,16 @@ bool AudioProcessorGraph::addConnection (const uint32 sourceNodeId,
                                          const uint32 destNodeId,
                                          const int destChannelIndex)
 {
+    const ScopedLock sl (graphLock);
+
     if (! canConnect (sourceNodeId, sourceChannelIndex, destNodeId, destChannelIndex))
         return false;
 
     GraphRenderingOps::ConnectionSorter sorter;
     connections.addSorted (sorter, new Connection (sourceNodeId, sourceChannelIndex,
                                                    destNodeId, destChannelIndex));
+
+    addToRenderOrder (getNodeForId (sourceNodeId), getNodeForId (destNodeId));
     triggerAsyncUpdate();
 
     return true;
@@ -1099,6 +1775,7 @@ bool AudioProcessorGraph::addConnection (const uint32 sourceNodeId,
 
 void AudioProcessorGraph::removeConnection (const int index)
 {
+    const ScopedLock sl (graphLock);
     connections.remove (index);
     triggerAsyncUpdate();
 }
@@ -1106,6 +1783,7 @@ void AudioProcessorGraph::removeConnection (const int index)
 bool AudioProcessorGraph::removeConnection (const uint32 sourceNodeId, const int sourceChannelIndex,
                                             const uint32 destNodeId, const int destChannelIndex)
 {
+    const ScopedLock sl (graphLock);
     bool doneAnything = false;
 
     for (int i = connections.size(); --i >= 0;)
@@ -1128,6 +1806,7 @@ bool AudioProcessorGraph::removeConnection (const uint32 sourceNodeId, const int
 
 bool AudioProcessorGraph::disconnectNode (const uint32 nodeId)
 {
+    const ScopedLock sl (graphLock);
     bool doneAnything = false;
 
     for (int i = connections.size(); --i >= 0;)
@@ -1147,6 +1826,7 @@ bool AudioProcessorGraph::disconnectNode (const uint32 nodeId)
 
 bool AudioProcessorGraph::removeIllegalConnections()
 {
+    const ScopedLock sl (graphLock);
     bool doneAnything = false;
 
     for (int i = connections.size(); --i >= 0;)
@@ -1178,15 +1858,28 @@ bool AudioProcessorGraph::removeIllegalConnections()
 //==============================================================================
 void AudioProcessorGraph::clearRenderingSequence()
 {
-    const ScopedLock sl (renderLock);
+    RenderSequence* oldSequence;
 
-    for (int i = renderingOps.size(); --i >= 0;)
     {
-        GraphRenderingOps::AudioGraphRenderingOp* const r
-            = (GraphRenderingOps::AudioGraphRenderingOp*) renderingOps.getUnchecked(i);
+        const ScopedLock sl (renderLock);
+        oldSequence = activeSequence;
+        activeSequence = nullptr;
+    }
+
+    delete oldSequence;
+    delete pendingSequence.exchange (nullptr);
+    deleteRetiredSequences();
+}
 
-        renderingOps.remove (i);
-        delete r;
+void AudioProcessorGraph::deleteRetiredSequences()
+{
+    RenderSequence* sequence = retiredSequences.exchange (nullptr);
+
+    while (sequence != nullptr)
+    {
+        RenderSequence* const next = sequence->nextRetired;
+        delete sequence;
+        sequence = next;
     }
 }
 
@@ -1210,61 +1903,152 @@ bool AudioProcessorGraph::isAnInputTo (const uint32 possibleInputId,
     return false;
 }
 
-void AudioProcessorGraph::buildRenderingSequence()
+void AudioProcessorGraph::addToRenderOrder (const Node* const source, const Node* const dest)
 {
-    Array<void*> newRenderingOps;
-    int numRenderingBuffersNeeded = 2;
-    int numMidiBuffersNeeded = 1;
+    /*  This keeps renderOrder sorted so that every node comes after its inputs, using
+        Pearce and Kelly's dynamic topological sort: if the new connection goes backwards,
+        only the nodes between its two ends can need to move. Connections that complete
+        a loop are left going backwards, and just get treated as feedback.
+    */
+    jassert (source != nullptr && dest != nullptr);
 
+    const int lowerBound = dest->renderIndex;
+    const int upperBound = source->renderIndex;
+
+    if (upperBound < lowerBound)
+        return;
+
+    const int numInRange = upperBound - lowerBound + 1;
+    HashMap<int, int> rangeIndexes;
+    int i;
+
+    for (i = 0; i < numInRange; ++i)
+        rangeIndexes.set ((int) renderOrder.getUnchecked (lowerBound + i)->nodeId, i);
+
+    // find the forward-going connections between the nodes in that range..
+    OwnedArray<SortedSet<int> > outputs, inputs;
+
+    for (i = 0; i < numInRange; ++i)
     {
-        MessageManagerLock mml;
+        outputs.add (new SortedSet<int>());
+        inputs.add (new SortedSet<int>());
+    }
 
-        Array<void*> orderedNodes;
+    for (i = 0; i < connections.size(); ++i)
+    {
+        const Connection* const c = connections.getUnchecked(i);
 
+        if (rangeIndexes.contains ((int) c->sourceNodeId) && rangeIndexes.contains ((int) c->destNodeId))
         {
-            const GraphRenderingOps::ConnectionLookupTable table (connections);
+            const int src = rangeIndexes [(int) c->sourceNodeId];
+            const int dst = rangeIndexes [(int) c->destNodeId];
 
-            for (int i = 0; i < nodes.size(); ++i)
+            if (src < dst)
             {
-                Node* const node = nodes.getUnchecked(i);
+                outputs.getUnchecked (src)->add (dst);
+                inputs.getUnchecked (dst)->add (src);
+            }
+        }
+    }
 
-                node->prepare (getSampleRate(), getBlockSize(), this);
+    // ..then everything in the range that depends on the destination, and everything the source depends on
+    SortedSet<int> movedForward, movedBack;
+    Array<int> stack;
 
-                int j = 0;
-                for (; j < orderedNodes.size(); ++j)
-                    if (table.isAnInputTo (node->nodeId, ((Node*) orderedNodes.getUnchecked(j))->nodeId))
-                      break;
+    stack.add (0);
+    movedForward.add (0);
+
+    while (stack.size() > 0)
+    {
+        const SortedSet<int>& next = *outputs.getUnchecked (stack.remove (stack.size() - 1));
 
-                orderedNodes.insert (j, node);
+        for (int j = 0; j < next.size(); ++j)
+        {
+            if (next.getUnchecked (j) == numInRange - 1)
+                return; // it's a feedback loop
+
+            if (! movedForward.contains (next.getUnchecked (j)))
+            {
+                movedForward.add (next.getUnchecked (j));
+                stack.add (next.getUnchecked (j));
             }
         }
+    }
 
-        GraphRenderingOps::RenderingOpSequenceCalculator calculator (*this, orderedNodes, newRenderingOps);
+    stack.add (numInRange - 1);
+    movedBack.add (numInRange - 1);
 
-        numRenderingBuffersNeeded = calculator.getNumBuffersNeeded();
-        numMidiBuffersNeeded = calculator.getNumMidiBuffersNeeded();
+    while (stack.size() > 0)
+    {
+        const SortedSet<int>& next = *inputs.getUnchecked (stack.remove (stack.size() - 1));
+
+        for (int j = 0; j < next.size(); ++j)
+        {
+            if (! movedBack.contains (next.getUnchecked (j)))
+            {
+                movedBack.add (next.getUnchecked (j));
+                stack.add (next.getUnchecked (j));
+            }
+        }
     }
 
-    Array<void*> oldRenderingOps (renderingOps);
+    // Both groups keep their own order, and share out the slots they were using, with
+    // the source's group going first
+    SortedSet<int> slots (movedBack);
+    Array<Node*> nodesToMove;
+
+    for (i = 0; i < movedBack.size(); ++i)
+        nodesToMove.add (renderOrder.getUnchecked (lowerBound + movedBack.getUnchecked (i)));
 
+    for (i = 0; i < movedForward.size(); ++i)
     {
-        // swap over to the new rendering sequence..
-        const ScopedLock sl (renderLock);
+        slots.add (movedForward.getUnchecked (i));
+        nodesToMove.add (renderOrder.getUnchecked (lowerBound + movedForward.getUnchecked (i)));
+    }
 
-        renderingBuffers.setSize (numRenderingBuffersNeeded, getBlockSize());
-        renderingBuffers.clear();
+    for (i = 0; i < slots.size(); ++i)
+    {
+        Node* const n = nodesToMove.getUnchecked (i);
+        n->renderIndex = lowerBound + slots.getUnchecked (i);
+        renderOrder.set (n->renderIndex, n);
+    }
+}
 
-        for (int i = midiBuffers.size(); --i >= 0;)
-            midiBuffers.getUnchecked(i)->clear();
+void AudioProcessorGraph::buildRenderingSequence()
+{
+    ScopedPointer<RenderSequence> newSequence (new RenderSequence());
 
-        while (midiBuffers.size() < numMidiBuffersNeeded)
-            midiBuffers.add (new MidiBuffer());
+    {
+        // (this only stops the graph being edited while the sequence is worked out; the
+        // audio thread never touches this lock)
+        const ScopedLock sl (graphLock);
 
-        renderingOps = newRenderingOps;
+        Array<void*> orderedNodes;
+
+        for (int i = 0; i < renderOrder.size(); ++i)
+        {
+            Node* const node = renderOrder.getUnchecked(i);
+            node->prepare (getSampleRate(), getBlockSize(), this);
+            node->latencyWatcher->compiledLatency = node->processor->getLatencySamples();
+            orderedNodes.add (node);
+        }
+
+        ReferenceCountedArray<ReferenceCountedObject> newDelayLines;
+        GraphRenderingOps::RenderingOpSequenceCalculator calculator (*this, orderedNodes, newSequence->ops,
+                                                                     delayLines, newDelayLines);
+        delayLines.swapWithArray (newDelayLines);
+
+        newSequence->prepareBuffers (calculator.getNumBuffersNeeded(),
+                                     calculator.getNumMidiBuffersNeeded(),
+                                     calculator.getNumHostChannels(),
+                                     getBlockSize());
     }
 
-    for (int i = oldRenderingOps.size(); --i >= 0;)
-        delete (GraphRenderingOps::AudioGraphRenderingOp*) oldRenderingOps.getUnchecked(i);
+    // Hand it over to the audio thread, which picks it up at the start of its next block. If
+    // it hadn't got round to taking the last one yet, that one can just be thrown away.
+    delete pendingSequence.exchange (newSequence.release());
+
+    deleteRetiredSequences();
 }
 
 void AudioProcessorGraph::handleAsyncUpdate()
@@ -1272,30 +2056,72 @@ void AudioProcessorGraph::handleAsyncUpdate()
     buildRenderingSequence();
 }
 
+//==============================================================================
+void AudioProcessorGraph::setMaxLatencyCompensation (const int numSamples)
+{
+    if (maxLatencyCompensation != numSamples)
+    {
+        maxLatencyCompensation = jmax (0, numSamples);
+        triggerAsyncUpdate();
+    }
+}
+
+void AudioProcessorGraph::setNumRenderThreads (int numThreads)
+{
+    numThreads = jmax (1, numThreads);
+
+    if (numThreads != numRenderThreads)
+    {
+        ScopedPointer<RenderThreadPool> newThreads (numThreads > 1 ? new RenderThreadPool (numThreads - 1) : nullptr);
+
+        {
+            const ScopedLock sl (renderLock);
+            renderThreads.swapWith (newThreads);
+            numRenderThreads = numThreads;
+        }
+    }
+}
+
 //==============================================================================
 void AudioProcessorGraph::prepareToPlay (double /*sampleRate*/, int estimatedSamplesPerBlock)
 {
     currentAudioInputBuffer = nullptr;
-    currentAudioOutputBuffer.setSize (jmax (1, getNumOutputChannels()), estimatedSamplesPerBlock);
+    currentAudioOutputBuffer = nullptr;
     currentMidiInputBuffer = nullptr;
     currentMidiOutputBuffer.clear();
 
+    {
+        // the output buffer is borrowed from this pool in processBlock(), so that
+        // the audio thread doesn't have to resize anything
+        const ScopedLock sl (renderLock);
+        outputBufferPool.prepare (jmax (1, getNumInputChannels(), getNumOutputChannels()),
+                                  estimatedSamplesPerBlock, 1);
+    }
+
     clearRenderingSequence();
     buildRenderingSequence();
 }
 
 void AudioProcessorGraph::releaseResources()
 {
-    for (int i = 0; i < nodes.size(); ++i)
-        nodes.getUnchecked(i)->unprepare();
+    {
+        const ScopedLock sl (graphLock);
+
+        for (int i = 0; i < nodes.size(); ++i)
+            nodes.getUnchecked(i)->unprepare();
 
-    renderingBuffers.setSize (1, 1);
-    midiBuffers.clear();
+        delayLines.clear();
+    }
+
+    clearRenderingSequence();
 
     currentAudioInputBuffer = nullptr;
-    currentAudioOutputBuffer.setSize (1, 1);
+    currentAudioOutputBuffer = nullptr;
     currentMidiInputBuffer = nullptr;
     currentMidiOutputBuffer.clear();
+
+    const ScopedLock sl (renderLock);
+    outputBufferPool.release();
 }
 
 void AudioProcessorGraph::processBlock (AudioSampleBuffer& buffer, MidiBuffer& midiMessages)
@@ -1305,22 +2131,57 @@ void AudioProcessorGraph::processBlock (AudioSampleBuffer& buffer, MidiBuffer& m
     const ScopedLock sl (renderLock);
 
     currentAudioInputBuffer = &buffer;
-    currentAudioOutputBuffer.setSize (jmax (1, buffer.getNumChannels()), numSamples);
-    currentAudioOutputBuffer.clear();
     currentMidiInputBuffer = &midiMessages;
     currentMidiOutputBuffer.clear();
 
-    int i;
-    for (i = 0; i < renderingOps.size(); ++i)
+    RenderSequence* const newSequence = pendingSequence.exchange (nullptr);
+
+    if (newSequence != nullptr)
+    {
+        // swap in the new sequence, and pass the old one back to be deleted on the message thread
+        RenderSequence* const oldSequence = activeSequence;
+        activeSequence = newSequence;
+
+        if (oldSequence != nullptr)
+        {
+            do
+            {
+                oldSequence->nextRetired = retiredSequences.get();
+            }
+            while (! retiredSequences.compareAndSetBool (oldSequence, oldSequence->nextRetired));
+
+            retiredSequenceDeleter->triggerAsyncUpdate();
+        }
+    }
+
+    if (activeSequence != nullptr && activeSequence->numHostChannels > 0)
     {
-        GraphRenderingOps::AudioGraphRenderingOp* const op
-            = (GraphRenderingOps::AudioGraphRenderingOp*) renderingOps.getUnchecked(i);
+        // the sequence renders in-place into the host's buffer..
+        activeSequence->perform (renderThreads, buffer, numSamples);
 
-        op->perform (renderingBuffers, midiBuffers, numSamples);
+        for (int i = activeSequence->numHostChannels; i < buffer.getNumChannels(); ++i)
+            buffer.clear (i, 0, numSamples);
     }
+    else
+    {
+        // If the host passes more channels than prepareToPlay() allowed for, the pool has to
+        // grow to fit them, but it keeps its new size, so this only allocates the first time.
+        if (buffer.getNumChannels() > outputBufferPool.getMaxNumChannels())
+            outputBufferPool.prepare (buffer.getNumChannels(), jmax (numSamples, outputBufferPool.getMaxNumSamples()), 1);
+
+        AudioBufferPool::Buffer outputBuffer (outputBufferPool, jmax (1, buffer.getNumChannels()), numSamples);
 
-    for (i = 0; i < buffer.getNumChannels(); ++i)
-        buffer.copyFrom (i, 0, currentAudioOutputBuffer, i, 0, numSamples);
+        currentAudioOutputBuffer = &outputBuffer.getBuffer();
+        currentAudioOutputBuffer->clear();
+
+        if (activeSequence != nullptr)
+            activeSequence->perform (renderThreads, buffer, numSamples);
+
+        for (int i = 0; i < buffer.getNumChannels(); ++i)
+            buffer.copyFrom (i, 0, *currentAudioOutputBuffer, i, 0, numSamples);
+
+        currentAudioOutputBuffer = nullptr;
+    }
 
     midiMessages.clear();
     midiMessages.addEvents (currentMidiOutputBuffer, 0, buffer.getNumSamples(), 0);
@@ -1406,10 +2267,12 @@ void AudioProcessorGraph::AudioGraphIOProcessor::processBlock (AudioSampleBuffer
     {
         case audioOutputNode:
         {
-            for (int i = jmin (graph->currentAudioOutputBuffer.getNumChannels(),
+            jassert (graph->currentAudioOutputBuffer != nullptr);
+
+            for (int i = jmin (graph->currentAudioOutputBuffer->getNumChannels(),
                                buffer.getNumChannels()); --i >= 0;)
             {
-                graph->currentAudioOutputBuffer.addFrom (i, 0, buffer, i, 0, buffer.getNumSamples());
+                graph->currentAudioOutputBuffer->addFrom (i, 0, buffer, i, 0, buffer.getNumSamples());
             }
 
             break;
@@ -1522,4 +2385,655 @@ void AudioProcessorGraph::AudioGraphIOProcessor::setParentGraph (AudioProcessorG
 }
 
 
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+#include "../../utilities/juce_UnitTest.h"
+#include "../../core/juce_Time.h"
+#include "../../maths/juce_Random.h"
+#include "../../core/juce_SystemStats.h"
+
+class AudioProcessorGraphTests  : public UnitTest
+{
+public:
+    AudioProcessorGraphTests() : UnitTest ("AudioProcessorGraph") {}
+
+    //==============================================================================
+    /*  A processor that sums its inputs, adds some noise and then does a fixed amount
+        of pointless sums on each sample, so that it costs about as much as a real one.
+    */
+    class TestProcessor  : public AudioProcessor
+    {
+    public:
+        TestProcessor (const int numIns, const int numOuts, const int64 seed_, const int workPerSample_)
+            : seed (seed_), random (seed_), workPerSample (workPerSample_)
+        {
+            setPlayConfigDetails (numIns, numOuts, 44100.0, 512);
+        }
+
+        const String getName() const                        { return "Test"; }
+        void prepareToPlay (double, int)                    { random.setSeed (seed); }
+        void releaseResources()                             {}
+
+        void processBlock (AudioSampleBuffer& buffer, MidiBuffer& midiMessages)
+        {
+            const float midiLevel = midiMessages.isEmpty() ? 0.0f : 0.01f;
+
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                float in = midiLevel;
+
+                for (int ch = 0; ch < getNumInputChannels(); ++ch)
+                    in += buffer.getSampleData (ch)[i] * (ch + 1) * 0.1f;
+
+                for (int ch = 0; ch < getNumOutputChannels(); ++ch)
+                {
+                    float out = in + random.nextFloat() * 0.1f;
+
+                    for (int j = workPerSample; --j >= 0;)
+                        out = out * 0.999f + 0.001f * (float) std::sin (out);
+
+                    buffer.getSampleData (ch)[i] = out;
+                }
+            }
+        }
+
+        const String getInputChannelName (int) const       { return String::empty; }
+        const String getOutputChannelName (int) const      { return String::empty; }
+        bool isInputChannelStereoPair (int) const           { return true; }
+        bool isOutputChannelStereoPair (int) const          { return true; }
+        bool acceptsMidi() const                            { return true; }
+        bool producesMidi() const                           { return false; }
+        AudioProcessorEditor* createEditor()                { return nullptr; }
+        bool hasEditor() const                              { return false; }
+        int getNumParameters()                              { return 0; }
+        const String getParameterName (int)                 { return String::empty; }
+        float getParameter (int)                            { return 0.0f; }
+        const String getParameterText (int)                 { return String::empty; }
+        void setParameter (int, float)                      {}
+        int getNumPrograms()                                { return 0; }
+        int getCurrentProgram()                             { return 0; }
+        void setCurrentProgram (int)                        {}
+        const String getProgramName (int)                   { return String::empty; }
+        void changeProgramName (int, const String&)         {}
+        void getStateInformation (JUCE_NAMESPACE::MemoryBlock&)    {}
+        void setStateInformation (const void*, int)         {}
+
+    private:
+        const int64 seed;
+        Random random;
+        const int workPerSample;
+    };
+
+    // Plays a click every so often
+    class ClickSource  : public TestProcessor
+    {
+    public:
+        ClickSource (const int interval_) : TestProcessor (0, 2, 0, 0), interval (interval_), position (0) {}
+
+        void prepareToPlay (double, int)    { position = 0; }
+
+        void processBlock (AudioSampleBuffer& buffer, MidiBuffer&)
+        {
+            buffer.clear();
+
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+                if ((position + i) % interval == interval - 1)
+                    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                        buffer.getSampleData (ch)[i] = 1.0f;
+
+            position += buffer.getNumSamples();
+        }
+
+    private:
+        const int interval;
+        int64 position;
+    };
+
+    // Delays its input by whatever its latency is set to
+    class LatentProcessor  : public TestProcessor
+    {
+    public:
+        LatentProcessor (const int latency) : TestProcessor (2, 2, 0, 0), position (0)
+        {
+            history.calloc (2 * historySize);
+            setLatencySamples (latency);
+        }
+
+        void processBlock (AudioSampleBuffer& buffer, MidiBuffer&)
+        {
+            for (int i = 0; i < buffer.getNumSamples(); ++i)
+            {
+                for (int ch = 0; ch < 2; ++ch)
+                {
+                    float* const h = history + ch * historySize;
+                    h [position] = buffer.getSampleData (ch)[i];
+                    buffer.getSampleData (ch)[i] = h [(position + historySize - getLatencySamples()) % historySize];
+                }
+
+                position = (position + 1) % historySize;
+            }
+        }
+
+    private:
+        enum { historySize = 8192 };
+        HeapBlock<float> history;
+        int position;
+    };
+
+    static const AudioSampleBuffer renderSamples (AudioProcessorGraph& graph, const int numBlocks)
+    {
+        AudioSampleBuffer result (2, numBlocks * blockSize), block (2, blockSize);
+
+        for (int i = 0; i < numBlocks; ++i)
+        {
+            renderBlock (graph, block, i);
+
+            for (int ch = 0; ch < 2; ++ch)
+                result.copyFrom (ch, i * blockSize, block, ch, 0, blockSize);
+        }
+
+        return result;
+    }
+
+    static int findLoudestSample (const AudioSampleBuffer& buffer)
+    {
+        int loudest = 0;
+
+        for (int i = 1; i < buffer.getNumSamples(); ++i)
+            if (std::abs (buffer.getSampleData (0)[i]) > std::abs (buffer.getSampleData (0)[loudest]))
+                loudest = i;
+
+        return loudest;
+    }
+
+    /*  Sends some clicks to the output directly and through a LatentProcessor, so that they
+        only come out as one click if the direct path gets delayed to match.
+    */
+    static LatentProcessor* createLatencyTestGraph (AudioProcessorGraph& graph, const int numPaths)
+    {
+        graph.setPlayConfigDetails (0, 2, 44100.0, blockSize);
+        graph.addNode (new AudioProcessorGraph::AudioGraphIOProcessor (AudioProcessorGraph::AudioGraphIOProcessor::audioOutputNode), audioOut);
+        graph.addNode (new ClickSource (4000), firstSource);
+
+        LatentProcessor* firstLatentProcessor = nullptr;
+
+        for (int i = 0; i < numPaths; ++i)
+        {
+            LatentProcessor* const p = new LatentProcessor (100 + 37 * i);
+            graph.addNode (p, (uint32) (effect + 100 + i));
+
+            if (firstLatentProcessor == nullptr)
+                firstLatentProcessor = p;
+
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                graph.addConnection (firstSource, ch, (uint32) (effect + 100 + i), ch);
+                graph.addConnection ((uint32) (effect + 100 + i), ch, audioOut, ch);
+            }
+        }
+
+        for (int ch = 0; ch < 2; ++ch)
+            graph.addConnection (firstSource, ch, audioOut, ch);
+
+        graph.prepareToPlay (44100.0, blockSize);
+        return firstLatentProcessor;
+    }
+
+    //==============================================================================
+    /*  Builds the same sort of graph that the plugin host's FilterGraph would have for
+        a multi-instrument patch: some synths fed from the midi input, summed by a mixer
+        and going through an effect, plus a couple of side chains straight to the output.
+    */
+    enum { midiIn = 1, audioOut = 2, mixer = 3, effect = 4, sideEffect = 5, firstSource = 100 };
+
+    static void createTestGraph (AudioProcessorGraph& graph, const int numSources, const int workPerSample)
+    {
+        graph.setPlayConfigDetails (0, 2, 44100.0, blockSize);
+
+        graph.addNode (new AudioProcessorGraph::AudioGraphIOProcessor (AudioProcessorGraph::AudioGraphIOProcessor::midiInputNode), midiIn);
+        graph.addNode (new AudioProcessorGraph::AudioGraphIOProcessor (AudioProcessorGraph::AudioGraphIOProcessor::audioOutputNode), audioOut);
+        graph.addNode (new TestProcessor (numSources * 2, 2, 1, workPerSample), mixer);
+        graph.addNode (new TestProcessor (2, 2, 2, workPerSample), effect);
+        graph.addNode (new TestProcessor (2, 2, 3, workPerSample), sideEffect);
+
+        for (int i = 0; i < numSources; ++i)
+        {
+            const uint32 source = (uint32) (firstSource + i);
+            graph.addNode (new TestProcessor (0, 2, 10 + i, workPerSample), source);
+            graph.addConnection (midiIn, AudioProcessorGraph::midiChannelIndex, source, AudioProcessorGraph::midiChannelIndex);
+
+            for (int ch = 0; ch < 2; ++ch)
+                graph.addConnection (source, ch, mixer, i * 2 + ch);
+        }
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            graph.addConnection (mixer, ch, effect, ch);
+            graph.addConnection (effect, ch, audioOut, ch);
+            graph.addConnection (firstSource, ch, sideEffect, ch);
+            graph.addConnection (sideEffect, ch, audioOut, ch);
+            graph.addConnection ((uint32) firstSource + 1, ch, audioOut, ch);
+        }
+
+        graph.prepareToPlay (44100.0, blockSize);
+    }
+
+    static void renderBlock (AudioProcessorGraph& graph, AudioSampleBuffer& buffer, const int blockNum)
+    {
+        MidiBuffer midi;
+
+        if (blockNum % 4 == 0)
+            midi.addEvent (MidiMessage::noteOn (1, 60 + blockNum % 12, 0.8f), 0);
+
+        buffer.clear();
+        graph.processBlock (buffer, midi);
+    }
+
+    /*  Makes a chain of processors, adding the nodes and connections in whatever order
+        it's given, so that the graph has to keep re-sorting them.
+    */
+    static void createChain (AudioProcessorGraph& graph, const int numNodes,
+                             const bool addNodesBackwards, Random& connectionOrder)
+    {
+        graph.setPlayConfigDetails (0, 2, 44100.0, blockSize);
+        graph.addNode (new AudioProcessorGraph::AudioGraphIOProcessor (AudioProcessorGraph::AudioGraphIOProcessor::audioOutputNode), audioOut);
+
+        for (int i = 0; i < numNodes; ++i)
+        {
+            const int n = addNodesBackwards ? numNodes - 1 - i : i;
+            graph.addNode (new TestProcessor (2, 2, 10 + n, 1), (uint32) (firstSource + n));
+        }
+
+        Array<int> links;
+
+        for (int i = 0; i < numNodes; ++i)
+            links.insert (connectionOrder.nextInt (links.size() + 1), i);
+
+        for (int i = 0; i < links.size(); ++i)
+        {
+            const int n = links.getUnchecked (i);
+            const uint32 dest = (uint32) (n < numNodes - 1 ? firstSource + n + 1 : audioOut);
+
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                graph.addConnection ((uint32) (firstSource + n), ch, dest, ch);
+
+                // ..with some extra links that skip a few nodes
+                if (n + 3 < numNodes)
+                    graph.addConnection ((uint32) (firstSource + n), ch, (uint32) (firstSource + n + 3), 1 - ch);
+            }
+        }
+
+        // and a feedback loop, which has to end up being treated the same way in both
+        graph.addConnection ((uint32) (firstSource + numNodes - 1), 0, (uint32) firstSource, 0);
+
+        graph.prepareToPlay (44100.0, blockSize);
+    }
+
+    /*  Wires the audio input through a few processors to two output nodes, with the channels
+        crossed over, a dry path mixed in and some latency to compensate for. With a second
+        audio input node, the graph has to copy its input and output instead of rendering in-place.
+    */
+    static void createInPlaceTestGraph (AudioProcessorGraph& graph, const bool withSecondInputNode)
+    {
+        enum { audioIn = 10, secondAudioOut = 11, secondAudioIn = 12 };
+
+        graph.setPlayConfigDetails (2, 2, 44100.0, blockSize);
+        graph.addNode (new AudioProcessorGraph::AudioGraphIOProcessor (AudioProcessorGraph::AudioGraphIOProcessor::audioOutputNode), audioOut);
+        graph.addNode (new AudioProcessorGraph::AudioGraphIOProcessor (AudioProcessorGraph::AudioGraphIOProcessor::audioOutputNode), secondAudioOut);
+        graph.addNode (new AudioProcessorGraph::AudioGraphIOProcessor (AudioProcessorGraph::AudioGraphIOProcessor::audioInputNode), audioIn);
+        graph.addNode (new TestProcessor (2, 2, 1, 0), effect);
+        graph.addNode (new LatentProcessor (50), sideEffect);
+
+        if (withSecondInputNode)
+            graph.addNode (new AudioProcessorGraph::AudioGraphIOProcessor (AudioProcessorGraph::AudioGraphIOProcessor::audioInputNode), secondAudioIn);
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            graph.addConnection (audioIn, ch, effect, 1 - ch);
+            graph.addConnection (effect, ch, audioOut, 1 - ch);
+            graph.addConnection (audioIn, ch, audioOut, ch);
+            graph.addConnection (audioIn, ch, sideEffect, ch);
+            graph.addConnection (sideEffect, ch, secondAudioOut, ch);
+        }
+
+        graph.addConnection (audioIn, 0, secondAudioOut, 1);
+        graph.prepareToPlay (44100.0, blockSize);
+    }
+
+    class RenderThread  : public Thread
+    {
+    public:
+        RenderThread (AudioProcessorGraph& graph_)
+            : Thread ("Graph test"), graph (graph_), numBlocks (0), slowestBlockMs (0)
+        {
+        }
+
+        ~RenderThread()
+        {
+            stopThread (-1);
+        }
+
+        void run()
+        {
+            AudioSampleBuffer buffer (2, blockSize);
+
+            while (! threadShouldExit())
+            {
+                const double startTime = Time::getMillisecondCounterHiRes();
+                renderBlock (graph, buffer, numBlocks++);
+                slowestBlockMs = jmax (slowestBlockMs, Time::getMillisecondCounterHiRes() - startTime);
+
+                // (leave some time for the other thread, like a real audio callback would)
+                Thread::sleep (1);
+            }
+        }
+
+        AudioProcessorGraph& graph;
+        int numBlocks;
+        double slowestBlockMs;
+    };
+
+    //==============================================================================
+    void runTest()
+    {
+        beginTest ("Latency compensation");
+
+        {
+            AudioProcessorGraph graph;
+            LatentProcessor* const latentProcessor = createLatencyTestGraph (graph, 1);
+            expectEquals (graph.getLatencySamples(), 100);
+
+            AudioSampleBuffer output (renderSamples (graph, 16));
+            expectEquals (findLoudestSample (output), 4099);
+            expectEquals (output.getSampleData (0)[4099], 2.0f);
+
+            // (there's no message loop running here, so do what the async update would)
+            latentProcessor->setLatencySamples (300);
+            graph.handleAsyncUpdate();
+            expectEquals (graph.getLatencySamples(), 300);
+
+            // (the clicks are at 3999, 7999, 11999.. and this starts at 8192)
+            output = renderSamples (graph, 16);
+            expectEquals (output.getSampleData (0)[11999 + 300 - 8192], 2.0f);
+            expectEquals (output.getSampleData (0)[15999 + 300 - 8192], 2.0f);
+            expectEquals (output.getMagnitude (11999 + 301 - 8192, 3000), 0.0f);
+
+            graph.releaseResources();
+        }
+
+        beginTest ("Latency compensation keeps going through a rebuild");
+
+        {
+            AudioProcessorGraph rebuilt, notRebuilt;
+            createLatencyTestGraph (rebuilt, 3);
+            createLatencyTestGraph (notRebuilt, 3);
+
+            bool allTheSame = true;
+
+            for (int i = 0; i < 40; ++i)
+            {
+                // rebuild while there are clicks inside the delay lines..
+                if (i % 8 == 7)
+                    rebuilt.handleAsyncUpdate();
+
+                const AudioSampleBuffer out1 (renderSamples (rebuilt, 1));
+                const AudioSampleBuffer out2 (renderSamples (notRebuilt, 1));
+
+                for (int ch = 0; ch < 2; ++ch)
+                    allTheSame = allTheSame && memcmp (out1.getSampleData (ch), out2.getSampleData (ch),
+                                                       sizeof (float) * blockSize) == 0;
+            }
+
+            expect (allTheSame);
+
+            rebuilt.releaseResources();
+            notRebuilt.releaseResources();
+        }
+
+        beginTest ("Latency compensation speed");
+
+        {
+            AudioProcessorGraph graph;
+            createLatencyTestGraph (graph, 64);
+
+            const int numBlocks = 200;
+            const double startTime = Time::getMillisecondCounterHiRes();
+            renderSamples (graph, numBlocks);
+            const double msPerBlock = (Time::getMillisecondCounterHiRes() - startTime) / numBlocks;
+
+            logMessage ("64 stereo paths with different latencies: " + String (msPerBlock, 3) + "ms per block");
+            graph.releaseResources();
+        }
+
+        beginTest ("Render order");
+
+        {
+            Random random (1234);
+            AudioProcessorGraph inOrder, shuffled;
+            createChain (inOrder, 40, false, random);
+            createChain (shuffled, 40, true, random);
+
+            AudioSampleBuffer inOrderOut (2, blockSize), shuffledOut (2, blockSize);
+            bool allTheSame = true;
+
+            for (int i = 0; i < 20; ++i)
+            {
+                renderBlock (inOrder, inOrderOut, i);
+                renderBlock (shuffled, shuffledOut, i);
+
+                for (int ch = 0; ch < 2; ++ch)
+                    allTheSame = allTheSame && memcmp (inOrderOut.getSampleData (ch), shuffledOut.getSampleData (ch),
+                                                       sizeof (float) * blockSize) == 0;
+            }
+
+            expect (allTheSame);
+            expect (inOrderOut.getMagnitude (0, blockSize) > 0.0f);
+
+            inOrder.releaseResources();
+            shuffled.releaseResources();
+        }
+
+        beginTest ("Editing while rendering");
+
+        {
+            AudioProcessorGraph graph;
+            createTestGraph (graph, 8, 1);
+
+            RenderThread renderThread (graph);
+            renderThread.startThread (9);
+
+            double slowestRebuildMs = 0;
+
+            for (int i = 0; i < 200; ++i)
+            {
+                const uint32 newNode = (uint32) (1000 + i);
+                graph.addNode (new TestProcessor (2, 2, i, 1), newNode);
+
+                for (int ch = 0; ch < 2; ++ch)
+                {
+                    graph.addConnection ((uint32) (firstSource + i % 8), ch, newNode, ch);
+                    graph.addConnection (newNode, ch, audioOut, ch);
+                }
+
+                if (i > 0 && (i & 1) != 0)
+                    graph.removeNode (newNode - 1);
+
+                // (there's no message loop running here, so this does what the async update would)
+                const double startTime = Time::getMillisecondCounterHiRes();
+                graph.handleAsyncUpdate();
+                slowestRebuildMs = jmax (slowestRebuildMs, Time::getMillisecondCounterHiRes() - startTime);
+
+                Thread::sleep (1);
+            }
+
+            renderThread.stopThread (-1);
+            expect (renderThread.numBlocks > 0);
+
+            logMessage (String (renderThread.numBlocks) + " blocks rendered during 200 edits, slowest block "
+                          + String (renderThread.slowestBlockMs, 3) + "ms, slowest rebuild " + String (slowestRebuildMs, 3) + "ms");
+
+            graph.releaseResources();
+        }
+
+        beginTest ("Rebuild speed");
+
+        {
+            Random random (4321);
+            AudioProcessorGraph graph;
+
+            double startTime = Time::getMillisecondCounterHiRes();
+            createChain (graph, 1000, true, random);
+            const double msToCreate = Time::getMillisecondCounterHiRes() - startTime;
+
+            startTime = Time::getMillisecondCounterHiRes();
+            graph.handleAsyncUpdate();
+            const double msToRebuild = Time::getMillisecondCounterHiRes() - startTime;
+
+            logMessage ("Creating a graph of 1000 nodes and 4000 connections took " + String (msToCreate, 1)
+                          + "ms, and rebuilding its rendering sequence takes " + String (msToRebuild, 1) + "ms");
+            graph.releaseResources();
+        }
+
+        beginTest ("Rendering in-place matches copying");
+
+        {
+            AudioProcessorGraph inPlace, copying;
+            createInPlaceTestGraph (inPlace, false);
+            createInPlaceTestGraph (copying, true);
+
+            // (the host can pass more channels than the graph uses, which should come back silent)
+            AudioSampleBuffer inPlaceBuffer (3, blockSize), copyingBuffer (2, blockSize);
+            Random random (5678);
+            MidiBuffer midi;
+            bool allTheSame = true;
+
+            for (int i = 0; i < 20; ++i)
+            {
+                for (int ch = 0; ch < 3; ++ch)
+                    for (int j = 0; j < blockSize; ++j)
+                        inPlaceBuffer.getSampleData (ch)[j] = random.nextFloat() - 0.5f;
+
+                copyingBuffer.copyFrom (0, 0, inPlaceBuffer, 0, 0, blockSize);
+                copyingBuffer.copyFrom (1, 0, inPlaceBuffer, 1, 0, blockSize);
+
+                inPlace.processBlock (inPlaceBuffer, midi);
+                copying.processBlock (copyingBuffer, midi);
+
+                for (int ch = 0; ch < 2; ++ch)
+                    allTheSame = allTheSame && memcmp (inPlaceBuffer.getSampleData (ch), copyingBuffer.getSampleData (ch),
+                                                       sizeof (float) * blockSize) == 0;
+            }
+
+            expect (allTheSame);
+            expect (inPlaceBuffer.getMagnitude (0, blockSize) > 0.0f);
+            expectEquals (inPlaceBuffer.getMagnitude (2, 0, blockSize), 0.0f);
+
+            inPlace.releaseResources();
+            copying.releaseResources();
+        }
+
+        beginTest ("The output buffer pool only grows once");
+
+        {
+            AudioProcessorGraph graph;
+            createInPlaceTestGraph (graph, true);
+
+            // (the host can pass more channels than the graph was prepared for)
+            AudioSampleBuffer buffer (4, blockSize);
+            MidiBuffer midi;
+            float* firstBlockData = nullptr;
+            bool neverReallocated = true;
+
+            for (int i = 0; i < 20; ++i)
+            {
+                buffer.clear();
+                graph.processBlock (buffer, midi);
+
+                // the pool hands out the same memory every time, unless it's been reallocated
+                AudioBufferPool::Buffer b (graph.outputBufferPool, buffer.getNumChannels(), buffer.getNumSamples());
+
+                if (firstBlockData == nullptr)
+                    firstBlockData = b.getInterleavedData();
+                else
+                    neverReallocated = neverReallocated && b.getInterleavedData() == firstBlockData;
+            }
+
+            expect (neverReallocated);
+            expect (graph.outputBufferPool.getMaxNumChannels() >= buffer.getNumChannels());
+
+            graph.releaseResources();
+        }
+
+        beginTest ("Parallel rendering matches serial");
+
+        {
+            AudioProcessorGraph serial, parallel;
+            createTestGraph (serial, 8, 4);
+            createTestGraph (parallel, 8, 4);
+            parallel.setNumRenderThreads (4);
+            expectEquals (parallel.getNumRenderThreads(), 4);
+
+            AudioSampleBuffer serialOut (2, blockSize), parallelOut (2, blockSize);
+            bool allTheSame = true;
+
+            for (int i = 0; i < 200; ++i)
+            {
+                renderBlock (serial, serialOut, i);
+                renderBlock (parallel, parallelOut, i);
+
+                for (int ch = 0; ch < 2; ++ch)
+                    allTheSame = allTheSame && memcmp (serialOut.getSampleData (ch), parallelOut.getSampleData (ch),
+                                                       sizeof (float) * blockSize) == 0;
+
+                // change the number of threads while it's running, too..
+                if (i == 100)
+                    parallel.setNumRenderThreads (2);
+            }
+
+            expect (allTheSame);
+            expect (serialOut.getMagnitude (0, blockSize) > 0.0f);
+
+            parallel.releaseResources();
+            serial.releaseResources();
+        }
+
+        beginTest ("Speed");
+
+        {
+            AudioProcessorGraph graph;
+            createTestGraph (graph, 8, 50);
+            AudioSampleBuffer output (2, blockSize);
+            const int numBlocks = 100;
+
+            for (int numThreads = 1; numThreads <= 4; numThreads *= 2)
+            {
+                graph.setNumRenderThreads (numThreads);
+                renderBlock (graph, output, 0);
+
+                const double startTime = Time::getMillisecondCounterHiRes();
+
+                for (int i = 0; i < numBlocks; ++i)
+                    renderBlock (graph, output, i);
+
+                const double msPerBlock = (Time::getMillisecondCounterHiRes() - startTime) / numBlocks;
+
+                logMessage (String (numThreads) + " thread(s): " + String (msPerBlock, 3) + "ms per "
+                              + String (blockSize) + "-sample block, on " + String (SystemStats::getNumCpus()) + " CPU(s)");
+            }
+
+            graph.setNumRenderThreads (1);
+            graph.releaseResources();
+        }
+    }
+
+    enum { blockSize = 512 };
+};
+
+static AudioProcessorGraphTests audioProcessorGraphTests;
+
+#endif
+
+
 END_JUCE_NAMESPACE
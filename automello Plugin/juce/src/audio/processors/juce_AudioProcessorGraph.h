@@ -27,6 +27,7 @@
 #define __JUCE_AUDIOPROCESSORGRAPH_JUCEHEADER__
 
 #include "juce_AudioProcessor.h"
+#include "../dsp/juce_AudioBufferPool.h"
 #include "../plugin_host/juce_AudioPluginFormatManager.h"
 #include "../plugin_host/juce_KnownPluginList.h"
 #include "../../containers/juce_NamedValueSet.h"
@@ -46,6 +47,11 @@
 
     To play back a graph through an audio device, you might want to use an
     AudioProcessorPlayer object.
+
+    Changes to the nodes and connections are picked up asynchronously: the new
+    rendering sequence is worked out on the message thread (or whichever thread
+    calls prepareToPlay()), and handed over to the audio thread without it ever
+    having to wait for a lock.
 */
 class JUCE_API  AudioProcessorGraph   : public AudioProcessor,
                                         public AsyncUpdater
@@ -97,8 +103,13 @@ public:
 
         const ScopedPointer<AudioProcessor> processor;
         bool isPrepared;
+        int renderIndex;
+
+        class LatencyWatcher;
+        ScopedPointer<LatencyWatcher> latencyWatcher;
 
         Node (uint32 nodeId, AudioProcessor* processor) noexcept;
+        ~Node();
 
         void prepare (double sampleRate, int blockSize, AudioProcessorGraph* graph);
         void unprepare();
@@ -254,6 +265,42 @@ public:
     */
     bool removeIllegalConnections();
 
+    //==============================================================================
+    /** Sets how many threads the graph uses to render each block.
+
+        With the default of 1, the nodes are processed one after another on the thread
+        that calls processBlock(). With more than that, the graph starts (numThreads - 1)
+        helper threads, and nodes that don't depend on each other's output get processed
+        at the same time, with the calling thread joining in.
+
+        The result is bit-identical to rendering serially, because each of the shared
+        buffers still has exactly the same operations done to it in the same order. But
+        it does mean that different processors will be running at the same time, so
+        only turn this on if they're all happy with that. A processor is never run on
+        two threads at once.
+    */
+    void setNumRenderThreads (int numThreads);
+
+    /** Returns the number of threads set with setNumRenderThreads(). */
+    int getNumRenderThreads() const noexcept                    { return numRenderThreads; }
+
+    //==============================================================================
+    /** Sets the longest delay, in samples, that the graph's latency compensation should
+        be ready for.
+
+        When processors with different latencies feed into the same node, the graph
+        delays the quicker paths to keep everything lined up. Its delay lines are made
+        long enough for this much latency up-front, so that when a processor's latency
+        changes (up to this limit) the graph can adjust without reallocating anything or
+        losing the audio that's in them. Longer delays still work, but need new delay lines.
+
+        The default is 8192 samples.
+    */
+    void setMaxLatencyCompensation (int numSamples);
+
+    /** Returns the value set by setMaxLatencyCompensation(). */
+    int getMaxLatencyCompensation() const noexcept              { return maxLatencyCompensation; }
+
     //==============================================================================
     /** A special number that represents the midi channel of a node.
 
@@ -399,21 +446,35 @@ private:
     //==============================================================================
     ReferenceCountedArray <Node> nodes;
     OwnedArray <Connection> connections;
+    Array <Node*> renderOrder;
     uint32 lastNodeId;
-    AudioSampleBuffer renderingBuffers;
-    OwnedArray <MidiBuffer> midiBuffers;
+    CriticalSection graphLock, renderLock;
+
+    class RenderingTaskList;
+    class RenderThreadPool;
+    class RenderSequence;
+    class RetiredSequenceDeleter;
+    RenderSequence* activeSequence;
+    Atomic <RenderSequence*> pendingSequence, retiredSequences;
+    ScopedPointer<RetiredSequenceDeleter> retiredSequenceDeleter;
+    ScopedPointer<RenderThreadPool> renderThreads;
+    int numRenderThreads;
 
-    CriticalSection renderLock;
-    Array<void*> renderingOps;
+    ReferenceCountedArray <ReferenceCountedObject> delayLines;
+    int maxLatencyCompensation;
 
     friend class AudioGraphIOProcessor;
+    friend class AudioProcessorGraphTests;
     AudioSampleBuffer* currentAudioInputBuffer;
-    AudioSampleBuffer currentAudioOutputBuffer;
+    AudioSampleBuffer* currentAudioOutputBuffer;
+    AudioBufferPool outputBufferPool;
     MidiBuffer* currentMidiInputBuffer;
     MidiBuffer currentMidiOutputBuffer;
 
     void clearRenderingSequence();
     void buildRenderingSequence();
+    void deleteRetiredSequences();
+    void addToRenderOrder (const Node* source, const Node* dest);
 
     bool isAnInputTo (uint32 possibleInputId, uint32 possibleDestinationId, int recursionCheck) const;
 
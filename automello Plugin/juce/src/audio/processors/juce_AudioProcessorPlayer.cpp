@@ -28,6 +28,8 @@
 BEGIN_JUCE_NAMESPACE
 
 #include "juce_AudioProcessorPlayer.h"
+#include "../../core/juce_Time.h"
+#include "../../threads/juce_Thread.h"
 
 
 //==============================================================================
@@ -36,9 +38,14 @@ AudioProcessorPlayer::AudioProcessorPlayer()
       sampleRate (0),
       blockSize (0),
       isPrepared (false),
+      ticksPerSample (0),
+      lastCallbackStartTicks (0),
+      lastDeadlineTicks (0),
       numInputChans (0),
       numOutputChans (0),
-      tempBuffer (1, 1)
+      tempBuffer (1, 1),
+      currentDevice (nullptr),
+      wasFreewheeling (false)
 {
 }
 
@@ -67,6 +74,9 @@ void AudioProcessorPlayer::setProcessor (AudioProcessor* const processorToPlay)
             oldOne = isPrepared ? processor : nullptr;
             processor = processorToPlay;
             isPrepared = true;
+
+            callbackProcessor = processorToPlay;
+            waitForCallbackToFinish();
         }
 
         if (oldOne != nullptr)
@@ -74,6 +84,17 @@ void AudioProcessorPlayer::setProcessor (AudioProcessor* const processorToPlay)
     }
 }
 
+void AudioProcessorPlayer::waitForCallbackToFinish() const
+{
+    // If a callback's in progress, it might have picked up the old processor before it
+    // got swapped, so wait for it to finish. Any later ones will see the new processor.
+    const int count = callbackCounter.get();
+
+    if ((count & 1) != 0)
+        while (callbackCounter.get() == count)
+            Thread::yield();
+}
+
 //==============================================================================
 void AudioProcessorPlayer::audioDeviceIOCallback (const float** const inputChannelData,
                                                   const int numInputChannels,
@@ -84,6 +105,10 @@ void AudioProcessorPlayer::audioDeviceIOCallback (const float** const inputChann
     // these should have been prepared by audioDeviceAboutToStart()...
     jassert (sampleRate > 0 && blockSize > 0);
 
+    ++callbackCounter;
+    const int64 startTicks = Time::getHighResolutionTicks();
+    const bool freewheeling = currentDevice != nullptr && currentDevice->isFreewheeling();
+
     incomingMidi.clear();
     messageCollector.removeNextBlockOfMessages (incomingMidi, numSamples);
     int i, totalNumChans = 0;
@@ -93,6 +118,8 @@ void AudioProcessorPlayer::audioDeviceIOCallback (const float** const inputChann
         // if there aren't enough output channels for the number of
         // inputs, we need to create some temporary extra ones (can't
         // use the input data in case it gets written to)
+        // (this was allocated in audioDeviceAboutToStart(), so it'll only need
+        // resizing if the device sends a bigger block than it said it would)
         tempBuffer.setSize (numInputChannels - numOutputChannels, numSamples,
                             false, false, true);
 
@@ -129,36 +156,65 @@ void AudioProcessorPlayer::audioDeviceIOCallback (const float** const inputChann
 
     AudioSampleBuffer buffer (channels, totalNumChans, numSamples);
 
-    const ScopedLock sl (lock);
+    AudioProcessor* const currentProcessor = callbackProcessor.get();
 
-    if (processor != nullptr)
+    if (currentProcessor != nullptr)
     {
-        const ScopedLock sl2 (processor->getCallbackLock());
+        // (this only changes the processor's mode when the device goes in or out of
+        // freewheeling, so it won't undo a setNonRealtime() call made by anyone else)
+        if (freewheeling != wasFreewheeling)
+        {
+            wasFreewheeling = freewheeling;
+            currentProcessor->setNonRealtime (freewheeling);
+        }
+
+        // The callback lock is only held by other threads while they're suspending or
+        // reconfiguring the processor, so rather than waiting for them, this block just
+        // gets skipped, the same as if it was suspended.
+        const ScopedTryLock sl (currentProcessor->getCallbackLock());
 
-        if (processor->isSuspended())
+        if (sl.isLocked() && ! currentProcessor->isSuspended())
         {
-            for (i = 0; i < numOutputChannels; ++i)
-                zeromem (outputChannelData[i], sizeof (float) * numSamples);
+            currentProcessor->processBlock (buffer, incomingMidi);
         }
         else
         {
-            processor->processBlock (buffer, incomingMidi);
+            for (i = 0; i < numOutputChannels; ++i)
+                zeromem (outputChannelData[i], sizeof (float) * numSamples);
         }
     }
+
+    ++callbackCounter;
+
+    // (a freewheeling device has no deadlines to miss)
+    if (freewheeling)
+        lastCallbackStartTicks = 0;
+    else
+        addBlockToCpuStats (startTicks, numSamples);
 }
 
 void AudioProcessorPlayer::audioDeviceAboutToStart (AudioIODevice* device)
 {
     const ScopedLock sl (lock);
 
+    currentDevice = device;
+    wasFreewheeling = false;
     sampleRate = device->getCurrentSampleRate();
     blockSize = device->getCurrentBufferSizeSamples();
     numInputChans = device->getActiveInputChannels().countNumberOfSetBits();
     numOutputChans = device->getActiveOutputChannels().countNumberOfSetBits();
 
     messageCollector.reset (sampleRate);
+    incomingMidi.ensureSize (2048);
     zeromem (channels, sizeof (channels));
 
+    // (so that the audio thread won't need to allocate this)
+    tempBuffer.setSize (jmax (1, numInputChans - numOutputChans), jmax (1, blockSize));
+
+    ticksPerSample = sampleRate > 0 ? Time::getHighResolutionTicksPerSecond() / sampleRate : 0.0;
+    lastCallbackStartTicks = 0;
+    resetCpuStats();
+
     if (processor != nullptr)
     {
         if (isPrepared)
@@ -177,6 +233,7 @@ void AudioProcessorPlayer::audioDeviceStopped()
     if (processor != nullptr && isPrepared)
         processor->releaseResources();
 
+    currentDevice = nullptr;
     sampleRate = 0.0;
     blockSize = 0;
     isPrepared = false;
@@ -188,5 +245,92 @@ void AudioProcessorPlayer::handleIncomingMidiMessage (MidiInput*, const MidiMess
     messageCollector.addMessageToQueue (message);
 }
 
+//==============================================================================
+void AudioProcessorPlayer::addBlockToCpuStats (const int64 startTicks, const int numSamples) noexcept
+{
+    const int64 endTicks = Time::getHighResolutionTicks();
+    const int64 deadlineTicks = jmax ((int64) 1, (int64) (numSamples * ticksPerSample));
+    const int load = (int) jmin ((int64) 1000000, ((endTicks - startTicks) * 1000) / deadlineTicks);
+
+    CpuCounters& c = cpuCounters;
+    ++c.numBlocks;
+    c.processingTicks += endTicks - startTicks;
+    c.deadlineTicks += deadlineTicks;
+    ++c.histogram [jmin ((int) CpuStats::numHistogramBins - 1, load / 50)];
+    c.latestLoad = load;
+
+    if (load > c.peakLoad.get())
+        c.peakLoad = load;
+
+    if (load > 1000)
+        ++c.numOverruns;
+
+    // A callback that's on time starts one block after the previous one, so a gap of
+    // more than three blocks means it's over two blocks late. (Only this thread ever
+    // touches these two members)
+    if (lastCallbackStartTicks != 0 && startTicks - lastCallbackStartTicks > 3 * lastDeadlineTicks)
+        ++c.numDropouts;
+
+    lastCallbackStartTicks = startTicks;
+    lastDeadlineTicks = deadlineTicks;
+}
+
+const AudioProcessorPlayer::CpuStats AudioProcessorPlayer::getCpuStats() const
+{
+    const CpuCounters& c = cpuCounters;
+    CpuStats stats;
+
+    stats.numBlocks = c.numBlocks.get();
+    stats.numOverruns = c.numOverruns.get();
+    stats.numDropouts = c.numDropouts.get();
+
+    const int64 deadlineTicks = c.deadlineTicks.get();
+    stats.averageLoad = deadlineTicks > 0 ? c.processingTicks.get() / (double) deadlineTicks : 0.0;
+    stats.peakLoad = c.peakLoad.get() / 1000.0;
+    stats.latestLoad = c.latestLoad.get() / 1000.0;
+
+    for (int i = 0; i < CpuStats::numHistogramBins; ++i)
+        stats.histogram[i] = c.histogram[i].get();
+
+    return stats;
+}
+
+void AudioProcessorPlayer::resetCpuStats()
+{
+    // (if a block is being rendered while this happens, it may only get partly counted)
+    CpuCounters& c = cpuCounters;
+    c.numBlocks = 0;
+    c.numOverruns = 0;
+    c.numDropouts = 0;
+    c.processingTicks = 0;
+    c.deadlineTicks = 0;
+    c.peakLoad = 0;
+    c.latestLoad = 0;
+
+    for (int i = 0; i < CpuStats::numHistogramBins; ++i)
+        c.histogram[i] = 0;
+}
+
+const String AudioProcessorPlayer::CpuStats::getSummary() const
+{
+    String s;
+    s << String (numBlocks) << " blocks, average load " << String (averageLoad * 100.0, 1)
+      << "%, peak " << String (peakLoad * 100.0, 1) << "%, " << String (numOverruns) << " overruns, "
+      << String (numDropouts) << " dropouts; load histogram:";
+
+    for (int i = 0; i < numHistogramBins; ++i)
+    {
+        if (histogram[i] > 0)
+        {
+            if (i < numHistogramBins - 1)
+                s << ' ' << (i * 5) << '-' << (i * 5 + 5) << "%=" << String (histogram[i]);
+            else
+                s << " over=" << String (histogram[i]);
+        }
+    }
+
+    return s;
+}
+
 
 END_JUCE_NAMESPACE
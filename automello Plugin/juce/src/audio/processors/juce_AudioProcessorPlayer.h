@@ -30,6 +30,7 @@
 #include "../devices/juce_AudioIODevice.h"
 #include "../midi/juce_MidiInput.h"
 #include "../midi/juce_MidiMessageCollector.h"
+#include "../../memory/juce_Atomic.h"
 
 
 //==============================================================================
@@ -42,6 +43,12 @@
     It's also a MidiInputCallback, so you can connect it to both an audio and midi
     input to send both streams through the processor.
 
+    The audio callback never waits for a lock: the processor gets handed over to it
+    through an atomic pointer, and setProcessor() waits on the message thread until
+    the audio thread has finished with the old one. It also keeps track of how long
+    each block takes to render, compared with the time the device allows for it - see
+    getCpuStats().
+
     @see AudioProcessor, AudioProcessorGraph
 */
 class JUCE_API  AudioProcessorPlayer    : public AudioIODeviceCallback,
@@ -61,6 +68,10 @@ public:
 
         The processor that is passed in will not be deleted or owned by this object.
         To stop anything playing, pass in 0 to this method.
+
+        If the device is running, this waits until any audio callback that might still
+        be using the old processor has finished, so once it returns, the old one can
+        safely be deleted. Don't call it from the audio thread!
     */
     void setProcessor (AudioProcessor* processorToPlay);
 
@@ -74,6 +85,48 @@ public:
     */
     MidiMessageCollector& getMidiMessageCollector()                 { return messageCollector; }
 
+    //==============================================================================
+    /** A snapshot of how long the processor has been taking to render its blocks.
+
+        The "load" of a block is the time it took to process, divided by the length
+        of audio it contained, so anything above 1.0 means that the block missed its
+        deadline.
+
+        @see getCpuStats
+    */
+    struct JUCE_API  CpuStats
+    {
+        /** The histogram has one bin for each 5% of load, up to 100%, and the last
+            bin counts the blocks that went over.
+        */
+        enum { numHistogramBins = 21 };
+
+        int64 numBlocks;            /**< The number of blocks that have been rendered. */
+        int64 numOverruns;          /**< The number of blocks that took longer to render than they lasted. */
+        int64 numDropouts;          /**< The number of callbacks that came more than two blocks late,
+                                         which usually means that the device glitched. */
+        double averageLoad;         /**< The total processing time, divided by the total length of the blocks. */
+        double peakLoad;            /**< The highest load that any block has had. */
+        double latestLoad;          /**< The load of the most recent block, e.g. for a CPU meter. */
+        int64 histogram [numHistogramBins];
+
+        /** Returns a one-line description of these stats, for logging. */
+        const String getSummary() const;
+    };
+
+    /** Returns the stats for the blocks that have been rendered since the device
+        was started, or since the last call to resetCpuStats().
+
+        This can be called from any thread, and doesn't interfere with the audio
+        thread, although the values may be a block or so out of step with each other.
+
+        Blocks that are rendered while the device is freewheeling aren't counted.
+    */
+    const CpuStats getCpuStats() const;
+
+    /** Clears the CPU stats. */
+    void resetCpuStats();
+
     //==============================================================================
     /** @internal */
     void audioDeviceIOCallback (const float** inputChannelData,
@@ -91,18 +144,38 @@ public:
 private:
     //==============================================================================
     AudioProcessor* processor;
+    Atomic <AudioProcessor*> callbackProcessor;
+    Atomic <int> callbackCounter;  // (odd while the audio callback is running)
     CriticalSection lock;
     double sampleRate;
     int blockSize;
     bool isPrepared;
 
+    // (these are only ever written by the audio thread, apart from being reset)
+    struct CpuCounters
+    {
+        Atomic <int64> numBlocks, numOverruns, numDropouts, processingTicks, deadlineTicks;
+        Atomic <int> peakLoad, latestLoad; // (in 1/1000ths)
+        Atomic <int64> histogram [CpuStats::numHistogramBins];
+    };
+
+    CpuCounters cpuCounters;
+    double ticksPerSample;
+    int64 lastCallbackStartTicks, lastDeadlineTicks;
+
     int numInputChans, numOutputChans;
     float* channels [128];
     AudioSampleBuffer tempBuffer;
 
+    AudioIODevice* currentDevice;
+    bool wasFreewheeling;
+
     MidiBuffer incomingMidi;
     MidiMessageCollector messageCollector;
 
+    void waitForCallbackToFinish() const;
+    void addBlockToCpuStats (int64 startTicks, int numSamples) noexcept;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioProcessorPlayer);
 };
 
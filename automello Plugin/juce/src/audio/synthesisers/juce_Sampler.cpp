@@ -38,7 +38,8 @@ SamplerSound::SamplerSound (const String& name_,
                             const int midiNoteForNormalPitch,
                             const double attackTimeSecs,
                             const double releaseTimeSecs,
-                            const double maxSampleLengthSeconds)
+                            const double maxSampleLengthSeconds,
+                            const bool storeCompressed)
     : name (name_),
       midiNotes (midiNotes_),
       midiRootNote (midiNoteForNormalPitch)
@@ -56,9 +57,16 @@ SamplerSound::SamplerSound (const String& name_,
         length = jmin ((int) source.lengthInSamples,
                        (int) (maxSampleLengthSeconds * sourceSampleRate));
 
-        data = new AudioSampleBuffer (jmin (2, (int) source.numChannels), length + 4);
+        if (storeCompressed)
+        {
+            compressedData = new CompressedAudioBuffer (source, 0, length + 4, 2);
+        }
+        else
+        {
+            data = new AudioSampleBuffer (jmin (2, (int) source.numChannels), length + 4);
 
-        data->readFromAudioReader (&source, 0, length + 4, 0, true, true);
+            data->readFromAudioReader (&source, 0, length + 4, 0, true, true);
+        }
 
         attackSamples = roundToInt (attackTimeSecs * sourceSampleRate);
         releaseSamples = roundToInt (releaseTimeSecs * sourceSampleRate);
@@ -88,7 +96,8 @@ SamplerVoice::SamplerVoice()
       lgain (0.0f),
       rgain (0.0f),
       isInAttack (false),
-      isInRelease (false)
+      isInRelease (false),
+      blockCache (2)
 {
 }
 
@@ -117,6 +126,7 @@ void SamplerVoice::startNote (const int midiNoteNumber,
         pitchRatio = (targetFreq * sound->sourceSampleRate) / (naturalFreq * getSampleRate());
 
         sourceSamplePosition = 0.0;
+        blockCache.setSource (sound->compressedData);
         lgain = velocity;
         rgain = velocity;
 
@@ -174,9 +184,16 @@ void SamplerVoice::renderNextBlock (AudioSampleBuffer& outputBuffer, int startSa
 
     if (playingSound != nullptr)
     {
-        const float* const inL = playingSound->data->getSampleData (0, 0);
-        const float* const inR = playingSound->data->getNumChannels() > 1
-                                    ? playingSound->data->getSampleData (1, 0) : nullptr;
+        const CompressedAudioBuffer* const compressedData = playingSound->compressedData;
+        const float* inL = nullptr;
+        const float* inR = nullptr;
+        int inStart = 0;
+
+        if (compressedData == nullptr)
+        {
+            inL = playingSound->data->getSampleData (0, 0);
+            inR = playingSound->data->getNumChannels() > 1 ? playingSound->data->getSampleData (1, 0) : nullptr;
+        }
 
         float* outL = outputBuffer.getSampleData (0, startSample);
         float* outR = outputBuffer.getNumChannels() > 1 ? outputBuffer.getSampleData (1, startSample) : nullptr;
@@ -187,9 +204,20 @@ void SamplerVoice::renderNextBlock (AudioSampleBuffer& outputBuffer, int startSa
             const float alpha = (float) (sourceSamplePosition - pos);
             const float invAlpha = 1.0f - alpha;
 
+            if (compressedData != nullptr)
+            {
+                // make sure the blocks around this position have been decoded..
+                blockCache.prepareToRead (pos);
+                inStart = blockCache.getStartSample();
+                inL = blockCache.getSampleData (0);
+                inR = compressedData->getNumChannels() > 1 ? blockCache.getSampleData (1) : nullptr;
+            }
+
+            const int index = pos - inStart;
+
             // just using a very simple linear interpolation here..
-            float l = (inL [pos] * invAlpha + inL [pos + 1] * alpha);
-            float r = (inR != nullptr) ? (inR [pos] * invAlpha + inR [pos + 1] * alpha)
+            float l = (inL [index] * invAlpha + inL [index + 1] * alpha);
+            float r = (inR != nullptr) ? (inR [index] * invAlpha + inR [index + 1] * alpha)
                                        : l;
 
             l *= lgain;
@@ -28,6 +28,7 @@
 
 #include "../../maths/juce_BigInteger.h"
 #include "../../memory/juce_ScopedPointer.h"
+#include "../dsp/juce_CompressedAudioBuffer.h"
 #include "juce_Synthesiser.h"
 
 
@@ -36,7 +37,8 @@
     A subclass of SynthesiserSound that represents a sampled audio clip.
 
     This is a pretty basic sampler, and just attempts to load the whole audio stream
-    into memory.
+    into memory. To save space, the audio can be held in a CompressedAudioBuffer
+    instead, in which case each SamplerVoice decodes it as it plays.
 
     To use it, create a Synthesiser, add some SamplerVoice objects to it, then
     give it some SampledSound objects to play.
@@ -64,6 +66,9 @@ public:
         @param releaseTimeSecs  the decay (fade-out) time, in seconds
         @param maxSampleLengthSeconds   a maximum length of audio to read from the audio
                                         source, in seconds
+        @param storeCompressed  if true, the audio is kept in a CompressedAudioBuffer rather
+                                than an AudioSampleBuffer. This uses far less memory, at the
+                                cost of some decoding work in the voices that play it
     */
     SamplerSound (const String& name,
                   AudioFormatReader& source,
@@ -71,7 +76,8 @@ public:
                   int midiNoteForNormalPitch,
                   double attackTimeSecs,
                   double releaseTimeSecs,
-                  double maxSampleLengthSeconds);
+                  double maxSampleLengthSeconds,
+                  bool storeCompressed = false);
 
     /** Destructor. */
     ~SamplerSound();
@@ -81,10 +87,16 @@ public:
     const String& getName() const                           { return name; }
 
     /** Returns the audio sample data.
-        This could be 0 if there was a problem loading it.
+        This could be 0 if there was a problem loading it, or if the sound was
+        created with the storeCompressed option.
     */
     AudioSampleBuffer* getAudioData() const                 { return data; }
 
+    /** Returns the compressed audio data.
+        This will be 0 unless the sound was created with the storeCompressed option.
+    */
+    CompressedAudioBuffer* getCompressedAudioData() const   { return compressedData; }
+
 
     //==============================================================================
     bool appliesToNote (const int midiNoteNumber);
@@ -97,6 +109,7 @@ private:
 
     String name;
     ScopedPointer <AudioSampleBuffer> data;
+    ScopedPointer <CompressedAudioBuffer> compressedData;
     double sourceSampleRate;
     BigInteger midiNotes;
     int length, attackSamples, releaseSamples;
@@ -150,6 +163,7 @@ private:
     double sourceSamplePosition;
     float lgain, rgain, attackReleaseLevel, attackDelta, releaseDelta;
     bool isInAttack, isInRelease;
+    CompressedAudioBuffer::BlockCache blockCache;
 
     JUCE_LEAK_DETECTOR (SamplerVoice);
 };
@@ -34,6 +34,25 @@ BEGIN_JUCE_NAMESPACE
  #include "../events/juce_MessageManager.h"
 #endif
 
+//==============================================================================
+static bool juceInitialisedNonGUI = false;
+
+JUCE_API void JUCE_CALLTYPE initialiseJuce_NonGUI()
+{
+    juceInitialisedNonGUI = true;
+}
+
+JUCE_API void JUCE_CALLTYPE shutdownJuce_NonGUI()
+{
+    if (juceInitialisedNonGUI)
+    {
+        juceInitialisedNonGUI = false;
+
+        JUCE_AUTORELEASEPOOL
+        DeletedAtShutdown::deleteAll();
+    }
+}
+
 //==============================================================================
 #if ! JUCE_ONLY_BUILD_CORE_LIBRARY
 
@@ -51,6 +51,25 @@ JUCE_API void JUCE_CALLTYPE  initialiseJuce_GUI();
 */
 JUCE_API void JUCE_CALLTYPE  shutdownJuce_GUI();
 
+//==============================================================================
+/** Initialises Juce's non-GUI classes.
+
+    If you're writing a command-line app that doesn't use the START_JUCE_APPLICATION
+    macro or any GUI classes, call this function before making any Juce calls.
+
+    @see shutdownJuce_NonGUI()
+*/
+JUCE_API void JUCE_CALLTYPE  initialiseJuce_NonGUI();
+
+/** Clears up any static data being used by Juce's non-GUI classes.
+
+    Call this at the end of a command-line app, so that any singletons and other
+    DeletedAtShutdown objects get deleted before the leak-detectors check for leaks.
+
+    @see initialiseJuce_NonGUI()
+*/
+JUCE_API void JUCE_CALLTYPE  shutdownJuce_NonGUI();
+
 
 //==============================================================================
 /** A utility object that helps you initialise and shutdown Juce correctly
@@ -77,6 +96,31 @@ public:
 };
 
 
+//==============================================================================
+/** A utility object that helps you initialise and shutdown Juce correctly
+    using an RAII pattern.
+
+    When an instance of this class is created, it calls initialiseJuce_NonGUI(),
+    and when it's deleted, it calls shutdownJuce_NonGUI(), which lets you easily
+    make sure that these functions are matched correctly.
+
+    This class is particularly handy to use at the beginning of a console app's
+    main() function, because it'll take care of shutting down whenever you return
+    from the main() call.
+
+    @see ScopedJuceInitialiser_GUI
+*/
+class ScopedJuceInitialiser_NonGUI
+{
+public:
+    /** The constructor simply calls initialiseJuce_NonGUI(). */
+    ScopedJuceInitialiser_NonGUI()      { initialiseJuce_NonGUI(); }
+
+    /** The destructor simply calls shutdownJuce_NonGUI(). */
+    ~ScopedJuceInitialiser_NonGUI()     { shutdownJuce_NonGUI(); }
+};
+
+
 //==============================================================================
 /*
     To start a JUCE app, use this macro: START_JUCE_APPLICATION (AppSubClass) where
@@ -102,6 +102,10 @@
   #include <intrin.h>
 #endif
 
+#if JUCE_USE_SSE_INTRINSICS
+  #include <emmintrin.h>
+#endif
+
 #if JUCE_MAC || JUCE_IOS
   #include <libkern/OSAtomic.h>
 #endif
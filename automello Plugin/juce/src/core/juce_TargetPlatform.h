@@ -181,5 +181,12 @@
   #error unknown compiler
 #endif
 
+//==============================================================================
+#if JUCE_INTEL && ! defined (JUCE_USE_SSE_INTRINSICS) \
+     && (defined (__SSE2__) || defined (__amd64__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2))
+  /** If defined, this indicates that SSE2 intrinsics can be used by the DSP code. */
+  #define JUCE_USE_SSE_INTRINSICS 1
+#endif
+
 
 #endif   // __JUCE_TARGETPLATFORM_JUCEHEADER__
@@ -60,9 +60,13 @@ public:
 
         Use stop() to stop the thread running.
 
+        If bindAddress is empty, connections are accepted on all the machine's network
+        interfaces; to only accept them from other processes on the same machine, you
+        can pass "127.0.0.1".
+
         @see createConnectionObject, stop
     */
-    bool beginWaitingForSocket (int portNumber);
+    bool beginWaitingForSocket (int portNumber, const String& bindAddress = String::empty);
 
     /** Terminates the listener thread, if it's active.
 
@@ -201,6 +201,17 @@ namespace SocketHelpers
         return FD_ISSET (handle, forReading ? &rset : &wset) ? 1 : 0;
     }
 
+    void stopHandleBeingInherited (const int handle) noexcept
+    {
+       #if ! JUCE_WINDOWS
+        // (otherwise a process that gets launched from this one would keep the socket
+        // open after we've closed it, so the other end would never see it disconnect)
+        fcntl (handle, F_SETFD, FD_CLOEXEC);
+       #else
+        (void) handle;
+       #endif
+    }
+
     bool setSocketBlockingState (const int handle, const bool shouldBlock) noexcept
     {
        #if JUCE_WINDOWS
@@ -246,6 +257,8 @@ namespace SocketHelpers
             return false;
         }
 
+        stopHandleBeingInherited (handle);
+
         if (isDatagram)
         {
             struct sockaddr* s = new struct sockaddr();
@@ -434,6 +447,8 @@ bool StreamingSocket::createListener (const int newPortNumber, const String& loc
     if (handle < 0)
         return false;
 
+    SocketHelpers::stopHandleBeingInherited (handle);
+
     const int reuse = 1;
     setsockopt (handle, SOL_SOCKET, SO_REUSEADDR, (const char*) &reuse, sizeof (reuse));
 
@@ -459,6 +474,9 @@ StreamingSocket* StreamingSocket::waitForNextConnection() const
         juce_socklen_t len = sizeof (sockaddr);
         const int newSocket = (int) accept (handle, &address, &len);
 
+        if (newSocket >= 0)
+            SocketHelpers::stopHandleBeingInherited (newSocket);
+
         if (newSocket >= 0 && connected)
             return new StreamingSocket (inet_ntoa (((struct sockaddr_in*) &address)->sin_addr),
                                         portNumber, newSocket);
@@ -0,0 +1,321 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#include "../../core/juce_StandardHeader.h"
+
+BEGIN_JUCE_NAMESPACE
+
+#include "juce_PrefetchingInputStream.h"
+
+
+//==============================================================================
+PrefetchingInputStream::PrefetchingInputStream (InputStream* const sourceStream,
+                                                const bool deleteSourceWhenDestroyed,
+                                                TimeSliceThread& backgroundThread,
+                                                const int bufferSize_,
+                                                const int numBuffersToPrefetch)
+   : source (sourceStream, deleteSourceWhenDestroyed),
+     thread (backgroundThread),
+     bufferSize (jmax (256, bufferSize_)),
+     totalLength (sourceStream->getTotalLength()),
+     position (sourceStream->getPosition()),
+     lastBlockRequested (-1)
+{
+    // You need to supply a real stream when creating a PrefetchingInputStream
+    jassert (sourceStream != nullptr);
+
+    for (int i = jmax (2, numBuffersToPrefetch); --i >= 0;)
+    {
+        Block* const b = new Block();
+        b->data.malloc (bufferSize);
+        b->start = -1;
+        b->numBytes = 0;
+        blocks.add (b);
+    }
+
+    thread.addTimeSliceClient (this);
+}
+
+PrefetchingInputStream::~PrefetchingInputStream()
+{
+    thread.removeTimeSliceClient (this);
+}
+
+//==============================================================================
+int64 PrefetchingInputStream::getTotalLength()
+{
+    return totalLength;
+}
+
+int64 PrefetchingInputStream::getPosition()
+{
+    return position;
+}
+
+bool PrefetchingInputStream::setPosition (int64 newPosition)
+{
+    const ScopedLock sl (blockLock);
+    position = jmax ((int64) 0, newPosition);
+    return true;
+}
+
+bool PrefetchingInputStream::isExhausted()
+{
+    if (totalLength >= 0)
+        return position >= totalLength;
+
+    const ScopedLock sl (blockLock);
+    const Block* const b = findBlock (getBlockStart (position));
+
+    return b != nullptr && position - b->start >= b->numBytes;
+}
+
+int PrefetchingInputStream::read (void* destBuffer, int maxBytesToRead)
+{
+    int bytesRead = 0;
+
+    while (maxBytesToRead > 0)
+    {
+        const int64 blockStart = getBlockStart (position);
+
+        {
+            const ScopedLock sl (blockLock);
+            const Block* const b = findBlock (blockStart);
+
+            if (b != nullptr)
+            {
+                const int offset = (int) (position - blockStart);
+                const int bytesAvailable = jmin (maxBytesToRead, b->numBytes - offset);
+
+                if (bytesAvailable <= 0)
+                    break; // reached the end of the source
+
+                memcpy (destBuffer, b->data + offset, bytesAvailable);
+                maxBytesToRead -= bytesAvailable;
+                bytesRead += bytesAvailable;
+                position += bytesAvailable;
+                destBuffer = static_cast <char*> (destBuffer) + bytesAvailable;
+                continue;
+            }
+        }
+
+        // the background thread hasn't got to this block yet, so read it here..
+        fillBlock (blockStart);
+    }
+
+    const int64 currentBlock = getBlockStart (position);
+
+    if (currentBlock != lastBlockRequested)
+    {
+        // when the position moves on to a new block, there's room to read further ahead
+        lastBlockRequested = currentBlock;
+        thread.moveToFrontOfQueue (this);
+    }
+
+    return bytesRead;
+}
+
+//==============================================================================
+PrefetchingInputStream::Block* PrefetchingInputStream::findBlock (const int64 start) const noexcept
+{
+    for (int i = blocks.size(); --i >= 0;)
+    {
+        Block* const b = blocks.getUnchecked (i);
+
+        if (b->start == start)
+            return b;
+    }
+
+    return nullptr;
+}
+
+PrefetchingInputStream::Block* PrefetchingInputStream::findBlockToReuse() const noexcept
+{
+    const int64 windowStart = getBlockStart (position);
+    const int64 windowEnd = windowStart + blocks.size() * (int64) bufferSize;
+
+    for (int i = blocks.size(); --i >= 0;)
+    {
+        Block* const b = blocks.getUnchecked (i);
+
+        if (b->start < windowStart || b->start >= windowEnd)
+            return b;
+    }
+
+    return nullptr;
+}
+
+int64 PrefetchingInputStream::findNextBlockToPrefetch() const noexcept
+{
+    int64 start = getBlockStart (position);
+
+    for (int i = blocks.size(); --i >= 0;)
+    {
+        if (totalLength >= 0 && start >= totalLength)
+            break;
+
+        const Block* const b = findBlock (start);
+
+        if (b == nullptr)
+            return start;
+
+        if (b->numBytes < bufferSize)
+            break; // this block hit the end of the source
+
+        start += bufferSize;
+    }
+
+    return -1;
+}
+
+void PrefetchingInputStream::fillBlock (const int64 start)
+{
+    const ScopedLock sl (sourceLock);
+    Block* b;
+
+    {
+        const ScopedLock sl2 (blockLock);
+
+        if (findBlock (start) != nullptr)
+            return; // another thread got there first
+
+        // (If the block being read is inside the window that starts at the current position,
+        // there will always be at least one free block outside it)
+        b = findBlockToReuse();
+
+        if (b == nullptr)
+            return;
+
+        b->start = -1;
+    }
+
+    int bytesRead = 0;
+
+    if (source->setPosition (start))
+    {
+        // (some streams, e.g. GZIP or network ones, can return fewer bytes than were
+        // asked for without having reached the end, but a short block means the end here)
+        while (bytesRead < bufferSize)
+        {
+            const int num = source->read (b->data + bytesRead, bufferSize - bytesRead);
+
+            if (num <= 0)
+                break;
+
+            bytesRead += num;
+        }
+    }
+
+    const ScopedLock sl2 (blockLock);
+    b->start = start;
+    b->numBytes = bytesRead;
+}
+
+int PrefetchingInputStream::useTimeSlice()
+{
+    int64 nextBlock;
+
+    {
+        const ScopedLock sl (blockLock);
+        nextBlock = findNextBlockToPrefetch();
+    }
+
+    if (nextBlock < 0)
+        return 100;
+
+    fillBlock (nextBlock);
+    return 0;
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+#include "../../utilities/juce_UnitTest.h"
+#include "juce_MemoryInputStream.h"
+#include "../../maths/juce_Random.h"
+
+class PrefetchingInputStreamTests  : public UnitTest
+{
+public:
+    PrefetchingInputStreamTests() : UnitTest ("PrefetchingInputStream") {}
+
+    // Never returns more than a few bytes at a time, like a decompressor might
+    class TrickleStream  : public MemoryInputStream
+    {
+    public:
+        TrickleStream (const MemoryBlock& data)  : MemoryInputStream (data, false) {}
+
+        int read (void* destBuffer, int maxBytesToRead)
+        {
+            return MemoryInputStream::read (destBuffer, jmin (maxBytesToRead, 77));
+        }
+    };
+
+    void runTest()
+    {
+        MemoryBlock data (10000);
+        Random r (1234);
+
+        for (size_t i = 0; i < data.getSize(); ++i)
+            data[i] = (char) r.nextInt (256);
+
+        TimeSliceThread thread ("Prefetch test");
+        thread.startThread();
+
+        beginTest ("Short reads from the source");
+        {
+            PrefetchingInputStream in (new TrickleStream (data), true, thread, 1024, 3);
+
+            MemoryBlock result ((size_t) in.getTotalLength());
+            expectEquals (in.read (result.getData(), (int) result.getSize()), (int) data.getSize());
+            expect (result == data);
+            expect (in.isExhausted());
+        }
+
+        beginTest ("Seeking");
+        {
+            PrefetchingInputStream in (new TrickleStream (data), true, thread, 1024, 3);
+            char buffer[3000];
+
+            for (int i = 0; i < 50; ++i)
+            {
+                const int pos = r.nextInt ((int) data.getSize());
+                in.setPosition (pos);
+
+                const int num = in.read (buffer, sizeof (buffer));
+                expectEquals (num, jmin ((int) sizeof (buffer), (int) data.getSize() - pos));
+                expect (memcmp (buffer, static_cast <const char*> (data.getData()) + pos, (size_t) num) == 0);
+            }
+        }
+
+        thread.stopThread (2000);
+    }
+};
+
+static PrefetchingInputStreamTests prefetchingInputStreamTests;
+
+#endif
+
+END_JUCE_NAMESPACE
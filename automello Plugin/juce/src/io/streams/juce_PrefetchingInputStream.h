@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+#ifndef __JUCE_PREFETCHINGINPUTSTREAM_JUCEHEADER__
+#define __JUCE_PREFETCHINGINPUTSTREAM_JUCEHEADER__
+
+#include "juce_InputStream.h"
+#include "../../memory/juce_OptionalScopedPointer.h"
+#include "../../memory/juce_HeapBlock.h"
+#include "../../containers/juce_OwnedArray.h"
+#include "../../threads/juce_CriticalSection.h"
+#include "../../threads/juce_TimeSliceThread.h"
+
+
+//==============================================================================
+/** Wraps another input stream, and uses a background thread to read ahead of
+    the current position.
+
+    A BufferedInputStream only goes back to its source when its buffer runs dry,
+    so anything that reads a file sequentially (e.g. an audio decoder) has to sit
+    and wait for each refill. This class keeps a set of buffers covering the region
+    just beyond the current read position, and uses a TimeSliceThread to fill them
+    in while the caller is busy with the data it has already got.
+
+    Reads that land in a block which hasn't been fetched yet (e.g. after a seek)
+    are serviced immediately on the caller's thread, and the background thread then
+    carries on prefetching from the new position.
+
+    @see BufferedInputStream, TimeSliceThread
+*/
+class JUCE_API  PrefetchingInputStream  : public InputStream,
+                                          private TimeSliceClient
+{
+public:
+    //==============================================================================
+    /** Creates a PrefetchingInputStream.
+
+        @param sourceStream                 the source stream to read from
+        @param deleteSourceWhenDestroyed    whether the sourceStream that is passed in should be
+                                            deleted by this object when it is itself deleted.
+        @param backgroundThread             the thread that should be used to read ahead. This
+                                            must be started by the caller, and must not be deleted
+                                            until this object has been destroyed. It can be shared
+                                            between any number of streams.
+        @param bufferSize                   the size of each of the blocks that are read from the
+                                            source
+        @param numBuffersToPrefetch         how many blocks beyond the current position should be
+                                            kept filled (the minimum is 2)
+    */
+    PrefetchingInputStream (InputStream* sourceStream,
+                            bool deleteSourceWhenDestroyed,
+                            TimeSliceThread& backgroundThread,
+                            int bufferSize = 65536,
+                            int numBuffersToPrefetch = 4);
+
+    /** Destructor.
+
+        This may also delete the source stream, if that option was chosen when the
+        stream was created.
+    */
+    ~PrefetchingInputStream();
+
+    //==============================================================================
+    int64 getTotalLength();
+    int64 getPosition();
+    bool setPosition (int64 newPosition);
+    int read (void* destBuffer, int maxBytesToRead);
+    bool isExhausted();
+
+
+private:
+    //==============================================================================
+    struct Block
+    {
+        HeapBlock <char> data;
+        int64 start;
+        int numBytes;
+    };
+
+    OptionalScopedPointer<InputStream> source;
+    TimeSliceThread& thread;
+    const int bufferSize;
+    const int64 totalLength;
+    int64 position, lastBlockRequested;
+    OwnedArray <Block> blocks;
+    CriticalSection sourceLock, blockLock;
+
+    int64 getBlockStart (int64 pos) const noexcept      { return pos - (pos % bufferSize); }
+    Block* findBlock (int64 start) const noexcept;
+    Block* findBlockToReuse() const noexcept;
+    int64 findNextBlockToPrefetch() const noexcept;
+    void fillBlock (int64 start);
+    int useTimeSlice();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PrefetchingInputStream);
+};
+
+#endif   // __JUCE_PREFETCHINGINPUTSTREAM_JUCEHEADER__
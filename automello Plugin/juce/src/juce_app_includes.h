@@ -53,6 +53,9 @@
 #ifndef __JUCE_AUDIOCDREADER_JUCEHEADER__
  #include "audio/audio_file_formats/juce_AudioCDReader.h"
 #endif
+#ifndef __JUCE_AUDIOFILEHEADERCACHE_JUCEHEADER__
+ #include "audio/audio_file_formats/juce_AudioFileHeaderCache.h"
+#endif
 #ifndef __JUCE_AUDIOFORMAT_JUCEHEADER__
  #include "audio/audio_file_formats/juce_AudioFormat.h"
 #endif
@@ -131,15 +134,30 @@
 #ifndef __JUCE_AUDIOIODEVICETYPE_JUCEHEADER__
  #include "audio/devices/juce_AudioIODeviceType.h"
 #endif
+#ifndef __JUCE_FILEAUDIOIODEVICETYPE_JUCEHEADER__
+ #include "audio/devices/juce_FileAudioIODeviceType.h"
+#endif
+#ifndef __JUCE_AUDIOBUFFERPOOL_JUCEHEADER__
+ #include "audio/dsp/juce_AudioBufferPool.h"
+#endif
 #ifndef __JUCE_AUDIODATACONVERTERS_JUCEHEADER__
  #include "audio/dsp/juce_AudioDataConverters.h"
 #endif
 #ifndef __JUCE_AUDIOSAMPLEBUFFER_JUCEHEADER__
  #include "audio/dsp/juce_AudioSampleBuffer.h"
 #endif
+#ifndef __JUCE_BIQUADCASCADE_JUCEHEADER__
+ #include "audio/dsp/juce_BiquadCascade.h"
+#endif
+#ifndef __JUCE_COMPRESSEDAUDIOBUFFER_JUCEHEADER__
+ #include "audio/dsp/juce_CompressedAudioBuffer.h"
+#endif
 #ifndef __JUCE_DECIBELS_JUCEHEADER__
  #include "audio/dsp/juce_Decibels.h"
 #endif
+#ifndef __JUCE_FLOATVECTOROPERATIONS_JUCEHEADER__
+ #include "audio/dsp/juce_FloatVectorOperations.h"
+#endif
 #ifndef __JUCE_IIRFILTER_JUCEHEADER__
  #include "audio/dsp/juce_IIRFilter.h"
 #endif
@@ -152,6 +170,9 @@
 #ifndef __JUCE_MIDIFILE_JUCEHEADER__
  #include "audio/midi/juce_MidiFile.h"
 #endif
+#ifndef __JUCE_MIDIFILEREADER_JUCEHEADER__
+ #include "audio/midi/juce_MidiFileReader.h"
+#endif
 #ifndef __JUCE_MIDIINPUT_JUCEHEADER__
  #include "audio/midi/juce_MidiInput.h"
 #endif
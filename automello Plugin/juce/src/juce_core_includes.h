@@ -194,6 +194,9 @@
 #ifndef __JUCE_OUTPUTSTREAM_JUCEHEADER__
  #include "io/streams/juce_OutputStream.h"
 #endif
+#ifndef __JUCE_PREFETCHINGINPUTSTREAM_JUCEHEADER__
+ #include "io/streams/juce_PrefetchingInputStream.h"
+#endif
 #ifndef __JUCE_SUBREGIONSTREAM_JUCEHEADER__
  #include "io/streams/juce_SubregionStream.h"
 #endif
@@ -236,6 +239,9 @@
 #ifndef __JUCE_REFERENCECOUNTEDOBJECT_JUCEHEADER__
  #include "memory/juce_ReferenceCountedObject.h"
 #endif
+#ifndef __JUCE_SCOPEDAUDIOTHREADALLOCATIONCHECK_JUCEHEADER__
+ #include "memory/juce_ScopedAudioThreadAllocationCheck.h"
+#endif
 #ifndef __JUCE_SCOPEDPOINTER_JUCEHEADER__
  #include "memory/juce_ScopedPointer.h"
 #endif
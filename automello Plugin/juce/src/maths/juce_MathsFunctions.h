@@ -427,6 +427,34 @@ inline int roundFloatToInt (const float value) noexcept
  #define JUCE_UNDENORMALISE(x)
 #endif
 
+//==============================================================================
+/**
+    Turns on the CPU's flush-to-zero and denormals-are-zero modes for as long as this
+    object exists, and restores the previous settings when it's deleted.
+
+    Create one of these on the stack around a section of DSP code that uses SSE
+    arithmetic, and denormalised values will be treated as zero by the hardware,
+    rather than having to be checked for with JUCE_UNDENORMALISE. On CPUs where SSE
+    isn't being used, it has no effect.
+*/
+class ScopedNoDenormals
+{
+public:
+   #if JUCE_USE_SSE_INTRINSICS
+    inline ScopedNoDenormals() noexcept   : oldMXCSR (_mm_getcsr())   { _mm_setcsr (oldMXCSR | 0x8040); }
+    inline ~ScopedNoDenormals() noexcept                               { _mm_setcsr (oldMXCSR); }
+   #else
+    inline ScopedNoDenormals() noexcept {}
+   #endif
+
+private:
+   #if JUCE_USE_SSE_INTRINSICS
+    const unsigned int oldMXCSR;
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE (ScopedNoDenormals);
+};
+
 //==============================================================================
 /** This namespace contains a few template classes for helping work out class type variations.
 */
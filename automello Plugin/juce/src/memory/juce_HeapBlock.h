@@ -26,6 +26,8 @@
 #ifndef __JUCE_HEAPBLOCK_JUCEHEADER__
 #define __JUCE_HEAPBLOCK_JUCEHEADER__
 
+#include "juce_ScopedAudioThreadAllocationCheck.h"
+
 
 //==============================================================================
 /**
@@ -92,6 +94,7 @@ public:
     explicit HeapBlock (const size_t numElements)
         : data (static_cast <ElementType*> (::malloc (numElements * sizeof (ElementType))))
     {
+        ScopedAudioThreadAllocationCheck::checkAllocation();
     }
 
     /** Destructor.
@@ -173,6 +176,7 @@ public:
     */
     void malloc (const size_t newNumElements, const size_t elementSize = sizeof (ElementType))
     {
+        ScopedAudioThreadAllocationCheck::checkAllocation();
         ::free (data);
         data = static_cast <ElementType*> (::malloc (newNumElements * elementSize));
     }
@@ -182,6 +186,7 @@ public:
     */
     void calloc (const size_t newNumElements, const size_t elementSize = sizeof (ElementType))
     {
+        ScopedAudioThreadAllocationCheck::checkAllocation();
         ::free (data);
         data = static_cast <ElementType*> (::calloc (newNumElements, elementSize));
     }
@@ -192,6 +197,7 @@ public:
     */
     void allocate (const size_t newNumElements, const bool initialiseToZero)
     {
+        ScopedAudioThreadAllocationCheck::checkAllocation();
         ::free (data);
 
         if (initialiseToZero)
@@ -207,6 +213,7 @@ public:
     */
     void realloc (const size_t newNumElements, const size_t elementSize = sizeof (ElementType))
     {
+        ScopedAudioThreadAllocationCheck::checkAllocation();
         if (data == nullptr)
             data = static_cast <ElementType*> (::malloc (newNumElements * elementSize));
         else
@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+#include "../core/juce_StandardHeader.h"
+
+BEGIN_JUCE_NAMESPACE
+
+#include "juce_ScopedAudioThreadAllocationCheck.h"
+
+
+//==============================================================================
+#if JUCE_CHECK_AUDIO_THREAD_ALLOCATIONS
+
+static juce_ThreadLocal int allocationCheckDepth = 0;
+
+ScopedAudioThreadAllocationCheck::ScopedAudioThreadAllocationCheck() noexcept
+{
+    ++allocationCheckDepth;
+}
+
+ScopedAudioThreadAllocationCheck::~ScopedAudioThreadAllocationCheck() noexcept
+{
+    --allocationCheckDepth;
+}
+
+bool ScopedAudioThreadAllocationCheck::isActive() noexcept
+{
+    return allocationCheckDepth > 0;
+}
+
+void ScopedAudioThreadAllocationCheck::checkAllocation() noexcept
+{
+    if (allocationCheckDepth > 0)
+    {
+        // (the check is turned off while the assertion is reported, because logging it may allocate)
+        const int oldDepth = allocationCheckDepth;
+        allocationCheckDepth = 0;
+
+        /*  If you hit this, then some code has allocated memory while rendering audio! Allocating
+            can block the audio thread for an unpredictable length of time, so have a look at the
+            stack trace to find out what did it, and change it to use memory that's allocated in
+            advance - e.g. in prepareToPlay(), or from an AudioBufferPool.
+        */
+        jassertfalse;
+
+        allocationCheckDepth = oldDepth;
+    }
+}
+
+#endif
+
+END_JUCE_NAMESPACE
+
+//==============================================================================
+#if JUCE_CHECK_AUDIO_THREAD_ALLOCATIONS
+
+void* operator new (size_t size)
+{
+    JUCE_NAMESPACE::ScopedAudioThreadAllocationCheck::checkAllocation();
+
+    void* const p = ::malloc (size > 0 ? size : 1);
+
+    if (p == nullptr)
+        throw std::bad_alloc();
+
+    return p;
+}
+
+void* operator new[] (size_t size)
+{
+    return operator new (size);
+}
+
+void operator delete (void* p) noexcept
+{
+    ::free (p);
+}
+
+void operator delete[] (void* p) noexcept
+{
+    ::free (p);
+}
+
+#endif
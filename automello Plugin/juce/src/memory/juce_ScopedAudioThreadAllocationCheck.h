@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE library - "Jules' Utility Class Extensions"
+   Copyright 2004-11 by Raw Material Software Ltd.
+
+  ------------------------------------------------------------------------------
+
+   JUCE can be redistributed and/or modified under the terms of the GNU General
+   Public License (Version 2), as published by the Free Software Foundation.
+   A copy of the license is included in the JUCE distribution, or can be found
+   online at www.gnu.org/licenses.
+
+   JUCE is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+   A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+  ------------------------------------------------------------------------------
+
+   To release a closed-source product which uses JUCE, commercial licenses are
+   available: visit www.rawmaterialsoftware.com/juce for more information.
+
+  ==============================================================================
+*/
+
+
+#ifndef __JUCE_SCOPEDAUDIOTHREADALLOCATIONCHECK_JUCEHEADER__
+#define __JUCE_SCOPEDAUDIOTHREADALLOCATIONCHECK_JUCEHEADER__
+
+
+//==============================================================================
+/**
+    Marks a section of code which mustn't allocate any memory.
+
+    If JUCE_CHECK_AUDIO_THREAD_ALLOCATIONS is enabled, then any heap allocation that's
+    made by a thread while one of these objects exists on its stack will trigger an
+    assertion. That covers everything that goes through a HeapBlock (which includes the
+    juce containers, Strings and AudioSampleBuffers), and anything created with operator new.
+
+    The AudioDeviceManager and the plugin wrappers create one of these around their
+    rendering callbacks, so turning on the flag in a debug build will show up any
+    allocations that your audio code makes. When the flag is off, this class does nothing.
+
+    @see AudioBufferPool
+*/
+class JUCE_API  ScopedAudioThreadAllocationCheck
+{
+public:
+   #if JUCE_CHECK_AUDIO_THREAD_ALLOCATIONS
+    /** Starts disallowing allocations on the calling thread. */
+    ScopedAudioThreadAllocationCheck() noexcept;
+
+    /** Destructor. */
+    ~ScopedAudioThreadAllocationCheck() noexcept;
+
+    /** Returns true if the calling thread is currently inside one of these objects. */
+    static bool isActive() noexcept;
+
+    /** This is called by the allocators, and asserts if the calling thread isn't allowed
+        to allocate memory at the moment.
+    */
+    static void checkAllocation() noexcept;
+   #else
+    ScopedAudioThreadAllocationCheck() noexcept     {}
+    ~ScopedAudioThreadAllocationCheck() noexcept    {}
+
+    static bool isActive() noexcept                 { return false; }
+    static void checkAllocation() noexcept          {}
+   #endif
+
+private:
+    JUCE_DECLARE_NON_COPYABLE (ScopedAudioThreadAllocationCheck);
+};
+
+
+#endif   // __JUCE_SCOPEDAUDIOTHREADALLOCATIONCHECK_JUCEHEADER__
@@ -124,7 +124,8 @@ public:
           numChannelsRunning (0),
           latency (0),
           isInput (forInput),
-          isInterleaved (true)
+          isInterleaved (true),
+          isMMap (false)
     {
         failed (snd_pcm_open (&handle, deviceID.toUTF8(),
                               forInput ? SND_PCM_STREAM_CAPTURE : SND_PCM_STREAM_PLAYBACK,
@@ -148,10 +149,28 @@ public:
         if (failed (snd_pcm_hw_params_any (handle, hwParams)))
             return false;
 
-        if (snd_pcm_hw_params_set_access (handle, hwParams, SND_PCM_ACCESS_RW_NONINTERLEAVED) >= 0)
+        // mmap access lets the samples get converted straight into (or out of) the device's
+        // own buffer, but not all devices and plugins can do it, so fall back to read/write..
+        if (snd_pcm_hw_params_set_access (handle, hwParams, SND_PCM_ACCESS_MMAP_NONINTERLEAVED) >= 0)
+        {
             isInterleaved = false;
+            isMMap = true;
+        }
+        else if (snd_pcm_hw_params_set_access (handle, hwParams, SND_PCM_ACCESS_MMAP_INTERLEAVED) >= 0)
+        {
+            isInterleaved = true;
+            isMMap = true;
+        }
+        else if (snd_pcm_hw_params_set_access (handle, hwParams, SND_PCM_ACCESS_RW_NONINTERLEAVED) >= 0)
+        {
+            isInterleaved = false;
+            isMMap = false;
+        }
         else if (snd_pcm_hw_params_set_access (handle, hwParams, SND_PCM_ACCESS_RW_INTERLEAVED) >= 0)
+        {
             isInterleaved = true;
+            isMMap = false;
+        }
         else
         {
             jassertfalse;
@@ -177,7 +196,7 @@ public:
                 bitDepth = formatsToTry [i + 1] & 255;
                 const bool isFloat = (formatsToTry [i + 1] & isFloatBit) != 0;
                 const bool isLittleEndian = (formatsToTry [i + 1] & isLittleEndianBit) != 0;
-                converter = createConverter (isInput, bitDepth, isFloat, isLittleEndian, numChannels);
+                converter = createConverter (isInput, bitDepth, isFloat, isLittleEndian, isInterleaved ? numChannels : 1);
                 break;
             }
         }
@@ -239,10 +258,16 @@ public:
     }
 
     //==============================================================================
+    bool isUsingMMap() const noexcept       { return isMMap; }
+
     bool writeToOutputDevice (AudioSampleBuffer& outputChannelBuffer, const int numSamples)
     {
         jassert (numChannelsRunning <= outputChannelBuffer.getNumChannels());
         float** const data = outputChannelBuffer.getArrayOfChannels();
+
+        if (isMMap)
+            return writeToMMapBuffer (data, numSamples);
+
         snd_pcm_sframes_t numDone = 0;
 
         if (isInterleaved)
@@ -281,6 +306,9 @@ public:
         jassert (numChannelsRunning <= inputChannelBuffer.getNumChannels());
         float** const data = inputChannelBuffer.getArrayOfChannels();
 
+        if (isMMap)
+            return readFromMMapBuffer (data, numSamples);
+
         if (isInterleaved)
         {
             scratch.ensureSize (sizeof (float) * numSamples * numChannelsRunning, false);
@@ -324,7 +352,7 @@ public:
     //==============================================================================
 private:
     const bool isInput;
-    bool isInterleaved;
+    bool isInterleaved, isMMap;
     MemoryBlock scratch;
     ScopedPointer<AudioData::Converter> converter;
 
@@ -369,6 +397,165 @@ private:
         return nullptr;
     }
 
+    //==============================================================================
+    bool writeToMMapBuffer (float** const data, const int numSamples)
+    {
+        int numDone = 0;
+
+        while (numDone < numSamples)
+        {
+            const snd_pcm_sframes_t avail = snd_pcm_avail_update (handle);
+
+            if (avail < 0)
+            {
+                if (! recoverFromError ((int) avail))
+                    return false;
+
+                continue;
+            }
+
+            if (avail < numSamples - numDone)
+            {
+                // The ring's full, so if the stream hasn't started yet, this is the time to do
+                // it (unlike writei, committing to the ring doesn't start it automatically)
+                if (snd_pcm_state (handle) == SND_PCM_STATE_PREPARED)
+                {
+                    if (failed (snd_pcm_start (handle)))
+                        return false;
+                }
+                else if (avail == 0)
+                {
+                    if (! waitForDevice())
+                        return false;
+
+                    continue;
+                }
+            }
+
+            const snd_pcm_channel_area_t* areas = nullptr;
+            snd_pcm_uframes_t offset = 0;
+            snd_pcm_uframes_t numFrames = (snd_pcm_uframes_t) jmin ((int) avail, numSamples - numDone);
+
+            const int err = snd_pcm_mmap_begin (handle, &areas, &offset, &numFrames);
+
+            if (err < 0)
+            {
+                if (! recoverFromError (err))
+                    return false;
+
+                continue;
+            }
+
+            for (int i = 0; i < numChannelsRunning; ++i)
+                converter->convertSamples (getAreaData (areas[i], offset), data[i] + numDone, (int) numFrames);
+
+            const snd_pcm_sframes_t numCommitted = snd_pcm_mmap_commit (handle, offset, numFrames);
+
+            if (numCommitted < 0 || (snd_pcm_uframes_t) numCommitted != numFrames)
+            {
+                if (! recoverFromError (numCommitted < 0 ? (int) numCommitted : -EPIPE))
+                    return false;
+            }
+
+            numDone += (int) numFrames;
+        }
+
+        return true;
+    }
+
+    bool readFromMMapBuffer (float** const data, const int numSamples)
+    {
+        int numDone = 0;
+
+        while (numDone < numSamples)
+        {
+            // (a capture stream doesn't start by itself in mmap mode)
+            if (snd_pcm_state (handle) == SND_PCM_STATE_PREPARED && failed (snd_pcm_start (handle)))
+                return false;
+
+            const snd_pcm_sframes_t avail = snd_pcm_avail_update (handle);
+
+            if (avail < 0)
+            {
+                if (! recoverFromError ((int) avail))
+                    return false;
+
+                continue;
+            }
+
+            if (avail == 0)
+            {
+                if (! waitForDevice())
+                    return false;
+
+                continue;
+            }
+
+            const snd_pcm_channel_area_t* areas = nullptr;
+            snd_pcm_uframes_t offset = 0;
+            snd_pcm_uframes_t numFrames = (snd_pcm_uframes_t) jmin ((int) avail, numSamples - numDone);
+
+            const int err = snd_pcm_mmap_begin (handle, &areas, &offset, &numFrames);
+
+            if (err < 0)
+            {
+                if (! recoverFromError (err))
+                    return false;
+
+                continue;
+            }
+
+            for (int i = 0; i < numChannelsRunning; ++i)
+                converter->convertSamples (data[i] + numDone, getAreaData (areas[i], offset), (int) numFrames);
+
+            const snd_pcm_sframes_t numCommitted = snd_pcm_mmap_commit (handle, offset, numFrames);
+
+            if (numCommitted < 0 || (snd_pcm_uframes_t) numCommitted != numFrames)
+            {
+                if (! recoverFromError (numCommitted < 0 ? (int) numCommitted : -EPIPE))
+                    return false;
+            }
+
+            numDone += (int) numFrames;
+        }
+
+        return true;
+    }
+
+    static void* getAreaData (const snd_pcm_channel_area_t& area, const snd_pcm_uframes_t offset) noexcept
+    {
+        // (the offsets in an area are all in bits)
+        return static_cast <char*> (area.addr) + (area.first + offset * area.step) / 8;
+    }
+
+    bool waitForDevice()
+    {
+        const int result = snd_pcm_wait (handle, 2000);
+
+        if (result < 0)
+            return recoverFromError (result);
+
+        if (result == 0)
+        {
+            error = "device timed out";
+            DBG ("ALSA error: " + error + "\n");
+            return false;
+        }
+
+        return true;
+    }
+
+    bool recoverFromError (const int errorNum)
+    {
+        // An xrun or a suspend just needs the stream re-preparing (or resuming), which is
+        // much quicker than closing and re-opening the device. The stream gets started
+        // again by the next read or write.
+        if (errorNum == -EPIPE)
+            DBG ("ALSA: xrun");
+
+        return ! failed (snd_pcm_recover (handle, errorNum, 1));
+    }
+
     //==============================================================================
     bool failed (const int errorNum)
     {
@@ -558,6 +745,8 @@ public:
 
     void run()
     {
+        const bool stackIsLocked = makeThreadRealtime();
+
         while (! threadShouldExit())
         {
             if (inputDevice != nullptr)
@@ -593,12 +782,16 @@ public:
 
             if (outputDevice != nullptr)
             {
-                failed (snd_pcm_wait (outputDevice->handle, 2000));
+                // (in mmap mode, the device waits for space itself)
+                if (! outputDevice->isUsingMMap())
+                {
+                    failed (snd_pcm_wait (outputDevice->handle, 2000));
 
-                if (threadShouldExit())
-                    break;
+                    if (threadShouldExit())
+                        break;
 
-                failed (snd_pcm_avail_update (outputDevice->handle));
+                    failed (snd_pcm_avail_update (outputDevice->handle));
+                }
 
                 if (! outputDevice->writeToOutputDevice (outputChannelBuffer, bufferSize))
                 {
@@ -607,6 +800,9 @@ public:
                 }
             }
         }
+
+        if (stackIsLocked)
+            unlockThreadStack();
     }
 
     int getBitDepth() const noexcept
@@ -654,6 +850,66 @@ private:
         return true;
     }
 
+    //==============================================================================
+    /*  startThread() only gets us SCHED_RR, which shares its time with any other threads at
+        the same priority, so this asks for SCHED_FIFO instead. It also locks the top of the
+        thread's stack into memory, so that the callback can't page-fault on it.
+
+        Both of these need the user to have real-time permissions (e.g. by being in an "audio"
+        group with rtprio and memlock limits), and if they're not allowed, the thread just
+        carries on as it was.
+    */
+    enum { stackBytesToLock = 256 * 1024 };
+
+    static bool makeThreadRealtime()
+    {
+        struct sched_param param;
+        zerostruct (param);
+        param.sched_priority = jmax (sched_get_priority_min (SCHED_FIFO), sched_get_priority_max (SCHED_FIFO) - 10);
+
+        if (pthread_setschedparam (pthread_self(), SCHED_FIFO, &param) != 0)
+            DBG ("ALSA: couldn't get SCHED_FIFO scheduling for the audio thread");
+
+        void* stackStart = nullptr;
+        size_t stackSize = 0;
+
+        if (getThreadStackToLock (stackStart, stackSize) && mlock (stackStart, stackSize) == 0)
+            return true;
+
+        DBG ("ALSA: couldn't lock the audio thread's stack");
+        return false;
+    }
+
+    static void unlockThreadStack()
+    {
+        void* stackStart = nullptr;
+        size_t stackSize = 0;
+
+        if (getThreadStackToLock (stackStart, stackSize))
+            munlock (stackStart, stackSize);
+    }
+
+    static bool getThreadStackToLock (void*& start, size_t& size)
+    {
+        pthread_attr_t attr;
+
+        if (pthread_getattr_np (pthread_self(), &attr) != 0)
+            return false;
+
+        void* stackBase = nullptr;
+        size_t stackSize = 0;
+        const bool ok = pthread_attr_getstack (&attr, &stackBase, &stackSize) == 0;
+        pthread_attr_destroy (&attr);
+
+        if (! ok)
+            return false;
+
+        // (the stack grows downwards, so the part that gets used is at the top)
+        size = jmin (stackSize, (size_t) stackBytesToLock);
+        start = static_cast <char*> (stackBase) + stackSize - size;
+        return true;
+    }
+
     void initialiseRatesAndChannels()
     {
         sampleRates.clear();
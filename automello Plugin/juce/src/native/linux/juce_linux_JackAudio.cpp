@@ -78,6 +78,8 @@ JUCE_DECL_JACK_FUNCTION (int, jack_set_port_connect_callback, (jack_client_t* cl
 JUCE_DECL_JACK_FUNCTION (jack_port_t* , jack_port_by_id, (jack_client_t* client, jack_port_id_t port_id), (client, port_id));
 JUCE_DECL_JACK_FUNCTION (int, jack_port_connected, (const jack_port_t* port), (port));
 JUCE_DECL_JACK_FUNCTION (int, jack_port_connected_to, (const jack_port_t* port, const char* port_name), (port, port_name));
+JUCE_DECL_JACK_FUNCTION (int, jack_set_freewheel_callback, (jack_client_t* client, JackFreewheelCallback freewheel_callback, void* arg), (client, freewheel_callback, arg));
+JUCE_DECL_JACK_FUNCTION (int, jack_set_freewheel, (jack_client_t* client, int onoff), (client, onoff));
 
 #if JUCE_DEBUG
   #define JACK_LOGGING_ENABLED 1
@@ -220,7 +222,32 @@ public:
         lastError = String::empty;
         close();
 
+        // Only the ports for the enabled channels get fetched and passed to the callback
+        activeInputChannels.clear();
+        activeOutputChannels.clear();
+        activeInputPorts.clearQuick();
+        activeOutputPorts.clearQuick();
+
+        for (int i = 0; i < inputPorts.size(); ++i)
+        {
+            if (inputChannels[i])
+            {
+                activeInputChannels.setBit (i);
+                activeInputPorts.add (inputPorts.getUnchecked (i));
+            }
+        }
+
+        for (int i = 0; i < outputPorts.size(); ++i)
+        {
+            if (outputChannels[i])
+            {
+                activeOutputChannels.setBit (i);
+                activeOutputPorts.add (outputPorts.getUnchecked (i));
+            }
+        }
+
         JUCE_NAMESPACE::jack_set_process_callback (client, processCallback, this);
+        JUCE_NAMESPACE::jack_set_freewheel_callback (client, freewheelCallback, this);
         JUCE_NAMESPACE::jack_on_shutdown (client, shutdownCallback, this);
         JUCE_NAMESPACE::jack_activate (client);
         isOpen_ = true;
@@ -284,10 +311,12 @@ public:
         {
             JUCE_NAMESPACE::jack_deactivate (client);
             JUCE_NAMESPACE::jack_set_process_callback (client, processCallback, 0);
+            JUCE_NAMESPACE::jack_set_freewheel_callback (client, freewheelCallback, 0);
             JUCE_NAMESPACE::jack_on_shutdown (client, shutdownCallback, 0);
         }
 
         isOpen_ = false;
+        freewheeling = 0;
     }
 
     void start (AudioIODeviceCallback* newCallback)
@@ -321,26 +350,16 @@ public:
     int getCurrentBitDepth()                { return 32; }
     const String getLastError()             { return lastError; }
 
-    const BigInteger getActiveOutputChannels() const
-    {
-        BigInteger outputBits;
+    const BigInteger getActiveOutputChannels() const    { return activeOutputChannels; }
+    const BigInteger getActiveInputChannels() const     { return activeInputChannels; }
 
-        for (int i = 0; i < outputPorts.size(); i++)
-            if (JUCE_NAMESPACE::jack_port_connected ((jack_port_t*) outputPorts [i]))
-                outputBits.setBit (i);
-
-        return outputBits;
-    }
+    bool isFreewheeling()                   { return freewheeling.get() != 0; }
 
-    const BigInteger getActiveInputChannels() const
+    bool setFreewheeling (const bool shouldFreewheel)
     {
-        BigInteger inputBits;
-
-        for (int i = 0; i < inputPorts.size(); i++)
-            if (JUCE_NAMESPACE::jack_port_connected ((jack_port_t*) inputPorts [i]))
-                inputBits.setBit (i);
-
-        return inputBits;
+        // (this puts the whole JACK session into freewheel mode, not just this client)
+        return client != 0 && isOpen_
+                && JUCE_NAMESPACE::jack_set_freewheel (client, shouldFreewheel ? 1 : 0) == 0;
     }
 
     int getOutputLatencyInSamples()
@@ -368,21 +387,22 @@ public:
 private:
     void process (const int numSamples)
     {
+        // The callback gets JACK's own port buffers, so nothing is copied on the way in or out.
         int i, numActiveInChans = 0, numActiveOutChans = 0;
 
-        for (i = 0; i < totalNumberOfInputChannels; ++i)
+        for (i = 0; i < activeInputPorts.size(); ++i)
         {
             jack_default_audio_sample_t* in
-                = (jack_default_audio_sample_t*) JUCE_NAMESPACE::jack_port_get_buffer ((jack_port_t*) inputPorts.getUnchecked(i), numSamples);
+                = (jack_default_audio_sample_t*) JUCE_NAMESPACE::jack_port_get_buffer ((jack_port_t*) activeInputPorts.getUnchecked(i), numSamples);
 
             if (in != nullptr)
                 inChans [numActiveInChans++] = (float*) in;
         }
 
-        for (i = 0; i < totalNumberOfOutputChannels; ++i)
+        for (i = 0; i < activeOutputPorts.size(); ++i)
         {
             jack_default_audio_sample_t* out
-                = (jack_default_audio_sample_t*) JUCE_NAMESPACE::jack_port_get_buffer ((jack_port_t*) outputPorts.getUnchecked(i), numSamples);
+                = (jack_default_audio_sample_t*) JUCE_NAMESPACE::jack_port_get_buffer ((jack_port_t*) activeOutputPorts.getUnchecked(i), numSamples);
 
             if (out != nullptr)
                 outChans [numActiveOutChans++] = (float*) out;
@@ -410,6 +430,15 @@ private:
         return 0;
     }
 
+    static void freewheelCallback (int starting, void* callbackArgument)
+    {
+        // While this is on, JACK calls process() as fast as it can rather than in real time
+        jack_Log ("JackAudioIODevice::freewheel " + String (starting));
+
+        if (callbackArgument != 0)
+            ((JackAudioIODevice*) callbackArgument)->freewheeling = (starting != 0 ? 1 : 0);
+    }
+
     static void threadInitCallback (void* callbackArgument)
     {
         jack_Log ("JackAudioIODevice::initialise");
@@ -443,6 +472,9 @@ private:
     int totalNumberOfInputChannels;
     int totalNumberOfOutputChannels;
     Array<void*> inputPorts, outputPorts;
+    Array<void*> activeInputPorts, activeOutputPorts;
+    BigInteger activeInputChannels, activeOutputChannels;
+    Atomic<int> freewheeling;
 };
 
 
@@ -75,6 +75,20 @@ void TimeSliceThread::removeTimeSliceClient (TimeSliceClient* const client)
     }
 }
 
+bool TimeSliceThread::moveToFrontOfQueue (TimeSliceClient* const client)
+{
+    const ScopedLock sl (listLock);
+
+    if (clients.contains (client))
+    {
+        client->nextCallTime = Time::getCurrentTime();
+        notify();
+        return true;
+    }
+
+    return false;
+}
+
 int TimeSliceThread::getNumClients() const
 {
     return clients.size();
@@ -117,6 +117,13 @@ public:
     */
     void removeTimeSliceClient (TimeSliceClient* client);
 
+    /** If the given client is waiting in the queue, it will be moved to the front
+        and given a time-slice as soon as possible.
+
+        Returns false if the client isn't registered with this thread.
+    */
+    bool moveToFrontOfQueue (TimeSliceClient* client);
+
     /** Returns the number of registered clients. */
     int getNumClients() const;
 